@@ -0,0 +1,719 @@
+/*******************************************************************************#
+#           guvcview              http://guvcview.sourceforge.net               #
+#                                                                               #
+#           Paulo Assis <pj.assis@gmail.com>                                    #
+#                                                                               #
+# This program is free software; you can redistribute it and/or modify          #
+# it under the terms of the GNU General Public License as published by          #
+# the Free Software Foundation; either version 2 of the License, or             #
+# (at your option) any later version.                                           #
+#                                                                               #
+# This program is distributed in the hope that it will be useful,               #
+# but WITHOUT ANY WARRANTY; without even the implied warranty of                #
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 #
+# GNU General Public License for more details.                                  #
+#                                                                               #
+# You should have received a copy of the GNU General Public License             #
+# along with this program; if not, write to the Free Software                   #
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA     #
+#                                                                               #
+********************************************************************************/
+
+#define _FILE_OFFSET_BITS 64
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <sys/types.h>
+
+#include "gviewv4l2core.h"
+#include "gview.h"
+#include "avi_writer.h"
+
+extern int debug_level;
+
+#define AVI_FOURCC(a,b,c,d) ((uint32_t)(a) | ((uint32_t)(b) << 8) | ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+
+#define AVIF_HASINDEX        0x00000010
+#define AVIIF_KEYFRAME       0x00000010
+#define AVI_INDEX_OF_INDEXES 0x00
+#define AVI_INDEX_OF_CHUNKS  0x01
+#define AVI_DELTA_FRAME      0x80000000
+
+/*size limit for each RIFF segment (OpenDML recommends 1GB)*/
+#define AVI_RIFF_MAX            (1024 * 1024 * 1024LL)
+/*video chunks per standard index (ix00) chunk*/
+#define AVI_STD_INDEX_FRAMES    512
+/*super index (indx) entries preallocated in the stream header*/
+#define AVI_SUPER_INDEX_ENTRIES 4096
+/*maximum number of padding chunks inserted for a single gap*/
+#define AVI_MAX_PADDING         1000
+/*stdio buffer size for the output file*/
+#define AVI_WRITE_BUFFER_SIZE   (1024 * 1024)
+
+#define AVI_DMLH_SIZE 248
+
+typedef struct _avi_index_entry_t
+{
+	uint32_t offset; // offset (idx1: from the movi fourcc; ix00: from the movi list)
+	uint32_t size;   // chunk data size (ix00: bit 31 set for non key frames)
+} avi_index_entry_t;
+
+struct _avi_writer_t
+{
+	FILE *file;
+	char *file_buffer; // stdio buffer
+
+	uint32_t fourcc;
+	int width;
+	int height;
+	int fps_num;
+	int fps_denom;
+	uint64_t frame_duration; // nominal frame interval (ns)
+
+	/*header fields patched on close*/
+	off_t avih_pos;
+	off_t strh_pos;
+	off_t indx_pos;
+	off_t dmlh_pos;
+
+	/*current RIFF segment*/
+	int riff_count;
+	off_t riff_pos;
+	off_t movi_pos;
+
+	/*legacy index (first RIFF segment only)*/
+	avi_index_entry_t *idx1;
+	uint32_t idx1_count;
+	uint32_t idx1_max;
+
+	/*pending standard index entries*/
+	avi_index_entry_t ix[AVI_STD_INDEX_FRAMES];
+	uint32_t ix_count;
+	uint32_t super_count;
+
+	uint32_t frames;        // total video chunks
+	uint32_t riff1_frames;  // video chunks in the first RIFF segment
+	uint32_t padded;        // empty chunks inserted for dropped frames
+	uint32_t max_chunk_size;
+	uint64_t bytes;         // total video payload
+
+	uint64_t first_ts;
+	uint64_t last_ts;
+
+	int error;
+};
+
+/*
+ * write a little endian 16 bit value
+ * args:
+ *   avi - pointer to avi writer
+ *   val - value
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+static void put_le16(avi_writer_t *avi, uint16_t val)
+{
+	uint8_t b[2] = {val & 0xff, (val >> 8) & 0xff};
+	if(fwrite(b, 1, 2, avi->file) != 2)
+		avi->error = 1;
+}
+
+/*
+ * write a little endian 32 bit value
+ * args:
+ *   avi - pointer to avi writer
+ *   val - value
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+static void put_le32(avi_writer_t *avi, uint32_t val)
+{
+	uint8_t b[4] = {val & 0xff, (val >> 8) & 0xff, (val >> 16) & 0xff, (val >> 24) & 0xff};
+	if(fwrite(b, 1, 4, avi->file) != 4)
+		avi->error = 1;
+}
+
+/*
+ * write a little endian 64 bit value
+ * args:
+ *   avi - pointer to avi writer
+ *   val - value
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+static void put_le64(avi_writer_t *avi, uint64_t val)
+{
+	put_le32(avi, (uint32_t) (val & 0xffffffff));
+	put_le32(avi, (uint32_t) (val >> 32));
+}
+
+/*
+ * write zero bytes
+ * args:
+ *   avi - pointer to avi writer
+ *   n - number of bytes
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+static void put_zeros(avi_writer_t *avi, int n)
+{
+	for(; n > 0; n--)
+		if(fputc(0, avi->file) == EOF)
+			avi->error = 1;
+}
+
+/*
+ * overwrite a 32 bit value at a given file offset
+ *   (the file position is restored)
+ * args:
+ *   avi - pointer to avi writer
+ *   pos - file offset
+ *   val - value
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+static void patch_le32(avi_writer_t *avi, off_t pos, uint32_t val)
+{
+	off_t cur = ftello(avi->file);
+	if(fseeko(avi->file, pos, SEEK_SET) != 0)
+	{
+		avi->error = 1;
+		return;
+	}
+	put_le32(avi, val);
+	fseeko(avi->file, cur, SEEK_SET);
+}
+
+/*
+ * start a list (or RIFF) with a size placeholder
+ * args:
+ *   avi - pointer to avi writer
+ *   id - list id (LIST or RIFF)
+ *   type - list type
+ *
+ * asserts:
+ *   none
+ *
+ * returns: list offset (to be passed to end_list)
+ */
+static off_t start_list(avi_writer_t *avi, uint32_t id, uint32_t type)
+{
+	off_t pos = ftello(avi->file);
+	put_le32(avi, id);
+	put_le32(avi, 0);
+	put_le32(avi, type);
+	return pos;
+}
+
+/*
+ * patch the list size with the current file position
+ * args:
+ *   avi - pointer to avi writer
+ *   pos - list offset
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+static void end_list(avi_writer_t *avi, off_t pos)
+{
+	patch_le32(avi, pos + 4, (uint32_t) (ftello(avi->file) - pos - 8));
+}
+
+/*
+ * write the file headers (hdrl list)
+ * args:
+ *   avi - pointer to avi writer
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+static void write_headers(avi_writer_t *avi)
+{
+	avi->riff_pos = start_list(avi, AVI_FOURCC('R','I','F','F'), AVI_FOURCC('A','V','I',' '));
+	avi->riff_count = 1;
+
+	off_t hdrl = start_list(avi, AVI_FOURCC('L','I','S','T'), AVI_FOURCC('h','d','r','l'));
+
+	/*main header*/
+	put_le32(avi, AVI_FOURCC('a','v','i','h'));
+	put_le32(avi, 56);
+	avi->avih_pos = ftello(avi->file);
+	put_le32(avi, (uint32_t) (avi->frame_duration / 1000)); // dwMicroSecPerFrame
+	put_le32(avi, 0); // dwMaxBytesPerSec
+	put_le32(avi, 0); // dwPaddingGranularity
+	put_le32(avi, AVIF_HASINDEX); // dwFlags
+	put_le32(avi, 0); // dwTotalFrames
+	put_le32(avi, 0); // dwInitialFrames
+	put_le32(avi, 1); // dwStreams
+	put_le32(avi, 0); // dwSuggestedBufferSize
+	put_le32(avi, avi->width);
+	put_le32(avi, avi->height);
+	put_zeros(avi, 16); // dwReserved
+
+	off_t strl = start_list(avi, AVI_FOURCC('L','I','S','T'), AVI_FOURCC('s','t','r','l'));
+
+	/*stream header*/
+	put_le32(avi, AVI_FOURCC('s','t','r','h'));
+	put_le32(avi, 56);
+	avi->strh_pos = ftello(avi->file);
+	put_le32(avi, AVI_FOURCC('v','i','d','s')); // fccType
+	put_le32(avi, avi->fourcc); // fccHandler
+	put_le32(avi, 0); // dwFlags
+	put_le16(avi, 0); // wPriority
+	put_le16(avi, 0); // wLanguage
+	put_le32(avi, 0); // dwInitialFrames
+	put_le32(avi, avi->fps_num); // dwScale
+	put_le32(avi, avi->fps_denom); // dwRate
+	put_le32(avi, 0); // dwStart
+	put_le32(avi, 0); // dwLength
+	put_le32(avi, 0); // dwSuggestedBufferSize
+	put_le32(avi, 0xffffffff); // dwQuality
+	put_le32(avi, 0); // dwSampleSize
+	put_le16(avi, 0); // rcFrame
+	put_le16(avi, 0);
+	put_le16(avi, avi->width);
+	put_le16(avi, avi->height);
+
+	/*stream format (BITMAPINFOHEADER)*/
+	put_le32(avi, AVI_FOURCC('s','t','r','f'));
+	put_le32(avi, 40);
+	put_le32(avi, 40); // biSize
+	put_le32(avi, avi->width);
+	put_le32(avi, avi->height);
+	put_le16(avi, 1); // biPlanes
+	put_le16(avi, 24); // biBitCount
+	put_le32(avi, avi->fourcc); // biCompression
+	put_le32(avi, avi->width * avi->height * 3); // biSizeImage
+	put_zeros(avi, 16); // biXPelsPerMeter, biYPelsPerMeter, biClrUsed, biClrImportant
+
+	/*OpenDML super index (entries filled as standard indexes are written)*/
+	put_le32(avi, AVI_FOURCC('i','n','d','x'));
+	put_le32(avi, 24 + 16 * AVI_SUPER_INDEX_ENTRIES);
+	avi->indx_pos = ftello(avi->file);
+	put_le16(avi, 4); // wLongsPerEntry
+	fputc(0, avi->file); // bIndexSubType
+	fputc(AVI_INDEX_OF_INDEXES, avi->file); // bIndexType
+	put_le32(avi, 0); // nEntriesInUse
+	put_le32(avi, AVI_FOURCC('0','0','d','c')); // dwChunkId
+	put_zeros(avi, 12 + 16 * AVI_SUPER_INDEX_ENTRIES);
+
+	end_list(avi, strl);
+
+	/*OpenDML extended header*/
+	off_t odml = start_list(avi, AVI_FOURCC('L','I','S','T'), AVI_FOURCC('o','d','m','l'));
+	put_le32(avi, AVI_FOURCC('d','m','l','h'));
+	put_le32(avi, AVI_DMLH_SIZE);
+	avi->dmlh_pos = ftello(avi->file);
+	put_zeros(avi, AVI_DMLH_SIZE); // dwTotalFrames + reserved
+	end_list(avi, odml);
+
+	end_list(avi, hdrl);
+
+	avi->movi_pos = start_list(avi, AVI_FOURCC('L','I','S','T'), AVI_FOURCC('m','o','v','i'));
+}
+
+/*
+ * write the pending standard index chunk and
+ *   add it to the super index
+ * args:
+ *   avi - pointer to avi writer
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+static void flush_std_index(avi_writer_t *avi)
+{
+	if(avi->ix_count == 0)
+		return;
+
+	off_t pos = ftello(avi->file);
+	uint32_t size = 24 + 8 * avi->ix_count;
+
+	put_le32(avi, AVI_FOURCC('i','x','0','0'));
+	put_le32(avi, size);
+	put_le16(avi, 2); // wLongsPerEntry
+	fputc(0, avi->file); // bIndexSubType
+	fputc(AVI_INDEX_OF_CHUNKS, avi->file); // bIndexType
+	put_le32(avi, avi->ix_count); // nEntriesInUse
+	put_le32(avi, AVI_FOURCC('0','0','d','c')); // dwChunkId
+	put_le64(avi, (uint64_t) avi->movi_pos); // qwBaseOffset
+	put_le32(avi, 0); // dwReserved
+
+	uint32_t i = 0;
+	for(i = 0; i < avi->ix_count; i++)
+	{
+		put_le32(avi, avi->ix[i].offset);
+		put_le32(avi, avi->ix[i].size);
+	}
+
+	if(avi->super_count < AVI_SUPER_INDEX_ENTRIES)
+	{
+		off_t entry = avi->indx_pos + 24 + 16 * avi->super_count;
+		patch_le32(avi, entry, (uint32_t) ((uint64_t) pos & 0xffffffff));
+		patch_le32(avi, entry + 4, (uint32_t) ((uint64_t) pos >> 32));
+		patch_le32(avi, entry + 8, size + 8);
+		patch_le32(avi, entry + 12, avi->ix_count);
+		avi->super_count++;
+		patch_le32(avi, avi->indx_pos + 4, avi->super_count);
+	}
+	else if(avi->super_count == AVI_SUPER_INDEX_ENTRIES)
+	{
+		fprintf(stderr, "GUVCMJPG: avi super index is full - remaining frames will not be indexed\n");
+		avi->super_count++;
+	}
+
+	avi->ix_count = 0;
+}
+
+/*
+ * close the current RIFF segment
+ *   (the first one also gets the legacy idx1 index)
+ * args:
+ *   avi - pointer to avi writer
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+static void end_riff(avi_writer_t *avi)
+{
+	flush_std_index(avi);
+	end_list(avi, avi->movi_pos);
+
+	if(avi->riff_count == 1)
+	{
+		put_le32(avi, AVI_FOURCC('i','d','x','1'));
+		put_le32(avi, 16 * avi->idx1_count);
+
+		uint32_t i = 0;
+		for(i = 0; i < avi->idx1_count; i++)
+		{
+			put_le32(avi, AVI_FOURCC('0','0','d','c'));
+			put_le32(avi, avi->idx1[i].size ? AVIIF_KEYFRAME : 0);
+			put_le32(avi, avi->idx1[i].offset);
+			put_le32(avi, avi->idx1[i].size);
+		}
+
+		free(avi->idx1);
+		avi->idx1 = NULL;
+		avi->idx1_count = 0;
+		avi->idx1_max = 0;
+	}
+
+	end_list(avi, avi->riff_pos);
+}
+
+/*
+ * write a single video chunk (starts a new RIFF segment if needed)
+ * args:
+ *   avi - pointer to avi writer
+ *   data - pointer to chunk data
+ *   size - chunk data size (0 for a dropped frame)
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+static void write_chunk(avi_writer_t *avi, const uint8_t *data, uint32_t size)
+{
+	off_t pos = ftello(avi->file);
+
+	/*reserve room for the index chunks that still go into this segment*/
+	off_t reserve = 32 + 8 * (avi->ix_count + 1);
+	if(avi->riff_count == 1)
+		reserve += 8 + 16 * (avi->idx1_count + 1);
+
+	if(pos + 8 + size + 1 + reserve - avi->riff_pos > AVI_RIFF_MAX)
+	{
+		end_riff(avi);
+		avi->riff_pos = start_list(avi, AVI_FOURCC('R','I','F','F'), AVI_FOURCC('A','V','I','X'));
+		avi->movi_pos = start_list(avi, AVI_FOURCC('L','I','S','T'), AVI_FOURCC('m','o','v','i'));
+		avi->riff_count++;
+
+		if(debug_level > 1)
+			printf("GUVCMJPG: avi - starting RIFF segment %i\n", avi->riff_count);
+
+		pos = ftello(avi->file);
+	}
+
+	put_le32(avi, AVI_FOURCC('0','0','d','c'));
+	put_le32(avi, size);
+	if(size > 0 && fwrite(data, 1, size, avi->file) != size)
+		avi->error = 1;
+	if(size & 1)
+		fputc(0, avi->file);
+
+	if(avi->riff_count == 1)
+	{
+		if(avi->idx1_count >= avi->idx1_max)
+		{
+			avi->idx1_max = avi->idx1_max ? avi->idx1_max * 2 : 4096;
+			avi->idx1 = realloc(avi->idx1, avi->idx1_max * sizeof(avi_index_entry_t));
+			if(avi->idx1 == NULL)
+			{
+				fprintf(stderr, "GUVCMJPG: FATAL memory allocation failure (avi_writer idx1): %s\n", strerror(errno));
+				exit(-1);
+			}
+		}
+		avi->idx1[avi->idx1_count].offset = (uint32_t) (pos - avi->movi_pos - 8);
+		avi->idx1[avi->idx1_count].size = size;
+		avi->idx1_count++;
+		avi->riff1_frames++;
+	}
+
+	avi->ix[avi->ix_count].offset = (uint32_t) (pos + 8 - avi->movi_pos);
+	avi->ix[avi->ix_count].size = size ? size : AVI_DELTA_FRAME;
+	avi->ix_count++;
+
+	avi->frames++;
+	avi->bytes += size;
+	if(size > avi->max_chunk_size)
+		avi->max_chunk_size = size;
+
+	if(avi->ix_count >= AVI_STD_INDEX_FRAMES)
+		flush_std_index(avi);
+}
+
+/*
+ * opens an avi file for writing a single video stream
+ * args:
+ *   filename - output file name
+ *   fourcc - stream compression fourcc (e.g. V4L2_PIX_FMT_MJPEG)
+ *   width - frame width
+ *   height - frame height
+ *   fps_num - nominal frame interval numerator (as in v4l2 timeperframe)
+ *   fps_denom - nominal frame interval denominator
+ *
+ * asserts:
+ *   filename is not null
+ *
+ * returns: pointer to avi writer (NULL on error)
+ */
+avi_writer_t *avi_writer_open(const char *filename,
+	uint32_t fourcc,
+	int width,
+	int height,
+	int fps_num,
+	int fps_denom)
+{
+	/*assertions*/
+	assert(filename != NULL);
+
+	avi_writer_t *avi = calloc(1, sizeof(avi_writer_t));
+	if(avi == NULL)
+	{
+		fprintf(stderr, "GUVCMJPG: FATAL memory allocation failure (avi_writer_open): %s\n", strerror(errno));
+		exit(-1);
+	}
+
+	avi->file = fopen(filename, "wb");
+	if(avi->file == NULL)
+	{
+		fprintf(stderr, "GUVCMJPG: couldn't open %s for write: %s\n", filename, strerror(errno));
+		free(avi);
+		return NULL;
+	}
+
+	/*frames are large, sequential writes: use a big stdio buffer*/
+	avi->file_buffer = malloc(AVI_WRITE_BUFFER_SIZE);
+	if(avi->file_buffer != NULL)
+		setvbuf(avi->file, avi->file_buffer, _IOFBF, AVI_WRITE_BUFFER_SIZE);
+
+	if(fps_num <= 0 || fps_denom <= 0)
+	{
+		fps_num = 1;
+		fps_denom = 25;
+	}
+
+	avi->fourcc = fourcc;
+	avi->width = width;
+	avi->height = height;
+	avi->fps_num = fps_num;
+	avi->fps_denom = fps_denom;
+	avi->frame_duration = ((uint64_t) fps_num * NSEC_PER_SEC) / fps_denom;
+
+	write_headers(avi);
+
+	if(avi->error)
+	{
+		fprintf(stderr, "GUVCMJPG: error writing avi headers to %s\n", filename);
+		fclose(avi->file);
+		free(avi->file_buffer);
+		free(avi);
+		return NULL;
+	}
+
+	if(debug_level > 0)
+		printf("GUVCMJPG: recording %ix%i (%i/%i fps) to %s\n",
+			width, height, fps_denom, fps_num, filename);
+
+	return avi;
+}
+
+/*
+ * writes a frame to the avi file
+ *   gaps in the capture timestamps (dropped frames) are padded
+ *   with empty chunks so that the constant rate stream stays
+ *   in sync with the capture clock
+ * args:
+ *   avi - pointer to avi writer
+ *   data - pointer to frame data
+ *   size - frame data size
+ *   timestamp - frame capture timestamp (ns)
+ *
+ * asserts:
+ *   avi is not null
+ *
+ * returns: error code (E_OK)
+ */
+int avi_writer_add_frame(avi_writer_t *avi, const uint8_t *data, uint32_t size, uint64_t timestamp)
+{
+	/*assertions*/
+	assert(avi != NULL);
+
+	if(avi->error)
+		return E_FILE_IO_ERR;
+
+	if(avi->frames == 0)
+		avi->first_ts = timestamp;
+	else if(timestamp > avi->last_ts)
+	{
+		/*number of frame intervals since the last frame (rounded)*/
+		uint64_t slots = (timestamp - avi->last_ts + avi->frame_duration / 2) / avi->frame_duration;
+		if(slots > AVI_MAX_PADDING)
+			slots = AVI_MAX_PADDING;
+
+		for(; slots > 1; slots--)
+		{
+			write_chunk(avi, NULL, 0);
+			avi->padded++;
+		}
+	}
+
+	avi->last_ts = timestamp;
+
+	write_chunk(avi, data, size);
+
+	if(avi->error)
+	{
+		fprintf(stderr, "GUVCMJPG: error writing avi frame: %s\n", strerror(errno));
+		return E_FILE_IO_ERR;
+	}
+
+	return E_OK;
+}
+
+/*
+ * gets the number of video chunks written (including padding)
+ * args:
+ *   avi - pointer to avi writer
+ *
+ * asserts:
+ *   avi is not null
+ *
+ * returns: number of frames
+ */
+uint32_t avi_writer_get_frames(avi_writer_t *avi)
+{
+	/*assertions*/
+	assert(avi != NULL);
+
+	return avi->frames;
+}
+
+/*
+ * writes the remaining index data, patches the headers
+ *   and closes the avi file
+ * args:
+ *   avi - pointer to avi writer
+ *
+ * asserts:
+ *   none
+ *
+ * returns: error code (E_OK)
+ */
+int avi_writer_close(avi_writer_t *avi)
+{
+	if(avi == NULL)
+		return E_OK;
+
+	end_riff(avi);
+
+	/*
+	 * the header rate is the nominal one unless the capture
+	 * timestamps show the camera running at a different rate
+	 */
+	uint32_t scale = avi->fps_num;
+	uint32_t rate = avi->fps_denom;
+	uint64_t interval = avi->frame_duration;
+	if(avi->frames > 1 && avi->last_ts > avi->first_ts)
+	{
+		uint64_t measured = (avi->last_ts - avi->first_ts) / (avi->frames - 1);
+		uint64_t diff = (measured > interval) ? measured - interval : interval - measured;
+		if(diff * 100 > interval)
+		{
+			interval = measured;
+			scale = (uint32_t) ((interval + 500) / 1000);
+			rate = 1000000;
+		}
+	}
+
+	uint64_t duration = interval * avi->frames;
+	uint32_t bytes_per_sec = duration ? (uint32_t) ((avi->bytes * NSEC_PER_SEC) / duration) : 0;
+	uint32_t buffer_size = avi->max_chunk_size + 8;
+
+	patch_le32(avi, avi->avih_pos, (uint32_t) (interval / 1000));
+	patch_le32(avi, avi->avih_pos + 4, bytes_per_sec);
+	patch_le32(avi, avi->avih_pos + 16, avi->riff1_frames);
+	patch_le32(avi, avi->avih_pos + 28, buffer_size);
+
+	patch_le32(avi, avi->strh_pos + 20, scale);
+	patch_le32(avi, avi->strh_pos + 24, rate);
+	patch_le32(avi, avi->strh_pos + 32, avi->frames);
+	patch_le32(avi, avi->strh_pos + 36, buffer_size);
+
+	patch_le32(avi, avi->dmlh_pos, avi->frames);
+
+	if(fclose(avi->file) != 0)
+		avi->error = 1;
+
+	int ret = avi->error ? E_FILE_IO_ERR : E_OK;
+
+	if(ret != E_OK)
+		fprintf(stderr, "GUVCMJPG: error closing avi file\n");
+	else if(debug_level > 0)
+		printf("GUVCMJPG: avi closed - %u frames (%u padded for drops) in %i RIFF segment(s)\n",
+			avi->frames, avi->padded, avi->riff_count);
+
+	free(avi->file_buffer);
+	free(avi->idx1);
+	free(avi);
+
+	return ret;
+}
@@ -0,0 +1,101 @@
+/*******************************************************************************#
+#           guvcview              http://guvcview.sourceforge.net               #
+#                                                                               #
+#           Paulo Assis <pj.assis@gmail.com>                                    #
+#                                                                               #
+# This program is free software; you can redistribute it and/or modify          #
+# it under the terms of the GNU General Public License as published by          #
+# the Free Software Foundation; either version 2 of the License, or             #
+# (at your option) any later version.                                           #
+#                                                                               #
+# This program is distributed in the hope that it will be useful,               #
+# but WITHOUT ANY WARRANTY; without even the implied warranty of                #
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 #
+# GNU General Public License for more details.                                  #
+#                                                                               #
+# You should have received a copy of the GNU General Public License             #
+# along with this program; if not, write to the Free Software                   #
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA     #
+#                                                                               #
+********************************************************************************/
+#ifndef AVI_WRITER_H
+#define AVI_WRITER_H
+
+#include <inttypes.h>
+#include <sys/types.h>
+
+/*
+ * OpenDML (AVI 2.0) writer for compressed video streams
+ *   frames are written as is (no transcoding) and the
+ *   stream index is written incrementally, so that a
+ *   recording is seekable up to the last index flush
+ *   even if the application dies before closing it
+ */
+typedef struct _avi_writer_t avi_writer_t;
+
+/*
+ * opens an avi file for writing a single video stream
+ * args:
+ *   filename - output file name
+ *   fourcc - stream compression fourcc (e.g. V4L2_PIX_FMT_MJPEG)
+ *   width - frame width
+ *   height - frame height
+ *   fps_num - nominal frame interval numerator (as in v4l2 timeperframe)
+ *   fps_denom - nominal frame interval denominator
+ *
+ * asserts:
+ *   filename is not null
+ *
+ * returns: pointer to avi writer (NULL on error)
+ */
+avi_writer_t *avi_writer_open(const char *filename,
+	uint32_t fourcc,
+	int width,
+	int height,
+	int fps_num,
+	int fps_denom);
+
+/*
+ * writes a frame to the avi file
+ *   gaps in the capture timestamps (dropped frames) are padded
+ *   with empty chunks so that the constant rate stream stays
+ *   in sync with the capture clock
+ * args:
+ *   avi - pointer to avi writer
+ *   data - pointer to frame data
+ *   size - frame data size
+ *   timestamp - frame capture timestamp (ns)
+ *
+ * asserts:
+ *   avi is not null
+ *
+ * returns: error code (E_OK)
+ */
+int avi_writer_add_frame(avi_writer_t *avi, const uint8_t *data, uint32_t size, uint64_t timestamp);
+
+/*
+ * gets the number of video chunks written (including padding)
+ * args:
+ *   avi - pointer to avi writer
+ *
+ * asserts:
+ *   avi is not null
+ *
+ * returns: number of frames
+ */
+uint32_t avi_writer_get_frames(avi_writer_t *avi);
+
+/*
+ * writes the remaining index data, patches the headers
+ *   and closes the avi file
+ * args:
+ *   avi - pointer to avi writer
+ *
+ * asserts:
+ *   none
+ *
+ * returns: error code (E_OK)
+ */
+int avi_writer_close(avi_writer_t *avi);
+
+#endif
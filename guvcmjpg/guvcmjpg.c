@@ -92,6 +92,13 @@ int main(int argc, char *argv[])
 	
 	if(my_options->disable_libv4l2)
 		v4l2core_disable_libv4l2();
+
+	/*
+	 * decoding pipeline: one frame per decoder thread
+	 * plus the one being rendered
+	 */
+	if(my_options->decoder_threads > 0)
+		v4l2core_set_frame_queue_size(my_options->decoder_threads + 1);
 	/*init the device list*/
 	v4l2core_init_device_list();
 	/*init the v4l2core (redefines language catalog)*/
@@ -105,13 +112,57 @@ int main(int argc, char *argv[])
 	}
 	else		
 		set_render_flag(render);
+
+	/*driver buffers (adaptive: grow on frame drops)*/
+	if(my_options->buffers < 0)
+		v4l2core_set_adaptive_buffers(NB_BUFFER_MIN, NB_BUFFER_MAX);
+	else if(my_options->buffers > 0)
+		v4l2core_set_buffer_count(my_options->buffers);
+
+	/*mjpeg band decoding (frames with restart markers), raw bayer and yuv bands*/
+	if(my_options->band_threads > 0)
+	{
+		v4l2core_set_jpeg_band_threads(my_options->band_threads);
+		v4l2core_set_bayer_threads(my_options->band_threads);
+		v4l2core_set_convert_threads(my_options->band_threads);
+	}
+
+	/*scaled down (dct) mjpeg preview*/
+	if(my_options->preview_scale > 1)
+		v4l2core_set_preview_scale(my_options->preview_scale);
+
+	/*latest frame wins (skip stale frames)*/
+	if(my_options->low_latency > 0)
+		v4l2core_set_low_latency(1);
+
+	/*16 bit luma (Y10B/Y16)*/
+	if(my_options->luma16 > 0)
+		v4l2core_set_luma16_mode(1);
+
+	/*per stage latency histograms*/
+	if(my_options->latency > 0)
+		v4l2core_set_latency_stats(1, my_options->latency);
 	
-	/*select capture method*/
+	/*select capture method (command line overrides config)*/
+	if(strlen(my_options->capture) > 0)
+		strncpy(my_config->capture, my_options->capture, 4);
+
 	if(strcasecmp(my_config->capture, "read") == 0)
 		v4l2core_set_capture_method(IO_READ);
+	else if(strcasecmp(my_config->capture, "user") == 0)
+		v4l2core_set_capture_method(IO_USERPTR);
 	else
 		v4l2core_set_capture_method(IO_MMAP);
 
+	/*replay file mode (only used if the device is a replay file)*/
+	if(strlen(my_options->replay) > 0)
+	{
+		int replay_flags = strstr(my_options->replay, "fast") ? 0 : REPLAY_TIMED;
+		if(strstr(my_options->replay, "loop"))
+			replay_flags |= REPLAY_LOOP;
+		v4l2core_set_replay_flags(replay_flags);
+	}
+
 	/*set software autofocus sort method*/
 	v4l2core_soft_autofocus_set_sort(AUTOF_SORT_INSERT);
 
@@ -157,6 +208,10 @@ int main(int argc, char *argv[])
 		return -1;
 	}
 
+	/*dump the raw frames for later replay*/
+	if(my_options->replay_record != NULL)
+		v4l2core_start_replay_record(my_options->replay_record);
+
 	capture_loop_data_t cl_data;
 	cl_data.options = (void *) my_options;
 	cl_data.config = (void *) my_config;
@@ -74,14 +74,14 @@ static opt_values_t opt_values[] =
 		.opt_long = "device",
 		.req_arg = 1,
 		.opt_help_arg = N_("DEVICE"),
-		.opt_help = N_("Set device name (def: /dev/video0)"),
+		.opt_help = N_("Set device name or replay file (def: /dev/video0)"),
 	},
 	{
 		.opt_short = 'c',
 		.opt_long = "capture",
 		.req_arg = 1,
 		.opt_help_arg = N_("METHOD"),
-		.opt_help = N_("Set capture method [read | mmap (def)]"),
+		.opt_help = N_("Set capture method [read | mmap (def) | user]"),
 	},
 	{
 		.opt_short = 'b',
@@ -165,7 +165,7 @@ static opt_values_t opt_values[] =
 		.opt_long = "video",
 		.req_arg = 1,
 		.opt_help_arg = N_("FILENAME"),
-		.opt_help = N_("filename for captured video)")
+		.opt_help = N_("filename for captured video (MJPG stream stored as is in an AVI file)")
 	},
 	{
 		.opt_short = 'i',
@@ -202,6 +202,69 @@ static opt_values_t opt_values[] =
 		.opt_help_arg = "",
 		.opt_help = N_("Start in control panel mode")
 	},
+	{
+		.opt_short = 'e',
+		.opt_long = "decoder_threads",
+		.req_arg = 1,
+		.opt_help_arg = N_("THREADS"),
+		.opt_help = N_("number of frame decoder threads (def: 0 - decode in capture thread)")
+	},
+	{
+		.opt_short = 'B',
+		.opt_long = "band_threads",
+		.req_arg = 1,
+		.opt_help_arg = N_("THREADS"),
+		.opt_help = N_("threads decoding each frame in bands (mjpeg needs restart markers)")
+	},
+	{
+		.opt_short = 'P',
+		.opt_long = "preview_scale",
+		.req_arg = 1,
+		.opt_help_arg = N_("DENOM"),
+		.opt_help = N_("decode the mjpeg preview at 1/DENOM size [1 (def) | 2 | 4 | 8]")
+	},
+	{
+		.opt_short = 'L',
+		.opt_long = "low_latency",
+		.req_arg = 0,
+		.opt_help_arg = "",
+		.opt_help = N_("show only the newest frame (skip stale frames if decoding falls behind)")
+	},
+	{
+		.opt_short = 'Y',
+		.opt_long = "luma16",
+		.req_arg = 0,
+		.opt_help_arg = "",
+		.opt_help = N_("keep the full 16 bit luma of Y10B/Y16 frames")
+	},
+	{
+		.opt_short = 's',
+		.opt_long = "buffers",
+		.req_arg = 1,
+		.opt_help_arg = N_("COUNT|auto"),
+		.opt_help = N_("number of driver buffers (auto - adapt to frame drops)")
+	},
+	{
+		.opt_short = 'l',
+		.opt_long = "latency",
+		.req_arg = 1,
+		.opt_help_arg = N_("SECONDS"),
+		.opt_help = N_("record per stage latency histograms and print them every SECONDS")
+	},
+	{
+		.opt_short = 'R',
+		.opt_long = "replay",
+		.req_arg = 1,
+		.opt_help_arg = N_("MODE"),
+		.opt_help = N_("replay file mode [timed (def) | fast] (add ,loop to restart at end of file)")
+	},
+	{
+		.opt_short = 'W',
+		.opt_long = "record_replay",
+		.req_arg = 1,
+		.opt_help_arg = N_("FILE"),
+		.opt_help = N_("record raw frames to a replay file (replay it with -d FILE)")
+	},
 	{
 		.opt_short = 0,
 		.opt_long = "",
@@ -239,6 +302,15 @@ static options_t my_options =
 	.photo_timer = 0,
 	.photo_npics = 0,
 	.render_flag = "none",
+	.decoder_threads = 0,
+	.band_threads = 0,
+	.preview_scale = 1,
+	.low_latency = 0,
+	.luma16 = 0,
+	.buffers = 0,
+	.latency = 0,
+	.replay = "",
+	.replay_record = NULL,
 };
 
 /*
@@ -452,7 +524,7 @@ int options_parse(int argc, char *argv[])
 			{
 				int str_size = strlen(optarg);
 				if(str_size > 1) /*device needs at least 2 chars*/
-					strncpy(my_options.device, optarg, 29);
+					strncpy(my_options.device, optarg, sizeof(my_options.device) - 1);
 				else
 					fprintf(stderr, "V4L2_CORE: (options) Error in device usage: -d[--device] DEVICENAME \n");
 				break;
@@ -624,6 +696,50 @@ int options_parse(int argc, char *argv[])
 			case 'n':
 				my_options.photo_npics = atoi(optarg);
 				break;
+			case 'e':
+				my_options.decoder_threads = atoi(optarg);
+				if(my_options.decoder_threads < 0)
+					my_options.decoder_threads = 0;
+				break;
+			case 'B':
+				my_options.band_threads = atoi(optarg);
+				if(my_options.band_threads < 0)
+					my_options.band_threads = 0;
+				break;
+			case 'P':
+				my_options.preview_scale = atoi(optarg);
+				if(my_options.preview_scale < 1)
+					my_options.preview_scale = 1;
+				break;
+			case 'L':
+				my_options.low_latency = 1;
+				break;
+			case 'Y':
+				my_options.luma16 = 1;
+				break;
+			case 's':
+				if(strcmp(optarg, "auto") == 0)
+					my_options.buffers = -1;
+				else
+				{
+					my_options.buffers = atoi(optarg);
+					if(my_options.buffers < 0)
+						my_options.buffers = 0;
+				}
+				break;
+			case 'l':
+				my_options.latency = atoi(optarg);
+				if(my_options.latency < 0)
+					my_options.latency = 0;
+				break;
+			case 'R':
+				strncpy(my_options.replay, optarg, sizeof(my_options.replay) - 1);
+				break;
+			case 'W':
+				if(my_options.replay_record != NULL)
+					free(my_options.replay_record);
+				my_options.replay_record = strdup(optarg);
+				break;
 			default:
 			case 'h':
 				opt_print_help();
@@ -674,4 +790,8 @@ void options_clean()
 	if(my_options.photo_path != NULL)
 		free(my_options.photo_path);
 	my_options.photo_path = NULL;
+
+	if(my_options.replay_record != NULL)
+		free(my_options.replay_record);
+	my_options.replay_record = NULL;
 }
@@ -24,6 +24,7 @@
 #include <sys/types.h>
 #include <sys/syscall.h>
 #include <time.h>
+#include <inttypes.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <linux/videodev2.h>
@@ -41,6 +42,7 @@
 #include "options.h"
 #include "core_io.h"
 #include "config.h"
+#include "avi_writer.h"
 
 /*flags*/
 extern int debug_level;
@@ -49,10 +51,13 @@ static int render = RENDER_SDL; /*render API*/
 static int quit = 0; /*terminate flag*/
 
 static uint64_t my_photo_timer = 0; /*timer count*/
+static int my_photo_request = 0; /*save the next frame to a photo file*/
 
 static uint64_t my_video_timer = 0; /*timer count*/
 static uint64_t my_video_begin_time = 0; /*first video frame ts*/
 
+static avi_writer_t *my_avi = NULL; /*passthrough video recording*/
+
 static int restart = 0; /*restart flag*/
 
 static char render_caption[64]; /*render window caption*/
@@ -123,6 +128,272 @@ void set_soft_focus(int value)
 void request_format_update()
 {
 	restart = 1;
+	/*don't wait for the next frame*/
+	v4l2core_wakeup();
+}
+
+/*
+ * checks if photo timed capture is on
+ * args:
+ *    none
+ *
+ * asserts:
+ *    none
+ *
+ * returns: 1 if on; 0 if off
+ */
+int check_photo_timer()
+{
+	return ( (my_photo_timer > 0) ? 1 : 0 );
+}
+
+/*
+ * stops the photo timed capture
+ * args:
+ *    none
+ *
+ * asserts:
+ *    none
+ *
+ * returns: none
+ */
+void stop_photo_timer()
+{
+	my_photo_timer = 0;
+	v4l2core_set_timer(0);
+}
+
+/*
+ * get the image format from the photo file extension
+ * args:
+ *    filename - photo file name
+ *
+ * asserts:
+ *    filename is not null
+ *
+ * returns: image format (IMG_FMT_JPG if the extension is unknown)
+ */
+static int get_photo_format(const char *filename)
+{
+	int format = IMG_FMT_JPG;
+	char *ext = get_file_extension(filename);
+
+	if(ext == NULL)
+		return format;
+
+	if(strcasecmp(ext, "png") == 0)
+		format = IMG_FMT_PNG;
+	else if(strcasecmp(ext, "bmp") == 0)
+		format = IMG_FMT_BMP;
+	else if(strcasecmp(ext, "raw") == 0)
+		format = IMG_FMT_RAW;
+
+	free(ext);
+	return format;
+}
+
+/*
+ * save the frame to a new photo file (name-<suffix>.ext)
+ *   encoding and writing are done by the core image writer thread
+ * args:
+ *    options - pointer to options data
+ *    frame - pointer to decoded frame
+ *
+ * asserts:
+ *    options is not null
+ *    frame is not null
+ *
+ * returns: error code
+ */
+static int save_photo(options_t *options, v4l2_frame_buff_t *frame)
+{
+	/*assertions*/
+	assert(options != NULL);
+	assert(frame != NULL);
+
+	const char *path = (options->photo_path != NULL) ? options->photo_path : ".";
+	char *name = NULL;
+
+	/*add_file_suffix needs an extension*/
+	if(options->photo_name == NULL)
+		name = strdup("my_photo.jpg");
+	else if(strrchr(options->photo_name, '.') == NULL)
+		name = set_file_extension(options->photo_name, "jpg");
+	else
+		name = strdup(options->photo_name);
+
+	char *suffixed_name = add_file_suffix(path, name);
+	char *filename = smart_cat(path, '/', suffixed_name);
+
+	int ret = v4l2core_save_image(frame, filename, get_photo_format(name));
+
+	if(debug_level > 1)
+		printf("GUVCMJPG: saving photo to %s (%i)\n", filename, ret);
+
+	free(filename);
+	free(suffixed_name);
+	free(name);
+
+	return ret;
+}
+
+/*
+ * checks if video timed capture is on
+ * args:
+ *    none
+ *
+ * asserts:
+ *    none
+ *
+ * returns: 1 if on; 0 if off
+ */
+int check_video_timer()
+{
+	return ( (my_video_timer > 0) ? 1 : 0 );
+}
+
+/*
+ * reset video timer
+ * args:
+ *   none
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+void reset_video_timer()
+{
+	my_video_timer = 0;
+	my_video_begin_time = 0;
+}
+
+/*
+ * get encoder status
+ * args:
+ *    none
+ *
+ * asserts:
+ *    none
+ *
+ * returns: encoder status (1 -running; 0 -not started)
+ */
+int get_encoder_status()
+{
+	return ( (my_avi != NULL) ? 1 : 0 );
+}
+
+/*
+ * starts the video recording
+ *   only compressed (MJPEG) streams are supported: the raw
+ *   frame payloads are stored as is (no decoding or transcoding)
+ * args:
+ *    options - pointer to options data
+ *
+ * asserts:
+ *    options is not null
+ *
+ * returns: error code
+ */
+static int start_video_capture(options_t *options)
+{
+	/*assertions*/
+	assert(options != NULL);
+
+	if(my_avi != NULL)
+		return E_OK;
+
+	if(v4l2core_get_requested_frame_format() != V4L2_PIX_FMT_MJPEG)
+	{
+		fprintf(stderr, "GUVCMJPG: video recording requires a MJPG stream (passthrough only) - not recording\n");
+		return E_FORMAT_ERR;
+	}
+
+	if(strlen(options->video_codec) > 0 && strcasecmp(options->video_codec, "mjpg") != 0)
+		fprintf(stderr, "GUVCMJPG: video codec '%s' not supported - storing the MJPG stream as is\n",
+			options->video_codec);
+
+	char *filename = NULL;
+	if(options->video_path != NULL)
+		filename = smart_cat(options->video_path, '/', options->video_name);
+	else
+		filename = strdup(options->video_name);
+
+	my_avi = avi_writer_open(filename,
+		V4L2_PIX_FMT_MJPEG,
+		v4l2core_get_frame_width(),
+		v4l2core_get_frame_height(),
+		v4l2core_get_fps_num(),
+		v4l2core_get_fps_denom());
+
+	free(filename);
+
+	if(my_avi == NULL)
+		return E_FILE_IO_ERR;
+
+	my_video_begin_time = 0;
+	if(options->video_timer > 0)
+		my_video_timer = NSEC_PER_SEC * options->video_timer;
+
+	return E_OK;
+}
+
+/*
+ * stops the video recording (closes the video file)
+ * args:
+ *    none
+ *
+ * asserts:
+ *    none
+ *
+ * returns: none
+ */
+static void stop_video_capture()
+{
+	if(my_avi == NULL)
+		return;
+
+	avi_writer_close(my_avi);
+	my_avi = NULL;
+
+	reset_video_timer();
+}
+
+/*
+ * stores the frame in the video file and checks the video timer
+ * args:
+ *    frame - pointer to frame buffer
+ *
+ * asserts:
+ *    frame is not null
+ *
+ * returns: none
+ */
+static void video_capture_frame(v4l2_frame_buff_t *frame)
+{
+	/*assertions*/
+	assert(frame != NULL);
+
+	if(my_avi == NULL || frame->raw_frame_size == 0)
+		return;
+
+	if(my_video_begin_time == 0)
+		my_video_begin_time = frame->timestamp;
+
+	if(avi_writer_add_frame(my_avi, frame->raw_frame, frame->raw_frame_size, frame->timestamp) != E_OK)
+	{
+		fprintf(stderr, "GUVCMJPG: video recording failed - stopping\n");
+		stop_video_capture();
+		return;
+	}
+
+	if(my_video_timer > 0 && frame->timestamp - my_video_begin_time >= my_video_timer)
+	{
+		if(debug_level > 0)
+			printf("GUVCMJPG: video timer expired - stopping video capture\n");
+		stop_video_capture();
+		quit = 1;
+	}
 }
 
 /*
@@ -158,7 +429,6 @@ void *capture_loop(void *data)
 	options_t *my_options = (options_t *) cl_data->options;
 	//config_t *my_config = (config_t *) cl_data->config;
 
-	uint64_t my_last_photo_time = 0; /*timer count*/
 	int my_photo_npics = 0;/*no npics*/
 
 	/*reset quit flag*/
@@ -180,22 +450,35 @@ void *capture_loop(void *data)
 	
 	render_set_verbosity(debug_level);
 	
-	if(render_init(render, v4l2core_get_frame_width(), v4l2core_get_frame_height(), render_flags) < 0)
+	if(render_init(render, v4l2core_get_preview_width(), v4l2core_get_preview_height(), render_flags) < 0)
 		render = RENDER_NONE;
 	else
 		render_set_event_callback(EV_QUIT, &quit_callback, NULL);
 
-	/*add a photo capture timer*/
+	/*add a photo capture timer (expirations are collected by the core event loop)*/
 	if(my_options->photo_timer > 0)
 	{
 		my_photo_timer = NSEC_PER_SEC * my_options->photo_timer;
-		my_last_photo_time = v4l2core_time_get_timestamp(); /*timer count*/
+		v4l2core_set_timer(my_photo_timer);
 	}
 
 	if(my_options->photo_npics > 0)
 		my_photo_npics = my_options->photo_npics;
 
+	/*no timer: a single photo of the first frame*/
+	my_photo_request = (my_options->photo_name != NULL && my_photo_timer == 0) ? 1 : 0;
+
 	v4l2core_start_stream();
+
+	if(my_options->decoder_threads > 0)
+	{
+		/*only the preview is used by default: decode it at the preview size*/
+		v4l2core_set_pipeline_preview(render != RENDER_NONE);
+		v4l2core_start_pipeline(my_options->decoder_threads);
+	}
+
+	if(my_options->video_name != NULL)
+		start_video_capture(my_options);
 	
 	v4l2_frame_buff_t *frame = NULL; //pointer to frame buffer
 
@@ -204,6 +487,15 @@ void *capture_loop(void *data)
 		if(restart)
 		{
 			restart = 0; /*reset*/
+
+			/*the avi stream can't change format*/
+			if(get_encoder_status())
+			{
+				fprintf(stderr, "GUVCMJPG: stream format changed - stopping video capture\n");
+				stop_video_capture();
+			}
+
+			v4l2core_stop_pipeline();
 			v4l2core_stop_stream();
 
 			/*close render*/
@@ -231,7 +523,7 @@ void *capture_loop(void *data)
 			}
 
 			/*restart the render with new format*/
-			if(render_init(render, v4l2core_get_frame_width(), v4l2core_get_frame_height(), render_flags) < 0)
+			if(render_init(render, v4l2core_get_preview_width(), v4l2core_get_preview_height(), render_flags) < 0)
 				render = RENDER_NONE;
 			else
 				render_set_event_callback(EV_QUIT, &quit_callback, NULL);
@@ -241,15 +533,83 @@ void *capture_loop(void *data)
 
 			v4l2core_start_stream();
 
+			if(my_options->decoder_threads > 0)
+			{
+				v4l2core_set_pipeline_preview(render != RENDER_NONE);
+				v4l2core_start_pipeline(my_options->decoder_threads);
+			}
 		}
 
-		frame = v4l2core_get_decoded_frame();
+		/*
+		 * nothing to display: when only recording skip the decoder
+		 * (the pipeline, if running, owns the dequeue side)
+		 */
+		if(render == RENDER_NONE && get_encoder_status() &&
+			!do_soft_autofocus && !do_soft_focus &&
+			!check_photo_timer() && !my_photo_request &&
+			my_options->decoder_threads <= 0)
+		{
+			frame = v4l2core_get_frame();
+			if(frame != NULL)
+			{
+				video_capture_frame(frame);
+				v4l2core_release_frame(frame);
+			}
+			/*replay file ended (not looping): nothing else to capture*/
+			else if(v4l2core_is_replay_eof())
+				quit = 1;
+			continue;
+		}
+
+		/*photo timer expirations are collected by the core event loop*/
+		if(check_photo_timer() && v4l2core_get_timer_expirations() > 0)
+			my_photo_request = 1;
+
+		/*
+		 * the decoded frame is only displayed: decode it
+		 * straight into the render buffer (saves a frame copy)
+		 */
+		int direct = (render != RENDER_NONE &&
+			!do_soft_autofocus && !do_soft_focus && !my_photo_request &&
+			my_options->decoder_threads <= 0);
+
+		frame = direct ? v4l2core_get_frame() : v4l2core_get_decoded_frame();
+
+		/*replay file ended (not looping): nothing else to capture*/
+		if(frame == NULL && v4l2core_is_replay_eof())
+		{
+			quit = 1;
+			continue;
+		}
 		if( frame != NULL)
 		{
+			/*store the compressed frame (before any further processing)*/
+			video_capture_frame(frame);
+
+			/*the pipeline decoded a preview size frame: decode the full frame*/
+			if(frame->yuv_scale > 1 &&
+				(do_soft_autofocus || do_soft_focus || my_photo_request))
+				v4l2core_decode_frame(frame, NULL, NULL);
+
 			/*run software autofocus (must be called after frame was grabbed and decoded)*/
 			if(do_soft_autofocus || do_soft_focus)
 				do_soft_focus = v4l2core_soft_autofocus_run(frame);
 
+			if(my_photo_request)
+			{
+				my_photo_request = 0;
+				/*the frame is copied: encoding and writing are done in the background*/
+				save_photo(my_options, frame);
+
+				if(my_photo_npics > 0 && --my_photo_npics == 0 && check_photo_timer())
+				{
+					stop_photo_timer();
+					/*nothing else to do*/
+					if(render == RENDER_NONE && !get_encoder_status())
+						quit = 1;
+				}
+			}
+
 			/*render the decoded frame*/
             cur_fps = v4l2core_get_realfps();
             if (last_fps != cur_fps) {
@@ -260,15 +620,61 @@ void *capture_loop(void *data)
                     snprintf(render_caption, 63, "Guvcmjpg ver:%s - %s - %dx%d (%2.2f fps) - seq: %d",  VERSION, my_options->format, v4l2core_get_frame_width(), v4l2core_get_frame_height(), cur_fps, v);
                 render_set_caption(render_caption);
                 v++;
+
+                if(debug_level > 1)
+                {
+                    v4l2_stream_stats_t stats;
+                    v4l2core_get_stream_stats(&stats);
+                    printf("GUVCMJPG: frames:%"PRIu64" dropped:%"PRIu64" corrupt:%"PRIu64" skipped:%"PRIu64" jitter:%"PRIu64" us (max %"PRIu64") dequeue delay:%"PRIu64" us (max %"PRIu64")\n",
+                        stats.frames, stats.dropped, stats.corrupt, stats.skipped,
+                        stats.jitter / 1000, stats.max_jitter / 1000,
+                        stats.dequeue_delay / 1000, stats.max_dequeue_delay / 1000);
+                }
             }
-			render_frame(frame->yuv_frame);
+			uint8_t *planes[3] = {NULL, NULL, NULL};
+			int pitches[3] = {0, 0, 0};
+			/*
+			 * a raw frame is decoded (at the preview size) straight into
+			 * the render buffer, a full size decoded frame is decimated
+			 * into it and a preview size decoded frame is rendered as is
+			 */
+			int scaled = (v4l2core_get_preview_width() != v4l2core_get_frame_width());
+			int preview = (scaled && frame->yuv_scale > 1);
+			int locked = (direct || (scaled && !preview)) && render_lock_frame(planes, pitches) == 0;
+			if(locked && direct)
+				v4l2core_decode_frame(frame, planes, pitches);
+			else if(locked)
+				v4l2core_copy_frame(frame, planes, pitches);
+			else if(direct)
+			{
+				/*the render buffer is not available: decode at the preview size*/
+				v4l2core_decode_preview_frame(frame);
+				preview = scaled;
+			}
+
+			uint64_t render_ts = (my_options->latency > 0) ? v4l2core_time_get_timestamp() : 0;
+			if(locked)
+				render_unlock_frame();
+			else if(!scaled || preview)
+				render_frame(frame->yuv_frame);
+			if(render_ts > 0)
+				v4l2core_record_latency(LATENCY_RENDER, v4l2core_time_get_timestamp() - render_ts);
 
 			/*we are done with the frame buffer release it*/
 			v4l2core_release_frame(frame);
 		}
 	}
 
+	stop_video_capture();
+
+	v4l2core_stop_pipeline();
 	v4l2core_stop_stream();
+
+	if(my_options->latency > 0)
+		v4l2core_print_latency_stats();
+
+	/*wait for any pending photos*/
+	v4l2core_save_image_flush();
 	
 	render_close();
 
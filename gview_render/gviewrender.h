@@ -132,6 +132,35 @@ void render_set_caption(const char* caption);
  */
 int render_frame(uint8_t *frame);
 
+/*
+ * lock the render frame buffer for direct writing
+ *   the frame is then decoded straight into the render planes
+ *   (no copy) and displayed with render_unlock_frame
+ * args:
+ *   planes - array of 3 plane pointers (filled with the render planes)
+ *   pitches - array of 3 plane pitches (filled with the render pitches)
+ *
+ * asserts:
+ *   planes is not null
+ *   pitches is not null
+ *
+ * returns: error code (0 - locked; -1 - not supported by the render)
+ */
+int render_lock_frame(uint8_t **planes, int *pitches);
+
+/*
+ * unlock and display the render frame buffer
+ *   (locked with render_lock_frame)
+ * args:
+ *   none
+ *
+ * asserts:
+ *   none
+ *
+ * returns: error code
+ */
+int render_unlock_frame();
+
 /*
  * get event index on render_events_list
  * args:
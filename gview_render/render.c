@@ -186,6 +186,74 @@ int render_frame(uint8_t *frame)
 	return ret;
 }
 
+/*
+ * lock the render frame buffer for direct writing
+ *   the frame is then decoded straight into the render planes
+ *   (no copy) and displayed with render_unlock_frame
+ * args:
+ *   planes - array of 3 plane pointers (filled with the render planes)
+ *   pitches - array of 3 plane pitches (filled with the render pitches)
+ *
+ * asserts:
+ *   planes is not null
+ *   pitches is not null
+ *
+ * returns: error code (0 - locked; -1 - not supported by the render)
+ */
+int render_lock_frame(uint8_t **planes, int *pitches)
+{
+	/*asserts*/
+	assert(planes != NULL);
+	assert(pitches != NULL);
+
+	int ret = -1;
+	switch(render_api)
+	{
+		case RENDER_NONE:
+			break;
+
+		case RENDER_SDL:
+		default:
+			#if !ENABLE_SDL2
+			ret = render_sdl1_lock_frame(planes, pitches);
+			#endif
+			break;
+	}
+
+	return ret;
+}
+
+/*
+ * unlock and display the render frame buffer
+ *   (locked with render_lock_frame)
+ * args:
+ *   none
+ *
+ * asserts:
+ *   none
+ *
+ * returns: error code
+ */
+int render_unlock_frame()
+{
+	int ret = 0;
+	switch(render_api)
+	{
+		case RENDER_NONE:
+			break;
+
+		case RENDER_SDL:
+		default:
+			#if !ENABLE_SDL2
+			ret = render_sdl1_unlock_frame();
+			render_sdl1_dispatch_events();
+			#endif
+			break;
+	}
+
+	return ret;
+}
+
 /*
  * set event callback
  * args:
@@ -285,6 +285,67 @@ int render_sdl1_frame(uint8_t *frame, int width, int height)
      SDL_DisplayYUVOverlay(poverlay, &drect);
 }
 
+/*
+ * lock the overlay and get its planes
+ *   so that a frame can be decoded straight into it
+ * args:
+ *   planes - array of 3 plane pointers (filled with the overlay planes)
+ *   pitches - array of 3 plane pitches (filled with the overlay pitches)
+ *
+ * asserts:
+ *   poverlay is not null
+ *   planes is not null
+ *   pitches is not null
+ *
+ * returns: error code (0 ok)
+ */
+int render_sdl1_lock_frame(uint8_t **planes, int *pitches)
+{
+	/*asserts*/
+	assert(poverlay != NULL);
+	assert(planes != NULL);
+	assert(pitches != NULL);
+
+	if(SDL_LockYUVOverlay(poverlay) < 0)
+		return -1;
+
+	int i = 0;
+	for(i = 0; i < 3; i++)
+	{
+		if(i < poverlay->planes)
+		{
+			planes[i] = (uint8_t *) poverlay->pixels[i];
+			pitches[i] = poverlay->pitches[i];
+		}
+		else
+		{
+			planes[i] = NULL;
+			pitches[i] = 0;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * unlock the overlay (locked with render_sdl1_lock_frame) and display it
+ * args:
+ *   none
+ *
+ * asserts:
+ *   poverlay is not null
+ *
+ * returns: error code (0 ok)
+ */
+int render_sdl1_unlock_frame()
+{
+	/*asserts*/
+	assert(poverlay != NULL);
+
+	SDL_UnlockYUVOverlay(poverlay);
+	return SDL_DisplayYUVOverlay(poverlay, &drect);
+}
+
 /*
  * set sdl1 render caption
  * args:
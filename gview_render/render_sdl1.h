@@ -54,6 +54,34 @@ int init_render_sdl1(int width, int height, int flags);
  */
 int render_sdl1_frame(uint8_t *frame, int width, int height);
 
+/*
+ * lock the overlay and get its planes
+ *   so that a frame can be decoded straight into it
+ * args:
+ *   planes - array of 3 plane pointers (filled with the overlay planes)
+ *   pitches - array of 3 plane pitches (filled with the overlay pitches)
+ *
+ * asserts:
+ *   poverlay is not null
+ *   planes is not null
+ *   pitches is not null
+ *
+ * returns: error code (0 ok)
+ */
+int render_sdl1_lock_frame(uint8_t **planes, int *pitches);
+
+/*
+ * unlock the overlay (locked with render_sdl1_lock_frame) and display it
+ * args:
+ *   none
+ *
+ * asserts:
+ *   poverlay is not null
+ *
+ * returns: error code (0 ok)
+ */
+int render_sdl1_unlock_frame();
+
 /*
  * set sdl1 render caption
  * args:
@@ -0,0 +1,368 @@
+/*******************************************************************************#
+#           guvcview              http://guvcview.sourceforge.net               #
+#                                                                               #
+#           Paulo Assis <pj.assis@gmail.com>                                    #
+#                                                                               #
+# This program is free software; you can redistribute it and/or modify          #
+# it under the terms of the GNU General Public License as published by          #
+# the Free Software Foundation; either version 2 of the License, or             #
+# (at your option) any later version.                                           #
+#                                                                               #
+# This program is distributed in the hope that it will be useful,               #
+# but WITHOUT ANY WARRANTY; without even the implied warranty of                #
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 #
+# GNU General Public License for more details.                                  #
+#                                                                               #
+# You should have received a copy of the GNU General Public License             #
+# along with this program; if not, write to the Free Software                   #
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA     #
+#                                                                               #
+********************************************************************************/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+
+#include "gviewv4l2core.h"
+#include "band_executor.h"
+#include "gview.h"
+
+extern int verbosity;
+
+/*
+ * band worker thread data
+ */
+typedef struct _band_worker_t
+{
+	band_executor_t *exec; //executor
+	int id;                //worker index (1..nthreads)
+} band_worker_t;
+
+struct _band_executor_t
+{
+	int nthreads_req;      //requested worker threads (started on first job)
+	__THREAD_TYPE threads[BAND_EXECUTOR_MAX_THREADS];
+	band_worker_t workers[BAND_EXECUTOR_MAX_THREADS];
+	int nthreads;          //number of worker threads running
+	int quit;              //set to 1 to stop the worker threads
+	int busy;              //a job is running
+
+	band_func_t func;      //current job
+	void *data;            //current job data
+	int height;            //current job rows
+	int band_rows;         //rows per band
+	int nbands;            //number of bands of the current job
+	int next;              //next band to run
+	int pending;           //bands not yet done
+
+	__MUTEX_TYPE mutex;
+	__COND_TYPE cond;
+};
+
+/*
+ * take the next band of the current job and run it
+ *   (must be called with the executor mutex locked, returns locked)
+ * args:
+ *    exec - pointer to band executor
+ *    worker - worker index
+ *
+ * asserts:
+ *    none
+ *
+ * returns: none
+ */
+static void run_next_band(band_executor_t *exec, int worker)
+{
+	int row0 = exec->next * exec->band_rows;
+	int row1 = row0 + exec->band_rows;
+	if(row1 > exec->height)
+		row1 = exec->height;
+	exec->next++;
+	__UNLOCK_MUTEX(&exec->mutex);
+
+	exec->func(exec->data, row0, row1, worker);
+
+	__LOCK_MUTEX(&exec->mutex);
+	if(--exec->pending == 0)
+		__COND_BCAST(&exec->cond);
+}
+
+/*
+ * band worker thread
+ * args:
+ *    data - pointer to band worker data
+ *
+ * asserts:
+ *    none
+ *
+ * returns: NULL
+ */
+static void *band_worker(void *data)
+{
+	band_worker_t *worker = (band_worker_t *) data;
+	band_executor_t *exec = worker->exec;
+
+	__LOCK_MUTEX(&exec->mutex);
+	while(1)
+	{
+		while(!exec->quit && exec->next >= exec->nbands)
+			__COND_WAIT(&exec->cond, &exec->mutex);
+
+		if(exec->quit)
+			break;
+
+		run_next_band(exec, worker->id);
+	}
+	__UNLOCK_MUTEX(&exec->mutex);
+
+	return NULL;
+}
+
+/*
+ * stop the worker threads
+ * args:
+ *    exec - pointer to band executor
+ *
+ * asserts:
+ *    none
+ *
+ * returns: none
+ */
+static void stop_workers(band_executor_t *exec)
+{
+	/*a job in progress is finished by its caller*/
+	__LOCK_MUTEX(&exec->mutex);
+	int nthreads = exec->nthreads;
+	exec->nthreads = 0;
+	exec->quit = 1;
+	__COND_BCAST(&exec->cond);
+	__UNLOCK_MUTEX(&exec->mutex);
+
+	int i = 0;
+	for(i = 0; i < nthreads; i++)
+		__THREAD_JOIN(exec->threads[i]);
+
+	__LOCK_MUTEX(&exec->mutex);
+	exec->quit = 0;
+	__UNLOCK_MUTEX(&exec->mutex);
+}
+
+/*
+ * start the requested worker threads
+ *   (must be called with the executor mutex locked)
+ * args:
+ *    exec - pointer to band executor
+ *
+ * asserts:
+ *    none
+ *
+ * returns: none
+ */
+static void start_workers(band_executor_t *exec)
+{
+	while(exec->nthreads < exec->nthreads_req)
+	{
+		band_worker_t *worker = &exec->workers[exec->nthreads];
+		worker->exec = exec;
+		worker->id = exec->nthreads + 1;
+		if(__THREAD_CREATE(&exec->threads[exec->nthreads], band_worker, (void *) worker))
+		{
+			fprintf(stderr, "V4L2_CORE: (band executor) couldn't create band thread %i\n", exec->nthreads);
+			/*don't retry on every job*/
+			exec->nthreads_req = exec->nthreads;
+			break;
+		}
+		exec->nthreads++;
+	}
+
+	if(verbosity > 0)
+		printf("V4L2_CORE: (band executor) %i band threads\n", exec->nthreads);
+}
+
+/*
+ * create a band executor
+ * args:
+ *    none
+ *
+ * asserts:
+ *    none
+ *
+ * returns: pointer to newly allocated band executor
+ */
+band_executor_t *band_executor_create()
+{
+	band_executor_t *exec = calloc(1, sizeof(band_executor_t));
+	if (exec == NULL)
+	{
+		fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (band_executor_create): %s\n", strerror(errno));
+		exit(-1);
+	}
+
+	__INIT_MUTEX(&exec->mutex);
+	__INIT_COND(&exec->cond);
+
+	return exec;
+}
+
+/*
+ * set the number of band worker threads
+ *   (started when the first job runs)
+ * args:
+ *    exec - pointer to band executor
+ *    nthreads - number of worker threads (0 - run in the calling thread)
+ *
+ * asserts:
+ *    exec is not null
+ *
+ * returns: none
+ */
+void band_executor_set_threads(band_executor_t *exec, int nthreads)
+{
+	/*asserts*/
+	assert(exec != NULL);
+
+	if(nthreads < 0)
+		nthreads = 0;
+	if(nthreads > BAND_EXECUTOR_MAX_THREADS)
+		nthreads = BAND_EXECUTOR_MAX_THREADS;
+
+	stop_workers(exec);
+
+	__LOCK_MUTEX(&exec->mutex);
+	exec->nthreads_req = nthreads;
+	__UNLOCK_MUTEX(&exec->mutex);
+}
+
+/*
+ * get the number of band worker threads (requested)
+ * args:
+ *    exec - pointer to band executor
+ *
+ * asserts:
+ *    exec is not null
+ *
+ * returns: number of worker threads
+ */
+int band_executor_get_threads(band_executor_t *exec)
+{
+	/*asserts*/
+	assert(exec != NULL);
+
+	__LOCK_MUTEX(&exec->mutex);
+	int nthreads = exec->nthreads_req;
+	__UNLOCK_MUTEX(&exec->mutex);
+
+	return nthreads;
+}
+
+/*
+ * run a job split in horizontal bands of rows
+ * args:
+ *    exec - pointer to band executor
+ *    func - band function
+ *    data - band function data
+ *    height - number of rows
+ *    row_align - band rows are a multiple of row_align (e.g. 2 for 4:2:0)
+ *    bytes_per_row - input + output bytes per row (band size)
+ *
+ * asserts:
+ *    exec is not null
+ *    func is not null
+ *
+ * returns: none
+ */
+void band_executor_run(band_executor_t *exec, band_func_t func, void *data,
+	int height, int row_align, int bytes_per_row)
+{
+	/*asserts*/
+	assert(exec != NULL);
+	assert(func != NULL);
+
+	if(height <= 0)
+		return;
+	if(row_align < 1)
+		row_align = 1;
+
+	__LOCK_MUTEX(&exec->mutex);
+	/*
+	 * the executor is serving another job: run it in the calling thread
+	 * (worker -1: it must not use the per worker data of the owning job)
+	 */
+	if(exec->busy)
+	{
+		__UNLOCK_MUTEX(&exec->mutex);
+		func(data, 0, height, -1);
+		return;
+	}
+	exec->busy = 1;
+
+	/*no worker threads: the owning caller runs the whole job*/
+	if(exec->nthreads_req == 0)
+	{
+		__UNLOCK_MUTEX(&exec->mutex);
+		func(data, 0, height, 0);
+		__LOCK_MUTEX(&exec->mutex);
+		exec->busy = 0;
+		__UNLOCK_MUTEX(&exec->mutex);
+		return;
+	}
+	if(exec->nthreads < exec->nthreads_req)
+		start_workers(exec);
+	int nthreads = exec->nthreads;
+
+	/*cache sized bands, but enough of them to keep all threads busy*/
+	int band_rows = BAND_EXECUTOR_BAND_BYTES / (bytes_per_row > 0 ? bytes_per_row : 1);
+	int max_rows = (height + nthreads) / (nthreads + 1);
+	if(band_rows > max_rows)
+		band_rows = max_rows;
+	band_rows -= band_rows % row_align;
+	if(band_rows < row_align)
+		band_rows = row_align;
+
+	exec->func = func;
+	exec->data = data;
+	exec->height = height;
+	exec->band_rows = band_rows;
+	exec->nbands = (height + band_rows - 1) / band_rows;
+	exec->next = 0;
+	exec->pending = exec->nbands;
+	if(exec->nbands > 1)
+		__COND_BCAST(&exec->cond);
+
+	/*the calling thread runs bands too*/
+	while(exec->next < exec->nbands)
+		run_next_band(exec, 0);
+	while(exec->pending > 0)
+		__COND_WAIT(&exec->cond, &exec->mutex);
+
+	exec->nbands = 0;
+	exec->next = 0;
+	exec->busy = 0;
+	__UNLOCK_MUTEX(&exec->mutex);
+}
+
+/*
+ * destroy the band executor
+ * args:
+ *    exec - pointer to band executor
+ *
+ * asserts:
+ *    none
+ *
+ * returns: none
+ */
+void band_executor_destroy(band_executor_t *exec)
+{
+	if (exec == NULL)
+		return;
+
+	stop_workers(exec);
+
+	__CLOSE_COND(&exec->cond);
+	__CLOSE_MUTEX(&exec->mutex);
+
+	free(exec);
+}
@@ -0,0 +1,119 @@
+/*******************************************************************************#
+#           guvcview              http://guvcview.sourceforge.net               #
+#                                                                               #
+#           Paulo Assis <pj.assis@gmail.com>                                    #
+#                                                                               #
+# This program is free software; you can redistribute it and/or modify          #
+# it under the terms of the GNU General Public License as published by          #
+# the Free Software Foundation; either version 2 of the License, or             #
+# (at your option) any later version.                                           #
+#                                                                               #
+# This program is distributed in the hope that it will be useful,               #
+# but WITHOUT ANY WARRANTY; without even the implied warranty of                #
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 #
+# GNU General Public License for more details.                                  #
+#                                                                               #
+# You should have received a copy of the GNU General Public License             #
+# along with this program; if not, write to the Free Software                   #
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA     #
+#                                                                               #
+********************************************************************************/
+
+
+#ifndef BAND_EXECUTOR_H
+#define BAND_EXECUTOR_H
+
+#include <inttypes.h>
+
+/*maximum number of band worker threads (the calling thread also runs bands)*/
+#define BAND_EXECUTOR_MAX_THREADS 15
+
+/*target working set (input + output bytes) of a single band*/
+#define BAND_EXECUTOR_BAND_BYTES (256 * 1024)
+
+typedef struct _band_executor_t band_executor_t;
+
+/*
+ * band function: processes frame rows [row0, row1)
+ *   worker is the index of the thread running the band
+ *   (0 - calling thread, 1..nthreads - band worker threads,
+ *   -1 - calling thread while the executor is busy with another job)
+ */
+typedef void (*band_func_t)(void *data, int row0, int row1, int worker);
+
+/*
+ * create a band executor
+ *   the worker threads are only started when the first job runs
+ * args:
+ *    none
+ *
+ * asserts:
+ *    none
+ *
+ * returns: pointer to newly allocated band executor
+ */
+band_executor_t *band_executor_create();
+
+/*
+ * set the number of band worker threads
+ * args:
+ *    exec - pointer to band executor
+ *    nthreads - number of worker threads (0 - run in the calling thread)
+ *
+ * asserts:
+ *    exec is not null
+ *
+ * returns: none
+ */
+void band_executor_set_threads(band_executor_t *exec, int nthreads);
+
+/*
+ * get the number of band worker threads (requested)
+ * args:
+ *    exec - pointer to band executor
+ *
+ * asserts:
+ *    exec is not null
+ *
+ * returns: number of worker threads
+ */
+int band_executor_get_threads(band_executor_t *exec);
+
+/*
+ * run a job split in horizontal bands of rows
+ *   bands are sized for a BAND_EXECUTOR_BAND_BYTES working set and
+ *   picked up by the worker threads and the calling thread; returns
+ *   when all bands are done. If the executor is already running a
+ *   job (another caller) the whole job runs in the calling thread
+ *   as worker -1 (even with no worker threads: worker 0 data is only
+ *   used by one caller at a time).
+ * args:
+ *    exec - pointer to band executor
+ *    func - band function
+ *    data - band function data
+ *    height - number of rows
+ *    row_align - band rows are a multiple of row_align (e.g. 2 for 4:2:0)
+ *    bytes_per_row - input + output bytes per row (band size)
+ *
+ * asserts:
+ *    exec is not null
+ *    func is not null
+ *
+ * returns: none
+ */
+void band_executor_run(band_executor_t *exec, band_func_t func, void *data,
+	int height, int row_align, int bytes_per_row);
+
+/*
+ * destroy the band executor (stops the worker threads)
+ * args:
+ *    exec - pointer to band executor
+ *
+ * asserts:
+ *    none
+ *
+ * returns: none
+ */
+void band_executor_destroy(band_executor_t *exec);
+
+#endif
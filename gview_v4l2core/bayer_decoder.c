@@ -0,0 +1,319 @@
+/*******************************************************************************#
+#           guvcview              http://guvcview.sourceforge.net               #
+#                                                                               #
+#           Paulo Assis <pj.assis@gmail.com>                                    #
+#                                                                               #
+# This program is free software; you can redistribute it and/or modify          #
+# it under the terms of the GNU General Public License as published by          #
+# the Free Software Foundation; either version 2 of the License, or             #
+# (at your option) any later version.                                           #
+#                                                                               #
+# This program is distributed in the hope that it will be useful,               #
+# but WITHOUT ANY WARRANTY; without even the implied warranty of                #
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 #
+# GNU General Public License for more details.                                  #
+#                                                                               #
+# You should have received a copy of the GNU General Public License             #
+# along with this program; if not, write to the Free Software                   #
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA     #
+#                                                                               #
+********************************************************************************/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+
+#include "gviewv4l2core.h"
+#include "bayer_decoder.h"
+#include "colorspaces_simd.h"
+#include "gview.h"
+
+extern int verbosity;
+
+/*
+ * bayer frame (decoder input and output)
+ */
+typedef struct _bayer_frame_t
+{
+	const uint8_t *in;   //raw bayer data
+	uint8_t *planes[3];  //output yu12 planes
+	int strides[3];      //output plane strides
+	int width;           //frame width
+	int height;          //frame height
+	int pix_order;       //bayer pixel order (0 to 3)
+} bayer_frame_t;
+
+/*
+ * rgb rows for a pair of frame rows (per band thread)
+ */
+typedef struct _bayer_stripe_t
+{
+	uint8_t *buf;        //rgb rows for a pair of rows (6 * width)
+	size_t buf_size;     //buf allocated size
+} bayer_stripe_t;
+
+struct _bayer_decoder_context_t
+{
+	band_executor_t *exec; //device band executor (NULL - no stripe threads)
+	bayer_stripe_t stripes[BAND_EXECUTOR_MAX_THREADS + 1]; //one per band thread
+};
+
+/*
+ * bayer frame decoded in stripes (band executor job)
+ */
+typedef struct _bayer_job_t
+{
+	bayer_decoder_context_t *bayer_ctx;
+	bayer_frame_t frame;
+} bayer_job_t;
+
+/*
+ * make sure the stripe rgb buffer fits a frame row pair
+ * args:
+ *    stripe - pointer to stripe
+ *    width - frame width
+ *
+ * asserts:
+ *    none
+ *
+ * returns: none
+ */
+static void stripe_alloc(bayer_stripe_t *stripe, int width)
+{
+	size_t size = (size_t) width * 6;
+
+	if(size <= stripe->buf_size)
+		return;
+
+	free(stripe->buf);
+	stripe->buf = malloc(size);
+	if(stripe->buf == NULL)
+	{
+		fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (bayer decoder): %s\n", strerror(errno));
+		exit(-1);
+	}
+	stripe->buf_size = size;
+}
+
+/*
+ * decode a stripe of rows: each pair of bayer rows is demosaiced
+ *   into planar rgb rows (cache resident) and converted to yu12
+ * args:
+ *    frame - pointer to bayer frame
+ *    stripe - pointer to stripe (rgb rows)
+ *    row0 - first row (even)
+ *    row1 - last row (exclusive, even)
+ *
+ * asserts:
+ *    none
+ *
+ * returns: none
+ */
+static void decode_stripe(const bayer_frame_t *frame, bayer_stripe_t *stripe, int row0, int row1)
+{
+	const cs_kernels_t *k = get_cs_kernels();
+
+	int width = frame->width;
+	int height = frame->height;
+
+	/*even rows: start with green (gb/rg and gr/bg) and have red samples (gr/bg and rg/bg)*/
+	int g_first_even = (frame->pix_order == 0 || frame->pix_order == 1);
+	int red_even = (frame->pix_order == 1 || frame->pix_order == 3);
+
+	uint8_t *rgb[2][3];
+	int i = 0, j = 0;
+	for(i = 0; i < 2; i++)
+		for(j = 0; j < 3; j++)
+			rgb[i][j] = stripe->buf + (i * 3 + j) * width;
+
+	int y = 0;
+	for(y = row0; y < row1; y += 2)
+	{
+		for(i = 0; i < 2; i++)
+		{
+			int row = y + i;
+			/*mirrored borders (keeps the bayer parity)*/
+			int row_up = (row > 0) ? row - 1 : 1;
+			int row_dn = (row < height - 1) ? row + 1 : height - 2;
+			int even = ((row & 1) == 0);
+			int g_first = even ? g_first_even : !g_first_even;
+			int red_row = even ? red_even : !red_even;
+
+			k->bayer_row(rgb[i][1],
+				red_row ? rgb[i][0] : rgb[i][2],
+				red_row ? rgb[i][2] : rgb[i][0],
+				frame->in + row_up * width,
+				frame->in + row * width,
+				frame->in + row_dn * width,
+				width, g_first);
+		}
+
+		k->rgb_rows_to_yu12(
+			frame->planes[0] + y * frame->strides[0],
+			frame->planes[0] + (y + 1) * frame->strides[0],
+			frame->planes[1] + (y / 2) * frame->strides[1],
+			frame->planes[2] + (y / 2) * frame->strides[2],
+			rgb[0][0], rgb[0][1], rgb[0][2],
+			rgb[1][0], rgb[1][1], rgb[1][2], width);
+	}
+}
+
+/*
+ * band function: decode a stripe of rows
+ * args:
+ *    data - pointer to bayer job
+ *    row0 - first row (even)
+ *    row1 - last row (exclusive, even)
+ *    worker - band thread index (-1 - not a band thread)
+ *
+ * asserts:
+ *    none
+ *
+ * returns: none
+ */
+static void decode_band(void *data, int row0, int row1, int worker)
+{
+	bayer_job_t *job = (bayer_job_t *) data;
+	const bayer_frame_t *frame = &job->frame;
+
+	if(worker < 0)
+	{
+		bayer_stripe_t stripe;
+		memset(&stripe, 0, sizeof(bayer_stripe_t));
+		stripe_alloc(&stripe, frame->width);
+		decode_stripe(frame, &stripe, row0, row1);
+		free(stripe.buf);
+		return;
+	}
+
+	bayer_stripe_t *stripe = &job->bayer_ctx->stripes[worker];
+	stripe_alloc(stripe, frame->width);
+	decode_stripe(frame, stripe, row0, row1);
+}
+
+/*
+ * init the raw bayer decoder context
+ * args:
+ *    none
+ *
+ * asserts:
+ *    none
+ *
+ * returns: pointer to newly allocated decoder context
+ */
+bayer_decoder_context_t *bayer_init_decoder()
+{
+	bayer_decoder_context_t *bayer_ctx = calloc(1, sizeof(bayer_decoder_context_t));
+	if (bayer_ctx == NULL)
+	{
+		fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (bayer_init_decoder): %s\n", strerror(errno));
+		exit(-1);
+	}
+
+	return bayer_ctx;
+}
+
+/*
+ * set the band executor for stripe decoding
+ * args:
+ *    bayer_ctx - pointer to decoder context
+ *    exec - pointer to band executor (NULL - decode in the calling thread)
+ *
+ * asserts:
+ *    bayer_ctx is not null
+ *
+ * returns: none
+ */
+void bayer_decoder_set_executor(bayer_decoder_context_t *bayer_ctx, band_executor_t *exec)
+{
+	/*asserts*/
+	assert(bayer_ctx != NULL);
+
+	bayer_ctx->exec = exec;
+}
+
+/*
+ * decode raw 8 bit bayer straight into yu12 planes
+ * args:
+ *    bayer_ctx - pointer to decoder context
+ *    planes - output planes (y, u, v)
+ *    strides - output plane strides
+ *    in_buf - pointer to raw bayer data (width * height bytes)
+ *    width - frame width (even)
+ *    height - frame height (even)
+ *    pix_order - bayer pixel order (0=gb/rg   1=gr/bg  2=bg/gr  3=rg/bg)
+ *
+ * asserts:
+ *    bayer_ctx is not null
+ *    planes is not null
+ *    strides is not null
+ *    in_buf is not null
+ *
+ * returns: error code (0 - E_OK)
+ */
+int bayer_decode(bayer_decoder_context_t *bayer_ctx, uint8_t **planes, int *strides,
+	const uint8_t *in_buf, int width, int height, int pix_order)
+{
+	/*asserts*/
+	assert(bayer_ctx != NULL);
+	assert(planes != NULL);
+	assert(strides != NULL);
+	assert(in_buf != NULL);
+
+	if(width < 2 || height < 2)
+		return E_BAD_WIDTH_OR_HEIGHT_ERR;
+
+	bayer_job_t job;
+	job.bayer_ctx = bayer_ctx;
+	job.frame.in = in_buf;
+	job.frame.width = width;
+	job.frame.height = height;
+	job.frame.pix_order = (pix_order >= 0 && pix_order <= 3) ? pix_order : 0;
+	int i = 0;
+	for(i = 0; i < 3; i++)
+	{
+		job.frame.planes[i] = planes[i];
+		job.frame.strides[i] = strides[i];
+	}
+
+	/*
+	 * no stripe threads: decode in the calling thread (not as worker 0,
+	 * concurrent decoder threads would share its stripe)
+	 */
+	if(bayer_ctx->exec == NULL)
+	{
+		decode_band(&job, 0, height & ~1, -1);
+		return E_OK;
+	}
+
+	/*stripes of whole row pairs: 1 byte in + 1.5 bytes out per pixel*/
+	band_executor_run(bayer_ctx->exec, decode_band, &job,
+		height & ~1, 2, (width * 5) / 2);
+
+	return E_OK;
+}
+
+/*
+ * close the raw bayer decoder context
+ * args:
+ *    bayer_ctx - pointer to decoder context
+ *
+ * asserts:
+ *    none
+ *
+ * returns: none
+ */
+void bayer_close_decoder(bayer_decoder_context_t *bayer_ctx)
+{
+	if (bayer_ctx == NULL)
+		return;
+
+	int i = 0;
+	for(i = 0; i < BAND_EXECUTOR_MAX_THREADS + 1; i++)
+		free(bayer_ctx->stripes[i].buf);
+
+	free(bayer_ctx);
+}
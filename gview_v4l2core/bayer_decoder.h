@@ -0,0 +1,97 @@
+/*******************************************************************************#
+#           guvcview              http://guvcview.sourceforge.net               #
+#                                                                               #
+#           Paulo Assis <pj.assis@gmail.com>                                    #
+#                                                                               #
+# This program is free software; you can redistribute it and/or modify          #
+# it under the terms of the GNU General Public License as published by          #
+# the Free Software Foundation; either version 2 of the License, or             #
+# (at your option) any later version.                                           #
+#                                                                               #
+# This program is distributed in the hope that it will be useful,               #
+# but WITHOUT ANY WARRANTY; without even the implied warranty of                #
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 #
+# GNU General Public License for more details.                                  #
+#                                                                               #
+# You should have received a copy of the GNU General Public License             #
+# along with this program; if not, write to the Free Software                   #
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA     #
+#                                                                               #
+********************************************************************************/
+
+
+#ifndef BAYER_DECODER_H
+#define BAYER_DECODER_H
+
+#include <inttypes.h>
+
+#include "band_executor.h"
+
+typedef struct _bayer_decoder_context_t bayer_decoder_context_t;
+
+/*
+ * init the raw bayer decoder context
+ *   the context does not depend on the frame format so it is
+ *   created once and kept across format changes
+ * args:
+ *    none
+ *
+ * asserts:
+ *    none
+ *
+ * returns: pointer to newly allocated decoder context
+ */
+bayer_decoder_context_t *bayer_init_decoder();
+
+/*
+ * set the band executor for stripe decoding
+ *   frames are split in stripes of rows, decoded in parallel by
+ *   the band threads and the calling thread
+ * args:
+ *    bayer_ctx - pointer to decoder context
+ *    exec - pointer to band executor (NULL - decode in the calling thread)
+ *
+ * asserts:
+ *    bayer_ctx is not null
+ *
+ * returns: none
+ */
+void bayer_decoder_set_executor(bayer_decoder_context_t *bayer_ctx, band_executor_t *exec);
+
+/*
+ * decode raw 8 bit bayer straight into yu12 planes (bilinear demosaic
+ *   and rgb to yuv fused per pair of rows, no intermediate rgb frame)
+ *   can be called concurrently from several decoder threads
+ * args:
+ *    bayer_ctx - pointer to decoder context
+ *    planes - output planes (y, u, v)
+ *    strides - output plane strides
+ *    in_buf - pointer to raw bayer data (width * height bytes)
+ *    width - frame width (even)
+ *    height - frame height (even)
+ *    pix_order - bayer pixel order (0=gb/rg   1=gr/bg  2=bg/gr  3=rg/bg)
+ *
+ * asserts:
+ *    bayer_ctx is not null
+ *    planes is not null
+ *    strides is not null
+ *    in_buf is not null
+ *
+ * returns: error code (0 - E_OK)
+ */
+int bayer_decode(bayer_decoder_context_t *bayer_ctx, uint8_t **planes, int *strides,
+	const uint8_t *in_buf, int width, int height, int pix_order);
+
+/*
+ * close the raw bayer decoder context
+ * args:
+ *    bayer_ctx - pointer to decoder context
+ *
+ * asserts:
+ *    none
+ *
+ * returns: none
+ */
+void bayer_close_decoder(bayer_decoder_context_t *bayer_ctx);
+
+#endif
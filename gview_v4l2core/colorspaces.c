@@ -27,6 +27,9 @@
 #include <assert.h>
 
 #include "gview.h"
+#include "gviewv4l2core.h"
+#include "colorspaces.h"
+#include "colorspaces_simd.h"
 
 extern int verbosity;
 
@@ -417,6 +420,123 @@ void bayer_to_rgb24(uint8_t *pBay, uint8_t *pRGB24, int width, int height, int p
 
 /*------------------ YU12 ----------------------*/
 
+/*
+ * fill the plane pointers and pitches of a contiguous yu12 frame
+ * args:
+ *    buf - pointer to yu12 frame buffer
+ *    width - frame width
+ *    height - frame height
+ *    planes - output plane pointers (y, u, v)
+ *    pitches - output plane pitches
+ *
+ * asserts:
+ *    none
+ *
+ * returns: none
+ */
+static void set_yu12_planes(uint8_t *buf, int width, int height, uint8_t **planes, int *pitches)
+{
+	planes[0] = buf;
+	planes[1] = buf + (width * height);
+	planes[2] = planes[1] + ((width * height) / 4);
+	pitches[0] = width;
+	pitches[1] = width / 2;
+	pitches[2] = width / 2;
+}
+
+/*
+ * copy a plane row by row
+ * args:
+ *    out - pointer to output plane
+ *    out_pitch - output plane pitch
+ *    in - pointer to input plane
+ *    in_pitch - input plane pitch
+ *    linesize - bytes to copy per row
+ *    lines - number of rows
+ *
+ * asserts:
+ *    none
+ *
+ * returns: none
+ */
+static void copy_plane(uint8_t *out, int out_pitch, uint8_t *in, int in_pitch, int linesize, int lines)
+{
+	if(out_pitch == linesize && in_pitch == linesize)
+	{
+		memcpy(out, in, linesize * lines);
+		return;
+	}
+
+	int h = 0;
+	for(h = 0; h < lines; h++)
+		memcpy(out + (h * out_pitch), in + (h * in_pitch), linesize);
+}
+
+/*
+ * convert from packed 422 yuv (yuyv, yvyu or uyvy) to yu12 planes
+ * args:
+ *    out - output yu12 planes (y, u, v)
+ *    out_pitches - output plane pitches
+ *    in - pointer to input packed data
+ *    in_pitch - input pitch (bytes per line)
+ *    width - frame width
+ *    height - frame height
+ *    y_first - 1 for yuyv and yvyu, 0 for uyvy
+ *    swap_uv - 1 for yvyu (v sample first)
+ *
+ * asserts:
+ *    none
+ *
+ * returns: none
+ */
+static void packed422_to_yu12_planes(uint8_t **out, int *out_pitches, uint8_t *in, int in_pitch,
+	int width, int height, int y_first, int swap_uv)
+{
+	const cs_kernels_t *k = get_cs_kernels();
+
+	int h = 0;
+
+	for(h = 0; h < height; h+=2)
+	{
+		uint8_t *in1 = in + (h * in_pitch); //first line
+		uint8_t *in2 = in1 + in_pitch; //second line
+		uint8_t *py = out[0] + (h * out_pitches[0]);
+		uint8_t *pu = out[1] + ((h / 2) * out_pitches[1]);
+		uint8_t *pv = out[2] + ((h / 2) * out_pitches[2]);
+
+		/*average u and v samples*/
+		if(swap_uv)
+			k->packed422_rows(py, py + out_pitches[0], pv, pu, in1, in2, width, y_first);
+		else
+			k->packed422_rows(py, py + out_pitches[0], pu, pv, in1, in2, width, y_first);
+	}
+}
+
+/*
+ *convert from packed 422 yuv (yuyv) to 420 planar (yu12) planes
+ * args:
+ *    out - output yu12 planes (y, u, v)
+ *    out_pitches - output plane pitches
+ *    in - input planes (yuyv packed data)
+ *    in_pitches - input plane pitches (bytes per line)
+ *    width - frame width
+ *    height - frame height
+ *
+ * asserts:
+ *    in is not null
+ *    out is not null
+ *
+ * returns: none
+ */
+void yuyv_to_yu12_planes(uint8_t **out, int *out_pitches, uint8_t **in, int *in_pitches, int width, int height)
+{
+	/*assertions*/
+	assert(in);
+	assert(out);
+
+	packed422_to_yu12_planes(out, out_pitches, in[0], in_pitches[0], width, height, 1, 0);
+}
+
 /*
  *convert from packed 422 yuv (yuyv) to 420 planar (yu12)
  * args:
@@ -432,41 +552,38 @@ void bayer_to_rgb24(uint8_t *pBay, uint8_t *pRGB24, int width, int height, int p
  * returns: none
  */
 void yuyv_to_yu12(uint8_t *out, uint8_t *in, int width, int height)
+{
+	uint8_t *out_planes[3];
+	int out_pitches[3];
+	int in_pitch = width * 2;
+
+	set_yu12_planes(out, width, height, out_planes, out_pitches);
+	yuyv_to_yu12_planes(out_planes, out_pitches, &in, &in_pitch, width, height);
+}
+
+/*
+ *convert from packed 422 yuv (yvyu) to 420 planar (yu12) planes
+ * args:
+ *    out - output yu12 planes (y, u, v)
+ *    out_pitches - output plane pitches
+ *    in - input planes (yvyu packed data)
+ *    in_pitches - input plane pitches (bytes per line)
+ *    width - frame width
+ *    height - frame height
+ *
+ * asserts:
+ *    in is not null
+ *    out is not null
+ *
+ * returns: none
+ */
+void yvyu_to_yu12_planes(uint8_t **out, int *out_pitches, uint8_t **in, int *in_pitches, int width, int height)
 {
 	/*assertions*/
 	assert(in);
 	assert(out);
 
-	int w = 0, h = 0;
-	int y_sizeline = width;
-	int c_sizeline = width/2;
-	
-	uint8_t *in1 = in; //first line
-	uint8_t *in2 = in1 + (width * 2); //second line in yuyv buffer
-
-	uint8_t *py1 = out; // first line
-	uint8_t *py2 = py1 + y_sizeline; //second line
-	uint8_t *pu = py1 + (width * height);
-	uint8_t *pv = pu + ((width * height) / 4);
-
-	for(h = 0; h < height; h+=2)
-	{
-		for(w = 0; w < width; w+=2) //yuyv 2 bytes per sample
-		{
-			//printf("decoding: h:%i w:%i\n", h, w);
-			*py1++ = *in1++;
-			*py2++ = *in2++;
-			*pu++ = ((*in1++) + (*in2++)) /2; //average u samples
-			*py1++ = *in1++;
-			*py2++ = *in2++;
-			*pv++ = ((*in1++) + (*in2++)) /2; //average v samples
-		}
-		in1 = in + (h * width * 2);
-		in2 = in + ((h+1) * width * 2);
-		py1 = out + (h * width);
-		py2 = out + ((h+1) * width); 
-	}
-
+	packed422_to_yu12_planes(out, out_pitches, in[0], in_pitches[0], width, height, 1, 1);
 }
 
 /*
@@ -484,40 +601,38 @@ void yuyv_to_yu12(uint8_t *out, uint8_t *in, int width, int height)
  * returns: none
  */
 void yvyu_to_yu12(uint8_t *out, uint8_t *in, int width, int height)
+{
+	uint8_t *out_planes[3];
+	int out_pitches[3];
+	int in_pitch = width * 2;
+
+	set_yu12_planes(out, width, height, out_planes, out_pitches);
+	yvyu_to_yu12_planes(out_planes, out_pitches, &in, &in_pitch, width, height);
+}
+
+/*
+ *convert from packed 422 yuv (uyvy) to 420 planar (yu12) planes
+ * args:
+ *    out - output yu12 planes (y, u, v)
+ *    out_pitches - output plane pitches
+ *    in - input planes (uyvy packed data)
+ *    in_pitches - input plane pitches (bytes per line)
+ *    width - frame width
+ *    height - frame height
+ *
+ * asserts:
+ *    in is not null
+ *    out is not null
+ *
+ * returns: none
+ */
+void uyvy_to_yu12_planes(uint8_t **out, int *out_pitches, uint8_t **in, int *in_pitches, int width, int height)
 {
 	/*assertions*/
 	assert(in);
 	assert(out);
 
-	int w = 0, h = 0;
-	int y_sizeline = width;
-	int c_sizeline = width/2;
-	
-	uint8_t *in1 = in; //first line
-	uint8_t *in2 = in1 + (width * 2); //second line in yuyv buffer
-
-	uint8_t *py1 = out; // first line
-	uint8_t *py2 = py1 + y_sizeline; //second line
-	uint8_t *pu = py1 + (width * height);
-	uint8_t *pv = pu + ((width * height) / 4);
-
-	for(h = 0; h < height; h+=2)
-	{
-		for(w = 0; w < width*2; w++) //yuyv 2 bytes per sample
-		{
-			*py1++ = *in1++;
-			*py2++ = *in2++;
-			*pv++ = ((*in1++) + (*in2++)) /2; //average v samples
-			*py1++ = *in1++;
-			*py2++ = *in2++;
-			*pu++ = ((*in1++) + (*in2++)) /2; //average u samples
-		}
-		in1 = in + (h * width * 2);
-		in2 = in + ((h+1) * width * 2);
-		py1 = out + (h * width);
-		py2 = out + ((h+1) * width); 
-	}
-
+	packed422_to_yu12_planes(out, out_pitches, in[0], in_pitches[0], width, height, 0, 0);
 }
 
 /*
@@ -535,40 +650,54 @@ void yvyu_to_yu12(uint8_t *out, uint8_t *in, int width, int height)
  * returns: none
  */
 void uyvy_to_yu12(uint8_t *out, uint8_t *in, int width, int height)
+{
+	uint8_t *out_planes[3];
+	int out_pitches[3];
+	int in_pitch = width * 2;
+
+	set_yu12_planes(out, width, height, out_planes, out_pitches);
+	uyvy_to_yu12_planes(out_planes, out_pitches, &in, &in_pitch, width, height);
+}
+
+/*
+ *convert from 422 planar yuv to 420 planar (yu12) planes
+ * args:
+ *    out - output yu12 planes (y, u, v)
+ *    out_pitches - output plane pitches
+ *    in - input planes (y, u, v)
+ *    in_pitches - input plane pitches
+ *    width - frame width
+ *    height - frame height
+ *
+ * asserts:
+ *    in is not null
+ *    out is not null
+ *
+ * returns: none
+ */
+void yuv422p_to_yu12_planes(uint8_t **out, int *out_pitches, uint8_t **in, int *in_pitches, int width, int height)
 {
 	/*assertions*/
 	assert(in);
 	assert(out);
 
-	int w = 0, h = 0;
-	int y_sizeline = width;
-	int c_sizeline = width/2;
-	
-	uint8_t *in1 = in; //first line
-	uint8_t *in2 = in1 + (width * 2); //second line in yuyv buffer
+	const cs_kernels_t *k = get_cs_kernels();
 
-	uint8_t *py1 = out; // first line
-	uint8_t *py2 = py1 + y_sizeline; //second line
-	uint8_t *pu = py1 + (width * height);
-	uint8_t *pv = pu + ((width * height) / 4);
+	/*copy y data*/
+	copy_plane(out[0], out_pitches[0], in[0], in_pitches[0], width, height);
+
+	int h = 0;
+	int c_sizeline = width/2;
 
 	for(h = 0; h < height; h+=2)
 	{
-		for(w = 0; w < width; w+=2) //yuyv 2 bytes per sample
-		{
-			*pu++ = ((*in1++) + (*in2++)) /2; //average u samples
-			*py1++ = *in1++;
-			*py2++ = *in2++;
-			*pv++ = ((*in1++) + (*in2++)) /2; //average v samples
-			*py1++ = *in1++;
-			*py2++ = *in2++;
-		}
-		in1 = in + (h * width * 2);
-		in2 = in + ((h+1) * width * 2);
-		py1 = out + (h * width);
-		py2 = out + ((h+1) * width); 
-	}
+		uint8_t *inu = in[1] + (h * in_pitches[1]);
+		uint8_t *inv = in[2] + (h * in_pitches[2]);
 
+		/*average u and v samples*/
+		k->average_rows(out[1] + ((h / 2) * out_pitches[1]), inu, inu + in_pitches[1], c_sizeline);
+		k->average_rows(out[2] + ((h / 2) * out_pitches[2]), inv, inv + in_pitches[2], c_sizeline);
+	}
 }
 
 /*
@@ -586,38 +715,59 @@ void uyvy_to_yu12(uint8_t *out, uint8_t *in, int width, int height)
  * returns: none
  */
 void yuv422p_to_yu12(uint8_t *out, uint8_t *in, int width, int height)
+{
+	uint8_t *out_planes[3];
+	int out_pitches[3];
+	uint8_t *in_planes[3] = {in, in + (width * height), in + ((width * height * 3) / 2)};
+	int in_pitches[3] = {width, width / 2, width / 2};
+
+	set_yu12_planes(out, width, height, out_planes, out_pitches);
+	yuv422p_to_yu12_planes(out_planes, out_pitches, in_planes, in_pitches, width, height);
+}
+
+/*
+ * convert yyuv (packed) to yuv420 planar (yu12) planes
+ * args:
+ *    out: output yu12 planes (y, u, v)
+ *    out_pitches: output plane pitches
+ *    in: input planes (yyuv packed data)
+ *    in_pitches: input plane pitches (bytes per line)
+ *    width: picture width
+ *    height: picture height
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void yyuv_to_yu12_planes(uint8_t **out, int *out_pitches, uint8_t **in, int *in_pitches, int width, int height)
 {
 	/*assertions*/
 	assert(in);
 	assert(out);
 
-    /*copy y data*/
-    memcpy(out, in, width*height);
-
 	int w = 0, h = 0;
-	int c_sizeline = width/2;
-	
-	uint8_t *pu = out + (width * height);
-    uint8_t *inu1 = in + (width * height);
-    uint8_t *inu2 = inu1 + (width/2);
-
-	uint8_t *pv = pu + ((width * height) / 4);
-    uint8_t *inv1 = inu1 + ((width * height) / 2);
-    uint8_t *inv2 = inv1 + (width / 2);
 
 	for(h = 0; h < height; h+=2)
 	{
-		for(w = 0; w < width/2; w++) 
+		uint8_t *in1 = in[0] + (h * in_pitches[0]); //first line
+		uint8_t *in2 = in1 + in_pitches[0]; //second line in yyuv buffer
+		uint8_t *py1 = out[0] + (h * out_pitches[0]); // first line
+		uint8_t *py2 = py1 + out_pitches[0]; //second line
+		uint8_t *pu = out[1] + ((h / 2) * out_pitches[1]);
+		uint8_t *pv = out[2] + ((h / 2) * out_pitches[2]);
+
+		for(w = 0; w < width; w+=2) //yyuv 2 bytes per sample
 		{
-			*pu++ = ((*inu1++) + (*inu2++)) /2; //average u sample
-			*pv++ = ((*inv1++) + (*inv2++)) /2; //average v samples
+			*py1++ = *in1++;
+			*py1++ = *in1++;
+			*py2++ = *in2++;
+			*py2++ = *in2++;
+			*pu++ = ((*in1++) + (*in2++) + 1) >> 1; //average u samples
+			*pv++ = ((*in1++) + (*in2++) + 1) >> 1; //average v samples
 		}
-        inu1 = in + (width * height) + (h * c_sizeline);
-		inu2 = in + (width * height) + ((h+1) * c_sizeline);
-		inv1 = inu1 + ((width * height) / 2);
-		inv2 = inv1 + (width / 2);
 	}
-
 }
 
 /*
@@ -635,40 +785,67 @@ void yuv422p_to_yu12(uint8_t *out, uint8_t *in, int width, int height)
  * returns: none
  */
 void yyuv_to_yu12(uint8_t *out, uint8_t *in, int width, int height)
+{
+	uint8_t *out_planes[3];
+	int out_pitches[3];
+	int in_pitch = width * 2;
+
+	set_yu12_planes(out, width, height, out_planes, out_pitches);
+	yyuv_to_yu12_planes(out_planes, out_pitches, &in, &in_pitch, width, height);
+}
+
+/*
+ *copy 420 planar (yu12) planes (any pitch)
+ * args:
+ *    out - output yu12 planes (y, u, v)
+ *    out_pitches - output plane pitches
+ *    in - input yu12 planes (y, u, v)
+ *    in_pitches - input plane pitches
+ *    width - frame width
+ *    height - frame height
+ *
+ * asserts:
+ *    in is not null
+ *    out is not null
+ *
+ * returns: none
+ */
+void yu12_to_yu12_planes(uint8_t **out, int *out_pitches, uint8_t **in, int *in_pitches, int width, int height)
 {
 	/*assertions*/
 	assert(in);
 	assert(out);
 
-	int w = 0, h = 0;
-	int y_sizeline = width;
-	int c_sizeline = width/2;
-	
-	uint8_t *in1 = in; //first line
-	uint8_t *in2 = in1 + (width * 2); //second line in yyuv buffer
-
-	uint8_t *py1 = out; // first line
-	uint8_t *py2 = py1 + y_sizeline; //second line
-	uint8_t *pu = py1 + (width * height);
-	uint8_t *pv = pu + ((width * height) / 4);
+	copy_plane(out[0], out_pitches[0], in[0], in_pitches[0], width, height);
+	copy_plane(out[1], out_pitches[1], in[1], in_pitches[1], width / 2, height / 2);
+	copy_plane(out[2], out_pitches[2], in[2], in_pitches[2], width / 2, height / 2);
+}
 
-	for(h = 0; h < height; h+=2)
-	{
-		for(w = 0; w < width; w+=2) //yyuv 2 bytes per sample
-		{
-			*py1++ = *in1++;
-			*py1++ = *in1++;
-			*py2++ = *in2++;
-			*py2++ = *in2++;
-			*pu++ = ((*in1++) + (*in2++)) /2; //average v samples
-			*pv++ = ((*in1++) + (*in2++)) /2; //average u samples
-		}
-		in1 = in + (h * width * 2);
-		in2 = in + ((h+1) * width * 2);
-		py1 = out + (h * width);
-		py2 = out + ((h+1) * width); 
-	}
+/*
+ *convert from 420 planar (yv12) to 420 planar (yu12) planes
+ * args:
+ *    out - output yu12 planes (y, u, v)
+ *    out_pitches - output plane pitches
+ *    in - input yv12 planes (y, v, u)
+ *    in_pitches - input plane pitches
+ *    width - frame width
+ *    height - frame height
+ *
+ * asserts:
+ *    in is not null
+ *    out is not null
+ *
+ * returns: none
+ */
+void yv12_to_yu12_planes(uint8_t **out, int *out_pitches, uint8_t **in, int *in_pitches, int width, int height)
+{
+	/*assertions*/
+	assert(in);
+	assert(out);
 
+	copy_plane(out[0], out_pitches[0], in[0], in_pitches[0], width, height);
+	copy_plane(out[1], out_pitches[1], in[2], in_pitches[2], width / 2, height / 2);
+	copy_plane(out[2], out_pitches[2], in[1], in_pitches[1], width / 2, height / 2);
 }
 
 /*
@@ -680,23 +857,87 @@ void yyuv_to_yu12(uint8_t *out, uint8_t *in, int width, int height)
  *    height - frame height
  *
  * asserts:
- *    in is not null
+ *    in is not null
+ *    out is not null
+ *
+ * returns: none
+ */
+void yv12_to_yu12(uint8_t *out, uint8_t *in, int width, int height)
+{
+	uint8_t *out_planes[3];
+	int out_pitches[3];
+	uint8_t *in_planes[3];
+	int in_pitches[3];
+
+	set_yu12_planes(out, width, height, out_planes, out_pitches);
+	set_yu12_planes(in, width, height, in_planes, in_pitches);
+	yv12_to_yu12_planes(out_planes, out_pitches, in_planes, in_pitches, width, height);
+}
+
+/*
+ * convert nv12/nv21 (uv interleaved) planes to yu12 planes
+ * args:
+ *    out: output yu12 planes (y, u, v)
+ *    out_pitches: output plane pitches
+ *    in: input planes (y, uv)
+ *    in_pitches: input plane pitches
+ *    width: picture width
+ *    height: picture height
+ *    swap_uv: 1 for nv21 (v sample first)
+ *
+ * asserts:
+ *    none
+ *
+ * returns: none
+ */
+static void nv420_to_yu12_planes(uint8_t **out, int *out_pitches, uint8_t **in, int *in_pitches,
+	int width, int height, int swap_uv)
+{
+	const cs_kernels_t *k = get_cs_kernels();
+
+	/*copy y data*/
+	copy_plane(out[0], out_pitches[0], in[0], in_pitches[0], width, height);
+
+	uint8_t *pu = out[swap_uv ? 2 : 1];
+	uint8_t *pv = out[swap_uv ? 1 : 2];
+	int pu_pitch = out_pitches[swap_uv ? 2 : 1];
+	int pv_pitch = out_pitches[swap_uv ? 1 : 2];
+
+	/*uv plane*/
+	if(in_pitches[1] == width && pu_pitch == width / 2 && pv_pitch == width / 2)
+	{
+		k->split_uv(pu, pv, in[1], width * height / 4);
+		return;
+	}
+
+	int h = 0;
+	for(h = 0; h < height / 2; h++)
+		k->split_uv(pu + (h * pu_pitch), pv + (h * pv_pitch), in[1] + (h * in_pitches[1]), width / 2);
+}
+
+/*
+ * convert nv12 planar (uv interleaved) to yuv420 planar (yu12) planes
+ * args:
+ *    out: output yu12 planes (y, u, v)
+ *    out_pitches: output plane pitches
+ *    in: input planes (y, uv)
+ *    in_pitches: input plane pitches
+ *    width: picture width
+ *    height: picture height
+ *
+ * asserts:
  *    out is not null
+ *    in is not null
  *
  * returns: none
  */
-void yv12_to_yu12(uint8_t *out, uint8_t *in, int width, int height)
+void nv12_to_yu12_planes(uint8_t **out, int *out_pitches, uint8_t **in, int *in_pitches, int width, int height)
 {
 	/*assertions*/
 	assert(in);
 	assert(out);
 
-    /*copy y data*/
-    memcpy(out, in, width*height);
-	/*copy u data*/
-	memcpy(out+(width*height), in+((width * height * 5) / 4), width * height / 4);
-	/*copy v data*/
-	memcpy(out+((width * height * 5) / 4), in+(width * height), width * height / 4);
+	nv420_to_yu12_planes(out, out_pitches, in, in_pitches, width, height, 0);
 }
 
 /*
@@ -714,25 +955,39 @@ void yv12_to_yu12(uint8_t *out, uint8_t *in, int width, int height)
  * returns: none
  */
 void nv12_to_yu12(uint8_t *out, uint8_t *in, int width, int height)
+{
+	uint8_t *out_planes[3];
+	int out_pitches[3];
+	uint8_t *in_planes[2] = {in, in + (width * height)};
+	int in_pitches[2] = {width, width};
+
+	set_yu12_planes(out, width, height, out_planes, out_pitches);
+	nv12_to_yu12_planes(out_planes, out_pitches, in_planes, in_pitches, width, height);
+}
+
+/*
+ * convert nv21 planar (vu interleaved) to yuv420 planar (yu12) planes
+ * args:
+ *    out: output yu12 planes (y, u, v)
+ *    out_pitches: output plane pitches
+ *    in: input planes (y, vu)
+ *    in_pitches: input plane pitches
+ *    width: picture width
+ *    height: picture height
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void nv21_to_yu12_planes(uint8_t **out, int *out_pitches, uint8_t **in, int *in_pitches, int width, int height)
 {
 	/*assertions*/
 	assert(in);
 	assert(out);
 
-	/*copy y data*/
-    memcpy(out, in, width*height);
-	
-	uint8_t *puv = in + (width * height);
-	uint8_t *pu = out + (width * height);
-	uint8_t *pv = pu + ((width * height) / 4);
-
-	/*uv plane*/
-	int i = 0;
-	for(i=0; i< width * height /2; i+=2)
-	{
-		*pu++ = *puv++;
-		*pv++ = *puv++;
-	}
+	nv420_to_yu12_planes(out, out_pitches, in, in_pitches, width, height, 1);
 }
 
 /*
@@ -751,25 +1006,77 @@ void nv12_to_yu12(uint8_t *out, uint8_t *in, int width, int height)
  */
 void nv21_to_yu12(uint8_t *out, uint8_t *in, int width, int height)
 {
-	/*assertions*/
-	assert(in);
-	assert(out);
+	uint8_t *out_planes[3];
+	int out_pitches[3];
+	uint8_t *in_planes[2] = {in, in + (width * height)};
+	int in_pitches[2] = {width, width};
+
+	set_yu12_planes(out, width, height, out_planes, out_pitches);
+	nv21_to_yu12_planes(out_planes, out_pitches, in_planes, in_pitches, width, height);
+}
+
+/*
+ * convert nv16/nv61 (uv interleaved 422) planes to yu12 planes
+ * args:
+ *   out: output yu12 planes (y, u, v)
+ *   out_pitches: output plane pitches
+ *   in: input planes (y, uv)
+ *   in_pitches: input plane pitches
+ *   width: picture width
+ *   height: picture height
+ *   swap_uv: 1 for nv61 (v sample first)
+ *
+ * asserts:
+ *    none
+ *
+ * returns: none
+ */
+static void nv422_to_yu12_planes(uint8_t **out, int *out_pitches, uint8_t **in, int *in_pitches,
+	int width, int height, int swap_uv)
+{
+	const cs_kernels_t *k = get_cs_kernels();
 
 	/*copy y data*/
-    memcpy(out, in, width*height);
-	
-	uint8_t *puv = in + (width * height);
-	uint8_t *pu = out + (width * height);
-	uint8_t *pv = pu + ((width * height) / 4);
+	copy_plane(out[0], out_pitches[0], in[0], in_pitches[0], width, height);
 
-	/*uv plane*/
-	int i = 0;
-	for(i=0; i< width * height /2; i+=2)
+	int h = 0;
+	for(h=0; h < height; h+=2)
 	{
-		*pv++ = *puv++;
-		*pu++ = *puv++;
+		uint8_t *puv = in[1] + (h * in_pitches[1]);
+		uint8_t *pu = out[1] + ((h / 2) * out_pitches[1]);
+		uint8_t *pv = out[2] + ((h / 2) * out_pitches[2]);
+
+		/*average two lines*/
+		if(swap_uv)
+			k->split_uv_rows(pv, pu, puv, puv + in_pitches[1], width / 2);
+		else
+			k->split_uv_rows(pu, pv, puv, puv + in_pitches[1], width / 2);
 	}
+}
+
+/*
+ * convert yuv 422 planar (uv interleaved) (nv16) to yuv420 planar (yu12) planes
+ * args:
+ *   out: output yu12 planes (y, u, v)
+ *   out_pitches: output plane pitches
+ *   in: input planes (y, uv)
+ *   in_pitches: input plane pitches
+ *   width: picture width
+ *   height: picture height
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void nv16_to_yu12_planes(uint8_t **out, int *out_pitches, uint8_t **in, int *in_pitches, int width, int height)
+{
+	/*assertions*/
+	assert(in);
+	assert(out);
 
+	nv422_to_yu12_planes(out, out_pitches, in, in_pitches, width, height, 0);
 }
 
 /*
@@ -787,32 +1094,39 @@ void nv21_to_yu12(uint8_t *out, uint8_t *in, int width, int height)
  * returns: none
  */
 void nv16_to_yu12 (uint8_t *out, uint8_t *in, int width, int height)
+{
+	uint8_t *out_planes[3];
+	int out_pitches[3];
+	uint8_t *in_planes[2] = {in, in + (width * height)};
+	int in_pitches[2] = {width, width};
+
+	set_yu12_planes(out, width, height, out_planes, out_pitches);
+	nv16_to_yu12_planes(out_planes, out_pitches, in_planes, in_pitches, width, height);
+}
+
+/*
+ * convert yuv 422 planar (vu interleaved) (nv61) to yuv420 planar (yu12) planes
+ * args:
+ *   out: output yu12 planes (y, u, v)
+ *   out_pitches: output plane pitches
+ *   in: input planes (y, vu)
+ *   in_pitches: input plane pitches
+ *   width: picture width
+ *   height: picture height
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void nv61_to_yu12_planes(uint8_t **out, int *out_pitches, uint8_t **in, int *in_pitches, int width, int height)
 {
 	/*assertions*/
 	assert(in);
 	assert(out);
 
-	/*copy y data*/
-    memcpy(out, in, width*height);
-	
-	/*uv plane*/
-	uint8_t *puv1 = in + (width * height); //first line
-	uint8_t *puv2 = puv1 + width; //second line
-	uint8_t *pu = out + (width * height);
-	uint8_t *pv = pu + ((width * height) / 4);
-
-	int h = 0;
-	int w = 0;
-	for(h=0; h < height; h+=2)
-	{
-		for(w=0; w < width; w+=2)
-		{
-			*pu++ = ((*puv1++) + (*puv2++)) / 2; //average
-			*pv++ = ((*puv1++) + (*puv2++)) / 2; //average
-		}
-		puv1 = in + (width + height) + (h * width);
-		puv2 = puv1 + width;
-	}
+	nv422_to_yu12_planes(out, out_pitches, in, in_pitches, width, height, 1);
 }
 
 /*
@@ -830,60 +1144,70 @@ void nv16_to_yu12 (uint8_t *out, uint8_t *in, int width, int height)
  * returns: none
  */
 void nv61_to_yu12 (uint8_t *out, uint8_t *in, int width, int height)
+{
+	uint8_t *out_planes[3];
+	int out_pitches[3];
+	uint8_t *in_planes[2] = {in, in + (width * height)};
+	int in_pitches[2] = {width, width};
+
+	set_yu12_planes(out, width, height, out_planes, out_pitches);
+	nv61_to_yu12_planes(out_planes, out_pitches, in_planes, in_pitches, width, height);
+}
+/*
+ * y10b samples unpacked per chunk (multiple of 4: chunks start on a byte)
+ */
+#define Y10B_CHUNK (4096)
+
+/*
+ * unpack y10b (bit-packed array greyscale format) to 16 bit luma
+ *   (full 10 bit precision)
+ * args:
+ *   out: pointer to output buffer (width * height samples)
+ *   in: pointer to input buffer containing y10b (bit-packed array) data frame
+ *   width: picture width
+ *   height: picture height
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void y10b_to_y16(uint16_t *out, uint8_t *in, int width, int height)
 {
 	/*assertions*/
 	assert(in);
 	assert(out);
 
-	/*copy y data*/
-    memcpy(out, in, width*height);
-	
-	/*uv plane*/
-	uint8_t *puv1 = in + (width * height); //first line
-	uint8_t *puv2 = puv1 + width; //second line
-	uint8_t *pu = out + (width * height);
-	uint8_t *pv = pu + ((width * height) / 4);
-
-	int h = 0;
-	int w = 0;
-	for(h=0; h < height; h+=2)
-	{
-		for(w=0; w < width; w+=2)
-		{
-			*pv++ = ((*puv1++) + (*puv2++)) / 2; //average
-			*pu++ = ((*puv1++) + (*puv2++)) / 2; //average
-		}
-		puv1 = in + (width + height) + (h * width);
-		puv2 = puv1 + width;
-	}
+	/*rows are not byte aligned if width is not a multiple of 4: unpack as a whole*/
+	get_cs_kernels()->unpack_y10b(out, in, width * height);
 }
 
 /*
- * Unpack buffer of (vw bit) data into padded 16bit buffer.
+ * convert 16 bit luma to yu12 (8 bit display copy)
  * args:
- *    raw - pointer to input raw packed data buffer
- *    unpacked - pointer to unpacked output data buffer
- *    vw - vw bit
- *    unpacked_len - length
+ *   out: pointer to output buffer (yu12)
+ *   in: pointer to 16 bit luma samples
+ *   width: picture width
+ *   height: picture height
+ *   bits: significant bits in the luma samples (8 to 16)
  *
  * asserts:
- *    none
+ *    out is not null
+ *    in is not null
  *
  * returns: none
  */
-static inline void convert_packed_to_16bit(uint8_t *raw, uint16_t *unpacked, int vw, int unpacked_len)
+void luma16_to_yu12(uint8_t *out, uint16_t *in, int width, int height, int bits)
 {
-	int mask = (1 << vw) - 1;
-	uint32_t buffer = 0;
-	int bitsIn = 0;
-	while (unpacked_len--) {
-		while (bitsIn < vw) {
-			buffer = (buffer << 8) | *(raw++);
-			bitsIn += 8;
-		}
-		bitsIn -= vw;
-		*(unpacked++) = (buffer >> bitsIn) & mask;
-	}
+	/*assertions*/
+	assert(in);
+	assert(out);
+
+	get_cs_kernels()->narrow_y16(out, in, width * height, bits - 8);
+
+	/*grey: no chroma*/
+	memset(out + (width * height), 0x80, (width * height) / 2);
 }
 
 /*
@@ -905,47 +1229,22 @@ void y10b_to_yu12(uint8_t *out, uint8_t *in, int width, int height)
 	/*assertions*/
 	assert(in);
 	assert(out);
-	
-	uint16_t *unpacked_buffer = NULL;
-	uint16_t *ptmp;
-	uint8_t *py = out;
-	uint8_t *pu = out + (width * height);
-	uint8_t *pv = pu + ((width * height) / 4);
-	
-	int h = 0;
-
-	unpacked_buffer = malloc(width * height * sizeof(uint16_t));
-	
-	if (unpacked_buffer == NULL)
-	{
-		fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (y10b_to_yu12): %s\n", strerror(errno));
-		exit(-1);
-	}
-	
-	convert_packed_to_16bit(in, unpacked_buffer, 10, width * height);
 
-	ptmp = unpacked_buffer;
+	const cs_kernels_t *k = get_cs_kernels();
+	uint16_t chunk[Y10B_CHUNK];
 
-	for (h = 0; h < height; h++)
-	{
-		int w=0;
-		for (w = 0; w < width; w++)
-		{
-			/* Y */
-			*py++ = (uint8_t) ((*ptmp++ & 0x3FF) >> 2);
-		}
-	}
-	
-	for(h=0; h < (width * height / 4); h++)
+	int n = width * height;
+	int i = 0;
+	for(i = 0; i < n; i += Y10B_CHUNK)
 	{
-		/* U */
-		*pu++ = 0x80;
-		/* V */
-		*pv++ = 0x80;
-	}
+		int len = (n - i < Y10B_CHUNK) ? n - i : Y10B_CHUNK;
 
+		k->unpack_y10b(chunk, in + (i / 4) * 5, len);
+		k->narrow_y16(out + i, chunk, len, 2);
+	}
 
-	free(unpacked_buffer);
+	/*grey: no chroma*/
+	memset(out + n, 0x80, n / 2);
 }
 
 /*
@@ -1022,10 +1321,12 @@ void y41p_to_yu12(uint8_t *out, uint8_t *in, int width, int height)
 }
 
 /*
- * convert yuv mono (grey) to yuv 420 planar (yu12)
+ * convert grey (luma only) planes to yu12 planes
  * args:
- *   out: pointer to output buffer (yu12)
- *   in: pointer to input buffer containing grey (y only) data frame
+ *   out: output yu12 planes (y, u, v)
+ *   out_pitches: output plane pitches
+ *   in: input planes (y)
+ *   in_pitches: input plane pitches
  *   width: picture width
  *   height: picture height
  *
@@ -1035,28 +1336,49 @@ void y41p_to_yu12(uint8_t *out, uint8_t *in, int width, int height)
  *
  * returns: none
  */
-void grey_to_yu12(uint8_t *out, uint8_t *in, int width, int height)
+void grey_to_yu12_planes(uint8_t **out, int *out_pitches, uint8_t **in, int *in_pitches, int width, int height)
 {
 	/*assertions*/
 	assert(in);
 	assert(out);
-	
-	uint8_t *pu = out + (width * height);
-	uint8_t *pv = pu + ((width * height) / 4);
-	
+
 	int h=0;
 
 	/* Y */
-	memcpy(out, in, width * height);
-	
+	copy_plane(out[0], out_pitches[0], in[0], in_pitches[0], width, height);
+
 	/* U and V */
-	for (h=0; h < (width * height / 4); h++)
+	for (h=0; h < height / 2; h++)
 	{
-		*pu++ = 0x80;
-		*pv++ = 0x80;
+		memset(out[1] + (h * out_pitches[1]), 0x80, width / 2);
+		memset(out[2] + (h * out_pitches[2]), 0x80, width / 2);
 	}
 }
 
+/*
+ * convert yuv mono (grey) to yuv 420 planar (yu12)
+ * args:
+ *   out: pointer to output buffer (yu12)
+ *   in: pointer to input buffer containing grey (y only) data frame
+ *   width: picture width
+ *   height: picture height
+ *
+ * asserts:
+ *   out is not null
+ *   in is not null
+ *
+ * returns: none
+ */
+void grey_to_yu12(uint8_t *out, uint8_t *in, int width, int height)
+{
+	uint8_t *out_planes[3];
+	int out_pitches[3];
+	int in_pitch = width;
+
+	set_yu12_planes(out, width, height, out_planes, out_pitches);
+	grey_to_yu12_planes(out_planes, out_pitches, &in, &in_pitch, width, height);
+}
+
 /*
  * convert y16 (16 bit greyscale format) to yu12
  * args:
@@ -1073,35 +1395,7 @@ void grey_to_yu12(uint8_t *out, uint8_t *in, int width, int height)
  */
 void y16_to_yu12(uint8_t *out, uint8_t *in, int width, int height)
 {
-	/*assertions*/
-	assert(in);
-	assert(out);
-	
-	uint16_t *ptmp = (uint16_t *) in;
-	uint8_t *py = out;
-	uint8_t *pu = out + (width * height);
-	uint8_t *pv = pu + ((width * height) / 4);
-	
-	int h = 0;
-
-	for (h = 0; h < height; h++)
-	{
-		int w=0;
-		for (w = 0; w < width; w++)
-		{
-			/* Y */
-			*py++ = (uint8_t) ((*ptmp++ & 0xFF00) >> 8);
-		}
-	}
-	
-	for(h=0; h < (width * height / 4); h++)
-	{
-		/* U */
-		*pu++ = 0x80;
-		/* V */
-		*pv++ = 0x80;
-	}
-	
+	luma16_to_yu12(out, (uint16_t *) in, width, height, 16);
 }
 
 /*
@@ -1396,8 +1690,87 @@ void bgr24_to_yu12(uint8_t *out, uint8_t *in, int width, int height)
 			*pv++ = (v1 + v2) / 2;
 		}
 	}
-	
-	
+	
+	
+}
+
+/*
+ * yuv to rgb fixed point coefficients (Q6) for each matrix (bt601, bt709, bt2020)
+ *   and range (full, limited): see cs_yuv2rgb_t
+ */
+static const cs_yuv2rgb_t yuv2rgb_coef[3][2] =
+{
+	{ /*bt601*/
+		{16384, 32, 90, 22, 46, 113},
+		{19077, -1160, 102, 25, 52, 129},
+	},
+	{ /*bt709*/
+		{16384, 32, 101, 12, 30, 119},
+		{19077, -1160, 115, 14, 34, 135},
+	},
+	{ /*bt2020*/
+		{16384, 32, 94, 11, 37, 120},
+		{19077, -1160, 107, 12, 42, 137},
+	},
+};
+
+/*
+ * get the yuv to rgb coefficients for matrix and range
+ *   (auto or unknown values fall back to bt601 full range, the jpeg default)
+ * args:
+ *    matrix - YUV_MATRIX_xxx
+ *    range - YUV_RANGE_xxx
+ *
+ * asserts:
+ *    none
+ *
+ * returns: pointer to the coefficients
+ */
+static const cs_yuv2rgb_t *get_yuv2rgb_coef(int matrix, int range)
+{
+	if(matrix < YUV_MATRIX_BT601 || matrix > YUV_MATRIX_BT2020)
+		matrix = YUV_MATRIX_BT601;
+
+	return &yuv2rgb_coef[matrix - YUV_MATRIX_BT601][range == YUV_RANGE_LIMITED ? 1 : 0];
+}
+
+/*
+ * yu12 to rgb24 (or bgr24)
+ * args:
+ *    out - pointer to output rgb data buffer
+ *    in - pointer to input yu12 data buffer
+ *    width - buffer width (in pixels)
+ *    height - buffer height (in pixels)
+ *    matrix - YUV_MATRIX_xxx
+ *    range - YUV_RANGE_xxx
+ *    flags - CS_RGB_BGR: bgr byte order; CS_RGB_FLIP: lines upsidedown
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void yu12_to_rgb(uint8_t *out, uint8_t *in, int width, int height, int matrix, int range, int flags)
+{
+	/*assertions*/
+	assert(out);
+	assert(in);
+
+	const cs_kernels_t *k = get_cs_kernels();
+	const cs_yuv2rgb_t *coef = get_yuv2rgb_coef(matrix, range);
+
+	uint8_t *pu = in + (width * height);
+	uint8_t *pv = pu + ((width * height) / 4);
+
+	int h = 0;
+	for(h = 0; h < height; h++)
+	{
+		uint8_t *pout = out + ((flags & CS_RGB_FLIP) ? (height - 1 - h) : h) * width * 3;
+
+		k->yuv_row_to_rgb(pout, in + (h * width), pu + ((h / 2) * (width / 2)), pv + ((h / 2) * (width / 2)),
+			width, coef, flags & CS_RGB_BGR);
+	}
 }
 
 /*
@@ -1415,65 +1788,7 @@ void bgr24_to_yu12(uint8_t *out, uint8_t *in, int width, int height)
  */
 void yu12_to_rgb24 (uint8_t *out, uint8_t *in, int width, int height)
 {
-	/*assertions*/
-	assert(out);
-	assert(in);
-	
-	uint8_t *py1 = in; //line 1
-	uint8_t *py2 = py1 + width; //line 2
-	uint8_t *pu = in + (width * height);
-	uint8_t *pv = pu + ((width * height) / 4);
-	
-	uint8_t *pout1 = out; //first line
-	uint8_t *pout2 = out + (width * 3); //second line
-	
-	int h=0, w=0;
-	
-	for(h=0; h < height; h+=2) //every two lines
-	{
-		py1 = in + (h * width);
-		py2 = py1 + width;
-		
-		pout1 = out + (h * width * 3);
-		pout2 = pout1 + (width * 3);
-		
-		for(w=0; w<width; w+=2) //every 2 pixels
-		{
-			/* standart: r = y0 + 1.402 (v-128) */
-			/* logitech: r = y0 + 1.370705 (v-128) */
-			*pout1++=CLIP(*py1 + 1.402 * (*pv-128));
-			*pout2++=CLIP(*py2 + 1.402 * (*pv-128));	
-			/* standart: g = y0 - 0.34414 (u-128) - 0.71414 (v-128)*/
-			/* logitech: g = y0 - 0.337633 (u-128)- 0.698001 (v-128)*/
-			*pout1++=CLIP(*py1 - 0.34414 * (*pu-128) -0.71414*(*pv-128));
-			*pout2++=CLIP(*py2 - 0.34414 * (*pu-128) -0.71414*(*pv-128));
-			/* standart: b = y0 + 1.772 (u-128) */
-			/* logitech: b = y0 + 1.732446 (u-128) */
-			*pout1++=CLIP(*py1 + 1.772 *( *pu-128));
-			*pout2++=CLIP(*py2 + 1.772 *( *pu-128));
-			
-			py1++;
-			py2++;
-			
-			/* standart: r1 =y1 + 1.402 (v-128) */
-			/* logitech: r1 = y1 + 1.370705 (v-128) */
-			*pout1++=CLIP(*py1 + 1.402 * (*pv-128));
-			*pout2++=CLIP(*py2 + 1.402 * (*pv-128));
-			/* standart: g1 = y1 - 0.34414 (u-128) - 0.71414 (v-128)*/
-			/* logitech: g1 = y1 - 0.337633 (u-128)- 0.698001 (v-128)*/
-			*pout1++=CLIP(*py1 - 0.34414 * (*pu-128) -0.71414 * (*pv-128));
-			*pout2++=CLIP(*py2 - 0.34414 * (*pu-128) -0.71414 * (*pv-128));
-			/* standart: b1 = y1 + 1.772 (u-128) */
-			/* logitech: b1 = y1 + 1.732446 (u-128) */
-			*pout1++=CLIP(*py1 + 1.772 * (*pu-128));
-			*pout2++=CLIP(*py2 + 1.772 * (*pu-128));
-			
-			py1++;
-			py2++;
-			pu++;
-			pv++;
-		}
-	}
+	yu12_to_rgb(out, in, width, height, YUV_MATRIX_BT601, YUV_RANGE_FULL, 0);
 }
 
 /*
@@ -1492,74 +1807,116 @@ void yu12_to_rgb24 (uint8_t *out, uint8_t *in, int width, int height)
  */
 void yu12_to_dib24 (uint8_t *out, uint8_t *in, int width, int height)
 {
-	/*assertions*/
-	assert(out);
-	assert(in);
-	
-	uint8_t *py1 = in + (height * width) - width; //begin of last line
-	uint8_t *py2 = py1 - width; //last line -1
-	
-	uint8_t *pu = in + ((width * height * 5) / 4) - (width/2); //begin of last line
-	uint8_t *pv = pu + ((width * height) / 4); //begin of last line
-	
-	uint8_t *pout1 = out; //first line
-	uint8_t *pout2 = pout1 + (width * 3); //second line
-	
-	int h=0, w=0;
-	int uvline = height/2;
-	
-	for(h=height; h >0 ; h-=2) //every two lines
+	yu12_to_rgb(out, in, width, height, YUV_MATRIX_BT601, YUV_RANGE_FULL, CS_RGB_BGR | CS_RGB_FLIP);
+}
+
+/*
+ * convert yuv planes (y + u and v samples) to yuv 422 (yuyv)
+ * args:
+ *    out - pointer to output buffer (yuyv)
+ *    py - pointer to y plane
+ *    y_pitch - y plane pitch
+ *    pu - pointer to first u sample
+ *    pv - pointer to first v sample
+ *    uv_pitch - chroma plane pitch
+ *    uv_step - distance between chroma samples (2 - interleaved)
+ *    uv_vsub - chroma vertical subsampling (1 - 422, 2 - 420)
+ *    width - picture width
+ *    height - picture height
+ *
+ * asserts:
+ *    none
+ *
+ * returns: none
+ */
+static void yuv_planes_to_yuyv(uint8_t *out, uint8_t *py, int y_pitch,
+	uint8_t *pu, uint8_t *pv, int uv_pitch, int uv_step, int uv_vsub,
+	int width, int height)
+{
+	int h = 0;
+	for(h = 0; h < height; h++)
 	{
-		uvline--; //begin of uv line
-		
-		py1 = in + ((h-1) * width);
-		py2 = py1 - width;
-		
-		pu = in + (width * height) + ((uvline * width)/2);
-		pv = pu + ((width * height) / 4);
-		
-		pout1 = out + ((height-h) * width * 3);
-		pout2 = pout1 + (width * 3);
-		
-		for(w=0; w<width; w+=2) //every 2 pixels
+		uint8_t *y = py + (h * y_pitch);
+		uint8_t *u = pu + ((h / uv_vsub) * uv_pitch);
+		uint8_t *v = pv + ((h / uv_vsub) * uv_pitch);
+		int w = 0;
+		for(w = 0; w < width; w += 2)
 		{
-			/* standart: b = y0 + 1.772 (u-128) */
-			/* logitech: b = y0 + 1.732446 (u-128) */
-			*pout1++=CLIP(*py1 + 1.772 *( *pu-128));
-			*pout2++=CLIP(*py2 + 1.772 *( *pu-128));	
-			/* standart: g = y0 - 0.34414 (u-128) - 0.71414 (v-128)*/
-			/* logitech: g = y0 - 0.337633 (u-128)- 0.698001 (v-128)*/
-			*pout1++=CLIP(*py1 - 0.34414 * (*pu-128) -0.71414*(*pv-128));
-			*pout2++=CLIP(*py2 - 0.34414 * (*pu-128) -0.71414*(*pv-128));
-			/* standart: r = y0 + 1.402 (v-128) */
-			/* logitech: r = y0 + 1.370705 (v-128) */
-			*pout1++=CLIP(*py1 + 1.402 * (*pv-128));
-			*pout2++=CLIP(*py2 + 1.402 * (*pv-128));
-			
-			py1++;
-			py2++;
-			
-			/* standart: b = y0 + 1.772 (u-128) */
-			/* logitech: b = y0 + 1.732446 (u-128) */
-			*pout1++=CLIP(*py1 + 1.772 *( *pu-128));
-			*pout2++=CLIP(*py2 + 1.772 *( *pu-128));	
-			/* standart: g = y0 - 0.34414 (u-128) - 0.71414 (v-128)*/
-			/* logitech: g = y0 - 0.337633 (u-128)- 0.698001 (v-128)*/
-			*pout1++=CLIP(*py1 - 0.34414 * (*pu-128) -0.71414*(*pv-128));
-			*pout2++=CLIP(*py2 - 0.34414 * (*pu-128) -0.71414*(*pv-128));
-			/* standart: r = y0 + 1.402 (v-128) */
-			/* logitech: r = y0 + 1.370705 (v-128) */
-			*pout1++=CLIP(*py1 + 1.402 * (*pv-128));
-			*pout2++=CLIP(*py2 + 1.402 * (*pv-128));
-			
-			py1++;
-			py2++;
-			pu++;
-			pv++;
+			*out++ = y[w];     //Y0
+			*out++ = *u;       //U
+			*out++ = y[w + 1]; //Y1
+			*out++ = *v;       //V
+
+			u += uv_step;
+			v += uv_step;
+		}
+	}
+}
+
+/*
+ * reorder packed yuv 422 (yyuv, uyvy or yvyu) to yuyv
+ * args:
+ *    out - pointer to output buffer (yuyv)
+ *    in - pointer to input packed data
+ *    in_pitch - input pitch (bytes per line)
+ *    width - picture width
+ *    height - picture height
+ *    order - input offsets of y0, u, y1 and v in a macropixel
+ *
+ * asserts:
+ *    none
+ *
+ * returns: none
+ */
+static void packed422_to_yuyv(uint8_t *out, uint8_t *in, int in_pitch,
+	int width, int height, const int order[4])
+{
+	int h = 0;
+	for(h = 0; h < height; h++)
+	{
+		uint8_t *pin = in + (h * in_pitch);
+		int w = 0;
+		for(w = 0; w < width * 2; w += 4)
+		{
+			/* Y0 */
+			out[0] = pin[order[0]];
+			/* U */
+			out[1] = pin[order[1]];
+			/* Y1 */
+			out[2] = pin[order[2]];
+			/* V */
+			out[3] = pin[order[3]];
+
+			pin += 4;
+			out += 4;
 		}
 	}
 }
 
+/*
+ * convert yuv 420 planar (yu12) planes to yuv 422 (yuyv)
+ * args:
+ *    out - pointer to output buffer (yuyv)
+ *    in - input planes (y, u, v)
+ *    in_pitches - input plane pitches
+ *    width - picture width
+ *    height - picture height
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void yu12_to_yuyv_planes(uint8_t *out, uint8_t **in, int *in_pitches, int width, int height)
+{
+	/*assertions*/
+	assert(out);
+	assert(in);
+
+	yuv_planes_to_yuyv(out, in[0], in_pitches[0], in[1], in[2], in_pitches[1], 1, 2, width, height);
+}
+
 /*
  * convert yuv 420 planar (yu12) to yuv 422
  * args:
@@ -1576,59 +1933,64 @@ void yu12_to_dib24 (uint8_t *out, uint8_t *in, int width, int height)
  */
 void yu12_to_yuyv (uint8_t *out, uint8_t *in, int width, int height)
 {
-	uint8_t *py;
-	uint8_t *pu;
-	uint8_t *pv;
+	uint8_t *in_planes[3];
+	int in_pitches[3];
 
-	int linesize = width * 2;
-	int uvlinesize = width / 2;
+	set_yu12_planes(in, width, height, in_planes, in_pitches);
+	yu12_to_yuyv_planes(out, in_planes, in_pitches, width, height);
+}
 
-	py=in;
-	pu=py+(width*height);
-	pv=pu+(width*height/4);
+/*------------------- YUYV --------------------*/
 
-	int h=0;
-	int huv=0;
+/*
+ * yuyv to rgb24 (or bgr24)
+ * args:
+ *    out - pointer to output rgb data buffer
+ *    in - pointer to input yuyv data buffer
+ *    width - buffer width (in pixels)
+ *    height - buffer height (in pixels)
+ *    matrix - YUV_MATRIX_xxx
+ *    range - YUV_RANGE_xxx
+ *    flags - CS_RGB_BGR: bgr byte order; CS_RGB_FLIP: lines upsidedown
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void yuyv_to_rgb(uint8_t *out, uint8_t *in, int width, int height, int matrix, int range, int flags)
+{
+	/*assertions*/
+	assert(out);
+	assert(in);
 
-	for(h=0;h<height;h+=2)
-	{
-		int wy = 0;
-		int wuv = 0;
-		int offset = h * linesize;
-		int offset1 = (h + 1) * linesize;
-		int offsety = h * width;
-		int offsety1 = (h + 1) * width;
-		int offsetuv = huv * uvlinesize;
-		int w = 0;
+	const cs_kernels_t *k = get_cs_kernels();
+	const cs_yuv2rgb_t *coef = get_yuv2rgb_coef(matrix, range);
 
-		for(w=0;w<linesize;w+=4)
-		{
-			/*y00*/
-			out[w + offset] = py[wy + offsety];
-			/*u0*/
-			out[(w + 1) + offset] = pu[wuv + offsetuv];
-			/*y01*/
-			out[(w + 2) + offset] = py[(wy + 1) + offsety];
-			/*v0*/
-			out[(w + 3) + offset] = pv[wuv + offsetuv];
+	/*one row of planar yuv (422)*/
+	uint8_t *row = malloc(width * 2);
+	if(row == NULL)
+	{
+		fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (yuyv_to_rgb): %s\n", strerror(errno));
+		exit(-1);
+	}
+	uint8_t *pu = row + width;
+	uint8_t *pv = pu + (width / 2);
 
-			/*y10*/
-			out[w + offset1] = py[wy + offsety1];
-			/*u0*/
-			out[(w + 1) + offset1] = pu[wuv + offsetuv];
-			/*y11*/
-			out[(w + 2) + offset1] = py[(wy + 1) + offsety1];
-			/*v0*/
-			out[(w + 3) + offset1] = pv[wuv + offsetuv];
+	int h = 0;
+	for(h = 0; h < height; h++)
+	{
+		uint8_t *pin = in + (h * width * 2);
+		uint8_t *pout = out + ((flags & CS_RGB_FLIP) ? (height - 1 - h) : h) * width * 3;
 
-			wuv++;
-			wy+=2;
-		}
-		huv++;
+		/*same row twice: chroma is not averaged*/
+		k->packed422_rows(row, row, pu, pv, pin, pin, width, 1);
+		k->yuv_row_to_rgb(pout, row, pu, pv, width, coef, flags & CS_RGB_BGR);
 	}
-}
 
-/*------------------- YUYV --------------------*/
+	free(row);
+}
 
 /*
  * regular yuv (YUYV) to rgb24
@@ -1645,29 +2007,7 @@ void yu12_to_yuyv (uint8_t *out, uint8_t *in, int width, int height)
  */
 void yuyv2rgb (uint8_t *pyuv, uint8_t *prgb, int width, int height)
 {
-	int l=0;
-	int SizeYUV=height * width * 2; /* 2 bytes per pixel*/
-	for(l=0;l<SizeYUV;l=l+4)
-	{	/*iterate every 4 bytes*/
-		/* standart: r = y0 + 1.402 (v-128) */
-		/* logitech: r = y0 + 1.370705 (v-128) */
-		*prgb++=CLIP(pyuv[l] + 1.402 * (pyuv[l+3]-128));
-		/* standart: g = y0 - 0.34414 (u-128) - 0.71414 (v-128)*/
-		/* logitech: g = y0 - 0.337633 (u-128)- 0.698001 (v-128)*/
-		*prgb++=CLIP(pyuv[l] - 0.34414 * (pyuv[l+1]-128) -0.71414*(pyuv[l+3]-128));
-		/* standart: b = y0 + 1.772 (u-128) */
-		/* logitech: b = y0 + 1.732446 (u-128) */
-		*prgb++=CLIP(pyuv[l] + 1.772 *( pyuv[l+1]-128));
-		/* standart: r1 =y1 + 1.402 (v-128) */
-		/* logitech: r1 = y1 + 1.370705 (v-128) */
-		*prgb++=CLIP(pyuv[l+2] + 1.402 * (pyuv[l+3]-128));
-		/* standart: g1 = y1 - 0.34414 (u-128) - 0.71414 (v-128)*/
-		/* logitech: g1 = y1 - 0.337633 (u-128)- 0.698001 (v-128)*/
-		*prgb++=CLIP(pyuv[l+2] - 0.34414 * (pyuv[l+1]-128) -0.71414 * (pyuv[l+3]-128));
-		/* standart: b1 = y1 + 1.772 (u-128) */
-		/* logitech: b1 = y1 + 1.732446 (u-128) */
-		*prgb++=CLIP(pyuv[l+2] + 1.772*(pyuv[l+1]-128));
-	}
+	yuyv_to_rgb(prgb, pyuv, width, height, YUV_MATRIX_BT601, YUV_RANGE_FULL, 0);
 }
 
 /*
@@ -1728,43 +2068,33 @@ void yuyv2rgb (uint8_t *pyuv, uint8_t *prgb, int width, int height)
  */
 void yuyv2bgr (uint8_t *pyuv, uint8_t *pbgr, int width, int height)
 {
+	yuyv_to_rgb(pbgr, pyuv, width, height, YUV_MATRIX_BT601, YUV_RANGE_FULL, CS_RGB_BGR | CS_RGB_FLIP);
+}
 
-	int l=0;
-	uint8_t *preverse;
-	int SizeBGR=height * width * 3; /* 3 bytes per pixel*/
-	/* BMP byte order is bgr and the lines start from last to first*/
-	preverse=pbgr+SizeBGR;/*start at the end and decrement*/
-	for(l=0;l<height;l++)
-	{	/*iterate every 1 line*/
-		preverse-=width*3;/*put pointer at begin of unprocessed line*/
-		int bytesUsed=l*width*2;
-		int k = 0;
-		for (k=0;k<(width*2);k=k+4)/*iterate every 4 bytes in the line*/
-		{
-			/* standart: b = y0 + 1.772 (u-128) */
-			/* logitech: b = y0 + 1.732446 (u-128) */
-			*preverse++=CLIP(pyuv[k+bytesUsed] + 1.772 *( pyuv[k+1+bytesUsed]-128));
-			/* standart: g = y0 - 0.34414 (u-128) - 0.71414 (v-128)*/
-			/* logitech: g = y0 - 0.337633 (u-128)- 0.698001 (v-128)*/
-			*preverse++=CLIP(pyuv[k+bytesUsed] - 0.34414 * (pyuv[k+1+bytesUsed]-128)
-				-0.71414*(pyuv[k+3+bytesUsed]-128));
-			/* standart: r = y0 + 1.402 (v-128) */
-			/* logitech: r = y0 + 1.370705 (v-128) */
-			*preverse++=CLIP(pyuv[k+bytesUsed] + 1.402 * (pyuv[k+3+bytesUsed]-128));
-			/* standart: b1 = y1 + 1.772 (u-128) */
-			/* logitech: b1 = y1 + 1.732446 (u-128) */
-			*preverse++=CLIP(pyuv[k+2+bytesUsed] + 1.772*(pyuv[k+1+bytesUsed]-128));
-			/* standart: g1 = y1 - 0.34414 (u-128) - 0.71414 (v-128)*/
-			/* logitech: g1 = y1 - 0.337633 (u-128)- 0.698001 (v-128)*/
-			*preverse++=CLIP(pyuv[k+2+bytesUsed] - 0.34414 * (pyuv[k+1+bytesUsed]-128)
-				-0.71414 * (pyuv[k+3+bytesUsed]-128));
-			/* standart: r1 =y1 + 1.402 (v-128) */
-			/* logitech: r1 = y1 + 1.370705 (v-128) */
-			*preverse++=CLIP(pyuv[k+2+bytesUsed] + 1.402 * (pyuv[k+3+bytesUsed]-128));
-		}
-		preverse-=width*3;/*get it back at the begin of processed line*/
+/*
+ * 16 bit luma samples to yuyv (grey)
+ * args:
+ *   out: pointer to output buffer (yuyv)
+ *   in: pointer to 16 bit luma samples
+ *   n: number of samples (even)
+ *   shift: right shift to 8 bit
+ *
+ * asserts:
+ *    none
+ *
+ * returns: none
+ */
+static void luma16_samples_to_yuyv(uint8_t *out, const uint16_t *in, int n, int shift)
+{
+	int i = 0;
+	for(i = 0; i < n; i++)
+	{
+		int y = in[i] >> shift;
+		/* Y */
+		*out++ = (y > 255) ? 255 : y;
+		/* U or V */
+		*out++ = 0x80;
 	}
-	preverse=NULL;
 }
 
 /*
@@ -1782,41 +2112,18 @@ void yuyv2bgr (uint8_t *pyuv, uint8_t *pbgr, int width, int height)
  */
 void y10b_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int height)
 {
-	uint16_t *unpacked_buffer = NULL;
-	uint16_t *ptmp;
-	int h = 0;
-
-	unpacked_buffer = malloc(width * height * sizeof(uint16_t));
-	
-	if (unpacked_buffer == NULL)
-	{
-		fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (y10b_to_yuyv): %s\n", strerror(errno));
-		exit(-1);
-	}
-	
-	convert_packed_to_16bit(tmpbuffer, unpacked_buffer, 10, width * height);
-
-	ptmp = unpacked_buffer;
+	const cs_kernels_t *k = get_cs_kernels();
+	uint16_t chunk[Y10B_CHUNK];
 
-	for (h = 0; h < height; h++)
+	int n = width * height;
+	int i = 0;
+	for(i = 0; i < n; i += Y10B_CHUNK)
 	{
-		int w=0;
-		for (w = 0; w < width; w += 2)
-		{
-			/* Y0 */
-			*framebuffer++ = (uint8_t) ((ptmp[0] & 0x3FF) >> 2);
-			/* U */
-			*framebuffer++ = 0x80;
-			/* Y1 */
-			*framebuffer++ = (uint8_t) ((ptmp[1] & 0x3FF) >> 2);
-			/* V */
-			*framebuffer++ = 0x80;
+		int len = (n - i < Y10B_CHUNK) ? n - i : Y10B_CHUNK;
 
-			ptmp += 2;
-		}
+		k->unpack_y10b(chunk, tmpbuffer + (i / 4) * 5, len);
+		luma16_samples_to_yuyv(framebuffer + (i * 2), chunk, len, 2);
 	}
-
-	free(unpacked_buffer);
 }
 
 /*
@@ -1834,27 +2141,56 @@ void y10b_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int heig
  */
 void y16_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int height)
 {
-	uint16_t *ptmp= (uint16_t *) tmpbuffer;
+	luma16_samples_to_yuyv(framebuffer, (uint16_t *) tmpbuffer, width * height, 8);
+}
 
-	int h=0;
+/*
+ * convert 16 bit luma to yuyv (8 bit display copy)
+ * args:
+ *   out: pointer to output buffer (yuyv)
+ *   in: pointer to 16 bit luma samples
+ *   width: picture width
+ *   height: picture height
+ *   bits: significant bits in the luma samples (8 to 16)
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void luma16_to_yuyv(uint8_t *out, uint16_t *in, int width, int height, int bits)
+{
+	/*assertions*/
+	assert(in);
+	assert(out);
 
-	for(h=0;h<height;h++)
-	{
-		int w=0;
-		for(w=0;w<width;w+=2)
-		{
-			/* Y0 */
-			*framebuffer++ = (uint8_t) ((ptmp[0] & 0xFF00) >> 8);
-			/* U */
-			*framebuffer++ = 0x80;
-			/* Y1 */
-			*framebuffer++ = (uint8_t) ((ptmp[1] & 0xFF00) >> 8);
-			/* V */
-			*framebuffer++ = 0x80;
+	luma16_samples_to_yuyv(out, in, width * height, bits - 8);
+}
 
-			ptmp += 2;
-		}
-	}
+/*
+ * convert yyuv (packed) planes to yuyv (packed)
+ * args:
+ *    out - pointer to output buffer (yuyv)
+ *    in - input planes (yyuv packed data)
+ *    in_pitches - input plane pitches (bytes per line)
+ *    width - picture width
+ *    height - picture height
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void yyuv_to_yuyv_planes(uint8_t *out, uint8_t **in, int *in_pitches, int width, int height)
+{
+	/*assertions*/
+	assert(out);
+	assert(in);
+
+	static const int order[4] = {0, 2, 1, 3};
+	packed422_to_yuyv(out, in[0], in_pitches[0], width, height, order);
 }
 
 /*
@@ -1872,31 +2208,34 @@ void y16_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int heigh
  */
 void yyuv_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int height)
 {
-	uint8_t *ptmp=NULL;
-	uint8_t *pfmb=NULL;
-	ptmp = tmpbuffer;
-	pfmb = framebuffer;
+	int in_pitch = width * 2;
 
-	int h=0;
+	yyuv_to_yuyv_planes(framebuffer, &tmpbuffer, &in_pitch, width, height);
+}
 
-	for(h=0;h<height;h++)
-	{
-		int w=0;
-		for(w=0;w<(width*2);w+=4)
-		{
-			/* Y0 */
-			pfmb[0] = ptmp[0];
-			/* U */
-			pfmb[1] = ptmp[2];
-			/* Y1 */
-			pfmb[2] = ptmp[1];
-			/* V */
-			pfmb[3] = ptmp[3];
+/*
+ * convert uyvy (packed) planes to yuyv (packed)
+ * args:
+ *    out - pointer to output buffer (yuyv)
+ *    in - input planes (uyvy packed data)
+ *    in_pitches - input plane pitches (bytes per line)
+ *    width - picture width
+ *    height - picture height
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void uyvy_to_yuyv_planes(uint8_t *out, uint8_t **in, int *in_pitches, int width, int height)
+{
+	/*assertions*/
+	assert(out);
+	assert(in);
 
-			ptmp += 4;
-			pfmb += 4;
-		}
-	}
+	static const int order[4] = {1, 0, 3, 2};
+	packed422_to_yuyv(out, in[0], in_pitches[0], width, height, order);
 }
 
 /*
@@ -1914,28 +2253,34 @@ void yyuv_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int heig
  */
 void uyvy_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int height)
 {
-	uint8_t *ptmp = tmpbuffer;
-	uint8_t *pfmb = framebuffer;
-	int h=0;
-
-	for(h=0;h<height;h++)
-	{
-		int w=0;
-		for(w=0;w<(width*2);w+=4)
-		{
-			/* Y0 */
-			pfmb[0] = ptmp[1];
-			/* U */
-			pfmb[1] = ptmp[0];
-			/* Y1 */
-			pfmb[2] = ptmp[3];
-			/* V */
-			pfmb[3] = ptmp[2];
+	int in_pitch = width * 2;
+
+	uyvy_to_yuyv_planes(framebuffer, &tmpbuffer, &in_pitch, width, height);
+}
+
+/*
+ * convert yvyu (packed) planes to yuyv (packed)
+ * args:
+ *    out - pointer to output buffer (yuyv)
+ *    in - input planes (yvyu packed data)
+ *    in_pitches - input plane pitches (bytes per line)
+ *    width - picture width
+ *    height - picture height
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void yvyu_to_yuyv_planes(uint8_t *out, uint8_t **in, int *in_pitches, int width, int height)
+{
+	/*assertions*/
+	assert(out);
+	assert(in);
 
-			ptmp += 4;
-			pfmb += 4;
-		}
-	}
+	static const int order[4] = {0, 3, 2, 1};
+	packed422_to_yuyv(out, in[0], in_pitches[0], width, height, order);
 }
 
 /*
@@ -1953,31 +2298,9 @@ void uyvy_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int heig
  */
 void yvyu_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int height)
 {
-	uint8_t *ptmp=NULL;
-	uint8_t *pfmb=NULL;
-	ptmp = tmpbuffer;
-	pfmb = framebuffer;
-
-	int h=0;
+	int in_pitch = width * 2;
 
-	for(h=0;h<height;h++)
-	{
-		int w = 0;
-		for(w=0;w<(width*2);w+=4)
-		{
-			/* Y0 */
-			pfmb[0] = ptmp[0];
-			/* U */
-			pfmb[1] = ptmp[3];
-			/* Y1 */
-			pfmb[2] = ptmp[2];
-			/* V */
-			pfmb[3] = ptmp[1];
-
-			ptmp += 4;
-			pfmb += 4;
-		}
-	}
+	yvyu_to_yuyv_planes(framebuffer, &tmpbuffer, &in_pitch, width, height);
 }
 
 /*
@@ -2034,6 +2357,30 @@ void yuv422_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int he
 	}
 }
 
+/*
+ * convert yvu 420 planar (yv12) planes to yuv 422 (yuyv)
+ * args:
+ *    out - pointer to output buffer (yuyv)
+ *    in - input planes (y, v, u)
+ *    in_pitches - input plane pitches
+ *    width - picture width
+ *    height - picture height
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void yvu420_to_yuyv_planes(uint8_t *out, uint8_t **in, int *in_pitches, int width, int height)
+{
+	/*assertions*/
+	assert(out);
+	assert(in);
+
+	yuv_planes_to_yuyv(out, in[0], in_pitches[0], in[2], in[1], in_pitches[1], 1, 2, width, height);
+}
+
 /*
  * convert yvu 420 planar (yv12) to yuv 422
  * args:
@@ -2049,56 +2396,36 @@ void yuv422_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int he
  */
 void yvu420_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int height)
 {
-	uint8_t *py;
-	uint8_t *pv;
-	uint8_t *pu;
-
-	int linesize = width * 2;
-	int uvlinesize = width / 2;
-
-	py=tmpbuffer;
-	pv=py+(width*height);
-	pu=pv+((width*height)/4);
-
-	int h=0;
-	int huv=0;
-
-	for(h=0;h<height;h+=2)
-	{
-		int wy=0;
-		int wuv=0;
-		int offset = h * linesize;
-		int offset1 = (h + 1) * linesize;
-		int offsety = h * width;
-		int offsety1 = (h + 1) * width;
-		int offsetuv = huv * uvlinesize;
-		int w = 0;
+	uint8_t *in_planes[3];
+	int in_pitches[3];
 
-		for(w=0;w<linesize;w+=4)
-		{
-			/*y00*/
-			framebuffer[w + offset] = py[wy + offsety];
-			/*u0*/
-			framebuffer[(w + 1) + offset] = pu[wuv + offsetuv];
-			/*y01*/
-			framebuffer[(w + 2) + offset] = py[(wy + 1) + offsety];
-			/*v0*/
-			framebuffer[(w + 3) + offset] = pv[wuv + offsetuv];
+	set_yu12_planes(tmpbuffer, width, height, in_planes, in_pitches);
+	yvu420_to_yuyv_planes(framebuffer, in_planes, in_pitches, width, height);
+}
 
-			/*y10*/
-			framebuffer[w + offset1] = py[wy + offsety1];
-			/*u0*/
-			framebuffer[(w + 1) + offset1] = pu[wuv + offsetuv];
-			/*y11*/
-			framebuffer[(w + 2) + offset1] = py[(wy + 1) + offsety1];
-			/*v0*/
-			framebuffer[(w + 3) + offset1] = pv[wuv + offsetuv];
+/*
+ * convert yuv 420 planar (uv interleaved) (nv12) planes to yuv 422 (yuyv)
+ * args:
+ *    out - pointer to output buffer (yuyv)
+ *    in - input planes (y, uv)
+ *    in_pitches - input plane pitches
+ *    width - picture width
+ *    height - picture height
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void nv12_to_yuyv_planes(uint8_t *out, uint8_t **in, int *in_pitches, int width, int height)
+{
+	/*assertions*/
+	assert(out);
+	assert(in);
 
-			wuv++;
-			wy+=2;
-		}
-		huv++;
-	}
+	/*the uv plane has the same pitch as the y plane*/
+	yuv_planes_to_yuyv(out, in[0], in_pitches[0], in[1], in[1] + 1, in_pitches[1], 2, 2, width, height);
 }
 
 /*
@@ -2116,53 +2443,35 @@ void yvu420_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int he
  */
 void nv12_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int height)
 {
-	uint8_t *py;
-	uint8_t *puv;
-
-	int linesize = width * 2;
-
-	py=tmpbuffer;
-	puv=py+(width*height);
-
-	int h=0;
-	int huv=0;
-
-	for(h=0;h<height;h+=2)
-	{
-		int wy=0;
-		int wuv=0;
-		int offset = h * linesize;
-		int offset1 = (h+1) * linesize;
-		int offsety = h * width;
-		int offsety1 = (h+1) * width;
-		int offsetuv = huv * width;
-		int w = 0;
+	uint8_t *in_planes[2] = {tmpbuffer, tmpbuffer + (width * height)};
+	int in_pitches[2] = {width, width};
 
-		for(w=0;w<linesize;w+=4)
-		{
-			/*y00*/
-			framebuffer[w + offset] = py[wy + offsety];
-			/*u0*/
-			framebuffer[(w + 1) + offset] = puv[wuv + offsetuv];
-			/*y01*/
-			framebuffer[(w + 2) + offset] = py[(wy + 1) + offsety];
-			/*v0*/
-			framebuffer[(w + 3) + offset] = puv[(wuv + 1) + offsetuv];
+	nv12_to_yuyv_planes(framebuffer, in_planes, in_pitches, width, height);
+}
 
-			/*y10*/
-			framebuffer[w + offset1] = py[wy + offsety1];
-			/*u0*/
-			framebuffer[(w + 1) + offset1] = puv[wuv + offsetuv];
-			/*y11*/
-			framebuffer[(w + 2) + offset1] = py[(wy + 1) + offsety1];
-			/*v0*/
-			framebuffer[(w + 3) + offset1] = puv[(wuv + 1) + offsetuv];
+/*
+ * convert yuv 420 planar (vu interleaved) (nv21) planes to yuv 422 (yuyv)
+ * args:
+ *    out - pointer to output buffer (yuyv)
+ *    in - input planes (y, vu)
+ *    in_pitches - input plane pitches
+ *    width - picture width
+ *    height - picture height
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void nv21_to_yuyv_planes(uint8_t *out, uint8_t **in, int *in_pitches, int width, int height)
+{
+	/*assertions*/
+	assert(out);
+	assert(in);
 
-			wuv+=2;
-			wy+=2;
-		}
-		huv++;
-	}
+	/*the uv plane has the same pitch as the y plane*/
+	yuv_planes_to_yuyv(out, in[0], in_pitches[0], in[1] + 1, in[1], in_pitches[1], 2, 2, width, height);
 }
 
 /*
@@ -2180,53 +2489,35 @@ void nv12_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int heig
  */
 void nv21_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int height)
 {
-	uint8_t *py;
-	uint8_t *puv;
+	uint8_t *in_planes[2] = {tmpbuffer, tmpbuffer + (width * height)};
+	int in_pitches[2] = {width, width};
 
-	int linesize = width * 2;
-
-	py=tmpbuffer;
-	puv=py+(width*height);
-
-	int h=0;
-	int huv=0;
-
-	for(h=0;h<height;h+=2)
-	{
-		int wy=0;
-		int wuv=0;
-		int offset = h * linesize;
-		int offset1 = (h+1) * linesize;
-		int offsety = h * width;
-		int offsety1 = (h+1) * width;
-		int offsetuv = huv * width;
-		int w = 0;
-
-		for(w=0;w<linesize;w+=4)
-		{
-			/*y00*/
-			framebuffer[w + offset] = py[wy + offsety];
-			/*u0*/
-			framebuffer[(w + 1) + offset] = puv[(wuv + 1) + offsetuv];
-			/*y01*/
-			framebuffer[(w + 2) + offset] = py[(wy + 1) + offsety];
-			/*v0*/
-			framebuffer[(w + 3) + offset] = puv[wuv + offsetuv];
+	nv21_to_yuyv_planes(framebuffer, in_planes, in_pitches, width, height);
+}
 
-			/*y10*/
-			framebuffer[w + offset1] = py[wy + offsety1];
-			/*u0*/
-			framebuffer[(w + 1) + offset1] = puv[(wuv + 1) + offsetuv];
-			/*y11*/
-			framebuffer[(w + 2) + offset1] = py[(wy + 1) + offsety1];
-			/*v0*/
-			framebuffer[(w + 3) + offset1] = puv[wuv + offsetuv];
+/*
+ * convert yuv 422 planar (uv interleaved) (nv16) planes to yuv 422 (yuyv)
+ * args:
+ *    out - pointer to output buffer (yuyv)
+ *    in - input planes (y, uv)
+ *    in_pitches - input plane pitches
+ *    width - picture width
+ *    height - picture height
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void nv16_to_yuyv_planes(uint8_t *out, uint8_t **in, int *in_pitches, int width, int height)
+{
+	/*assertions*/
+	assert(out);
+	assert(in);
 
-			wuv+=2;
-			wy+=2;
-		}
-		huv++;
-	}
+	/*the uv plane has the same pitch as the y plane*/
+	yuv_planes_to_yuyv(out, in[0], in_pitches[0], in[1], in[1] + 1, in_pitches[1], 2, 1, width, height);
 }
 
 /*
@@ -2244,42 +2535,35 @@ void nv21_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int heig
  */
 void nv16_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int height)
 {
-	uint8_t *py;
-	uint8_t *puv;
-
-	int linesize = width * 2;
-
-	py=tmpbuffer;
-	puv=py+(width*height);
-
-	int h=0;
-	int huv=0;
+	uint8_t *in_planes[2] = {tmpbuffer, tmpbuffer + (width * height)};
+	int in_pitches[2] = {width, width};
 
-	for(h=0;h<height;h++)
-	{
-		int wy=0;
-		int wuv=0;
-		int offset = h * linesize;
-		int offsety = h * width;
-		int offsetuv = huv * width;
-		int w = 0;
+	nv16_to_yuyv_planes(framebuffer, in_planes, in_pitches, width, height);
+}
 
-		for(w=0;w<linesize;w+=4)
-		{
-			/*y00*/
-			framebuffer[w + offset] = py[wy + offsety];
-			/*u0*/
-			framebuffer[(w + 1) + offset] = puv[wuv + offsetuv];
-			/*y01*/
-			framebuffer[(w + 2) + offset] = py[(wy + 1) + offsety];
-			/*v0*/
-			framebuffer[(w + 3) + offset] = puv[(wuv + 1) + offsetuv];
+/*
+ * convert yuv 422 planar (vu interleaved) (nv61) planes to yuv 422 (yuyv)
+ * args:
+ *    out - pointer to output buffer (yuyv)
+ *    in - input planes (y, vu)
+ *    in_pitches - input plane pitches
+ *    width - picture width
+ *    height - picture height
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void nv61_to_yuyv_planes(uint8_t *out, uint8_t **in, int *in_pitches, int width, int height)
+{
+	/*assertions*/
+	assert(out);
+	assert(in);
 
-			wuv+=2;
-			wy+=2;
-		}
-		huv++;
-	}
+	/*the uv plane has the same pitch as the y plane*/
+	yuv_planes_to_yuyv(out, in[0], in_pitches[0], in[1] + 1, in[1], in_pitches[1], 2, 1, width, height);
 }
 
 /*
@@ -2297,41 +2581,10 @@ void nv16_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int heig
  */
 void nv61_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int height)
 {
-	uint8_t *py;
-	uint8_t *puv;
-
-	int linesize = width * 2;
-
-	py=tmpbuffer;
-	puv=py+(width*height);
-
-	int h=0;
-	int huv=0;
-
-	for(h=0;h<height;h++)
-	{
-		int wy=0;
-		int wuv=0;
-		int offset = h * linesize;
-		int offsety = h * width;
-		int offsetuv = huv * width;
-		int w = 0;
-		for(w=0;w<linesize;w+=4)
-		{
-			/*y00*/
-			framebuffer[w + offset] = py[wy + offsety];
-			/*u0*/
-			framebuffer[(w + 1) + offset] = puv[(wuv + 1) + offsetuv];
-			/*y01*/
-			framebuffer[(w + 2) + offset] = py[(wy + 1) + offsety];
-			/*v0*/
-			framebuffer[(w + 3) + offset] = puv[wuv + offsetuv];
+	uint8_t *in_planes[2] = {tmpbuffer, tmpbuffer + (width * height)};
+	int in_pitches[2] = {width, width};
 
-			wuv+=2;
-			wy+=2;
-		}
-		huv++;
-	}
+	nv61_to_yuyv_planes(framebuffer, in_planes, in_pitches, width, height);
 }
 
 /*
@@ -2378,6 +2631,40 @@ void y41p_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int heig
 	}
 }
 
+/*
+ * convert yuv mono (grey) planes to yuv 422
+ * args:
+ *    out - pointer to output buffer (yuyv)
+ *    in - input planes (y)
+ *    in_pitches - input plane pitches
+ *    width - picture width
+ *    height - picture height
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void grey_to_yuyv_planes(uint8_t *out, uint8_t **in, int *in_pitches, int width, int height)
+{
+	/*assertions*/
+	assert(out);
+	assert(in);
+
+	int h = 0;
+	for(h = 0; h < height; h++)
+	{
+		uint8_t *py = in[0] + (h * in_pitches[0]);
+		int w = 0;
+		for(w = 0; w < width; w++)
+		{
+			*out++ = py[w]; //Y
+			*out++ = 0x80;  //U or V
+		}
+	}
+}
+
 /*
  * convert yuv mono (grey) to yuv 422
  * args:
@@ -2393,18 +2680,9 @@ void y41p_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int heig
  */
 void grey_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int height)
 {
-	int h=0;
+	int in_pitch = width;
 
-	for(h=0;h<height;h++)
-	{
-		int offset = width * h;
-		int w = 0;
-		for(w=0;w<width;w++)
-		{
-			*framebuffer++=tmpbuffer[w + offset]; //Y
-			*framebuffer++=0x80;                  //U or V
-		}
-	}
+	grey_to_yuyv_planes(framebuffer, &tmpbuffer, &in_pitch, width, height);
 }
 
 /*
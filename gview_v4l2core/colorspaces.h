@@ -40,6 +40,24 @@
  */
 void yuyv_to_yu12(uint8_t *out, uint8_t *in, int width, int height);
 
+/*
+ *convert from packed 422 yuv (yuyv) to 420 planar (yu12) planes
+ * args:
+ *    out - output yu12 planes (y, u, v)
+ *    out_pitches - output plane pitches
+ *    in - input planes (yuyv packed data)
+ *    in_pitches - input plane pitches (bytes per line)
+ *    width - frame width
+ *    height - frame height
+ *
+ * asserts:
+ *    in is not null
+ *    out is not null
+ *
+ * returns: none
+ */
+void yuyv_to_yu12_planes(uint8_t **out, int *out_pitches, uint8_t **in, int *in_pitches, int width, int height);
+
 /*
  *convert from packed 422 yuv (yvyu) to 420 planar (yu12)
  * args:
@@ -56,6 +74,24 @@ void yuyv_to_yu12(uint8_t *out, uint8_t *in, int width, int height);
  */
 void yvyu_to_yu12(uint8_t *out, uint8_t *in, int width, int height);
 
+/*
+ *convert from packed 422 yuv (yvyu) to 420 planar (yu12) planes
+ * args:
+ *    out - output yu12 planes (y, u, v)
+ *    out_pitches - output plane pitches
+ *    in - input planes (yvyu packed data)
+ *    in_pitches - input plane pitches (bytes per line)
+ *    width - frame width
+ *    height - frame height
+ *
+ * asserts:
+ *    in is not null
+ *    out is not null
+ *
+ * returns: none
+ */
+void yvyu_to_yu12_planes(uint8_t **out, int *out_pitches, uint8_t **in, int *in_pitches, int width, int height);
+
 /*
  *convert from packed 422 yuv (uyvy) to 420 planar (yu12)
  * args:
@@ -72,6 +108,24 @@ void yvyu_to_yu12(uint8_t *out, uint8_t *in, int width, int height);
  */
 void uyvy_to_yu12(uint8_t *out, uint8_t *in, int width, int height);
 
+/*
+ *convert from packed 422 yuv (uyvy) to 420 planar (yu12) planes
+ * args:
+ *    out - output yu12 planes (y, u, v)
+ *    out_pitches - output plane pitches
+ *    in - input planes (uyvy packed data)
+ *    in_pitches - input plane pitches (bytes per line)
+ *    width - frame width
+ *    height - frame height
+ *
+ * asserts:
+ *    in is not null
+ *    out is not null
+ *
+ * returns: none
+ */
+void uyvy_to_yu12_planes(uint8_t **out, int *out_pitches, uint8_t **in, int *in_pitches, int width, int height);
+
 /*
  *convert from 422 planar yuv to 420 planar (yu12)
  * args:
@@ -88,6 +142,24 @@ void uyvy_to_yu12(uint8_t *out, uint8_t *in, int width, int height);
  */
 void yuv422p_to_yu12(uint8_t *out, uint8_t *in, int width, int height);
 
+/*
+ *convert from 422 planar yuv to 420 planar (yu12) planes
+ * args:
+ *    out - output yu12 planes (y, u, v)
+ *    out_pitches - output plane pitches
+ *    in - input planes (y, u, v)
+ *    in_pitches - input plane pitches
+ *    width - frame width
+ *    height - frame height
+ *
+ * asserts:
+ *    in is not null
+ *    out is not null
+ *
+ * returns: none
+ */
+void yuv422p_to_yu12_planes(uint8_t **out, int *out_pitches, uint8_t **in, int *in_pitches, int width, int height);
+
 /*
  * convert yyuv (packed) to yuv420 planar (yu12)
  * args:
@@ -104,6 +176,24 @@ void yuv422p_to_yu12(uint8_t *out, uint8_t *in, int width, int height);
  */
 void yyuv_to_yu12(uint8_t *out, uint8_t *in, int width, int height);
 
+/*
+ * convert yyuv (packed) to yuv420 planar (yu12) planes
+ * args:
+ *    out: output yu12 planes (y, u, v)
+ *    out_pitches: output plane pitches
+ *    in: input planes (yyuv packed data)
+ *    in_pitches: input plane pitches (bytes per line)
+ *    width: picture width
+ *    height: picture height
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void yyuv_to_yu12_planes(uint8_t **out, int *out_pitches, uint8_t **in, int *in_pitches, int width, int height);
+
 /*
  *convert from 420 planar (yv12) to 420 planar (yu12)
  * args:
@@ -120,6 +210,42 @@ void yyuv_to_yu12(uint8_t *out, uint8_t *in, int width, int height);
  */
 void yv12_to_yu12(uint8_t *out, uint8_t *in, int width, int height);
 
+/*
+ *copy 420 planar (yu12) planes (any pitch)
+ * args:
+ *    out - output yu12 planes (y, u, v)
+ *    out_pitches - output plane pitches
+ *    in - input yu12 planes (y, u, v)
+ *    in_pitches - input plane pitches
+ *    width - frame width
+ *    height - frame height
+ *
+ * asserts:
+ *    in is not null
+ *    out is not null
+ *
+ * returns: none
+ */
+void yu12_to_yu12_planes(uint8_t **out, int *out_pitches, uint8_t **in, int *in_pitches, int width, int height);
+
+/*
+ *convert from 420 planar (yv12) to 420 planar (yu12) planes
+ * args:
+ *    out - output yu12 planes (y, u, v)
+ *    out_pitches - output plane pitches
+ *    in - input yv12 planes (y, v, u)
+ *    in_pitches - input plane pitches
+ *    width - frame width
+ *    height - frame height
+ *
+ * asserts:
+ *    in is not null
+ *    out is not null
+ *
+ * returns: none
+ */
+void yv12_to_yu12_planes(uint8_t **out, int *out_pitches, uint8_t **in, int *in_pitches, int width, int height);
+
 /*
  * convert nv12 planar (uv interleaved) to yuv420 planar (yu12)
  * args:
@@ -136,6 +262,24 @@ void yv12_to_yu12(uint8_t *out, uint8_t *in, int width, int height);
  */
 void nv12_to_yu12(uint8_t *out, uint8_t *in, int width, int height);
 
+/*
+ * convert nv12 planar (uv interleaved) to yuv420 planar (yu12) planes
+ * args:
+ *    out: output yu12 planes (y, u, v)
+ *    out_pitches: output plane pitches
+ *    in: input planes (y, uv)
+ *    in_pitches: input plane pitches
+ *    width: picture width
+ *    height: picture height
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void nv12_to_yu12_planes(uint8_t **out, int *out_pitches, uint8_t **in, int *in_pitches, int width, int height);
+
 /*
  * convert nv21 planar (vu interleaved) to yuv420 planar (yu12)
  * args:
@@ -152,6 +296,24 @@ void nv12_to_yu12(uint8_t *out, uint8_t *in, int width, int height);
  */
 void nv21_to_yu12(uint8_t *out, uint8_t *in, int width, int height);
 
+/*
+ * convert nv21 planar (vu interleaved) to yuv420 planar (yu12) planes
+ * args:
+ *    out: output yu12 planes (y, u, v)
+ *    out_pitches: output plane pitches
+ *    in: input planes (y, vu)
+ *    in_pitches: input plane pitches
+ *    width: picture width
+ *    height: picture height
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void nv21_to_yu12_planes(uint8_t **out, int *out_pitches, uint8_t **in, int *in_pitches, int width, int height);
+
 /*
  * convert yuv 422 planar (uv interleaved) (nv16) to yuv420 planar (yu12)
  * args:
@@ -168,6 +330,24 @@ void nv21_to_yu12(uint8_t *out, uint8_t *in, int width, int height);
  */
 void nv16_to_yu12 (uint8_t *out, uint8_t *in, int width, int height);
 
+/*
+ * convert yuv 422 planar (uv interleaved) (nv16) to yuv420 planar (yu12) planes
+ * args:
+ *   out: output yu12 planes (y, u, v)
+ *   out_pitches: output plane pitches
+ *   in: input planes (y, uv)
+ *   in_pitches: input plane pitches
+ *   width: picture width
+ *   height: picture height
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void nv16_to_yu12_planes(uint8_t **out, int *out_pitches, uint8_t **in, int *in_pitches, int width, int height);
+
 /*
  * convert yuv 422 planar (vu interleaved) (nv61) to yuv420 planar (yu12)
  * args:
@@ -184,6 +364,24 @@ void nv16_to_yu12 (uint8_t *out, uint8_t *in, int width, int height);
  */
 void nv61_to_yu12 (uint8_t *out, uint8_t *in, int width, int height);
 
+/*
+ * convert yuv 422 planar (vu interleaved) (nv61) to yuv420 planar (yu12) planes
+ * args:
+ *   out: output yu12 planes (y, u, v)
+ *   out_pitches: output plane pitches
+ *   in: input planes (y, vu)
+ *   in_pitches: input plane pitches
+ *   width: picture width
+ *   height: picture height
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void nv61_to_yu12_planes(uint8_t **out, int *out_pitches, uint8_t **in, int *in_pitches, int width, int height);
+
 /*
  * convert y10b (bit-packed array greyscale format) to yu12
  * args:
@@ -200,6 +398,40 @@ void nv61_to_yu12 (uint8_t *out, uint8_t *in, int width, int height);
  */
 void y10b_to_yu12(uint8_t *out, uint8_t *in, int width, int height);
 
+/*
+ * unpack y10b (bit-packed array greyscale format) to 16 bit luma
+ *   (full 10 bit precision)
+ * args:
+ *   out: pointer to output buffer (width * height samples)
+ *   in: pointer to input buffer containing y10b (bit-packed array) data frame
+ *   width: picture width
+ *   height: picture height
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void y10b_to_y16(uint16_t *out, uint8_t *in, int width, int height);
+
+/*
+ * convert 16 bit luma to yu12 (8 bit display copy)
+ * args:
+ *   out: pointer to output buffer (yu12)
+ *   in: pointer to 16 bit luma samples
+ *   width: picture width
+ *   height: picture height
+ *   bits: significant bits in the luma samples (8 to 16)
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void luma16_to_yu12(uint8_t *out, uint16_t *in, int width, int height, int bits);
+
 /*
  * convert yuv 411 packed (y41p) to planar yuv 420 (yu12)
  * args:
@@ -232,6 +464,24 @@ void y41p_to_yu12(uint8_t *out, uint8_t *in, int width, int height);
  */
 void grey_to_yu12(uint8_t *out, uint8_t *in, int width, int height);
 
+/*
+ * convert grey (luma only) planes to yu12 planes
+ * args:
+ *   out: output yu12 planes (y, u, v)
+ *   out_pitches: output plane pitches
+ *   in: input planes (y)
+ *   in_pitches: input plane pitches
+ *   width: picture width
+ *   height: picture height
+ *
+ * asserts:
+ *   out is not null
+ *   in is not null
+ *
+ * returns: none
+ */
+void grey_to_yu12_planes(uint8_t **out, int *out_pitches, uint8_t **in, int *in_pitches, int width, int height);
+
 /*
  * convert y16 (16 bit greyscale format) to yu12
  * args:
@@ -333,6 +583,31 @@ void rgb24_to_yu12(uint8_t *out, uint8_t *in, int width, int height);
  */
 void bgr24_to_yu12(uint8_t *out, uint8_t *in, int width, int height);
 
+/*
+ * yu12/yuyv to rgb flags
+ */
+#define CS_RGB_BGR  (1) //bgr byte order
+#define CS_RGB_FLIP (2) //lines upsidedown (bitmap files)
+
+/*
+ * yu12 to rgb24 (or bgr24)
+ * args:
+ *    out - pointer to output rgb data buffer
+ *    in - pointer to input yu12 data buffer
+ *    width - buffer width (in pixels)
+ *    height - buffer height (in pixels)
+ *    matrix - YUV_MATRIX_xxx
+ *    range - YUV_RANGE_xxx
+ *    flags - CS_RGB_BGR: bgr byte order; CS_RGB_FLIP: lines upsidedown
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void yu12_to_rgb(uint8_t *out, uint8_t *in, int width, int height, int matrix, int range, int flags);
+
 /*
  * yu12 to rgb24
  * args:
@@ -364,6 +639,23 @@ void yu12_to_rgb24 (uint8_t *out, uint8_t *in, int width, int height);
  */
 void yu12_to_dib24 (uint8_t *out, uint8_t *in, int width, int height);
 
+/*
+ * convert yuv 420 planar (yu12) planes to yuv 422 (yuyv)
+ * args:
+ *    out - pointer to output buffer (yuyv)
+ *    in - input planes (y, u, v)
+ *    in_pitches - input plane pitches
+ *    width - picture width
+ *    height - picture height
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void yu12_to_yuyv_planes(uint8_t *out, uint8_t **in, int *in_pitches, int width, int height);
+
 /*
  * convert yuv 420 planar (yu12) to yuv 422
  * args:
@@ -380,6 +672,25 @@ void yu12_to_dib24 (uint8_t *out, uint8_t *in, int width, int height);
  */
 void yu12_to_yuyv (uint8_t *out, uint8_t *in, int width, int height);
 
+/*
+ * yuyv to rgb24 (or bgr24)
+ * args:
+ *    out - pointer to output rgb data buffer
+ *    in - pointer to input yuyv data buffer
+ *    width - buffer width (in pixels)
+ *    height - buffer height (in pixels)
+ *    matrix - YUV_MATRIX_xxx
+ *    range - YUV_RANGE_xxx
+ *    flags - CS_RGB_BGR: bgr byte order; CS_RGB_FLIP: lines upsidedown
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void yuyv_to_rgb(uint8_t *out, uint8_t *in, int width, int height, int matrix, int range, int flags);
+
 /*
  * regular yuv (YUYV) to rgb24
  * args:
@@ -457,6 +768,40 @@ void y10b_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int heig
  */
 void y16_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int height);
 
+/*
+ * convert 16 bit luma to yuyv (8 bit display copy)
+ * args:
+ *   out: pointer to output buffer (yuyv)
+ *   in: pointer to 16 bit luma samples
+ *   width: picture width
+ *   height: picture height
+ *   bits: significant bits in the luma samples (8 to 16)
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void luma16_to_yuyv(uint8_t *out, uint16_t *in, int width, int height, int bits);
+
+/*
+ * convert yyuv (packed) planes to yuyv (packed)
+ * args:
+ *    out - pointer to output buffer (yuyv)
+ *    in - input planes (yyuv packed data)
+ *    in_pitches - input plane pitches (bytes per line)
+ *    width - picture width
+ *    height - picture height
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void yyuv_to_yuyv_planes(uint8_t *out, uint8_t **in, int *in_pitches, int width, int height);
+
 /*
  * convert yyuv (packed) to yuyv (packed)
  * args:
@@ -472,6 +817,23 @@ void y16_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int heigh
  */
 void yyuv_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int height);
 
+/*
+ * convert uyvy (packed) planes to yuyv (packed)
+ * args:
+ *    out - pointer to output buffer (yuyv)
+ *    in - input planes (uyvy packed data)
+ *    in_pitches - input plane pitches (bytes per line)
+ *    width - picture width
+ *    height - picture height
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void uyvy_to_yuyv_planes(uint8_t *out, uint8_t **in, int *in_pitches, int width, int height);
+
 /*
  * convert uyvy (packed) to yuyv (packed)
  * args:
@@ -487,6 +849,23 @@ void yyuv_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int heig
  */
 void uyvy_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int height);
 
+/*
+ * convert yvyu (packed) planes to yuyv (packed)
+ * args:
+ *    out - pointer to output buffer (yuyv)
+ *    in - input planes (yvyu packed data)
+ *    in_pitches - input plane pitches (bytes per line)
+ *    width - picture width
+ *    height - picture height
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void yvyu_to_yuyv_planes(uint8_t *out, uint8_t **in, int *in_pitches, int width, int height);
+
 /*
  * convert yvyu (packed) to yuyv (packed)
  * args:
@@ -502,6 +881,23 @@ void uyvy_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int heig
  */
 void yvyu_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int height);
 
+/*
+ * convert yvu 420 planar (yv12) planes to yuv 422 (yuyv)
+ * args:
+ *    out - pointer to output buffer (yuyv)
+ *    in - input planes (y, v, u)
+ *    in_pitches - input plane pitches
+ *    width - picture width
+ *    height - picture height
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void yvu420_to_yuyv_planes(uint8_t *out, uint8_t **in, int *in_pitches, int width, int height);
+
 /*
  * convert yvu 420 planar (yv12) to yuv 422
  * args:
@@ -517,6 +913,23 @@ void yvyu_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int heig
  */
 void yvu420_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int height);
 
+/*
+ * convert yuv 420 planar (uv interleaved) (nv12) planes to yuv 422 (yuyv)
+ * args:
+ *    out - pointer to output buffer (yuyv)
+ *    in - input planes (y, uv)
+ *    in_pitches - input plane pitches
+ *    width - picture width
+ *    height - picture height
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void nv12_to_yuyv_planes(uint8_t *out, uint8_t **in, int *in_pitches, int width, int height);
+
 /*
  * convert yuv 420 planar (uv interleaved) (nv12) to yuv 422
  * args:
@@ -532,6 +945,23 @@ void yvu420_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int he
  */
 void nv12_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int height);
 
+/*
+ * convert yuv 420 planar (vu interleaved) (nv21) planes to yuv 422 (yuyv)
+ * args:
+ *    out - pointer to output buffer (yuyv)
+ *    in - input planes (y, vu)
+ *    in_pitches - input plane pitches
+ *    width - picture width
+ *    height - picture height
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void nv21_to_yuyv_planes(uint8_t *out, uint8_t **in, int *in_pitches, int width, int height);
+
 /*
  * convert yuv 420 planar (vu interleaved) (nv21) to yuv 422
  * args:
@@ -547,6 +977,23 @@ void nv12_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int heig
  */
 void nv21_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int height);
 
+/*
+ * convert yuv 422 planar (uv interleaved) (nv16) planes to yuv 422 (yuyv)
+ * args:
+ *    out - pointer to output buffer (yuyv)
+ *    in - input planes (y, uv)
+ *    in_pitches - input plane pitches
+ *    width - picture width
+ *    height - picture height
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void nv16_to_yuyv_planes(uint8_t *out, uint8_t **in, int *in_pitches, int width, int height);
+
 /*
  * convert yuv 422 planar (uv interleaved) (nv16) to yuv 422
  * args:
@@ -562,6 +1009,23 @@ void nv21_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int heig
  */
 void nv16_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int height);
 
+/*
+ * convert yuv 422 planar (vu interleaved) (nv61) planes to yuv 422 (yuyv)
+ * args:
+ *    out - pointer to output buffer (yuyv)
+ *    in - input planes (y, vu)
+ *    in_pitches - input plane pitches
+ *    width - picture width
+ *    height - picture height
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void nv61_to_yuyv_planes(uint8_t *out, uint8_t **in, int *in_pitches, int width, int height);
+
 /*
  * convert yuv 422 planar (vu interleaved) (nv61) to yuv 422
  * args:
@@ -592,6 +1056,23 @@ void nv61_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int heig
  */
 void y41p_to_yuyv (uint8_t *framebuffer, uint8_t *tmpbuffer, int width, int height);
 
+/*
+ * convert yuv mono (grey) planes to yuv 422
+ * args:
+ *    out - pointer to output buffer (yuyv)
+ *    in - input planes (y)
+ *    in_pitches - input plane pitches
+ *    width - picture width
+ *    height - picture height
+ *
+ * asserts:
+ *    out is not null
+ *    in is not null
+ *
+ * returns: none
+ */
+void grey_to_yuyv_planes(uint8_t *out, uint8_t **in, int *in_pitches, int width, int height);
+
 /*
  * convert yuv mono (grey) to yuv 422
  * args:
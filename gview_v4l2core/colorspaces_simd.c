@@ -0,0 +1,1213 @@
+/*******************************************************************************#
+#           guvcview              http://guvcview.sourceforge.net               #
+#                                                                               #
+#           Paulo Assis <pj.assis@gmail.com>                                    #
+#                                                                               #
+# This program is free software; you can redistribute it and/or modify          #
+# it under the terms of the GNU General Public License as published by          #
+# the Free Software Foundation; either version 2 of the License, or             #
+# (at your option) any later version.                                           #
+#                                                                               #
+# This program is distributed in the hope that it will be useful,               #
+# but WITHOUT ANY WARRANTY; without even the implied warranty of                #
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 #
+# GNU General Public License for more details.                                  #
+#                                                                               #
+# You should have received a copy of the GNU General Public License             #
+# along with this program; if not, write to the Free Software                   #
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA     #
+#                                                                               #
+********************************************************************************/
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "colorspaces_simd.h"
+#include "gview.h"
+
+/*x86: sse2 and avx2 kernels (selected by cpuid)*/
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define CS_X86 1
+#include <immintrin.h>
+#define CS_TARGET_SSE2 __attribute__((target("sse2")))
+#define CS_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+extern int verbosity;
+
+/*
+ * rgb to yuv in Q7 fixed point (same coefficients as rgb24_to_yu12)
+ *   y = 0.299 r + 0.587 g + 0.114 b
+ *   u = -0.147 r - 0.289 g + 0.436 b + 128
+ *   v = 0.615 r - 0.515 g - 0.100 b + 128
+ *   products and sums fit in 16 bit signed lanes
+ */
+#define CS_YR 38
+#define CS_YG 75
+#define CS_YB 15
+#define CS_UR (-19)
+#define CS_UG (-37)
+#define CS_UB 56
+#define CS_VR 79
+#define CS_VG (-66)
+#define CS_VB (-13)
+
+#define CS_AVG(a, b) (((a) + (b) + 1) >> 1)
+
+/*------------------------------ scalar kernels ------------------------------*/
+
+/*
+ * two rows of packed 422 (yuyv or uyvy) to yu12
+ *   the chroma of both rows is averaged (rounded)
+ * args:
+ *    py1 - pointer to first luma row
+ *    py2 - pointer to second luma row
+ *    pu - pointer to u row
+ *    pv - pointer to v row
+ *    in1 - pointer to first packed row
+ *    in2 - pointer to second packed row
+ *    width - row width in pixels (even)
+ *    y_first - 1: yuyv byte order; 0: uyvy byte order
+ *
+ * asserts:
+ *    none
+ *
+ * returns: none
+ */
+static void packed422_rows_c(uint8_t *py1, uint8_t *py2, uint8_t *pu, uint8_t *pv,
+	const uint8_t *in1, const uint8_t *in2, int width, int y_first)
+{
+	int yo = y_first ? 0 : 1; /*luma offset in the 4 byte group*/
+	int co = 1 - yo; /*chroma offset in the 4 byte group*/
+	int w = 0;
+
+	for(w = 0; w < width; w += 2)
+	{
+		*py1++ = in1[yo];
+		*py1++ = in1[yo + 2];
+		*py2++ = in2[yo];
+		*py2++ = in2[yo + 2];
+		*pu++ = (in1[co] + in2[co] + 1) >> 1;
+		*pv++ = (in1[co + 2] + in2[co + 2] + 1) >> 1;
+		in1 += 4;
+		in2 += 4;
+	}
+}
+
+/*
+ * split interleaved uv samples
+ * args:
+ *    pu - pointer to u samples
+ *    pv - pointer to v samples
+ *    in - pointer to interleaved uv samples
+ *    n - number of uv pairs
+ *
+ * asserts:
+ *    none
+ *
+ * returns: none
+ */
+static void split_uv_c(uint8_t *pu, uint8_t *pv, const uint8_t *in, int n)
+{
+	int i = 0;
+	for(i = 0; i < n; i++)
+	{
+		*pu++ = *in++;
+		*pv++ = *in++;
+	}
+}
+
+/*
+ * split and average two rows of interleaved uv samples
+ * args:
+ *    pu - pointer to u samples
+ *    pv - pointer to v samples
+ *    in1 - pointer to first row of interleaved uv samples
+ *    in2 - pointer to second row of interleaved uv samples
+ *    n - number of uv pairs
+ *
+ * asserts:
+ *    none
+ *
+ * returns: none
+ */
+static void split_uv_rows_c(uint8_t *pu, uint8_t *pv, const uint8_t *in1, const uint8_t *in2, int n)
+{
+	int i = 0;
+	for(i = 0; i < n; i++)
+	{
+		*pu++ = (in1[0] + in2[0] + 1) >> 1;
+		*pv++ = (in1[1] + in2[1] + 1) >> 1;
+		in1 += 2;
+		in2 += 2;
+	}
+}
+
+/*
+ * average two rows of samples (rounded)
+ * args:
+ *    out - pointer to output row
+ *    in1 - pointer to first row
+ *    in2 - pointer to second row
+ *    n - number of samples
+ *
+ * asserts:
+ *    none
+ *
+ * returns: none
+ */
+static void average_rows_c(uint8_t *out, const uint8_t *in1, const uint8_t *in2, int n)
+{
+	int i = 0;
+	for(i = 0; i < n; i++)
+		out[i] = (in1[i] + in2[i] + 1) >> 1;
+}
+
+/*
+ * bilinear demosaic of a range of bayer row samples
+ *   borders are mirrored (column -1 is column 1), which keeps the bayer parity
+ * args:
+ *    pg - pointer to green row
+ *    px - pointer to row of the color sampled in this row
+ *    py - pointer to row of the other color
+ *    up - pointer to bayer row above
+ *    c - pointer to bayer row
+ *    dn - pointer to bayer row below
+ *    width - row width
+ *    g_first - 1: row starts with a green sample
+ *    x0 - first sample
+ *    x1 - last sample (exclusive)
+ *
+ * asserts:
+ *    none
+ *
+ * returns: none
+ */
+static void bayer_range_c(uint8_t *pg, uint8_t *px, uint8_t *py,
+	const uint8_t *up, const uint8_t *c, const uint8_t *dn, int width, int g_first, int x0, int x1)
+{
+	int x = 0;
+
+	for(x = x0; x < x1; x++)
+	{
+		int l = (x > 0) ? x - 1 : 1;
+		int r = (x < width - 1) ? x + 1 : width - 2;
+
+		int hv = CS_AVG(c[l], c[r]);
+		int vv = CS_AVG(up[x], dn[x]);
+
+		if(((x & 1) == 0) == (g_first != 0))
+		{
+			/*green sample: x on the sides, y above and below*/
+			pg[x] = c[x];
+			px[x] = hv;
+			py[x] = vv;
+		}
+		else
+		{
+			/*x sample: green on the sides and above/below, y on the diagonals*/
+			pg[x] = CS_AVG(hv, vv);
+			px[x] = c[x];
+			py[x] = CS_AVG(CS_AVG(up[l], up[r]), CS_AVG(dn[l], dn[r]));
+		}
+	}
+}
+
+/*
+ * bilinear demosaic of a bayer row
+ *   args as in bayer_range_c (whole row)
+ */
+static void bayer_row_c(uint8_t *pg, uint8_t *px, uint8_t *py,
+	const uint8_t *up, const uint8_t *c, const uint8_t *dn, int width, int g_first)
+{
+	bayer_range_c(pg, px, py, up, c, dn, width, g_first, 0, width);
+}
+
+/*
+ * clip to 0-255
+ */
+static inline uint8_t cs_clip(int v)
+{
+	return (v < 0) ? 0 : ((v > 255) ? 255 : v);
+}
+
+/*
+ * two rows of planar rgb to yu12 (range of samples)
+ * args:
+ *    py1 - pointer to first luma row
+ *    py2 - pointer to second luma row
+ *    pu - pointer to u row
+ *    pv - pointer to v row
+ *    r1, g1, b1 - pointers to first rgb row
+ *    r2, g2, b2 - pointers to second rgb row
+ *    x0 - first sample (even)
+ *    x1 - last sample (exclusive, even)
+ *
+ * asserts:
+ *    none
+ *
+ * returns: none
+ */
+static void rgb_range_to_yu12_c(uint8_t *py1, uint8_t *py2, uint8_t *pu, uint8_t *pv,
+	const uint8_t *r1, const uint8_t *g1, const uint8_t *b1,
+	const uint8_t *r2, const uint8_t *g2, const uint8_t *b2, int x0, int x1)
+{
+	int x = 0;
+
+	for(x = x0; x < x1; x++)
+	{
+		py1[x] = (CS_YR * r1[x] + CS_YG * g1[x] + CS_YB * b1[x] + 64) >> 7;
+		py2[x] = (CS_YR * r2[x] + CS_YG * g2[x] + CS_YB * b2[x] + 64) >> 7;
+	}
+
+	for(x = x0; x < x1; x += 2)
+	{
+		int r = (r1[x] + r1[x + 1] + r2[x] + r2[x + 1] + 2) >> 2;
+		int g = (g1[x] + g1[x + 1] + g2[x] + g2[x + 1] + 2) >> 2;
+		int b = (b1[x] + b1[x + 1] + b2[x] + b2[x + 1] + 2) >> 2;
+
+		pu[x / 2] = cs_clip(((CS_UR * r + CS_UG * g + CS_UB * b + 64) >> 7) + 128);
+		pv[x / 2] = cs_clip(((CS_VR * r + CS_VG * g + CS_VB * b + 64) >> 7) + 128);
+	}
+}
+
+/*
+ * two rows of planar rgb to yu12
+ *   args as in rgb_range_to_yu12_c (whole row)
+ */
+static void rgb_rows_to_yu12_c(uint8_t *py1, uint8_t *py2, uint8_t *pu, uint8_t *pv,
+	const uint8_t *r1, const uint8_t *g1, const uint8_t *b1,
+	const uint8_t *r2, const uint8_t *g2, const uint8_t *b2, int width)
+{
+	rgb_range_to_yu12_c(py1, py2, pu, pv, r1, g1, b1, r2, g2, b2, 0, width);
+}
+
+/*
+ * a range of a yuv row to packed rgb24 (chroma at half width)
+ *   same fixed point math (and results) as the simd kernels
+ * args:
+ *    out - pointer to rgb row
+ *    py - pointer to luma row
+ *    pu - pointer to u row
+ *    pv - pointer to v row
+ *    coef - conversion coefficients
+ *    bgr - 1: bgr byte order; 0: rgb byte order
+ *    x0 - first pixel (even)
+ *    x1 - last pixel (exclusive)
+ *
+ * asserts:
+ *    none
+ *
+ * returns: none
+ */
+static void yuv_range_to_rgb_c(uint8_t *out, const uint8_t *py, const uint8_t *pu, const uint8_t *pv,
+	const cs_yuv2rgb_t *coef, int bgr, int x0, int x1)
+{
+	int x = 0;
+
+	for(x = x0; x < x1; x++)
+	{
+		int u = pu[x / 2] - 128;
+		int v = pv[x / 2] - 128;
+		int ys = (int) ((((uint32_t) py[x] << 8) * coef->y_mul) >> 16) + coef->y_bias;
+
+		uint8_t r = cs_clip((ys + coef->rv * v) >> 6);
+		uint8_t g = cs_clip((ys - (coef->gu * u + coef->gv * v)) >> 6);
+		uint8_t b = cs_clip((ys + coef->bu * u) >> 6);
+
+		out[3 * x] = bgr ? b : r;
+		out[3 * x + 1] = g;
+		out[3 * x + 2] = bgr ? r : b;
+	}
+}
+
+/*
+ * a row of yuv to packed rgb24
+ *   args as in yuv_range_to_rgb_c (whole row)
+ */
+static void yuv_row_to_rgb_c(uint8_t *out, const uint8_t *py, const uint8_t *pu, const uint8_t *pv,
+	int width, const cs_yuv2rgb_t *coef, int bgr)
+{
+	yuv_range_to_rgb_c(out, py, pu, pv, coef, bgr, 0, width);
+}
+
+/*
+ * unpack y10b samples (range)
+ * args:
+ *    out - pointer to 16 bit samples (whole buffer)
+ *    in - pointer to y10b data (whole buffer)
+ *    x0 - first sample (multiple of 4)
+ *    n - number of samples
+ *
+ * asserts:
+ *    none
+ *
+ * returns: none
+ */
+static void unpack_y10b_range_c(uint16_t *out, const uint8_t *in, int x0, int n)
+{
+	const uint8_t *p = in + (x0 / 4) * 5;
+	int x = x0;
+
+	/*4 samples in 5 bytes*/
+	for(; x + 4 <= n; x += 4, p += 5)
+	{
+		out[x] = (p[0] << 2) | (p[1] >> 6);
+		out[x + 1] = ((p[1] & 0x3F) << 4) | (p[2] >> 4);
+		out[x + 2] = ((p[2] & 0x0F) << 6) | (p[3] >> 2);
+		out[x + 3] = ((p[3] & 0x03) << 8) | p[4];
+	}
+
+	/*last (incomplete) group*/
+	uint32_t buffer = 0;
+	int bits = 0;
+	for(; x < n; x++)
+	{
+		while(bits < 10)
+		{
+			buffer = (buffer << 8) | *p++;
+			bits += 8;
+		}
+		bits -= 10;
+		out[x] = (buffer >> bits) & 0x3FF;
+	}
+}
+
+/*
+ * unpack n y10b samples to 16 bit
+ *   args as in unpack_y10b_range_c (all samples)
+ */
+static void unpack_y10b_c(uint16_t *out, const uint8_t *in, int n)
+{
+	unpack_y10b_range_c(out, in, 0, n);
+}
+
+/*
+ * 16 bit samples to 8 bit (range)
+ * args:
+ *    out - pointer to 8 bit samples
+ *    in - pointer to 16 bit samples
+ *    shift - right shift
+ *    x0 - first sample
+ *    n - number of samples
+ *
+ * asserts:
+ *    none
+ *
+ * returns: none
+ */
+static void narrow_y16_range_c(uint8_t *out, const uint16_t *in, int shift, int x0, int n)
+{
+	int x = 0;
+	for(x = x0; x < n; x++)
+	{
+		int v = in[x] >> shift;
+		out[x] = (v > 255) ? 255 : v;
+	}
+}
+
+/*
+ * n 16 bit samples to 8 bit
+ *   args as in narrow_y16_range_c (all samples)
+ */
+static void narrow_y16_c(uint8_t *out, const uint16_t *in, int n, int shift)
+{
+	narrow_y16_range_c(out, in, shift, 0, n);
+}
+
+static const cs_kernels_t scalar_kernels =
+{
+	.name = "scalar",
+	.packed422_rows = packed422_rows_c,
+	.split_uv = split_uv_c,
+	.split_uv_rows = split_uv_rows_c,
+	.average_rows = average_rows_c,
+	.bayer_row = bayer_row_c,
+	.rgb_rows_to_yu12 = rgb_rows_to_yu12_c,
+	.yuv_row_to_rgb = yuv_row_to_rgb_c,
+	.unpack_y10b = unpack_y10b_c,
+	.narrow_y16 = narrow_y16_c,
+};
+
+#ifdef CS_X86
+/*------------------------------- sse2 kernels -------------------------------*/
+
+/*
+ * two rows of packed 422 to yu12 (16 pixels per iteration)
+ *   args as in packed422_rows_c
+ */
+static CS_TARGET_SSE2 void packed422_rows_sse2(uint8_t *py1, uint8_t *py2, uint8_t *pu, uint8_t *pv,
+	const uint8_t *in1, const uint8_t *in2, int width, int y_first)
+{
+	const __m128i mask = _mm_set1_epi16(0x00FF);
+	int w = 0;
+
+	for(w = 0; w + 16 <= width; w += 16)
+	{
+		__m128i a0 = _mm_loadu_si128((const __m128i *) (in1 + 2 * w));
+		__m128i a1 = _mm_loadu_si128((const __m128i *) (in1 + 2 * w + 16));
+		__m128i b0 = _mm_loadu_si128((const __m128i *) (in2 + 2 * w));
+		__m128i b1 = _mm_loadu_si128((const __m128i *) (in2 + 2 * w + 16));
+
+		/*even bytes and odd bytes of each row*/
+		__m128i ae = _mm_packus_epi16(_mm_and_si128(a0, mask), _mm_and_si128(a1, mask));
+		__m128i ao = _mm_packus_epi16(_mm_srli_epi16(a0, 8), _mm_srli_epi16(a1, 8));
+		__m128i be = _mm_packus_epi16(_mm_and_si128(b0, mask), _mm_and_si128(b1, mask));
+		__m128i bo = _mm_packus_epi16(_mm_srli_epi16(b0, 8), _mm_srli_epi16(b1, 8));
+
+		_mm_storeu_si128((__m128i *) (py1 + w), y_first ? ae : ao);
+		_mm_storeu_si128((__m128i *) (py2 + w), y_first ? be : bo);
+
+		/*uvuv... averaged over the two rows*/
+		__m128i c = y_first ? _mm_avg_epu8(ao, bo) : _mm_avg_epu8(ae, be);
+		__m128i u = _mm_packus_epi16(_mm_and_si128(c, mask), c);
+		__m128i v = _mm_packus_epi16(_mm_srli_epi16(c, 8), c);
+
+		_mm_storel_epi64((__m128i *) (pu + w / 2), u);
+		_mm_storel_epi64((__m128i *) (pv + w / 2), v);
+	}
+
+	if(w < width)
+		packed422_rows_c(py1 + w, py2 + w, pu + w / 2, pv + w / 2,
+			in1 + 2 * w, in2 + 2 * w, width - w, y_first);
+}
+
+/*
+ * split interleaved uv samples (16 pairs per iteration)
+ *   args as in split_uv_c
+ */
+static CS_TARGET_SSE2 void split_uv_sse2(uint8_t *pu, uint8_t *pv, const uint8_t *in, int n)
+{
+	const __m128i mask = _mm_set1_epi16(0x00FF);
+	int i = 0;
+
+	for(i = 0; i + 16 <= n; i += 16)
+	{
+		__m128i a0 = _mm_loadu_si128((const __m128i *) (in + 2 * i));
+		__m128i a1 = _mm_loadu_si128((const __m128i *) (in + 2 * i + 16));
+
+		_mm_storeu_si128((__m128i *) (pu + i),
+			_mm_packus_epi16(_mm_and_si128(a0, mask), _mm_and_si128(a1, mask)));
+		_mm_storeu_si128((__m128i *) (pv + i),
+			_mm_packus_epi16(_mm_srli_epi16(a0, 8), _mm_srli_epi16(a1, 8)));
+	}
+
+	if(i < n)
+		split_uv_c(pu + i, pv + i, in + 2 * i, n - i);
+}
+
+/*
+ * split and average two rows of interleaved uv samples (16 pairs per iteration)
+ *   args as in split_uv_rows_c
+ */
+static CS_TARGET_SSE2 void split_uv_rows_sse2(uint8_t *pu, uint8_t *pv, const uint8_t *in1, const uint8_t *in2, int n)
+{
+	const __m128i mask = _mm_set1_epi16(0x00FF);
+	int i = 0;
+
+	for(i = 0; i + 16 <= n; i += 16)
+	{
+		__m128i a0 = _mm_avg_epu8(_mm_loadu_si128((const __m128i *) (in1 + 2 * i)),
+			_mm_loadu_si128((const __m128i *) (in2 + 2 * i)));
+		__m128i a1 = _mm_avg_epu8(_mm_loadu_si128((const __m128i *) (in1 + 2 * i + 16)),
+			_mm_loadu_si128((const __m128i *) (in2 + 2 * i + 16)));
+
+		_mm_storeu_si128((__m128i *) (pu + i),
+			_mm_packus_epi16(_mm_and_si128(a0, mask), _mm_and_si128(a1, mask)));
+		_mm_storeu_si128((__m128i *) (pv + i),
+			_mm_packus_epi16(_mm_srli_epi16(a0, 8), _mm_srli_epi16(a1, 8)));
+	}
+
+	if(i < n)
+		split_uv_rows_c(pu + i, pv + i, in1 + 2 * i, in2 + 2 * i, n - i);
+}
+
+/*
+ * average two rows of samples (16 samples per iteration)
+ *   args as in average_rows_c
+ */
+static CS_TARGET_SSE2 void average_rows_sse2(uint8_t *out, const uint8_t *in1, const uint8_t *in2, int n)
+{
+	int i = 0;
+
+	for(i = 0; i + 16 <= n; i += 16)
+		_mm_storeu_si128((__m128i *) (out + i),
+			_mm_avg_epu8(_mm_loadu_si128((const __m128i *) (in1 + i)),
+				_mm_loadu_si128((const __m128i *) (in2 + i))));
+
+	if(i < n)
+		average_rows_c(out + i, in1 + i, in2 + i, n - i);
+}
+
+/*
+ * bilinear demosaic of a bayer row (16 samples per iteration)
+ *   args as in bayer_row_c
+ */
+static CS_TARGET_SSE2 void bayer_row_sse2(uint8_t *pg, uint8_t *px, uint8_t *py,
+	const uint8_t *up, const uint8_t *c, const uint8_t *dn, int width, int g_first)
+{
+	/*lanes with a green sample (even samples if g_first)*/
+	__m128i gmask = _mm_set1_epi16(g_first ? 0x00FF : (short) 0xFF00);
+	int x = 2;
+
+	/*first samples (mirrored border)*/
+	bayer_range_c(pg, px, py, up, c, dn, width, g_first, 0, (width < 2) ? width : 2);
+
+	for(x = 2; x + 17 <= width; x += 16)
+	{
+		__m128i cc = _mm_loadu_si128((const __m128i *) (c + x));
+		__m128i hv = _mm_avg_epu8(_mm_loadu_si128((const __m128i *) (c + x - 1)),
+			_mm_loadu_si128((const __m128i *) (c + x + 1)));
+		__m128i vv = _mm_avg_epu8(_mm_loadu_si128((const __m128i *) (up + x)),
+			_mm_loadu_si128((const __m128i *) (dn + x)));
+		__m128i dv = _mm_avg_epu8(
+			_mm_avg_epu8(_mm_loadu_si128((const __m128i *) (up + x - 1)),
+				_mm_loadu_si128((const __m128i *) (up + x + 1))),
+			_mm_avg_epu8(_mm_loadu_si128((const __m128i *) (dn + x - 1)),
+				_mm_loadu_si128((const __m128i *) (dn + x + 1))));
+		__m128i gv = _mm_avg_epu8(hv, vv);
+
+		_mm_storeu_si128((__m128i *) (pg + x),
+			_mm_or_si128(_mm_and_si128(gmask, cc), _mm_andnot_si128(gmask, gv)));
+		_mm_storeu_si128((__m128i *) (px + x),
+			_mm_or_si128(_mm_and_si128(gmask, hv), _mm_andnot_si128(gmask, cc)));
+		_mm_storeu_si128((__m128i *) (py + x),
+			_mm_or_si128(_mm_and_si128(gmask, vv), _mm_andnot_si128(gmask, dv)));
+	}
+
+	if(x < width)
+		bayer_range_c(pg, px, py, up, c, dn, width, g_first, x, width);
+}
+
+/*
+ * luma of 8 samples (16 bit lanes) in Q7
+ */
+static CS_TARGET_SSE2 inline __m128i luma_sse2(__m128i r, __m128i g, __m128i b)
+{
+	__m128i y = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(CS_YR)),
+		_mm_mullo_epi16(g, _mm_set1_epi16(CS_YG)));
+	y = _mm_add_epi16(y, _mm_mullo_epi16(b, _mm_set1_epi16(CS_YB)));
+	return _mm_srli_epi16(_mm_add_epi16(y, _mm_set1_epi16(64)), 7);
+}
+
+/*
+ * chroma of 8 samples (16 bit lanes) in Q7 (+128, not clipped)
+ */
+static CS_TARGET_SSE2 inline __m128i chroma_sse2(__m128i r, __m128i g, __m128i b, short cr, short cg, short cb)
+{
+	__m128i c = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(cr)),
+		_mm_mullo_epi16(g, _mm_set1_epi16(cg)));
+	c = _mm_add_epi16(c, _mm_mullo_epi16(b, _mm_set1_epi16(cb)));
+	c = _mm_srai_epi16(_mm_add_epi16(c, _mm_set1_epi16(64)), 7);
+	return _mm_add_epi16(c, _mm_set1_epi16(128));
+}
+
+/*
+ * 2x2 average of 16 samples of two rows (8 results in 16 bit lanes)
+ */
+static CS_TARGET_SSE2 inline __m128i quad_avg_sse2(__m128i a, __m128i b)
+{
+	const __m128i mask = _mm_set1_epi16(0x00FF);
+	__m128i s = _mm_add_epi16(_mm_and_si128(a, mask), _mm_srli_epi16(a, 8));
+	s = _mm_add_epi16(s, _mm_add_epi16(_mm_and_si128(b, mask), _mm_srli_epi16(b, 8)));
+	return _mm_srli_epi16(_mm_add_epi16(s, _mm_set1_epi16(2)), 2);
+}
+
+/*
+ * two rows of planar rgb to yu12 (16 samples per iteration)
+ *   args as in rgb_rows_to_yu12_c
+ */
+static CS_TARGET_SSE2 void rgb_rows_to_yu12_sse2(uint8_t *py1, uint8_t *py2, uint8_t *pu, uint8_t *pv,
+	const uint8_t *r1, const uint8_t *g1, const uint8_t *b1,
+	const uint8_t *r2, const uint8_t *g2, const uint8_t *b2, int width)
+{
+	const __m128i zero = _mm_setzero_si128();
+	int x = 0;
+
+	for(x = 0; x + 16 <= width; x += 16)
+	{
+		__m128i ra = _mm_loadu_si128((const __m128i *) (r1 + x));
+		__m128i ga = _mm_loadu_si128((const __m128i *) (g1 + x));
+		__m128i ba = _mm_loadu_si128((const __m128i *) (b1 + x));
+		__m128i rb = _mm_loadu_si128((const __m128i *) (r2 + x));
+		__m128i gb = _mm_loadu_si128((const __m128i *) (g2 + x));
+		__m128i bb = _mm_loadu_si128((const __m128i *) (b2 + x));
+
+		_mm_storeu_si128((__m128i *) (py1 + x), _mm_packus_epi16(
+			luma_sse2(_mm_unpacklo_epi8(ra, zero), _mm_unpacklo_epi8(ga, zero), _mm_unpacklo_epi8(ba, zero)),
+			luma_sse2(_mm_unpackhi_epi8(ra, zero), _mm_unpackhi_epi8(ga, zero), _mm_unpackhi_epi8(ba, zero))));
+		_mm_storeu_si128((__m128i *) (py2 + x), _mm_packus_epi16(
+			luma_sse2(_mm_unpacklo_epi8(rb, zero), _mm_unpacklo_epi8(gb, zero), _mm_unpacklo_epi8(bb, zero)),
+			luma_sse2(_mm_unpackhi_epi8(rb, zero), _mm_unpackhi_epi8(gb, zero), _mm_unpackhi_epi8(bb, zero))));
+
+		__m128i r = quad_avg_sse2(ra, rb);
+		__m128i g = quad_avg_sse2(ga, gb);
+		__m128i b = quad_avg_sse2(ba, bb);
+
+		__m128i u = chroma_sse2(r, g, b, CS_UR, CS_UG, CS_UB);
+		__m128i v = chroma_sse2(r, g, b, CS_VR, CS_VG, CS_VB);
+		_mm_storel_epi64((__m128i *) (pu + x / 2), _mm_packus_epi16(u, u));
+		_mm_storel_epi64((__m128i *) (pv + x / 2), _mm_packus_epi16(v, v));
+	}
+
+	if(x < width)
+		rgb_range_to_yu12_c(py1, py2, pu, pv, r1, g1, b1, r2, g2, b2, x, width);
+}
+
+/*
+ * yuv to rgb for 8 pixels (16 bit lanes, u and v centered at 0)
+ *   k - broadcast coefficients (y_mul, y_bias, rv, gu, gv, bu)
+ *   returns r, g and b in Q0 (not clamped)
+ */
+static CS_TARGET_SSE2 inline void yuv_to_rgb_sse2(__m128i y, __m128i u, __m128i v, const __m128i *k,
+	__m128i *r, __m128i *g, __m128i *b)
+{
+	__m128i ys = _mm_add_epi16(_mm_mulhi_epu16(_mm_slli_epi16(y, 8), k[0]), k[1]);
+
+	*r = _mm_srai_epi16(_mm_adds_epi16(ys, _mm_mullo_epi16(v, k[2])), 6);
+	*g = _mm_srai_epi16(_mm_subs_epi16(ys,
+		_mm_adds_epi16(_mm_mullo_epi16(u, k[3]), _mm_mullo_epi16(v, k[4]))), 6);
+	*b = _mm_srai_epi16(_mm_adds_epi16(ys, _mm_mullo_epi16(u, k[5])), 6);
+}
+
+/*
+ * pack 4 pixels of 32 bit (c0 c1 c2 0) into 12 bytes (low bytes)
+ */
+static CS_TARGET_SSE2 inline __m128i pack_rgb_sse2(__m128i p)
+{
+	const __m128i even = _mm_set_epi32(0, 0x00FFFFFF, 0, 0x00FFFFFF);
+	const __m128i odd = _mm_set_epi32(0x00FFFFFF, 0, 0x00FFFFFF, 0);
+	const __m128i lo6 = _mm_set_epi32(0, 0, 0x0000FFFF, (int) 0xFFFFFFFF);
+
+	/*6 bytes in each 64 bit half*/
+	__m128i t = _mm_or_si128(_mm_and_si128(p, even), _mm_srli_epi64(_mm_and_si128(p, odd), 8));
+	/*move the upper 6 bytes down to bytes 6 to 11*/
+	return _mm_or_si128(_mm_and_si128(t, lo6), _mm_andnot_si128(lo6, _mm_srli_si128(t, 2)));
+}
+
+/*
+ * interleave 16 pixels of 3 channels into 48 bytes (c0 c1 c2 ...)
+ */
+static CS_TARGET_SSE2 inline void store_rgb_sse2(uint8_t *out, __m128i c0, __m128i c1, __m128i c2)
+{
+	const __m128i zero = _mm_setzero_si128();
+
+	__m128i c01_lo = _mm_unpacklo_epi8(c0, c1);
+	__m128i c01_hi = _mm_unpackhi_epi8(c0, c1);
+	__m128i c2z_lo = _mm_unpacklo_epi8(c2, zero);
+	__m128i c2z_hi = _mm_unpackhi_epi8(c2, zero);
+
+	/*each store overlaps the next one by 4 bytes*/
+	_mm_storeu_si128((__m128i *) out, pack_rgb_sse2(_mm_unpacklo_epi16(c01_lo, c2z_lo)));
+	_mm_storeu_si128((__m128i *) (out + 12), pack_rgb_sse2(_mm_unpackhi_epi16(c01_lo, c2z_lo)));
+	_mm_storeu_si128((__m128i *) (out + 24), pack_rgb_sse2(_mm_unpacklo_epi16(c01_hi, c2z_hi)));
+
+	__m128i last = pack_rgb_sse2(_mm_unpackhi_epi16(c01_hi, c2z_hi));
+	_mm_storel_epi64((__m128i *) (out + 36), last);
+	int tail = _mm_cvtsi128_si32(_mm_srli_si128(last, 8));
+	memcpy(out + 44, &tail, 4);
+}
+
+/*
+ * a row of yuv to packed rgb24 (16 pixels per iteration)
+ *   args as in yuv_row_to_rgb_c
+ */
+static CS_TARGET_SSE2 void yuv_row_to_rgb_sse2(uint8_t *out, const uint8_t *py, const uint8_t *pu, const uint8_t *pv,
+	int width, const cs_yuv2rgb_t *coef, int bgr)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i c128 = _mm_set1_epi16(128);
+	__m128i k[6];
+	k[0] = _mm_set1_epi16((short) coef->y_mul);
+	k[1] = _mm_set1_epi16(coef->y_bias);
+	k[2] = _mm_set1_epi16(coef->rv);
+	k[3] = _mm_set1_epi16(coef->gu);
+	k[4] = _mm_set1_epi16(coef->gv);
+	k[5] = _mm_set1_epi16(coef->bu);
+
+	int x = 0;
+	for(x = 0; x + 16 <= width; x += 16)
+	{
+		__m128i y = _mm_loadu_si128((const __m128i *) (py + x));
+		__m128i u = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) (pu + x / 2)), zero), c128);
+		__m128i v = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) (pv + x / 2)), zero), c128);
+
+		__m128i r0, g0, b0, r1, g1, b1;
+		yuv_to_rgb_sse2(_mm_unpacklo_epi8(y, zero), _mm_unpacklo_epi16(u, u), _mm_unpacklo_epi16(v, v),
+			k, &r0, &g0, &b0);
+		yuv_to_rgb_sse2(_mm_unpackhi_epi8(y, zero), _mm_unpackhi_epi16(u, u), _mm_unpackhi_epi16(v, v),
+			k, &r1, &g1, &b1);
+
+		__m128i r = _mm_packus_epi16(r0, r1);
+		__m128i g = _mm_packus_epi16(g0, g1);
+		__m128i b = _mm_packus_epi16(b0, b1);
+
+		if(bgr)
+			store_rgb_sse2(out + 3 * x, b, g, r);
+		else
+			store_rgb_sse2(out + 3 * x, r, g, b);
+	}
+
+	yuv_range_to_rgb_c(out, py, pu, pv, coef, bgr, x, width);
+}
+
+/*
+ * n 16 bit samples to 8 bit (16 samples per iteration)
+ *   args as in narrow_y16_c
+ */
+static CS_TARGET_SSE2 void narrow_y16_sse2(uint8_t *out, const uint16_t *in, int n, int shift)
+{
+	int x = 0;
+
+	/*packus is signed: a shift is needed to keep the samples positive*/
+	if(shift > 0)
+	{
+		__m128i count = _mm_cvtsi32_si128(shift);
+		for(x = 0; x + 16 <= n; x += 16)
+		{
+			__m128i a = _mm_srl_epi16(_mm_loadu_si128((const __m128i *) (in + x)), count);
+			__m128i b = _mm_srl_epi16(_mm_loadu_si128((const __m128i *) (in + x + 8)), count);
+			_mm_storeu_si128((__m128i *) (out + x), _mm_packus_epi16(a, b));
+		}
+	}
+
+	narrow_y16_range_c(out, in, shift, x, n);
+}
+
+static const cs_kernels_t sse2_kernels =
+{
+	.name = "sse2",
+	.packed422_rows = packed422_rows_sse2,
+	.split_uv = split_uv_sse2,
+	.split_uv_rows = split_uv_rows_sse2,
+	.average_rows = average_rows_sse2,
+	.bayer_row = bayer_row_sse2,
+	.rgb_rows_to_yu12 = rgb_rows_to_yu12_sse2,
+	.yuv_row_to_rgb = yuv_row_to_rgb_sse2,
+	/*no byte shuffle in sse2: 4 samples (5 bytes) per iteration*/
+	.unpack_y10b = unpack_y10b_c,
+	.narrow_y16 = narrow_y16_sse2,
+};
+
+/*------------------------------- avx2 kernels -------------------------------*/
+
+/*
+ * avx2 packs work inside each 128 bit lane:
+ *   reorder the 64 bit quads (0, 2, 1, 3) to get the samples in sequence
+ */
+#define CS_AVX2_FIXLANES(x) _mm256_permute4x64_epi64(x, 0xD8)
+
+/*
+ * two rows of packed 422 to yu12 (32 pixels per iteration)
+ *   args as in packed422_rows_c
+ */
+static CS_TARGET_AVX2 void packed422_rows_avx2(uint8_t *py1, uint8_t *py2, uint8_t *pu, uint8_t *pv,
+	const uint8_t *in1, const uint8_t *in2, int width, int y_first)
+{
+	const __m256i mask = _mm256_set1_epi16(0x00FF);
+	int w = 0;
+
+	for(w = 0; w + 32 <= width; w += 32)
+	{
+		__m256i a0 = _mm256_loadu_si256((const __m256i *) (in1 + 2 * w));
+		__m256i a1 = _mm256_loadu_si256((const __m256i *) (in1 + 2 * w + 32));
+		__m256i b0 = _mm256_loadu_si256((const __m256i *) (in2 + 2 * w));
+		__m256i b1 = _mm256_loadu_si256((const __m256i *) (in2 + 2 * w + 32));
+
+		/*even bytes and odd bytes of each row*/
+		__m256i ae = CS_AVX2_FIXLANES(_mm256_packus_epi16(_mm256_and_si256(a0, mask), _mm256_and_si256(a1, mask)));
+		__m256i ao = CS_AVX2_FIXLANES(_mm256_packus_epi16(_mm256_srli_epi16(a0, 8), _mm256_srli_epi16(a1, 8)));
+		__m256i be = CS_AVX2_FIXLANES(_mm256_packus_epi16(_mm256_and_si256(b0, mask), _mm256_and_si256(b1, mask)));
+		__m256i bo = CS_AVX2_FIXLANES(_mm256_packus_epi16(_mm256_srli_epi16(b0, 8), _mm256_srli_epi16(b1, 8)));
+
+		_mm256_storeu_si256((__m256i *) (py1 + w), y_first ? ae : ao);
+		_mm256_storeu_si256((__m256i *) (py2 + w), y_first ? be : bo);
+
+		/*uvuv... averaged over the two rows*/
+		__m256i c = y_first ? _mm256_avg_epu8(ao, bo) : _mm256_avg_epu8(ae, be);
+		__m256i u = CS_AVX2_FIXLANES(_mm256_packus_epi16(_mm256_and_si256(c, mask), c));
+		__m256i v = CS_AVX2_FIXLANES(_mm256_packus_epi16(_mm256_srli_epi16(c, 8), c));
+
+		_mm_storeu_si128((__m128i *) (pu + w / 2), _mm256_castsi256_si128(u));
+		_mm_storeu_si128((__m128i *) (pv + w / 2), _mm256_castsi256_si128(v));
+	}
+
+	if(w < width)
+		packed422_rows_sse2(py1 + w, py2 + w, pu + w / 2, pv + w / 2,
+			in1 + 2 * w, in2 + 2 * w, width - w, y_first);
+}
+
+/*
+ * split interleaved uv samples (32 pairs per iteration)
+ *   args as in split_uv_c
+ */
+static CS_TARGET_AVX2 void split_uv_avx2(uint8_t *pu, uint8_t *pv, const uint8_t *in, int n)
+{
+	const __m256i mask = _mm256_set1_epi16(0x00FF);
+	int i = 0;
+
+	for(i = 0; i + 32 <= n; i += 32)
+	{
+		__m256i a0 = _mm256_loadu_si256((const __m256i *) (in + 2 * i));
+		__m256i a1 = _mm256_loadu_si256((const __m256i *) (in + 2 * i + 32));
+
+		_mm256_storeu_si256((__m256i *) (pu + i), CS_AVX2_FIXLANES(
+			_mm256_packus_epi16(_mm256_and_si256(a0, mask), _mm256_and_si256(a1, mask))));
+		_mm256_storeu_si256((__m256i *) (pv + i), CS_AVX2_FIXLANES(
+			_mm256_packus_epi16(_mm256_srli_epi16(a0, 8), _mm256_srli_epi16(a1, 8))));
+	}
+
+	if(i < n)
+		split_uv_sse2(pu + i, pv + i, in + 2 * i, n - i);
+}
+
+/*
+ * split and average two rows of interleaved uv samples (32 pairs per iteration)
+ *   args as in split_uv_rows_c
+ */
+static CS_TARGET_AVX2 void split_uv_rows_avx2(uint8_t *pu, uint8_t *pv, const uint8_t *in1, const uint8_t *in2, int n)
+{
+	const __m256i mask = _mm256_set1_epi16(0x00FF);
+	int i = 0;
+
+	for(i = 0; i + 32 <= n; i += 32)
+	{
+		__m256i a0 = _mm256_avg_epu8(_mm256_loadu_si256((const __m256i *) (in1 + 2 * i)),
+			_mm256_loadu_si256((const __m256i *) (in2 + 2 * i)));
+		__m256i a1 = _mm256_avg_epu8(_mm256_loadu_si256((const __m256i *) (in1 + 2 * i + 32)),
+			_mm256_loadu_si256((const __m256i *) (in2 + 2 * i + 32)));
+
+		_mm256_storeu_si256((__m256i *) (pu + i), CS_AVX2_FIXLANES(
+			_mm256_packus_epi16(_mm256_and_si256(a0, mask), _mm256_and_si256(a1, mask))));
+		_mm256_storeu_si256((__m256i *) (pv + i), CS_AVX2_FIXLANES(
+			_mm256_packus_epi16(_mm256_srli_epi16(a0, 8), _mm256_srli_epi16(a1, 8))));
+	}
+
+	if(i < n)
+		split_uv_rows_sse2(pu + i, pv + i, in1 + 2 * i, in2 + 2 * i, n - i);
+}
+
+/*
+ * average two rows of samples (32 samples per iteration)
+ *   args as in average_rows_c
+ */
+static CS_TARGET_AVX2 void average_rows_avx2(uint8_t *out, const uint8_t *in1, const uint8_t *in2, int n)
+{
+	int i = 0;
+
+	for(i = 0; i + 32 <= n; i += 32)
+		_mm256_storeu_si256((__m256i *) (out + i),
+			_mm256_avg_epu8(_mm256_loadu_si256((const __m256i *) (in1 + i)),
+				_mm256_loadu_si256((const __m256i *) (in2 + i))));
+
+	if(i < n)
+		average_rows_sse2(out + i, in1 + i, in2 + i, n - i);
+}
+
+/*
+ * bilinear demosaic of a bayer row (32 samples per iteration)
+ *   args as in bayer_row_c
+ */
+static CS_TARGET_AVX2 void bayer_row_avx2(uint8_t *pg, uint8_t *px, uint8_t *py,
+	const uint8_t *up, const uint8_t *c, const uint8_t *dn, int width, int g_first)
+{
+	/*lanes with a green sample (even samples if g_first)*/
+	__m256i gmask = _mm256_set1_epi16(g_first ? 0x00FF : (short) 0xFF00);
+	int x = 2;
+
+	/*first samples (mirrored border)*/
+	bayer_range_c(pg, px, py, up, c, dn, width, g_first, 0, (width < 2) ? width : 2);
+
+	for(x = 2; x + 33 <= width; x += 32)
+	{
+		__m256i cc = _mm256_loadu_si256((const __m256i *) (c + x));
+		__m256i hv = _mm256_avg_epu8(_mm256_loadu_si256((const __m256i *) (c + x - 1)),
+			_mm256_loadu_si256((const __m256i *) (c + x + 1)));
+		__m256i vv = _mm256_avg_epu8(_mm256_loadu_si256((const __m256i *) (up + x)),
+			_mm256_loadu_si256((const __m256i *) (dn + x)));
+		__m256i dv = _mm256_avg_epu8(
+			_mm256_avg_epu8(_mm256_loadu_si256((const __m256i *) (up + x - 1)),
+				_mm256_loadu_si256((const __m256i *) (up + x + 1))),
+			_mm256_avg_epu8(_mm256_loadu_si256((const __m256i *) (dn + x - 1)),
+				_mm256_loadu_si256((const __m256i *) (dn + x + 1))));
+		__m256i gv = _mm256_avg_epu8(hv, vv);
+
+		_mm256_storeu_si256((__m256i *) (pg + x), _mm256_blendv_epi8(gv, cc, gmask));
+		_mm256_storeu_si256((__m256i *) (px + x), _mm256_blendv_epi8(cc, hv, gmask));
+		_mm256_storeu_si256((__m256i *) (py + x), _mm256_blendv_epi8(dv, vv, gmask));
+	}
+
+	if(x < width)
+		bayer_range_c(pg, px, py, up, c, dn, width, g_first, x, width);
+}
+
+/*
+ * luma of 16 samples (16 bit lanes) in Q7
+ */
+static CS_TARGET_AVX2 inline __m256i luma_avx2(__m256i r, __m256i g, __m256i b)
+{
+	__m256i y = _mm256_add_epi16(_mm256_mullo_epi16(r, _mm256_set1_epi16(CS_YR)),
+		_mm256_mullo_epi16(g, _mm256_set1_epi16(CS_YG)));
+	y = _mm256_add_epi16(y, _mm256_mullo_epi16(b, _mm256_set1_epi16(CS_YB)));
+	return _mm256_srli_epi16(_mm256_add_epi16(y, _mm256_set1_epi16(64)), 7);
+}
+
+/*
+ * chroma of 16 samples (16 bit lanes) in Q7 (+128, not clipped)
+ */
+static CS_TARGET_AVX2 inline __m256i chroma_avx2(__m256i r, __m256i g, __m256i b, short cr, short cg, short cb)
+{
+	__m256i c = _mm256_add_epi16(_mm256_mullo_epi16(r, _mm256_set1_epi16(cr)),
+		_mm256_mullo_epi16(g, _mm256_set1_epi16(cg)));
+	c = _mm256_add_epi16(c, _mm256_mullo_epi16(b, _mm256_set1_epi16(cb)));
+	c = _mm256_srai_epi16(_mm256_add_epi16(c, _mm256_set1_epi16(64)), 7);
+	return _mm256_add_epi16(c, _mm256_set1_epi16(128));
+}
+
+/*
+ * 2x2 average of 32 samples of two rows (16 results in 16 bit lanes)
+ */
+static CS_TARGET_AVX2 inline __m256i quad_avg_avx2(__m256i a, __m256i b)
+{
+	const __m256i mask = _mm256_set1_epi16(0x00FF);
+	__m256i s = _mm256_add_epi16(_mm256_and_si256(a, mask), _mm256_srli_epi16(a, 8));
+	s = _mm256_add_epi16(s, _mm256_add_epi16(_mm256_and_si256(b, mask), _mm256_srli_epi16(b, 8)));
+	return _mm256_srli_epi16(_mm256_add_epi16(s, _mm256_set1_epi16(2)), 2);
+}
+
+/*
+ * two rows of planar rgb to yu12 (32 samples per iteration)
+ *   args as in rgb_rows_to_yu12_c
+ */
+static CS_TARGET_AVX2 void rgb_rows_to_yu12_avx2(uint8_t *py1, uint8_t *py2, uint8_t *pu, uint8_t *pv,
+	const uint8_t *r1, const uint8_t *g1, const uint8_t *b1,
+	const uint8_t *r2, const uint8_t *g2, const uint8_t *b2, int width)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	int x = 0;
+
+	for(x = 0; x + 32 <= width; x += 32)
+	{
+		__m256i ra = _mm256_loadu_si256((const __m256i *) (r1 + x));
+		__m256i ga = _mm256_loadu_si256((const __m256i *) (g1 + x));
+		__m256i ba = _mm256_loadu_si256((const __m256i *) (b1 + x));
+		__m256i rb = _mm256_loadu_si256((const __m256i *) (r2 + x));
+		__m256i gb = _mm256_loadu_si256((const __m256i *) (g2 + x));
+		__m256i bb = _mm256_loadu_si256((const __m256i *) (b2 + x));
+
+		/*unpack and pack work in the same 128 bit lanes: no reordering*/
+		_mm256_storeu_si256((__m256i *) (py1 + x), _mm256_packus_epi16(
+			luma_avx2(_mm256_unpacklo_epi8(ra, zero), _mm256_unpacklo_epi8(ga, zero), _mm256_unpacklo_epi8(ba, zero)),
+			luma_avx2(_mm256_unpackhi_epi8(ra, zero), _mm256_unpackhi_epi8(ga, zero), _mm256_unpackhi_epi8(ba, zero))));
+		_mm256_storeu_si256((__m256i *) (py2 + x), _mm256_packus_epi16(
+			luma_avx2(_mm256_unpacklo_epi8(rb, zero), _mm256_unpacklo_epi8(gb, zero), _mm256_unpacklo_epi8(bb, zero)),
+			luma_avx2(_mm256_unpackhi_epi8(rb, zero), _mm256_unpackhi_epi8(gb, zero), _mm256_unpackhi_epi8(bb, zero))));
+
+		__m256i r = quad_avg_avx2(ra, rb);
+		__m256i g = quad_avg_avx2(ga, gb);
+		__m256i b = quad_avg_avx2(ba, bb);
+
+		__m256i u = CS_AVX2_FIXLANES(_mm256_packus_epi16(chroma_avx2(r, g, b, CS_UR, CS_UG, CS_UB), zero));
+		__m256i v = CS_AVX2_FIXLANES(_mm256_packus_epi16(chroma_avx2(r, g, b, CS_VR, CS_VG, CS_VB), zero));
+		_mm_storeu_si128((__m128i *) (pu + x / 2), _mm256_castsi256_si128(u));
+		_mm_storeu_si128((__m128i *) (pv + x / 2), _mm256_castsi256_si128(v));
+	}
+
+	if(x < width)
+		rgb_rows_to_yu12_sse2(py1 + x, py2 + x, pu + x / 2, pv + x / 2,
+			r1 + x, g1 + x, b1 + x, r2 + x, g2 + x, b2 + x, width - x);
+}
+
+/*
+ * yuv to rgb for 16 pixels (16 bit lanes, u and v centered at 0)
+ *   args as in yuv_to_rgb_sse2
+ */
+static CS_TARGET_AVX2 inline void yuv_to_rgb_avx2(__m256i y, __m256i u, __m256i v, const __m256i *k,
+	__m256i *r, __m256i *g, __m256i *b)
+{
+	__m256i ys = _mm256_add_epi16(_mm256_mulhi_epu16(_mm256_slli_epi16(y, 8), k[0]), k[1]);
+
+	*r = _mm256_srai_epi16(_mm256_adds_epi16(ys, _mm256_mullo_epi16(v, k[2])), 6);
+	*g = _mm256_srai_epi16(_mm256_subs_epi16(ys,
+		_mm256_adds_epi16(_mm256_mullo_epi16(u, k[3]), _mm256_mullo_epi16(v, k[4]))), 6);
+	*b = _mm256_srai_epi16(_mm256_adds_epi16(ys, _mm256_mullo_epi16(u, k[5])), 6);
+}
+
+/*
+ * interleave 16 pixels of 3 channels into 48 bytes (c0 c1 c2 ...)
+ *   with byte shuffles (ssse3, always available with avx2)
+ */
+static CS_TARGET_AVX2 inline void store_rgb_avx2(uint8_t *out, __m128i c0, __m128i c1, __m128i c2)
+{
+	const __m128i m00 = _mm_setr_epi8(0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1, 5);
+	const __m128i m01 = _mm_setr_epi8(-1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1);
+	const __m128i m02 = _mm_setr_epi8(-1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1);
+	const __m128i m10 = _mm_setr_epi8(-1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10, -1);
+	const __m128i m11 = _mm_setr_epi8(5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10);
+	const __m128i m12 = _mm_setr_epi8(-1, 5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1);
+	const __m128i m20 = _mm_setr_epi8(-1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1, -1);
+	const __m128i m21 = _mm_setr_epi8(-1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1);
+	const __m128i m22 = _mm_setr_epi8(10, -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15);
+
+	_mm_storeu_si128((__m128i *) out, _mm_or_si128(_mm_or_si128(
+		_mm_shuffle_epi8(c0, m00), _mm_shuffle_epi8(c1, m01)), _mm_shuffle_epi8(c2, m02)));
+	_mm_storeu_si128((__m128i *) (out + 16), _mm_or_si128(_mm_or_si128(
+		_mm_shuffle_epi8(c0, m10), _mm_shuffle_epi8(c1, m11)), _mm_shuffle_epi8(c2, m12)));
+	_mm_storeu_si128((__m128i *) (out + 32), _mm_or_si128(_mm_or_si128(
+		_mm_shuffle_epi8(c0, m20), _mm_shuffle_epi8(c1, m21)), _mm_shuffle_epi8(c2, m22)));
+}
+
+/*
+ * a row of yuv to packed rgb24 (32 pixels per iteration)
+ *   args as in yuv_row_to_rgb_c
+ */
+static CS_TARGET_AVX2 void yuv_row_to_rgb_avx2(uint8_t *out, const uint8_t *py, const uint8_t *pu, const uint8_t *pv,
+	int width, const cs_yuv2rgb_t *coef, int bgr)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i c128 = _mm256_set1_epi16(128);
+	__m256i k[6];
+	k[0] = _mm256_set1_epi16((short) coef->y_mul);
+	k[1] = _mm256_set1_epi16(coef->y_bias);
+	k[2] = _mm256_set1_epi16(coef->rv);
+	k[3] = _mm256_set1_epi16(coef->gu);
+	k[4] = _mm256_set1_epi16(coef->gv);
+	k[5] = _mm256_set1_epi16(coef->bu);
+
+	int x = 0;
+	for(x = 0; x + 32 <= width; x += 32)
+	{
+		__m256i y = _mm256_loadu_si256((const __m256i *) (py + x));
+		__m256i u = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (pu + x / 2))), c128);
+		__m256i v = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) (pv + x / 2))), c128);
+
+		/*
+		 * in lane unpacks: the low halves hold pixels 0-7 and 16-23,
+		 * the high halves pixels 8-15 and 24-31 (packus restores the order)
+		 */
+		__m256i r0, g0, b0, r1, g1, b1;
+		yuv_to_rgb_avx2(_mm256_unpacklo_epi8(y, zero), _mm256_unpacklo_epi16(u, u), _mm256_unpacklo_epi16(v, v),
+			k, &r0, &g0, &b0);
+		yuv_to_rgb_avx2(_mm256_unpackhi_epi8(y, zero), _mm256_unpackhi_epi16(u, u), _mm256_unpackhi_epi16(v, v),
+			k, &r1, &g1, &b1);
+
+		__m256i r = _mm256_packus_epi16(r0, r1);
+		__m256i g = _mm256_packus_epi16(g0, g1);
+		__m256i b = _mm256_packus_epi16(b0, b1);
+		if(bgr)
+		{
+			__m256i t = r;
+			r = b;
+			b = t;
+		}
+
+		store_rgb_avx2(out + 3 * x, _mm256_castsi256_si128(r), _mm256_castsi256_si128(g), _mm256_castsi256_si128(b));
+		store_rgb_avx2(out + 3 * x + 48, _mm256_extracti128_si256(r, 1), _mm256_extracti128_si256(g, 1),
+			_mm256_extracti128_si256(b, 1));
+	}
+
+	yuv_range_to_rgb_c(out, py, pu, pv, coef, bgr, x, width);
+}
+
+/*
+ * unpack n y10b samples to 16 bit (16 samples per iteration)
+ *   each lane gathers the two bytes holding a sample (big endian)
+ *   and shifts it into place with a multiply (no per lane 16 bit shift)
+ *   args as in unpack_y10b_c
+ */
+static CS_TARGET_AVX2 void unpack_y10b_avx2(uint16_t *out, const uint8_t *in, int n)
+{
+	const __m256i pick = _mm256_setr_epi8(
+		1, 0, 2, 1, 3, 2, 4, 3, 6, 5, 7, 6, 8, 7, 9, 8,
+		1, 0, 2, 1, 3, 2, 4, 3, 6, 5, 7, 6, 8, 7, 9, 8);
+	const __m256i mul = _mm256_setr_epi16(1, 4, 16, 64, 1, 4, 16, 64, 1, 4, 16, 64, 1, 4, 16, 64);
+
+	int x = 0;
+	/*each lane loads 16 bytes (uses 10): keep the loads inside the buffer*/
+	for(x = 0; x + 24 <= n; x += 16)
+	{
+		const uint8_t *p = in + (x / 4) * 5;
+		__m256i b = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *) p)),
+			_mm_loadu_si128((const __m128i *) (p + 10)), 1);
+		__m256i w = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_shuffle_epi8(b, pick), mul), 6);
+		_mm256_storeu_si256((__m256i *) (out + x), w);
+	}
+
+	unpack_y10b_range_c(out, in, x, n);
+}
+
+/*
+ * n 16 bit samples to 8 bit (32 samples per iteration)
+ *   args as in narrow_y16_c
+ */
+static CS_TARGET_AVX2 void narrow_y16_avx2(uint8_t *out, const uint16_t *in, int n, int shift)
+{
+	int x = 0;
+
+	/*packus is signed: a shift is needed to keep the samples positive*/
+	if(shift > 0)
+	{
+		__m128i count = _mm_cvtsi32_si128(shift);
+		for(x = 0; x + 32 <= n; x += 32)
+		{
+			__m256i a = _mm256_srl_epi16(_mm256_loadu_si256((const __m256i *) (in + x)), count);
+			__m256i b = _mm256_srl_epi16(_mm256_loadu_si256((const __m256i *) (in + x + 16)), count);
+			_mm256_storeu_si256((__m256i *) (out + x), CS_AVX2_FIXLANES(_mm256_packus_epi16(a, b)));
+		}
+	}
+
+	narrow_y16_range_c(out, in, shift, x, n);
+}
+
+static const cs_kernels_t avx2_kernels =
+{
+	.name = "avx2",
+	.packed422_rows = packed422_rows_avx2,
+	.split_uv = split_uv_avx2,
+	.split_uv_rows = split_uv_rows_avx2,
+	.average_rows = average_rows_avx2,
+	.bayer_row = bayer_row_avx2,
+	.rgb_rows_to_yu12 = rgb_rows_to_yu12_avx2,
+	.yuv_row_to_rgb = yuv_row_to_rgb_avx2,
+	.unpack_y10b = unpack_y10b_avx2,
+	.narrow_y16 = narrow_y16_avx2,
+};
+#endif /*CS_X86*/
+
+static __MUTEX_TYPE kernels_mutex = __STATIC_MUTEX_INIT;
+static const cs_kernels_t *kernels = NULL;
+
+/*
+ * get the colorspace row kernels for this cpu
+ *   (cpu features are checked on the first call)
+ * args:
+ *    none
+ *
+ * asserts:
+ *    none
+ *
+ * returns: pointer to the row kernels
+ */
+const cs_kernels_t *get_cs_kernels()
+{
+	__LOCK_MUTEX(&kernels_mutex);
+	if(kernels == NULL)
+	{
+		kernels = &scalar_kernels;
+#if defined(CS_X86)
+		__builtin_cpu_init();
+		if(__builtin_cpu_supports("avx2"))
+			kernels = &avx2_kernels;
+		else if(__builtin_cpu_supports("sse2"))
+			kernels = &sse2_kernels;
+#endif
+		if(verbosity > 0)
+			printf("V4L2_CORE: colorspace conversions using %s kernels\n", kernels->name);
+	}
+	const cs_kernels_t *k = kernels;
+	__UNLOCK_MUTEX(&kernels_mutex);
+
+	return k;
+}
@@ -0,0 +1,119 @@
+/*******************************************************************************#
+#           guvcview              http://guvcview.sourceforge.net               #
+#                                                                               #
+#           Paulo Assis <pj.assis@gmail.com>                                    #
+#                                                                               #
+# This program is free software; you can redistribute it and/or modify          #
+# it under the terms of the GNU General Public License as published by          #
+# the Free Software Foundation; either version 2 of the License, or             #
+# (at your option) any later version.                                           #
+#                                                                               #
+# This program is distributed in the hope that it will be useful,               #
+# but WITHOUT ANY WARRANTY; without even the implied warranty of                #
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 #
+# GNU General Public License for more details.                                  #
+#                                                                               #
+# You should have received a copy of the GNU General Public License             #
+# along with this program; if not, write to the Free Software                   #
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA     #
+#                                                                               #
+********************************************************************************/
+
+
+#ifndef COLORSPACES_SIMD_H
+#define COLORSPACES_SIMD_H
+
+#include <inttypes.h>
+
+/*
+ * yuv to rgb fixed point coefficients (one set per matrix and range)
+ *   ys = ((y << 8) * y_mul >> 16) + y_bias    (Q6, y_bias includes rounding)
+ *   r = ys + rv * v
+ *   g = ys - gu * u - gv * v
+ *   b = ys + bu * u
+ *   (u and v are centered at 0, chroma coefficients in Q6)
+ */
+typedef struct _cs_yuv2rgb_t
+{
+	uint16_t y_mul;  //luma gain (Q14)
+	int16_t y_bias;  //luma offset and rounding (Q6)
+	int16_t rv;      //v contribution to r
+	int16_t gu;      //u contribution to g (subtracted)
+	int16_t gv;      //v contribution to g (subtracted)
+	int16_t bu;      //u contribution to b
+} cs_yuv2rgb_t;
+
+/*
+ * row kernels for the colorspace conversions
+ *   (scalar, SSE2 or AVX2 - selected at runtime)
+ */
+typedef struct _cs_kernels_t
+{
+	const char *name;
+
+	/*
+	 * two rows of packed 422 (yuyv or uyvy) to yu12:
+	 *   two rows of luma and one row of (averaged) chroma
+	 *   y_first - 1: yuyv byte order; 0: uyvy byte order
+	 *   (swap u and v for yvyu/vyuy)
+	 */
+	void (*packed422_rows)(uint8_t *py1, uint8_t *py2, uint8_t *pu, uint8_t *pv,
+		const uint8_t *in1, const uint8_t *in2, int width, int y_first);
+
+	/*split n interleaved uv samples (nv12/nv21 chroma)*/
+	void (*split_uv)(uint8_t *pu, uint8_t *pv, const uint8_t *in, int n);
+
+	/*split and average two rows of n interleaved uv samples (nv16/nv61 chroma)*/
+	void (*split_uv_rows)(uint8_t *pu, uint8_t *pv, const uint8_t *in1, const uint8_t *in2, int n);
+
+	/*average two rows of n samples (422 planar chroma)*/
+	void (*average_rows)(uint8_t *out, const uint8_t *in1, const uint8_t *in2, int n);
+
+	/*
+	 * bilinear demosaic of a bayer row (up and dn are the rows above and below):
+	 *   pg - green; px - the color sampled in this row; py - the other color
+	 *   g_first - 1: row starts with a green sample
+	 */
+	void (*bayer_row)(uint8_t *pg, uint8_t *px, uint8_t *py,
+		const uint8_t *up, const uint8_t *c, const uint8_t *dn, int width, int g_first);
+
+	/*
+	 * two rows of planar rgb to yu12 (fixed point bt.601 luma,
+	 *   chroma from the 2x2 average)
+	 */
+	void (*rgb_rows_to_yu12)(uint8_t *py1, uint8_t *py2, uint8_t *pu, uint8_t *pv,
+		const uint8_t *r1, const uint8_t *g1, const uint8_t *b1,
+		const uint8_t *r2, const uint8_t *g2, const uint8_t *b2, int width);
+
+	/*
+	 * a row of yuv (chroma at half width) to packed rgb24
+	 *   coef - conversion coefficients (matrix and range)
+	 *   bgr - 1: bgr byte order; 0: rgb byte order
+	 */
+	void (*yuv_row_to_rgb)(uint8_t *out, const uint8_t *py, const uint8_t *pu, const uint8_t *pv,
+		int width, const cs_yuv2rgb_t *coef, int bgr);
+
+	/*
+	 * unpack n y10b samples (10 bit, big endian bit packed:
+	 *   4 samples in 5 bytes) to 16 bit
+	 */
+	void (*unpack_y10b)(uint16_t *out, const uint8_t *in, int n);
+
+	/*n 16 bit samples to 8 bit (in >> shift, saturated)*/
+	void (*narrow_y16)(uint8_t *out, const uint16_t *in, int n, int shift);
+} cs_kernels_t;
+
+/*
+ * get the colorspace row kernels for this cpu
+ *   (cpu features are checked on the first call)
+ * args:
+ *    none
+ *
+ * asserts:
+ *    none
+ *
+ * returns: pointer to the row kernels
+ */
+const cs_kernels_t *get_cs_kernels();
+
+#endif
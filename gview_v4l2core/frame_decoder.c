@@ -34,10 +34,561 @@
 #include "gviewv4l2core.h"
 #include "frame_decoder.h"
 #include "jpeg_decoder.h"
+#include "bayer_decoder.h"
+#include "band_executor.h"
 #include "colorspaces.h"
 
 extern int verbosity;
 
+/*
+ * get the bayer pixel order for a raw bayer format
+ * args:
+ *   format - v4l2 pixel format
+ *
+ * asserts:
+ *   none
+ *
+ * returns: pixel order (0..3) or -1 if format is not raw bayer
+ */
+static int get_bayer_pix_order(int format)
+{
+	switch(format)
+	{
+		case V4L2_PIX_FMT_SGBRG8:
+			return 0;
+		case V4L2_PIX_FMT_SGRBG8:
+			return 1;
+		case V4L2_PIX_FMT_SBGGR8:
+			return 2;
+		case V4L2_PIX_FMT_SRGGB8:
+			return 3;
+		default:
+			return -1;
+	}
+}
+
+/*
+ * get the raw frame planes for formats with a strided converter
+ *   rows may be padded by the driver (bytesperline > width)
+ * args:
+ *   vd - pointer to video device data
+ *   raw - pointer to raw frame data
+ *   planes - output raw frame planes
+ *   pitches - output raw frame plane pitches
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: raw frame size for this layout (0 - no strided converter)
+ */
+static size_t get_raw_frame_planes(v4l2_dev_t *vd, uint8_t *raw, uint8_t **planes, int *pitches)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	int width = vd->format.fmt.pix.width;
+	int height = vd->format.fmt.pix.height;
+	int bytesperline = vd->format.fmt.pix.bytesperline;
+
+	switch(vd->requested_fmt)
+	{
+		case V4L2_PIX_FMT_YUYV:
+		case V4L2_PIX_FMT_YVYU:
+		case V4L2_PIX_FMT_UYVY:
+		case V4L2_PIX_FMT_YYUV:
+			if(bytesperline < width * 2)
+				bytesperline = width * 2;
+			planes[0] = raw;
+			pitches[0] = bytesperline;
+			return (size_t) bytesperline * height;
+
+		case V4L2_PIX_FMT_GREY:
+			if(bytesperline < width)
+				bytesperline = width;
+			planes[0] = raw;
+			pitches[0] = bytesperline;
+			return (size_t) bytesperline * height;
+
+		case V4L2_PIX_FMT_NV12:
+		case V4L2_PIX_FMT_NV21:
+		case V4L2_PIX_FMT_NV16:
+		case V4L2_PIX_FMT_NV61:
+			/*the uv plane has the same pitch as the y plane*/
+			if(bytesperline < width)
+				bytesperline = width;
+			planes[0] = raw;
+			planes[1] = raw + (size_t) bytesperline * height;
+			pitches[0] = bytesperline;
+			pitches[1] = bytesperline;
+			if(vd->requested_fmt == V4L2_PIX_FMT_NV16 || vd->requested_fmt == V4L2_PIX_FMT_NV61)
+				return (size_t) bytesperline * height * 2;
+			return (size_t) bytesperline * height * 3 / 2;
+
+		case V4L2_PIX_FMT_YUV420:
+		case V4L2_PIX_FMT_YVU420:
+			/*chroma planes have half the pitch of the y plane*/
+			if(bytesperline < width)
+				bytesperline = width;
+			planes[0] = raw;
+			planes[1] = raw + (size_t) bytesperline * height;
+			planes[2] = planes[1] + (size_t) (bytesperline / 2) * (height / 2);
+			pitches[0] = bytesperline;
+			pitches[1] = bytesperline / 2;
+			pitches[2] = bytesperline / 2;
+			return (size_t) bytesperline * height * 3 / 2;
+
+		default:
+			return 0;
+	}
+}
+
+#ifdef USE_PLANAR_YUV
+/*
+ * strided yu12 converter (*_to_yu12_planes)
+ */
+typedef void (*yu12_planes_conv_t)(uint8_t **out, int *out_pitches,
+	uint8_t **in, int *in_pitches, int width, int height);
+
+/*
+ * raw frame conversion split in bands of rows (band executor job)
+ */
+typedef struct _planes_job_t
+{
+	yu12_planes_conv_t conv; //converter
+	uint8_t *in[3];          //raw frame planes
+	int in_pitches[3];       //raw frame plane pitches
+	int in_vsub[3];          //raw frame plane vertical subsampling
+	int nin;                 //number of raw frame planes
+	uint8_t *out[3];         //yu12 planes
+	int out_pitches[3];      //yu12 plane pitches
+	int width;               //frame width
+} planes_job_t;
+
+/*
+ * band function: convert raw frame rows [row0, row1)
+ * args:
+ *   data - pointer to planes job
+ *   row0 - first row (even)
+ *   row1 - last row (exclusive, even)
+ *   worker - band thread index (not used)
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+static void convert_band(void *data, int row0, int row1, int worker)
+{
+	(void) worker;
+
+	planes_job_t *job = (planes_job_t *) data;
+
+	uint8_t *in[3];
+	uint8_t *out[3];
+	int i = 0;
+	for(i = 0; i < job->nin; i++)
+		in[i] = job->in[i] + (row0 / job->in_vsub[i]) * job->in_pitches[i];
+
+	out[0] = job->out[0] + row0 * job->out_pitches[0];
+	out[1] = job->out[1] + (row0 / 2) * job->out_pitches[1];
+	out[2] = job->out[2] + (row0 / 2) * job->out_pitches[2];
+
+	job->conv(out, job->out_pitches, in, job->in_pitches, job->width, row1 - row0);
+}
+
+/*
+ * convert a raw frame into yu12 planes in a single pass
+ *   (honors the driver bytesperline and any output plane pitch)
+ * args:
+ *   vd - pointer to video device data
+ *   frame - pointer to frame buffer
+ *   planes - output planes (NULL - frame yuv_frame)
+ *   pitches - output plane pitches (NULL - frame yuv_frame)
+ *
+ * asserts:
+ *   vd is not null
+ *   frame is not null
+ *
+ * returns: error code (0- E_OK)
+ */
+static int decode_raw_planes(v4l2_dev_t *vd, v4l2_frame_buff_t *frame,
+	uint8_t **planes, int *pitches)
+{
+	/*assertions*/
+	assert(vd != NULL);
+	assert(frame != NULL);
+
+	int width = vd->format.fmt.pix.width;
+	int height = vd->format.fmt.pix.height;
+
+	planes_job_t job;
+	size_t in_size = get_raw_frame_planes(vd, frame->raw_frame, job.in, job.in_pitches);
+	if(in_size == 0)
+		return E_FORMAT_ERR;
+
+	if(!frame->raw_frame || frame->raw_frame_size < in_size)
+	{
+		fprintf(stderr, "V4L2_CORE: dropping short raw frame (%i bytes, expected %i)\n",
+			(int) frame->raw_frame_size, (int) in_size);
+		return E_DECODE_ERR;
+	}
+
+	uint8_t *frame_planes[3];
+	int frame_pitches[3];
+	if(planes == NULL || pitches == NULL)
+	{
+		frame_planes[0] = frame->yuv_frame;
+		frame_planes[1] = frame_planes[0] + width * height;
+		frame_planes[2] = frame_planes[1] + (width * height) / 4;
+		frame_pitches[0] = width;
+		frame_pitches[1] = width / 2;
+		frame_pitches[2] = width / 2;
+		planes = frame_planes;
+		pitches = frame_pitches;
+	}
+
+	/*raw frame planes: luma, then chroma (4:2:0 chroma has half the rows)*/
+	job.nin = 1;
+	job.in_vsub[0] = 1;
+	job.in_vsub[1] = 1;
+	job.in_vsub[2] = 1;
+	switch(vd->requested_fmt)
+	{
+		case V4L2_PIX_FMT_YUYV:
+			job.conv = yuyv_to_yu12_planes;
+			break;
+		case V4L2_PIX_FMT_YVYU:
+			job.conv = yvyu_to_yu12_planes;
+			break;
+		case V4L2_PIX_FMT_UYVY:
+			job.conv = uyvy_to_yu12_planes;
+			break;
+		case V4L2_PIX_FMT_YYUV:
+			job.conv = yyuv_to_yu12_planes;
+			break;
+		case V4L2_PIX_FMT_GREY:
+			job.conv = grey_to_yu12_planes;
+			break;
+		case V4L2_PIX_FMT_NV12:
+			job.conv = nv12_to_yu12_planes;
+			job.nin = 2;
+			job.in_vsub[1] = 2;
+			break;
+		case V4L2_PIX_FMT_NV21:
+			job.conv = nv21_to_yu12_planes;
+			job.nin = 2;
+			job.in_vsub[1] = 2;
+			break;
+		case V4L2_PIX_FMT_NV16:
+			job.conv = nv16_to_yu12_planes;
+			job.nin = 2;
+			break;
+		case V4L2_PIX_FMT_NV61:
+			job.conv = nv61_to_yu12_planes;
+			job.nin = 2;
+			break;
+		case V4L2_PIX_FMT_YUV420:
+			job.conv = yu12_to_yu12_planes;
+			job.nin = 3;
+			job.in_vsub[1] = 2;
+			job.in_vsub[2] = 2;
+			break;
+		case V4L2_PIX_FMT_YVU420:
+			job.conv = yv12_to_yu12_planes;
+			job.nin = 3;
+			job.in_vsub[1] = 2;
+			job.in_vsub[2] = 2;
+			break;
+		default:
+			return E_FORMAT_ERR;
+	}
+
+	int i = 0;
+	for(i = 0; i < 3; i++)
+	{
+		job.out[i] = planes[i];
+		job.out_pitches[i] = pitches[i];
+	}
+	job.width = width;
+
+	if(vd->band_exec == NULL || vd->convert_threads == 0)
+	{
+		job.conv(job.out, job.out_pitches, job.in, job.in_pitches, width, height);
+		return E_OK;
+	}
+
+	/*bands of whole row pairs (4:2:0 output)*/
+	int bytes_per_row = (width * 3) / 2;
+	for(i = 0; i < job.nin; i++)
+		bytes_per_row += job.in_pitches[i] / job.in_vsub[i];
+
+	band_executor_run(vd->band_exec, convert_band, &job, height, 2, bytes_per_row);
+
+	return E_OK;
+}
+
+/*
+ * apply the band thread settings to the device band executor
+ *   a single executor is shared by the (m)jpeg band, raw bayer
+ *   stripe and raw frame conversion decoding: it runs the largest
+ *   number of threads requested and each decoder only uses it
+ *   if its own number of threads is set
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void set_band_threads(v4l2_dev_t *vd)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	/*else it's set when the executor is created*/
+	if(vd->band_exec == NULL)
+		return;
+
+	int nthreads = vd->jpeg_band_threads;
+	if(vd->bayer_threads > nthreads)
+		nthreads = vd->bayer_threads;
+	if(vd->convert_threads > nthreads)
+		nthreads = vd->convert_threads;
+
+	if(band_executor_get_threads(vd->band_exec) != nthreads)
+		band_executor_set_threads(vd->band_exec, nthreads);
+
+	if(vd->jpeg_ctx != NULL)
+		jpeg_decoder_set_band_executor(vd->jpeg_ctx,
+			(vd->jpeg_band_threads > 0) ? vd->band_exec : NULL);
+	if(vd->bayer_ctx != NULL)
+		bayer_decoder_set_executor(vd->bayer_ctx,
+			(vd->bayer_threads > 0) ? vd->band_exec : NULL);
+}
+
+/*
+ * create the raw bayer decoder context (if not yet created)
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: error code (0- E_OK)
+ */
+static int init_bayer_decoder(v4l2_dev_t *vd)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	if(vd->bayer_ctx == NULL)
+	{
+		vd->bayer_ctx = bayer_init_decoder();
+		if(vd->bayer_ctx == NULL)
+			return E_NO_CODEC;
+		set_band_threads(vd);
+	}
+
+	return E_OK;
+}
+
+/*
+ * decode a raw bayer frame into yu12 planes
+ * args:
+ *   vd - pointer to video device data
+ *   frame - pointer to frame buffer
+ *   planes - output planes (NULL - frame yuv_frame)
+ *   pitches - output plane pitches (NULL - frame yuv_frame)
+ *   pix_order - bayer pixel order (0..3)
+ *
+ * asserts:
+ *   vd is not null
+ *   frame is not null
+ *
+ * returns: error code (0- E_OK)
+ */
+static int decode_bayer(v4l2_dev_t *vd, v4l2_frame_buff_t *frame,
+	uint8_t **planes, int *pitches, int pix_order)
+{
+	/*assertions*/
+	assert(vd != NULL);
+	assert(frame != NULL);
+
+	int width = vd->format.fmt.pix.width;
+	int height = vd->format.fmt.pix.height;
+
+	if(!frame->raw_frame || frame->raw_frame_size < (size_t) (width * height))
+	{
+		fprintf(stderr, "V4L2_CORE: (bayer decoder) short raw frame (%i bytes)\n",
+			(int) frame->raw_frame_size);
+		return E_DECODE_ERR;
+	}
+
+	if(init_bayer_decoder(vd) != E_OK)
+		return E_NO_CODEC;
+
+	uint8_t *frame_planes[3];
+	int frame_pitches[3];
+	if(planes == NULL || pitches == NULL)
+	{
+		frame_planes[0] = frame->yuv_frame;
+		frame_planes[1] = frame_planes[0] + width * height;
+		frame_planes[2] = frame_planes[1] + (width * height) / 4;
+		frame_pitches[0] = width;
+		frame_pitches[1] = width / 2;
+		frame_pitches[2] = width / 2;
+		planes = frame_planes;
+		pitches = frame_pitches;
+	}
+
+	return bayer_decode(vd->bayer_ctx, planes, pitches, frame->raw_frame,
+		width, height, pix_order);
+}
+#else
+/*
+ * convert a raw frame to yuyv (frame yuv_frame)
+ *   (honors the driver bytesperline)
+ * args:
+ *   vd - pointer to video device data
+ *   frame - pointer to frame buffer
+ *
+ * asserts:
+ *   vd is not null
+ *   frame is not null
+ *
+ * returns: error code (0- E_OK)
+ */
+static int decode_raw_yuyv(v4l2_dev_t *vd, v4l2_frame_buff_t *frame)
+{
+	/*assertions*/
+	assert(vd != NULL);
+	assert(frame != NULL);
+
+	int width = vd->format.fmt.pix.width;
+	int height = vd->format.fmt.pix.height;
+
+	uint8_t *in[3];
+	int in_pitches[3];
+	if(get_raw_frame_planes(vd, frame->raw_frame, in, in_pitches) == 0)
+		return E_FORMAT_ERR;
+
+	switch(vd->requested_fmt)
+	{
+		case V4L2_PIX_FMT_YUYV:
+		{
+			int h = 0;
+			for(h = 0; h < height; h++)
+				memcpy(frame->yuv_frame + h * width * 2, in[0] + h * in_pitches[0], width * 2);
+			break;
+		}
+		case V4L2_PIX_FMT_UYVY:
+			uyvy_to_yuyv_planes(frame->yuv_frame, in, in_pitches, width, height);
+			break;
+		case V4L2_PIX_FMT_YVYU:
+			yvyu_to_yuyv_planes(frame->yuv_frame, in, in_pitches, width, height);
+			break;
+		case V4L2_PIX_FMT_YYUV:
+			yyuv_to_yuyv_planes(frame->yuv_frame, in, in_pitches, width, height);
+			break;
+		case V4L2_PIX_FMT_YUV420:
+			yu12_to_yuyv_planes(frame->yuv_frame, in, in_pitches, width, height);
+			break;
+		case V4L2_PIX_FMT_YVU420:
+			yvu420_to_yuyv_planes(frame->yuv_frame, in, in_pitches, width, height);
+			break;
+		case V4L2_PIX_FMT_NV12:
+			nv12_to_yuyv_planes(frame->yuv_frame, in, in_pitches, width, height);
+			break;
+		case V4L2_PIX_FMT_NV21:
+			nv21_to_yuyv_planes(frame->yuv_frame, in, in_pitches, width, height);
+			break;
+		case V4L2_PIX_FMT_NV16:
+			nv16_to_yuyv_planes(frame->yuv_frame, in, in_pitches, width, height);
+			break;
+		case V4L2_PIX_FMT_NV61:
+			nv61_to_yuyv_planes(frame->yuv_frame, in, in_pitches, width, height);
+			break;
+		case V4L2_PIX_FMT_GREY:
+			grey_to_yuyv_planes(frame->yuv_frame, in, in_pitches, width, height);
+			break;
+		default:
+			return E_FORMAT_ERR;
+	}
+
+	return E_OK;
+}
+#endif
+
+/*
+ * get the minimum raw frame size read by the converter of the
+ *   requested format (padded rows for the strided converters)
+ * args:
+ *   vd - pointer to video device data
+ *   raw - pointer to raw frame data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: minimum raw frame size in bytes (0 - not checked)
+ */
+static size_t get_raw_frame_min_size(v4l2_dev_t *vd, uint8_t *raw)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	int format = vd->requested_fmt;
+	size_t npix = (size_t) vd->format.fmt.pix.width * vd->format.fmt.pix.height;
+
+	/*raw bayer in a yuyv frame (logitech)*/
+	if(format == V4L2_PIX_FMT_YUYV && vd->isbayer > 0)
+		return npix;
+
+	uint8_t *planes[3];
+	int pitches[3];
+	size_t size = get_raw_frame_planes(vd, raw, planes, pitches);
+	if(size > 0)
+		return size;
+
+	switch(format)
+	{
+		case V4L2_PIX_FMT_YUYV:
+		case V4L2_PIX_FMT_UYVY:
+		case V4L2_PIX_FMT_YVYU:
+		case V4L2_PIX_FMT_YYUV:
+		case V4L2_PIX_FMT_NV16:
+		case V4L2_PIX_FMT_NV61:
+			return npix * 2;
+		case V4L2_PIX_FMT_Y16:
+			/*decode_luma16 copies rows with the driver pitch*/
+			if(vd->format.fmt.pix.bytesperline > vd->format.fmt.pix.width * 2)
+				return (size_t) vd->format.fmt.pix.bytesperline * vd->format.fmt.pix.height;
+			return npix * 2;
+		case V4L2_PIX_FMT_YUV420:
+		case V4L2_PIX_FMT_YVU420:
+		case V4L2_PIX_FMT_NV12:
+		case V4L2_PIX_FMT_NV21:
+		case V4L2_PIX_FMT_Y41P:
+		case V4L2_PIX_FMT_SPCA501:
+		case V4L2_PIX_FMT_SPCA505:
+		case V4L2_PIX_FMT_SPCA508:
+			return npix * 3 / 2;
+		case V4L2_PIX_FMT_Y10BPACK:
+			return npix * 10 / 8;
+		case V4L2_PIX_FMT_GREY:
+		case V4L2_PIX_FMT_SGBRG8:
+		case V4L2_PIX_FMT_SGRBG8:
+		case V4L2_PIX_FMT_SBGGR8:
+		case V4L2_PIX_FMT_SRGGB8:
+			return npix;
+		case V4L2_PIX_FMT_RGB24:
+		case V4L2_PIX_FMT_BGR24:
+			return npix * 3;
+		default:
+			return 0;
+	}
+}
+
 /*
  * Alloc image buffers for decoding video stream
  * args:
@@ -73,17 +624,30 @@ int alloc_v4l2_frames(v4l2_dev_t *vd)
 #else
 	int framesizeIn = (width * height * 2); /*2 bytes per pixel*/
 #endif
+
+	/*band executor for the decoders (threads start on first use)*/
+	if(vd->band_exec == NULL)
+	{
+		vd->band_exec = band_executor_create();
+		set_band_threads(vd);
+	}
+
 	switch (vd->requested_fmt)
 	{
 		case V4L2_PIX_FMT_JPEG:
 		case V4L2_PIX_FMT_MJPEG:
-			/*init jpeg decoder*/
-			ret = jpeg_init_decoder(width, height);
+			/*init jpeg decoder (kept across format changes)*/
+			if(vd->jpeg_ctx == NULL)
+			{
+				vd->jpeg_ctx = jpeg_init_decoder();
+				if(vd->jpeg_ctx != NULL)
+					set_band_threads(vd);
+			}
 
-			if(ret)
+			if(vd->jpeg_ctx == NULL)
 			{
 				fprintf(stderr, "V4L2_CORE: couldn't init jpeg decoder\n");
-				return ret;
+				return E_NO_CODEC;
 			}
 			
 			/*frame queue*/
@@ -95,6 +659,16 @@ int alloc_v4l2_frames(v4l2_dev_t *vd)
 					fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (alloc_v4l2_frames): %s\n", strerror(errno));
 					exit(-1);
 				}
+#ifndef USE_PLANAR_YUV
+				/*the decoder output is yu12: converted to yuyv*/
+				vd->frame_queue[i].tmp_buffer_max_size = width * height * 3/2;
+				vd->frame_queue[i].tmp_buffer = calloc(vd->frame_queue[i].tmp_buffer_max_size, sizeof(uint8_t));
+				if(vd->frame_queue[i].tmp_buffer == NULL)
+				{
+					fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (alloc_v4l2_frames): %s\n", strerror(errno));
+					exit(-1);
+				}
+#endif
 			}
 			break;
 
@@ -111,65 +685,17 @@ int alloc_v4l2_frames(v4l2_dev_t *vd)
 		case V4L2_PIX_FMT_SPCA501:
 		case V4L2_PIX_FMT_SPCA505:
 		case V4L2_PIX_FMT_SPCA508:
-			framebuf_size = framesizeIn;
-			/*frame queue*/
-			for(i=0; i<vd->frame_queue_size; ++i)
-			{
-				/*FIXME: do we need the temp buffer ?*/
-				/* alloc a temp buffer for colorspace conversion*/
-				vd->frame_queue[i].tmp_buffer_max_size = width * height * 2;
-				vd->frame_queue[i].tmp_buffer = calloc(vd->frame_queue[i].tmp_buffer_max_size, sizeof(uint8_t));
-				if(vd->frame_queue[i].tmp_buffer == NULL)
-				{
-					fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (alloc_v4l2_frames): %s\n", strerror(errno));
-					exit(-1);
-				}
-			
-				vd->frame_queue[i].yuv_frame = calloc(framebuf_size, sizeof(uint8_t));
-				if(vd->frame_queue[i].yuv_frame == NULL)
-				{
-					fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (alloc_v4l2_frames): %s\n", strerror(errno));
-					exit(-1);
-				}
-			}
-			break;
-
 		case V4L2_PIX_FMT_GREY:
+		case V4L2_PIX_FMT_Y10BPACK:
+		case V4L2_PIX_FMT_Y16:
+			/*
+			 * the converters read straight from the raw frame
+			 *  (checked against get_raw_frame_min_size): no temp buffer
+			 */
 			framebuf_size = framesizeIn;
 			/*frame queue*/
 			for(i=0; i<vd->frame_queue_size; ++i)
 			{
-				/* alloc a temp buffer for colorspace conversion*/
-				vd->frame_queue[i].tmp_buffer_max_size = width * height; /* 1 byte per pixel*/
-				vd->frame_queue[i].tmp_buffer = calloc(vd->frame_queue[i].tmp_buffer_max_size, sizeof(uint8_t));
-				if(vd->frame_queue[i].tmp_buffer == NULL)
-				{
-					fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (alloc_v4l2_frames): %s\n", strerror(errno));
-					exit(-1);
-				}
-				vd->frame_queue[i].yuv_frame = calloc(framebuf_size, sizeof(uint8_t));
-				if(vd->frame_queue[i].yuv_frame == NULL)
-				{
-					fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (alloc_v4l2_frames): %s\n", strerror(errno));
-					exit(-1);
-				}
-			}
-			break;
-
-	    case V4L2_PIX_FMT_Y10BPACK:
-	    case V4L2_PIX_FMT_Y16:
-			framebuf_size = framesizeIn;
-			/*frame queue*/
-			for(i=0; i<vd->frame_queue_size; ++i)
-			{
-				/* alloc a temp buffer for colorspace conversion*/
-				vd->frame_queue[i].tmp_buffer_max_size = framesizeIn; /* 2 byte per pixel*/
-				vd->frame_queue[i].tmp_buffer = calloc(vd->frame_queue[i].tmp_buffer_max_size, sizeof(uint8_t));
-				if(vd->frame_queue[i].tmp_buffer == NULL)
-				{
-					fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (alloc_v4l2_frames): %s\n", strerror(errno));
-					exit(-1);
-				}
 				vd->frame_queue[i].yuv_frame = calloc(framebuf_size, sizeof(uint8_t));
 				if(vd->frame_queue[i].yuv_frame == NULL)
 				{
@@ -185,6 +711,11 @@ int alloc_v4l2_frames(v4l2_dev_t *vd)
 			 *  video processing disable is set (bayer processing).
 			 *            (logitech cameras only)
 			 */
+#ifdef USE_PLANAR_YUV
+			/*bayer processing decodes straight to yu12 (no temp buffer)*/
+			if(init_bayer_decoder(vd) != E_OK)
+				return E_NO_CODEC;
+#endif
 			framebuf_size = framesizeIn;
 			/*frame queue*/
 			for(i=0; i<vd->frame_queue_size; ++i)
@@ -205,13 +736,20 @@ int alloc_v4l2_frames(v4l2_dev_t *vd)
 			/*
 			 * Raw 8 bit bayer
 			 * when grabbing use:
+			 *    bayer_decode(bayer_ctx, yu12 planes, strides, bayer_data, width, height, 0..3)
+			 *  or (yuyv):
 			 *    bayer_to_rgb24(bayer_data, RGB24_data, width, height, 0..3)
 			 *    rgb2yuyv(RGB24_data, vd->framebuffer, width, height)
 			 */
 			framebuf_size = framesizeIn;
+#ifdef USE_PLANAR_YUV
+			if(init_bayer_decoder(vd) != E_OK)
+				return E_NO_CODEC;
+#endif
 			/*frame queue*/
 			for(i=0; i<vd->frame_queue_size; ++i)
 			{
+#ifndef USE_PLANAR_YUV
 				/* alloc a temp buffer for converting to YUYV*/
 				/* rgb buffer for decoding bayer data*/
 				vd->frame_queue[i].tmp_buffer_max_size = width * height * 3;
@@ -221,6 +759,7 @@ int alloc_v4l2_frames(v4l2_dev_t *vd)
 					fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (alloc_v4l2_frames): %s\n", strerror(errno));
 					exit(-1);
 				}
+#endif
 				vd->frame_queue[i].yuv_frame = calloc(framebuf_size, sizeof(uint8_t));
 				if(vd->frame_queue[i].yuv_frame == NULL)
 				{
@@ -324,11 +863,106 @@ void clean_v4l2_frames(v4l2_dev_t *vd)
 			free(vd->frame_queue[i].yuv_frame);
 			vd->frame_queue[i].yuv_frame = NULL;
 		}
+
+		if(vd->frame_queue[i].luma16_frame)
+		{
+			free(vd->frame_queue[i].luma16_frame);
+			vd->frame_queue[i].luma16_frame = NULL;
+		}
+		vd->frame_queue[i].luma16_bits = 0;
 	}
+}
 
-	if(vd->requested_fmt == V4L2_PIX_FMT_JPEG ||
-	   vd->requested_fmt == V4L2_PIX_FMT_MJPEG)
-		jpeg_close_decoder();
+/*
+ * check the raw frame before decoding (cheap structural check)
+ *   only compressed formats are checked
+ * args:
+ *    vd - pointer to device data
+ *    frame - pointer to frame buffer
+ *
+ * asserts:
+ *    vd is not null
+ *    frame is not null
+ *
+ * returns: error code ( 0 - E_OK)
+ */
+int check_v4l2_frame(v4l2_dev_t *vd, v4l2_frame_buff_t *frame)
+{
+	/*asserts*/
+	assert(vd != NULL);
+	assert(frame != NULL);
+
+	if(!frame->raw_frame || frame->raw_frame_size == 0)
+		return E_NO_DATA;
+
+	switch(vd->requested_fmt)
+	{
+		case V4L2_PIX_FMT_JPEG:
+		case V4L2_PIX_FMT_MJPEG:
+			return jpeg_check_frame(frame->raw_frame, frame->raw_frame_size,
+				vd->format.fmt.pix.width, vd->format.fmt.pix.height);
+
+		default:
+			break;
+	}
+
+	return E_OK;
+}
+
+/*
+ * decode Y10B/Y16 keeping the full luma precision (16 bit luma mode)
+ *   the luma is stored in frame->luma16_frame (allocated on first use)
+ *   and yuv_frame gets an 8 bit copy for rendering
+ * args:
+ *    vd - pointer to device data
+ *    frame - pointer to frame buffer
+ *
+ * asserts:
+ *    none
+ *
+ * returns: error code (E_OK)
+ */
+static int decode_luma16(v4l2_dev_t *vd, v4l2_frame_buff_t *frame)
+{
+	int width = vd->format.fmt.pix.width;
+	int height = vd->format.fmt.pix.height;
+
+	/*freed in clean_v4l2_frames (format change)*/
+	if(frame->luma16_frame == NULL)
+	{
+		frame->luma16_frame = calloc(width * height, sizeof(uint16_t));
+		if(frame->luma16_frame == NULL)
+		{
+			fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (decode_luma16): %s\n", strerror(errno));
+			exit(-1);
+		}
+	}
+
+	if(vd->requested_fmt == V4L2_PIX_FMT_Y10BPACK)
+	{
+		y10b_to_y16(frame->luma16_frame, frame->raw_frame, width, height);
+		frame->luma16_bits = 10;
+	}
+	else
+	{
+		/*the raw frame goes back to the driver: keep a copy (rows may be padded)*/
+		int pitch = vd->format.fmt.pix.bytesperline;
+		if(pitch < width * 2)
+			pitch = width * 2;
+
+		int h = 0;
+		for(h = 0; h < height; h++)
+			memcpy(frame->luma16_frame + h * width, frame->raw_frame + h * pitch, width * sizeof(uint16_t));
+		frame->luma16_bits = 16;
+	}
+
+#ifdef USE_PLANAR_YUV
+	luma16_to_yu12(frame->yuv_frame, frame->luma16_frame, width, height, frame->luma16_bits);
+#else
+	luma16_to_yuyv(frame->yuv_frame, frame->luma16_frame, width, height, frame->luma16_bits);
+#endif
+
+	return E_OK;
 }
 
 /*
@@ -359,6 +993,9 @@ int decode_v4l2_frame(v4l2_dev_t *vd, v4l2_frame_buff_t *frame)
 
 	int ret = E_OK;
 
+	/*full size decode*/
+	frame->yuv_scale = 1;
+
 	int width = vd->format.fmt.pix.width;
 	int height = vd->format.fmt.pix.height;
 
@@ -366,9 +1003,20 @@ int decode_v4l2_frame(v4l2_dev_t *vd, v4l2_frame_buff_t *frame)
 	 * use the requested format since it may differ
 	 * from format.fmt.pix.pixelformat (muxed H264)
 	 */
-	int format = vd->requested_fmt;
+	int format = vd->requested_fmt;
+
+	/*
+	 * uncompressed formats are converted straight from the raw frame
+	 * (no staging copy): don't read past the end of a short frame
+	 */
+	size_t raw_min_size = get_raw_frame_min_size(vd, frame->raw_frame);
+	if(frame->raw_frame_size < raw_min_size)
+	{
+		fprintf(stderr, "V4L2_CORE: dropping short raw frame (%i bytes, expected %i)\n",
+			(int) frame->raw_frame_size, (int) raw_min_size);
+		return E_DECODE_ERR;
+	}
 
-	int framesizeIn =(width * height << 1);//2 bytes per pixel
 	switch (format)
 	{
 		case V4L2_PIX_FMT_JPEG:
@@ -380,17 +1028,19 @@ int decode_v4l2_frame(v4l2_dev_t *vd, v4l2_frame_buff_t *frame)
 				ret = E_DECODE_ERR;
 				return (ret);
 			}
-			
-			
-			ret = jpeg_decode(frame->yuv_frame, frame->raw_frame, frame->raw_frame_size);						
-			
-			//memcpy(frame->tmp_buffer, frame->raw_frame, frame->raw_frame_size);
-			//ret = jpeg_decode(&frame->yuv_frame, frame->tmp_buffer, width, height);
-			//if ( ret < 0)
-			//{
-			//	fprintf(stderr, "V4L2_CORE: jpeg decoder exit with error (%i) (res: %ix%i - %x)\n", ret, width, height, vd->format.fmt.pix.pixelformat);
-			//	return E_DECODE_ERR;
-			//}
+
+#ifdef USE_PLANAR_YUV
+			ret = jpeg_decode(vd->jpeg_ctx, frame->yuv_frame, width, height, frame->raw_frame, frame->raw_frame_size);
+#else
+			ret = jpeg_decode(vd->jpeg_ctx, frame->tmp_buffer, width, height, frame->raw_frame, frame->raw_frame_size);
+			if(ret > 0)
+				yu12_to_yuyv(frame->yuv_frame, frame->tmp_buffer, width, height);
+#endif
+			if ( ret <= 0)
+			{
+				fprintf(stderr, "V4L2_CORE: jpeg decoder exit with error (res: %ix%i - %x)\n", width, height, vd->format.fmt.pix.pixelformat);
+				return E_DECODE_ERR;
+			}
 			if(verbosity > 3)
 				fprintf(stderr, "V4L2_CORE: (jpeg decoder) decode frame of size %i\n", ret);
 			ret = E_OK;
@@ -398,165 +1048,73 @@ int decode_v4l2_frame(v4l2_dev_t *vd, v4l2_frame_buff_t *frame)
 
 		case V4L2_PIX_FMT_UYVY:
 #ifdef USE_PLANAR_YUV
-			uyvy_to_yu12(frame->yuv_frame, frame->raw_frame, width, height);
+			ret = decode_raw_planes(vd, frame, NULL, NULL);
 #else
-			/*FIXME: do we need the tmp_buffer or can we just use the raw_frame?*/
-			if(frame->raw_frame_size > frame->tmp_buffer_max_size)
-			{
-				// Prevent crash on very large image
-				fprintf(stderr, "V4L2_CORE: (uyvy decoder) cliping unexpected large buffer (%i bytes)\n",
-					(int) frame->raw_frame_size);
-				memcpy(frame->tmp_buffer, frame->raw_frame, frame->tmp_buffer_max_size);
-			}
-			else
-				memcpy(frame->tmp_buffer, frame->raw_frame, frame->raw_frame_size);
-			uyvy_to_yuyv(frame->yuv_frame, frame->tmp_buffer, width, height);
+			ret = decode_raw_yuyv(vd, frame);
 #endif
 			break;
 
 		case V4L2_PIX_FMT_YVYU:
 #ifdef USE_PLANAR_YUV
-			yvyu_to_yu12(frame->yuv_frame, frame->raw_frame, width, height);
+			ret = decode_raw_planes(vd, frame, NULL, NULL);
 #else
-			/*FIXME: do we need the tmp_buffer or can we just use the raw_frame?*/
-			if(frame->raw_frame_size > frame->tmp_buffer_max_size)
-			{
-				// Prevent crash on very large image
-				fprintf(stderr, "V4L2_CORE: (yvyu decoder) cliping unexpected large buffer (%i bytes)\n",
-					(int) frame->raw_frame_size);
-				memcpy(frame->tmp_buffer, frame->raw_frame, frame->tmp_buffer_max_size);
-			}
-			else
-				memcpy(frame->tmp_buffer, frame->raw_frame, frame->raw_frame_size);
-			yvyu_to_yuyv(frame->yuv_frame, frame->tmp_buffer, width, height);
+			ret = decode_raw_yuyv(vd, frame);
 #endif
 			break;
 
 		case V4L2_PIX_FMT_YYUV:
 #ifdef USE_PLANAR_YUV
-			yyuv_to_yu12(frame->yuv_frame, frame->raw_frame, width, height);
+			ret = decode_raw_planes(vd, frame, NULL, NULL);
 #else
-			/*FIXME: do we need the tmp_buffer or can we just use the raw_frame?*/
-			if(frame->raw_frame_size > frame->tmp_buffer_max_size)
-			{
-				// Prevent crash on very large image
-				fprintf(stderr, "V4L2_CORE: (yyuv decoder) cliping unexpected large buffer (%i bytes)\n",
-					(int) frame->raw_frame_size);
-				memcpy(frame->tmp_buffer, frame->raw_frame, frame->tmp_buffer_max_size);
-			}
-			else
-				memcpy(frame->tmp_buffer, frame->raw_frame, frame->raw_frame_size);
-			yyuv_to_yuyv(frame->yuv_frame, frame->tmp_buffer, width, height);
+			ret = decode_raw_yuyv(vd, frame);
 #endif
 			break;
 
 		case V4L2_PIX_FMT_YUV420:
 #ifdef USE_PLANAR_YUV
-			if(frame->raw_frame_size > (width * height * 3/2))
-				frame->raw_frame_size = width * height * 3/2;
-			memcpy(frame->yuv_frame, frame->raw_frame, frame->raw_frame_size);
+			ret = decode_raw_planes(vd, frame, NULL, NULL);
 #else
-			/*FIXME: do we need the tmp_buffer or can we just use the raw_frame?*/
-			if(frame->raw_frame_size > frame->tmp_buffer_max_size)
-			{
-				// Prevent crash on very large image
-				fprintf(stderr, "V4L2_CORE: (yuv420 decoder) cliping unexpected large buffer (%i bytes)\n",
-					(int) frame->raw_frame_size);
-				memcpy(frame->tmp_buffer, frame->raw_frame, frame->tmp_buffer_max_size);
-			}
-			else
-				memcpy(frame->tmp_buffer, frame->raw_frame, frame->raw_frame_size);
-			yu12_to_yuyv(frame->yuv_frame, frame->tmp_buffer, width, height);
+			ret = decode_raw_yuyv(vd, frame);
 #endif
 			break;
 
 		case V4L2_PIX_FMT_YVU420:
 #ifdef USE_PLANAR_YUV
-			yv12_to_yu12(frame->yuv_frame, frame->raw_frame, width, height);
+			ret = decode_raw_planes(vd, frame, NULL, NULL);
 #else
-			/*FIXME: do we need the tmp_buffer or can we just use the raw_frame?*/
-			if(frame->raw_frame_size > frame->tmp_buffer_max_size)
-			{
-				// Prevent crash on very large image
-				fprintf(stderr, "V4L2_CORE: (yvu420 decoder) cliping unexpected large buffer (%i bytes)\n",
-					(int) frame->raw_frame_size);
-				memcpy(frame->tmp_buffer, frame->raw_frame, frame->tmp_buffer_max_size);
-			}
-			else
-				memcpy(frame->tmp_buffer, frame->raw_frame, frame->raw_frame_size);
-			yvu420_to_yuyv(frame->yuv_frame, frame->tmp_buffer, width, height);
+			ret = decode_raw_yuyv(vd, frame);
 #endif
 			break;
 
 		case V4L2_PIX_FMT_NV12:
 #ifdef USE_PLANAR_YUV
-			nv12_to_yu12(frame->yuv_frame, frame->raw_frame, width, height);
+			ret = decode_raw_planes(vd, frame, NULL, NULL);
 #else
-			/*FIXME: do we need the tmp_buffer or can we just use the raw_frame?*/
-			if(frame->raw_frame_size > frame->tmp_buffer_max_size)
-			{
-				// Prevent crash on very large image
-				fprintf(stderr, "V4L2_CORE: (nv12 decoder) cliping unexpected large buffer (%i bytes)\n",
-					(int) frame->raw_frame_size);
-				memcpy(frame->tmp_buffer, frame->raw_frame, frame->tmp_buffer_max_size);
-			}
-			else
-				memcpy(frame->tmp_buffer, frame->raw_frame, frame->raw_frame_size);
-			nv12_to_yuyv(frame->yuv_frame, frame->tmp_buffer, width, height);
+			ret = decode_raw_yuyv(vd, frame);
 #endif
 			break;
 
 		case V4L2_PIX_FMT_NV21:
 #ifdef USE_PLANAR_YUV
-			nv21_to_yu12(frame->yuv_frame, frame->raw_frame, width, height);
+			ret = decode_raw_planes(vd, frame, NULL, NULL);
 #else
-			/*FIXME: do we need the tmp_buffer or can we just use the raw_frame?*/
-			if(frame->raw_frame_size > frame->tmp_buffer_max_size)
-			{
-				// Prevent crash on very large image
-				fprintf(stderr, "V4L2_CORE: (nv21 decoder) cliping unexpected large buffer (%i bytes).\n",
-					(int) frame->raw_frame_size);
-				memcpy(frame->tmp_buffer, frame->raw_frame, frame->tmp_buffer_max_size);
-			}
-			else
-				memcpy(frame->tmp_buffer, frame->raw_frame, frame->raw_frame_size);
-			nv21_to_yuyv(frame->yuv_frame, frame->tmp_buffer, width, height);
+			ret = decode_raw_yuyv(vd, frame);
 #endif
 			break;
 
 		case V4L2_PIX_FMT_NV16:
 #ifdef USE_PLANAR_YUV
-			nv16_to_yu12(frame->yuv_frame, frame->raw_frame, width, height);
+			ret = decode_raw_planes(vd, frame, NULL, NULL);
 #else
-			/*FIXME: do we need the tmp_buffer or can we just use the raw_frame?*/
-			if(frame->raw_frame_size > frame->tmp_buffer_max_size)
-			{
-				// Prevent crash on very large image
-				fprintf(stderr, "V4L2_CORE: (nv16 decoder) cliping unexpected large buffer (%i bytes)\n",
-					(int) frame->raw_frame_size);
-				memcpy(frame->tmp_buffer, frame->raw_frame, frame->tmp_buffer_max_size);
-			}
-			else
-				memcpy(frame->tmp_buffer, frame->raw_frame, frame->raw_frame_size);
-			nv16_to_yuyv(frame->yuv_frame, frame->tmp_buffer, width, height);
+			ret = decode_raw_yuyv(vd, frame);
 #endif
 			break;
 
 		case V4L2_PIX_FMT_NV61:
 #ifdef USE_PLANAR_YUV
-			nv61_to_yu12(frame->yuv_frame, frame->raw_frame, width, height);
+			ret = decode_raw_planes(vd, frame, NULL, NULL);
 #else
-			/*FIXME: do we need the tmp_buffer or can we just use the raw_frame?*/
-			if(frame->raw_frame_size > frame->tmp_buffer_max_size)
-			{
-				// Prevent crash on very large image
-				fprintf(stderr, "V4L2_CORE: (nv61 decoder) cliping unexpected large buffer (%i bytes)\n",
-					(int) frame->raw_frame_size);
-				memcpy(frame->tmp_buffer, frame->raw_frame, frame->tmp_buffer_max_size);
-			}
-			else
-				memcpy(frame->tmp_buffer, frame->raw_frame, frame->raw_frame_size);
-			nv61_to_yuyv(frame->yuv_frame, frame->tmp_buffer, width, height);
+			ret = decode_raw_yuyv(vd, frame);
 #endif
 			break;
 
@@ -564,71 +1122,43 @@ int decode_v4l2_frame(v4l2_dev_t *vd, v4l2_frame_buff_t *frame)
 #ifdef USE_PLANAR_YUV
 			y41p_to_yu12(frame->yuv_frame, frame->raw_frame, width, height);
 #else
-			/*FIXME: do we need the tmp_buffer or can we just use the raw_frame?*/
-			if(frame->raw_frame_size > frame->tmp_buffer_max_size)
-			{
-				// Prevent crash on very large image
-				fprintf(stderr, "V4L2_CORE: (y41p decoder) cliping unexpected large buffer (%i bytes)\n",
-					(int) frame->raw_frame_size);
-				memcpy(frame->tmp_buffer, frame->raw_frame, frame->tmp_buffer_max_size);
-			}
-			else
-				memcpy(frame->tmp_buffer, frame->raw_frame, frame->raw_frame_size);
-			y41p_to_yuyv(frame->yuv_frame, frame->tmp_buffer, width, height);
+			y41p_to_yuyv(frame->yuv_frame, frame->raw_frame, width, height);
 #endif
 			break;
 
 		case V4L2_PIX_FMT_GREY:
 #ifdef USE_PLANAR_YUV
-			grey_to_yu12(frame->yuv_frame, frame->raw_frame, width, height);
+			ret = decode_raw_planes(vd, frame, NULL, NULL);
 #else
-			/*FIXME: do we need the tmp_buffer or can we just use the raw_frame?*/
-			if(frame->raw_frame_size > frame->tmp_buffer_max_size)
-			{
-				// Prevent crash on very large image
-				fprintf(stderr, "V4L2_CORE: (grey decoder) cliping unexpected large buffer (%i bytes)\n",
-					(int) frame->raw_frame_size);
-				memcpy(frame->tmp_buffer, frame->raw_frame, frame->tmp_buffer_max_size);
-			}
-			else
-				memcpy(frame->tmp_buffer, frame->raw_frame, frame->raw_frame_size);
-			grey_to_yuyv(frame->yuv_frame, frame->tmp_buffer, width, height);
+			ret = decode_raw_yuyv(vd, frame);
 #endif
 			break;
 
 		case V4L2_PIX_FMT_Y10BPACK:
+			if(vd->luma16_mode)
+			{
+				ret = decode_luma16(vd, frame);
+				break;
+			}
+			frame->luma16_bits = 0;
 #ifdef USE_PLANAR_YUV
 			y10b_to_yu12(frame->yuv_frame, frame->raw_frame, width, height);
 #else
-			/*FIXME: do we need the tmp_buffer or can we just use the raw_frame?*/
-			if(frame->raw_frame_size > frame->tmp_buffer_max_size)
-			{
-				// Prevent crash on very large image
-				fprintf(stderr, "V4L2_CORE: (y10b decoder) cliping unexpected large buffer (%i bytes)\n",
-					(int) frame->raw_frame_size);
-				memcpy(frame->tmp_buffer, frame->raw_frame, frame->tmp_buffer_max_size);
-			}
-			else
-				memcpy(frame->tmp_buffer, frame->raw_frame, frame->raw_frame_size);
-			y10b_to_yuyv(frame->yuv_frame, frame->tmp_buffer, width, height);
+			y10b_to_yuyv(frame->yuv_frame, frame->raw_frame, width, height);
 #endif
 			break;
 
 	    case V4L2_PIX_FMT_Y16:
+			if(vd->luma16_mode)
+			{
+				ret = decode_luma16(vd, frame);
+				break;
+			}
+			frame->luma16_bits = 0;
 #ifdef USE_PLANAR_YUV
 			y16_to_yu12(frame->yuv_frame, frame->raw_frame, width, height);
 #else
-			/*FIXME: do we need the tmp_buffer or can we just use the raw_frame?*/
-			if(frame->raw_frame_size > frame->tmp_buffer_max_size)
-			{
-				// Prevent crash on very large image
-				fprintf(stderr, "V4L2_CORE: (y16 decoder) cliping unexpected large buffer (%i bytes)\n",
-					(int) frame->raw_frame_size);
-				memcpy(frame->tmp_buffer, frame->raw_frame, frame->tmp_buffer_max_size);
-			}
-			else
-				memcpy(frame->tmp_buffer, frame->raw_frame, frame->raw_frame_size);
-			y16_to_yuyv(frame->yuv_frame, frame->tmp_buffer, width, height);
+			y16_to_yuyv(frame->yuv_frame, frame->raw_frame, width, height);
 #endif
 			break;
 
@@ -636,17 +1166,7 @@ int decode_v4l2_frame(v4l2_dev_t *vd, v4l2_frame_buff_t *frame)
 #ifdef USE_PLANAR_YUV
 			s501_to_yu12(frame->yuv_frame, frame->raw_frame, width, height);
 #else
-			/*FIXME: do we need the tmp_buffer or can we just use the raw_frame?*/
-			if(frame->raw_frame_size > frame->tmp_buffer_max_size)
-			{
-				// Prevent crash on very large image
-				fprintf(stderr, "V4L2_CORE: (spca501 decoder) cliping unexpected large buffer (%i bytes)\n",
-					(int) frame->raw_frame_size);
-				memcpy(frame->tmp_buffer, frame->raw_frame, frame->tmp_buffer_max_size);
-			}
-			else
-				memcpy(frame->tmp_buffer, frame->raw_frame, frame->raw_frame_size);
-			s501_to_yuyv(frame->yuv_frame, frame->tmp_buffer, width, height);
+			s501_to_yuyv(frame->yuv_frame, frame->raw_frame, width, height);
 #endif
 			break;
 
@@ -654,17 +1174,7 @@ int decode_v4l2_frame(v4l2_dev_t *vd, v4l2_frame_buff_t *frame)
 #ifdef USE_PLANAR_YUV
 			s505_to_yu12(frame->yuv_frame, frame->raw_frame, width, height);
 #else
-			/*FIXME: do we need the tmp_buffer or can we just use the raw_frame?*/
-			if(frame->raw_frame_size > frame->tmp_buffer_max_size)
-			{
-				// Prevent crash on very large image
-				fprintf(stderr, "V4L2_CORE: (spca505 decoder) cliping unexpected large buffer (%i bytes)\n",
-					(int) frame->raw_frame_size);
-				memcpy(frame->tmp_buffer, frame->raw_frame, frame->tmp_buffer_max_size);
-			}
-			else
-				memcpy(frame->tmp_buffer, frame->raw_frame, frame->raw_frame_size);
-			s505_to_yuyv(frame->yuv_frame, frame->tmp_buffer, width, height);
+			s505_to_yuyv(frame->yuv_frame, frame->raw_frame, width, height);
 #endif
 			break;
 
@@ -672,17 +1182,7 @@ int decode_v4l2_frame(v4l2_dev_t *vd, v4l2_frame_buff_t *frame)
 #ifdef USE_PLANAR_YUV
 			s508_to_yu12(frame->yuv_frame, frame->raw_frame, width, height);
 #else
-			/*FIXME: do we need the tmp_buffer or can we just use the raw_frame?*/
-			if(frame->raw_frame_size > frame->tmp_buffer_max_size)
-			{
-				// Prevent crash on very large image
-				fprintf(stderr, "V4L2_CORE: (spca508 decoder) cliping unexpected large buffer (%i bytes)\n",
-					(int) frame->raw_frame_size);
-				memcpy(frame->tmp_buffer, frame->raw_frame, frame->tmp_buffer_max_size);
-			}
-			else
-				memcpy(frame->tmp_buffer, frame->raw_frame, frame->raw_frame_size);
-			s508_to_yuyv(frame->yuv_frame, frame->tmp_buffer, width, height);
+			s508_to_yuyv(frame->yuv_frame, frame->raw_frame, width, height);
 #endif
 			break;
 
@@ -690,23 +1190,11 @@ int decode_v4l2_frame(v4l2_dev_t *vd, v4l2_frame_buff_t *frame)
 #ifdef USE_PLANAR_YUV
 			if(vd->isbayer>0)
 			{
-				if (!(frame->tmp_buffer))
-				{
-					/* rgb buffer for decoding bayer data*/
-					frame->tmp_buffer_max_size = width * height * 3;
-					frame->tmp_buffer = calloc(frame->tmp_buffer_max_size, sizeof(uint8_t));
-					if(frame->tmp_buffer == NULL)
-					{
-						fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (v4l2core_frame_decode): %s\n", strerror(errno));
-						exit(-1);
-					}
-				}
 				/*convert raw bayer to iyuv*/
-				bayer_to_rgb24 (frame->raw_frame, frame->tmp_buffer, width, height, vd->bayer_pix_order);
-				rgb24_to_yu12(frame->yuv_frame, frame->tmp_buffer, width, height);
+				ret = decode_bayer(vd, frame, NULL, NULL, vd->bayer_pix_order);
 			}
 			else
-				yuyv_to_yu12(frame->yuv_frame, frame->raw_frame, width, height);
+				ret = decode_raw_planes(vd, frame, NULL, NULL);
 #else
 			if(vd->isbayer>0)
 			{
@@ -726,47 +1214,18 @@ int decode_v4l2_frame(v4l2_dev_t *vd, v4l2_frame_buff_t *frame)
 				rgb2yuyv (frame->tmp_buffer, frame->yuv_frame, width, height);
 			}
 			else
-			{
-				if (frame->raw_frame_size > framesizeIn)
-					memcpy(frame->yuv_frame, frame->raw_frame,
-						(size_t) framesizeIn);
-				else
-					memcpy(frame->yuv_frame, frame->raw_frame, frame->raw_frame_size);
-			}
+				ret = decode_raw_yuyv(vd, frame);
 #endif
 			break;
 
 		case V4L2_PIX_FMT_SGBRG8: //0
-			bayer_to_rgb24 (frame->raw_frame, frame->tmp_buffer, width, height, 0);
-#ifdef USE_PLANAR_YUV
-			rgb24_to_yu12(frame->yuv_frame, frame->tmp_buffer, width, height);
-#else
-			rgb2yuyv (frame->tmp_buffer, frame->yuv_frame, width, height);
-#endif
-			break;
-
 		case V4L2_PIX_FMT_SGRBG8: //1
-			bayer_to_rgb24 (frame->raw_frame, frame->tmp_buffer, width, height, 1);
-#ifdef USE_PLANAR_YUV
-			rgb24_to_yu12(frame->yuv_frame, frame->tmp_buffer, width, height);
-#else
-			rgb2yuyv (frame->tmp_buffer, frame->yuv_frame, width, height);
-#endif
-			break;
-
 		case V4L2_PIX_FMT_SBGGR8: //2
-			bayer_to_rgb24 (frame->raw_frame, frame->tmp_buffer, width, height, 2);
-#ifdef USE_PLANAR_YUV
-			rgb24_to_yu12(frame->yuv_frame, frame->tmp_buffer, width, height);
-#else
-			rgb2yuyv (frame->tmp_buffer, frame->yuv_frame, width, height);
-#endif
-			break;
 		case V4L2_PIX_FMT_SRGGB8: //3
-			bayer_to_rgb24 (frame->raw_frame, frame->tmp_buffer, width, height, 3);
 #ifdef USE_PLANAR_YUV
-			rgb24_to_yu12(frame->yuv_frame, frame->tmp_buffer, width, height);
+			ret = decode_bayer(vd, frame, NULL, NULL, get_bayer_pix_order(format));
 #else
+			bayer_to_rgb24 (frame->raw_frame, frame->tmp_buffer, width, height, get_bayer_pix_order(format));
 			rgb2yuyv (frame->tmp_buffer, frame->yuv_frame, width, height);
 #endif
 			break;
@@ -794,3 +1253,335 @@ int decode_v4l2_frame(v4l2_dev_t *vd, v4l2_frame_buff_t *frame)
 
 	return ret;
 }
+
+/*
+ * get the preview scale denominator
+ *   the preview is only scaled for (m)jpeg (dct scaling) and
+ *   the scaled planes must keep even dimensions
+ * args:
+ *    vd - pointer to device data
+ *
+ * asserts:
+ *    vd is not null
+ *
+ * returns: preview scale denominator (1, 2, 4 or 8)
+ */
+int get_preview_scale(v4l2_dev_t *vd)
+{
+	/*asserts*/
+	assert(vd != NULL);
+
+	int scale = 1;
+#ifdef USE_PLANAR_YUV
+	if(vd->requested_fmt == V4L2_PIX_FMT_MJPEG || vd->requested_fmt == V4L2_PIX_FMT_JPEG)
+	{
+		int width = vd->format.fmt.pix.width;
+		int height = vd->format.fmt.pix.height;
+
+		scale = vd->preview_scale;
+		while(scale > 1 && ((width % (2 * scale)) || (height % (2 * scale))))
+			scale >>= 1;
+	}
+#endif
+	return scale;
+}
+
+/*
+ * get the yuv colorimetry of the decoded frames (for rgb conversion)
+ *   only uncompressed yuv formats carry the driver colorimetry
+ *   (when the driver reports it), everything else is converted
+ *   to (or decoded as) bt601 full range yuv, like jpeg
+ * args:
+ *    vd - pointer to device data
+ *    matrix - pointer to yuv matrix (YUV_MATRIX_xxx)
+ *    range - pointer to yuv range (YUV_RANGE_xxx)
+ *
+ * asserts:
+ *    vd is not null
+ *    matrix is not null
+ *    range is not null
+ *
+ * returns: none
+ */
+void get_yuv_colorimetry(v4l2_dev_t *vd, int *matrix, int *range)
+{
+	/*asserts*/
+	assert(vd != NULL);
+	assert(matrix != NULL);
+	assert(range != NULL);
+
+	int fmt_matrix = YUV_MATRIX_BT601;
+	int fmt_range = YUV_RANGE_FULL;
+
+	switch(vd->requested_fmt)
+	{
+		case V4L2_PIX_FMT_YUYV:
+			if(vd->isbayer > 0)
+				break;
+			/*fall through*/
+		case V4L2_PIX_FMT_YVYU:
+		case V4L2_PIX_FMT_UYVY:
+		case V4L2_PIX_FMT_YYUV:
+		case V4L2_PIX_FMT_YUV422P:
+		case V4L2_PIX_FMT_YUV420:
+		case V4L2_PIX_FMT_YVU420:
+		case V4L2_PIX_FMT_NV12:
+		case V4L2_PIX_FMT_NV21:
+		case V4L2_PIX_FMT_NV16:
+		case V4L2_PIX_FMT_NV61:
+		case V4L2_PIX_FMT_Y41P:
+			switch(vd->format.fmt.pix.colorspace)
+			{
+				case V4L2_COLORSPACE_REC709:
+					fmt_matrix = YUV_MATRIX_BT709;
+					break;
+				case V4L2_COLORSPACE_BT2020:
+					fmt_matrix = YUV_MATRIX_BT2020;
+					break;
+				default:
+					break;
+			}
+#ifdef V4L2_PIX_FMT_PRIV_MAGIC
+			/*extended format fields (ycbcr_enc, quantization) are valid*/
+			if(vd->format.fmt.pix.priv == V4L2_PIX_FMT_PRIV_MAGIC)
+			{
+				switch(vd->format.fmt.pix.ycbcr_enc)
+				{
+					case V4L2_YCBCR_ENC_601:
+						fmt_matrix = YUV_MATRIX_BT601;
+						break;
+					case V4L2_YCBCR_ENC_709:
+						fmt_matrix = YUV_MATRIX_BT709;
+						break;
+					case V4L2_YCBCR_ENC_BT2020:
+						fmt_matrix = YUV_MATRIX_BT2020;
+						break;
+					default:
+						break;
+				}
+
+				if(vd->format.fmt.pix.quantization == V4L2_QUANTIZATION_LIM_RANGE)
+					fmt_range = YUV_RANGE_LIMITED;
+			}
+#endif
+			break;
+
+		default:
+			break;
+	}
+
+	*matrix = (vd->yuv_matrix != YUV_MATRIX_AUTO) ? vd->yuv_matrix : fmt_matrix;
+	*range = (vd->yuv_range != YUV_RANGE_AUTO) ? vd->yuv_range : fmt_range;
+}
+
+/*
+ * decode video stream straight into the given planes
+ *   (e.g. the render overlay) honouring the plane pitches:
+ *   (m)jpeg frames are decoded into the planes and other
+ *   formats are converted into them if they are contiguous,
+ *   else the frame is decoded to the frame buffer and copied
+ *   (frame->yuv_frame is only valid in the last case)
+ *   the output is scaled down by the preview scale (get_preview_scale)
+ * args:
+ *    vd - pointer to device data
+ *    frame - pointer to frame buffer
+ *    planes - output planes (yu12: y, u, v; yuyv: a single plane)
+ *    pitches - output plane pitches
+ *
+ * asserts:
+ *    vd is not null
+ *    frame is not null
+ *    planes is not null
+ *    pitches is not null
+ *
+ * returns: error code ( 0 - E_OK)
+*/
+int decode_v4l2_frame_to(v4l2_dev_t *vd, v4l2_frame_buff_t *frame, uint8_t **planes, int *pitches)
+{
+	/*asserts*/
+	assert(vd != NULL);
+	assert(frame != NULL);
+	assert(planes != NULL);
+	assert(pitches != NULL);
+
+	int width = vd->format.fmt.pix.width;
+	int format = vd->requested_fmt;
+	int ret = E_OK;
+#ifdef USE_PLANAR_YUV
+	int height = vd->format.fmt.pix.height;
+	int scale = get_preview_scale(vd);
+	uint8_t *in_planes[3];
+	int in_pitches[3];
+#endif
+
+	if(format == V4L2_PIX_FMT_MJPEG || format == V4L2_PIX_FMT_JPEG)
+	{
+#ifdef USE_PLANAR_YUV
+		if(frame->raw_frame && frame->raw_frame_size > HEADERFRAME1)
+		{
+			ret = jpeg_decode_planes(vd->jpeg_ctx, planes, pitches, width, height, scale,
+				frame->raw_frame, frame->raw_frame_size);
+			if(ret > 0)
+				return E_OK;
+			if(ret == 0)
+				return E_DECODE_ERR;
+			/*frame size mismatch: decode to the frame buffer*/
+		}
+#endif
+	}
+#ifdef USE_PLANAR_YUV
+	else if(get_bayer_pix_order(format) >= 0 || (format == V4L2_PIX_FMT_YUYV && vd->isbayer > 0))
+	{
+		/*raw bayer is decoded in rows: any plane pitch*/
+		int pix_order = (format == V4L2_PIX_FMT_YUYV) ? vd->bayer_pix_order : get_bayer_pix_order(format);
+		return decode_bayer(vd, frame, planes, pitches, pix_order);
+	}
+	else if(get_raw_frame_planes(vd, frame->raw_frame, in_planes, in_pitches) > 0)
+	{
+		/*strided converters: any plane pitch*/
+		return decode_raw_planes(vd, frame, planes, pitches);
+	}
+#endif
+	else
+	{
+#ifdef USE_PLANAR_YUV
+		int contiguous = (pitches[0] == width &&
+			pitches[1] == width / 2 && pitches[2] == width / 2 &&
+			planes[1] == planes[0] + width * height &&
+			planes[2] == planes[1] + (width / 2) * (height / 2));
+#else
+		int contiguous = (pitches[0] == width * 2);
+#endif
+		/*the converters only write to the output buffer: point it to the planes*/
+		if(contiguous)
+		{
+			uint8_t *yuv_frame = frame->yuv_frame;
+			frame->yuv_frame = planes[0];
+			ret = decode_v4l2_frame(vd, frame);
+			frame->yuv_frame = yuv_frame;
+			return ret;
+		}
+	}
+
+	ret = decode_v4l2_frame(vd, frame);
+	if(ret != E_OK)
+		return ret;
+
+	return copy_v4l2_frame_to(vd, frame, planes, pitches);
+}
+
+/*
+ * decode video stream to the frame buffer at the preview size
+ *   (m)jpeg frames are scaled down in the idct and stored as
+ *   contiguous planes at the preview size (frame->yuv_scale)
+ * args:
+ *    vd - pointer to device data
+ *    frame - pointer to frame buffer
+ *
+ * asserts:
+ *    vd is not null
+ *    frame is not null
+ *
+ * returns: error code ( 0 - E_OK)
+*/
+int decode_v4l2_frame_preview(v4l2_dev_t *vd, v4l2_frame_buff_t *frame)
+{
+	/*asserts*/
+	assert(vd != NULL);
+	assert(frame != NULL);
+
+	int scale = get_preview_scale(vd);
+	if(scale <= 1)
+		return decode_v4l2_frame(vd, frame);
+
+	/*contiguous yu12 planes, like a full size frame*/
+	int width = vd->format.fmt.pix.width / scale;
+	int height = vd->format.fmt.pix.height / scale;
+	uint8_t *planes[3];
+	int pitches[3] = {width, width / 2, width / 2};
+	planes[0] = frame->yuv_frame;
+	planes[1] = planes[0] + width * height;
+	planes[2] = planes[1] + (width / 2) * (height / 2);
+
+	int ret = decode_v4l2_frame_to(vd, frame, planes, pitches);
+	frame->yuv_scale = scale;
+
+	return ret;
+}
+
+/*
+ * copy the decoded frame (frame->yuv_frame) to the given planes
+ *   honouring the plane pitches, decimated to the preview size
+ *   (get_preview_scale) unless it was decoded at the preview size
+ * args:
+ *    vd - pointer to device data
+ *    frame - pointer to decoded frame buffer
+ *    planes - output planes (yu12: y, u, v; yuyv: a single plane)
+ *    pitches - output plane pitches
+ *
+ * asserts:
+ *    vd is not null
+ *    frame is not null
+ *    planes is not null
+ *    pitches is not null
+ *
+ * returns: error code ( 0 - E_OK)
+*/
+int copy_v4l2_frame_to(v4l2_dev_t *vd, v4l2_frame_buff_t *frame, uint8_t **planes, int *pitches)
+{
+	/*asserts*/
+	assert(vd != NULL);
+	assert(frame != NULL);
+	assert(planes != NULL);
+	assert(pitches != NULL);
+
+	int yuv_scale = (frame->yuv_scale > 1) ? frame->yuv_scale : 1;
+	int width = vd->format.fmt.pix.width / yuv_scale;
+	int height = vd->format.fmt.pix.height / yuv_scale;
+	int preview_scale = get_preview_scale(vd);
+
+	/*the frame buffer can't be scaled up*/
+	if(preview_scale < yuv_scale)
+		return E_DECODE_ERR;
+
+	/*
+	 * copy (or decimate to the preview size) the frame buffer to the planes
+	 * (decimating in place is safe: the output never gets ahead of the input)
+	 */
+	uint8_t *src = frame->yuv_frame;
+	int i = 0;
+#ifdef USE_PLANAR_YUV
+	int scale = preview_scale / yuv_scale;
+	for(i = 0; i < 3; i++)
+	{
+		int plane_width = (i == 0) ? width : width / 2;
+		int plane_height = (i == 0) ? height : height / 2;
+		uint8_t *dst = planes[i];
+		int h = 0;
+		for(h = 0; h < plane_height / scale; h++)
+		{
+			uint8_t *line = src + h * scale * plane_width;
+			if(scale == 1)
+				memcpy(dst, line, plane_width);
+			else
+			{
+				int w = 0;
+				for(w = 0; w < plane_width / scale; w++)
+					dst[w] = line[w * scale];
+			}
+			dst += pitches[i];
+		}
+		src += plane_width * plane_height;
+	}
+#else
+	uint8_t *dst = planes[0];
+	for(i = 0; i < height; i++)
+	{
+		memcpy(dst, src, width * 2);
+		dst += pitches[0];
+		src += width * 2;
+	}
+#endif
+
+	return E_OK;
+}
@@ -39,6 +39,21 @@
  */
 int alloc_v4l2_frames(v4l2_dev_t *vd);
 
+/*
+ * check the raw frame before decoding (cheap structural check)
+ *   only compressed formats are checked
+ * args:
+ *    vd - pointer to device data
+ *    frame - pointer to frame buffer
+ *
+ * asserts:
+ *    vd is not null
+ *    frame is not null
+ *
+ * returns: error code ( 0 - E_OK)
+ */
+int check_v4l2_frame(v4l2_dev_t *vd, v4l2_frame_buff_t *frame);
+
 /*
  * decode video stream ( from raw_frame to frame buffer (yuyv format))
  * args:
@@ -51,6 +66,105 @@ int alloc_v4l2_frames(v4l2_dev_t *vd);
  */
 int decode_v4l2_frame(v4l2_dev_t *vd, v4l2_frame_buff_t *frame);
 
+/*
+ * get the preview scale denominator
+ *   the preview is only scaled for (m)jpeg (dct scaling) and
+ *   the scaled planes must keep even dimensions
+ * args:
+ *    vd - pointer to device data
+ *
+ * asserts:
+ *    vd is not null
+ *
+ * returns: preview scale denominator (1, 2, 4 or 8)
+ */
+int get_preview_scale(v4l2_dev_t *vd);
+
+/*
+ * apply the band thread settings to the device band executor
+ *   (shared by the jpeg, bayer and raw frame decoders)
+ * args:
+ *    vd - pointer to device data
+ *
+ * asserts:
+ *    vd is not null
+ *
+ * returns: none
+ */
+void set_band_threads(v4l2_dev_t *vd);
+
+/*
+ * get the yuv colorimetry of the decoded frames (for rgb conversion)
+ *   auto values are resolved from the driver format
+ * args:
+ *    vd - pointer to device data
+ *    matrix - pointer to yuv matrix (YUV_MATRIX_xxx)
+ *    range - pointer to yuv range (YUV_RANGE_xxx)
+ *
+ * asserts:
+ *    vd is not null
+ *    matrix is not null
+ *    range is not null
+ *
+ * returns: none
+ */
+void get_yuv_colorimetry(v4l2_dev_t *vd, int *matrix, int *range);
+
+/*
+ * decode video stream straight into the given planes
+ *   (e.g. the render overlay) honouring the plane pitches
+ *   and scaled down by the preview scale
+ *   (frame->yuv_frame may not hold the decoded frame)
+ * args:
+ *    vd - pointer to device data
+ *    frame - pointer to frame buffer
+ *    planes - output planes (yu12: y, u, v; yuyv: a single plane)
+ *    pitches - output plane pitches
+ *
+ * asserts:
+ *    vd is not null
+ *    frame is not null
+ *    planes is not null
+ *    pitches is not null
+ *
+ * returns: error code (E_OK)
+ */
+int decode_v4l2_frame_to(v4l2_dev_t *vd, v4l2_frame_buff_t *frame, uint8_t **planes, int *pitches);
+
+/*
+ * decode video stream to the frame buffer at the preview size
+ *   (frame->yuv_scale is set to the preview scale)
+ * args:
+ *    vd - pointer to device data
+ *    frame - pointer to frame buffer
+ *
+ * asserts:
+ *    vd is not null
+ *    frame is not null
+ *
+ * returns: error code (E_OK)
+ */
+int decode_v4l2_frame_preview(v4l2_dev_t *vd, v4l2_frame_buff_t *frame);
+
+/*
+ * copy a decoded frame buffer to the given planes
+ *   honouring the plane pitches and decimated to the preview size
+ * args:
+ *    vd - pointer to device data
+ *    frame - pointer to decoded frame buffer
+ *    planes - output planes (yu12: y, u, v; yuyv: a single plane)
+ *    pitches - output plane pitches
+ *
+ * asserts:
+ *    vd is not null
+ *    frame is not null
+ *    planes is not null
+ *    pitches is not null
+ *
+ * returns: error code (E_OK)
+ */
+int copy_v4l2_frame_to(v4l2_dev_t *vd, v4l2_frame_buff_t *frame, uint8_t **planes, int *pitches);
+
 /*
  * free image buffers for decoding video stream
  * args:
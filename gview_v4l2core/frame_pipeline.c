@@ -0,0 +1,522 @@
+/*******************************************************************************#
+#           guvcview              http://guvcview.sourceforge.net               #
+#                                                                               #
+#           Paulo Assis <pj.assis@gmail.com>                                    #
+#                                                                               #
+# This program is free software; you can redistribute it and/or modify          #
+# it under the terms of the GNU General Public License as published by          #
+# the Free Software Foundation; either version 2 of the License, or             #
+# (at your option) any later version.                                           #
+#                                                                               #
+# This program is distributed in the hope that it will be useful,               #
+# but WITHOUT ANY WARRANTY; without even the implied warranty of                #
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 #
+# GNU General Public License for more details.                                  #
+#                                                                               #
+# You should have received a copy of the GNU General Public License             #
+# along with this program; if not, write to the Free Software                   #
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA     #
+#                                                                               #
+********************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/types.h>
+#include <sys/syscall.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <time.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+
+#include "gviewv4l2core.h"
+#include "v4l2_core.h"
+#include "frame_decoder.h"
+#include "frame_pipeline.h"
+#include "jpeg_decoder.h"
+#include "latency_stats.h"
+#include "gview.h"
+
+#define __PMUTEX (&vd->mutex)
+
+/*max time (ms) to wait for a decoded frame*/
+#define PIPELINE_FRAME_TIMEOUT (1000)
+
+extern int verbosity;
+
+struct _frame_pipeline_t
+{
+	v4l2_dev_t *vd;                     //device being decoded
+
+	__THREAD_TYPE dequeue_thread;       //dequeues and timestamps driver buffers
+	int has_dequeue_thread;             //set to 1 if dequeue_thread is running
+	__THREAD_TYPE *decoder_threads;     //decoder worker pool
+	int ndecoders;                      //number of decoder threads
+
+	__COND_TYPE cond;                   //signaled on every frame status change
+
+	int quit;                           //set to 1 to stop all pipeline threads
+	int wakeup;                         //set to 1 to return from a frame wait without a frame
+};
+
+/*
+ * wait on the pipeline condition for at most ms milliseconds
+ *   (device mutex must be locked)
+ * args:
+ *   vd - pointer to video device data
+ *   ms - timeout in milliseconds
+ *
+ * asserts:
+ *   none
+ *
+ * returns: 0 if signaled, ETIMEDOUT on timeout
+ */
+static int pipeline_timed_wait(v4l2_dev_t *vd, int ms)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+
+	ts.tv_sec += ms / 1000;
+	ts.tv_nsec += (ms % 1000) * 1000000L;
+	if(ts.tv_nsec >= NSEC_PER_SEC)
+	{
+		ts.tv_sec++;
+		ts.tv_nsec -= NSEC_PER_SEC;
+	}
+
+	return __COND_TIMED_WAIT(&vd->pipeline->cond, __PMUTEX, &ts);
+}
+
+/*
+ * check for a free slot in the frame queue
+ *   (device mutex must be locked)
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   none
+ *
+ * returns: 1 if a slot is free, 0 otherwise
+ */
+static int has_free_frame(v4l2_dev_t *vd)
+{
+	/*
+	 * enough slots to keep every decoder busy plus the frame being
+	 * delivered, but always leave a driver buffer to capture into
+	 */
+	int max_frames = vd->pipeline->ndecoders + 1;
+	if(vd->num_buffers > 1 && max_frames > vd->num_buffers - 1)
+		max_frames = vd->num_buffers - 1;
+
+	int nready = 0;
+	int i = 0;
+	for(i = 0; i < vd->frame_queue_size; ++i)
+	{
+		if(vd->frame_queue[i].status == FRAME_READY)
+			nready++;
+	}
+
+	return (nready > 0 && vd->frame_queue_size - nready < max_frames);
+}
+
+/*
+ * check that every frame slot is free (no frame holds a driver buffer)
+ *   (device mutex must be locked)
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   none
+ *
+ * returns: 1 if all slots are free, 0 otherwise
+ */
+static int all_frames_free(v4l2_dev_t *vd)
+{
+	int i = 0;
+	for(i = 0; i < vd->frame_queue_size; ++i)
+	{
+		if(vd->frame_queue[i].status != FRAME_READY)
+			return 0;
+	}
+
+	return 1;
+}
+
+/*
+ * get the captured frame with the lowest frame_index that
+ *   is still owned by the pipeline (queued, decoding or done)
+ *   (device mutex must be locked)
+ * args:
+ *   vd - pointer to video device data
+ *   status - if >= 0 only consider frames with this status
+ *
+ * asserts:
+ *   none
+ *
+ * returns: pointer to frame (NULL if none)
+ */
+static v4l2_frame_buff_t *get_oldest_frame(v4l2_dev_t *vd, int status)
+{
+	v4l2_frame_buff_t *oldest = NULL;
+
+	int i = 0;
+	for(i = 0; i < vd->frame_queue_size; ++i)
+	{
+		v4l2_frame_buff_t *frame = &vd->frame_queue[i];
+
+		if(frame->status != FRAME_QUEUED &&
+			frame->status != FRAME_DECODING &&
+			frame->status != FRAME_DONE)
+			continue;
+
+		if(status >= 0 && frame->status != status)
+			continue;
+
+		if(oldest == NULL || frame->frame_index < oldest->frame_index)
+			oldest = frame;
+	}
+
+	return oldest;
+}
+
+/*
+ * dequeue thread: dequeues and timestamps driver buffers
+ *   and hands them to the decoder threads
+ * args:
+ *   data - pointer to video device data
+ *
+ * asserts:
+ *   none
+ *
+ * returns: NULL
+ */
+static void *dequeue_loop(void *data)
+{
+	v4l2_dev_t *vd = (v4l2_dev_t *) data;
+	frame_pipeline_t *pipe = vd->pipeline;
+
+	if(verbosity > 1)
+		printf("V4L2_CORE: pipeline dequeue thread (tid: %u)\n",
+			(unsigned int) syscall (SYS_gettid));
+
+	__LOCK_MUTEX( __PMUTEX );
+	while(!pipe->quit)
+	{
+		/*
+		 * only dequeue when a frame slot is available
+		 * otherwise the driver buffer would be lost
+		 */
+		if(!has_free_frame(vd))
+		{
+			__COND_WAIT(&pipe->cond, __PMUTEX);
+			continue;
+		}
+
+		/*
+		 * a fps or buffer count change remaps the driver buffers:
+		 * stop dequeuing until the decoders and the client have
+		 * given back every frame (the change is applied in get_frame)
+		 */
+		if((vd->flag_fps_change > 0 || vd->flag_buffers_change > 0) &&
+			!all_frames_free(vd))
+		{
+			__COND_WAIT(&pipe->cond, __PMUTEX);
+			continue;
+		}
+
+		if(vd->streaming != STRM_OK)
+			break;
+		__UNLOCK_MUTEX( __PMUTEX );
+
+		v4l2_frame_buff_t *frame = v4l2core_dev_get_frame(vd);
+
+		__LOCK_MUTEX( __PMUTEX );
+		if(frame != NULL)
+		{
+			frame->status = FRAME_QUEUED;
+			__COND_BCAST(&pipe->cond);
+		}
+	}
+	/*wake anybody waiting for frames*/
+	__COND_BCAST(&pipe->cond);
+	__UNLOCK_MUTEX( __PMUTEX );
+
+	return NULL;
+}
+
+/*
+ * decoder thread: decodes queued frames
+ * args:
+ *   data - pointer to video device data
+ *
+ * asserts:
+ *   none
+ *
+ * returns: NULL
+ */
+static void *decoder_loop(void *data)
+{
+	v4l2_dev_t *vd = (v4l2_dev_t *) data;
+	frame_pipeline_t *pipe = vd->pipeline;
+
+	if(verbosity > 1)
+		printf("V4L2_CORE: pipeline decoder thread (tid: %u)\n",
+			(unsigned int) syscall (SYS_gettid));
+
+	__LOCK_MUTEX( __PMUTEX );
+	while(!pipe->quit)
+	{
+		/*decode the oldest queued frame first*/
+		v4l2_frame_buff_t *frame = get_oldest_frame(vd, FRAME_QUEUED);
+
+		if(frame == NULL)
+		{
+			__COND_WAIT(&pipe->cond, __PMUTEX);
+			continue;
+		}
+
+		frame->status = FRAME_DECODING;
+		int preview = vd->pipeline_preview;
+		__UNLOCK_MUTEX( __PMUTEX );
+
+		uint64_t lat_ts = latency_stats_start(vd);
+
+		int ret = preview ? decode_v4l2_frame_preview(vd, frame) : decode_v4l2_frame(vd, frame);
+
+		if(ret != E_OK)
+			fprintf(stderr, "V4L2_CORE: Error - Couldn't decode frame\n");
+
+		latency_stats_stop(vd, LATENCY_DECODE, lat_ts);
+
+		__LOCK_MUTEX( __PMUTEX );
+		frame->status = FRAME_DONE;
+		__COND_BCAST(&pipe->cond);
+	}
+	__UNLOCK_MUTEX( __PMUTEX );
+
+	return NULL;
+}
+
+/*
+ * start the decoding pipeline (dequeue thread + decoder threads)
+ * args:
+ *   vd - pointer to video device data
+ *   ndecoders - number of decoder threads
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: error code (0- E_OK)
+ */
+int frame_pipeline_start(v4l2_dev_t *vd, int ndecoders)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	if(vd->pipeline != NULL)
+	{
+		fprintf(stderr, "V4L2_CORE: (pipeline) already running\n");
+		return E_OK;
+	}
+
+	if(ndecoders < 1)
+		ndecoders = 1;
+
+	frame_pipeline_t *pipe = calloc(1, sizeof(frame_pipeline_t));
+	if(pipe == NULL)
+	{
+		fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (frame_pipeline_start): %s\n", strerror(errno));
+		exit(-1);
+	}
+
+	pipe->decoder_threads = calloc(ndecoders, sizeof(__THREAD_TYPE));
+	if(pipe->decoder_threads == NULL)
+	{
+		fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (frame_pipeline_start): %s\n", strerror(errno));
+		exit(-1);
+	}
+
+	pipe->vd = vd;
+	__INIT_COND(&pipe->cond);
+
+	/*one (m)jpeg decoder handle per decoder thread*/
+	if(vd->jpeg_ctx != NULL)
+		jpeg_decoder_reserve(vd->jpeg_ctx, ndecoders);
+
+	__LOCK_MUTEX( __PMUTEX );
+	vd->pipeline = pipe;
+	__UNLOCK_MUTEX( __PMUTEX );
+
+	if(verbosity > 0)
+		printf("V4L2_CORE: (pipeline) starting with %i decoder threads and %i frame slots\n",
+			ndecoders, vd->frame_queue_size);
+
+	int i = 0;
+	for(i = 0; i < ndecoders; ++i)
+	{
+		if(__THREAD_CREATE(&pipe->decoder_threads[i], decoder_loop, (void *) vd))
+		{
+			fprintf(stderr, "V4L2_CORE: (pipeline) couldn't create decoder thread %i\n", i);
+			break;
+		}
+		pipe->ndecoders++;
+	}
+
+	if(pipe->ndecoders > 0 &&
+		!__THREAD_CREATE(&pipe->dequeue_thread, dequeue_loop, (void *) vd))
+		pipe->has_dequeue_thread = 1;
+
+	if(!pipe->has_dequeue_thread)
+	{
+		fprintf(stderr, "V4L2_CORE: (pipeline) couldn't create pipeline threads\n");
+		frame_pipeline_stop(vd);
+		return E_UNKNOWN_ERR;
+	}
+
+	return E_OK;
+}
+
+/*
+ * get the next decoded frame from the pipeline (in capture order)
+ *   the frame must be released with v4l2core_dev_release_frame
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: pointer to decoded frame buffer (NULL on timeout)
+ */
+v4l2_frame_buff_t *frame_pipeline_get_frame(v4l2_dev_t *vd)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	v4l2_frame_buff_t *frame = NULL;
+
+	__LOCK_MUTEX( __PMUTEX );
+	while(vd->pipeline != NULL && !vd->pipeline->quit)
+	{
+		/*
+		 * deliver in capture order: the oldest frame
+		 * in the pipeline must already be decoded
+		 */
+		v4l2_frame_buff_t *oldest = get_oldest_frame(vd, -1);
+		if(oldest != NULL && oldest->status == FRAME_DONE)
+		{
+			oldest->status = FRAME_IN_USE;
+			frame = oldest;
+			break;
+		}
+
+		if(vd->pipeline->wakeup)
+		{
+			vd->pipeline->wakeup = 0;
+			break;
+		}
+
+		if(pipeline_timed_wait(vd, PIPELINE_FRAME_TIMEOUT) == ETIMEDOUT)
+			break;
+	}
+	__UNLOCK_MUTEX( __PMUTEX );
+
+	return frame;
+}
+
+/*
+ * notify the pipeline that a frame was released
+ *   (must be called with the device mutex locked)
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void frame_pipeline_frame_released(v4l2_dev_t *vd)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	if(vd->pipeline != NULL)
+		__COND_BCAST(&vd->pipeline->cond);
+}
+
+/*
+ * wake up the client waiting for a decoded frame
+ *   (must be called with the device mutex locked)
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void frame_pipeline_wakeup(v4l2_dev_t *vd)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	if(vd->pipeline == NULL)
+		return;
+
+	vd->pipeline->wakeup = 1;
+	__COND_BCAST(&vd->pipeline->cond);
+}
+
+/*
+ * stop the decoding pipeline
+ *   joins all pipeline threads and returns the frames
+ *   not yet delivered to the driver
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void frame_pipeline_stop(v4l2_dev_t *vd)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	frame_pipeline_t *pipe = vd->pipeline;
+
+	if(pipe == NULL)
+		return;
+
+	__LOCK_MUTEX( __PMUTEX );
+	pipe->quit = 1;
+	__COND_BCAST(&pipe->cond);
+	__UNLOCK_MUTEX( __PMUTEX );
+
+	if(pipe->has_dequeue_thread)
+		__THREAD_JOIN(pipe->dequeue_thread);
+
+	int i = 0;
+	for(i = 0; i < pipe->ndecoders; ++i)
+		__THREAD_JOIN(pipe->decoder_threads[i]);
+
+	__LOCK_MUTEX( __PMUTEX );
+	vd->pipeline = NULL;
+	__UNLOCK_MUTEX( __PMUTEX );
+
+	/*give back to the driver any frame not delivered to the client*/
+	for(i = 0; i < vd->frame_queue_size; ++i)
+	{
+		if(vd->frame_queue[i].status == FRAME_QUEUED ||
+			vd->frame_queue[i].status == FRAME_DONE)
+			v4l2core_dev_release_frame(vd, &vd->frame_queue[i]);
+	}
+
+	__CLOSE_COND(&pipe->cond);
+	free(pipe->decoder_threads);
+	free(pipe);
+
+	if(verbosity > 0)
+		printf("V4L2_CORE: (pipeline) stopped\n");
+}
@@ -0,0 +1,96 @@
+/*******************************************************************************#
+#           guvcview              http://guvcview.sourceforge.net               #
+#                                                                               #
+#           Paulo Assis <pj.assis@gmail.com>                                    #
+#                                                                               #
+# This program is free software; you can redistribute it and/or modify          #
+# it under the terms of the GNU General Public License as published by          #
+# the Free Software Foundation; either version 2 of the License, or             #
+# (at your option) any later version.                                           #
+#                                                                               #
+# This program is distributed in the hope that it will be useful,               #
+# but WITHOUT ANY WARRANTY; without even the implied warranty of                #
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 #
+# GNU General Public License for more details.                                  #
+#                                                                               #
+# You should have received a copy of the GNU General Public License             #
+# along with this program; if not, write to the Free Software                   #
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA     #
+#                                                                               #
+********************************************************************************/
+
+#ifndef FRAME_PIPELINE_H
+#define FRAME_PIPELINE_H
+
+#include "gviewv4l2core.h"
+#include "v4l2_core.h"
+
+typedef struct _frame_pipeline_t frame_pipeline_t;
+
+/*
+ * start the decoding pipeline (dequeue thread + decoder threads)
+ * args:
+ *   vd - pointer to video device data
+ *   ndecoders - number of decoder threads
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: error code (0- E_OK)
+ */
+int frame_pipeline_start(v4l2_dev_t *vd, int ndecoders);
+
+/*
+ * get the next decoded frame from the pipeline (in capture order)
+ *   the frame must be released with v4l2core_dev_release_frame
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: pointer to decoded frame buffer (NULL on timeout)
+ */
+v4l2_frame_buff_t *frame_pipeline_get_frame(v4l2_dev_t *vd);
+
+/*
+ * notify the pipeline that a frame was released
+ *   (must be called with the device mutex locked)
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void frame_pipeline_frame_released(v4l2_dev_t *vd);
+
+/*
+ * wake up the client waiting for a decoded frame
+ *   (must be called with the device mutex locked)
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void frame_pipeline_wakeup(v4l2_dev_t *vd);
+
+/*
+ * stop the decoding pipeline
+ *   joins all pipeline threads and returns the frames
+ *   not yet delivered to the driver
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void frame_pipeline_stop(v4l2_dev_t *vd);
+
+#endif
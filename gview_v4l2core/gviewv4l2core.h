@@ -102,6 +102,14 @@ __BEGIN_DECLS
  */
 #define IO_MMAP 1
 #define IO_READ 2
+#define IO_USERPTR 3 //driver writes into a page aligned buffer pool owned by the core
+#define IO_REPLAY 4 //frames are read from a replay file (opened as the video device)
+
+/*
+ * Replay flags
+ */
+#define REPLAY_TIMED (1) //replay frames with the recorded timing (else as fast as possible)
+#define REPLAY_LOOP (2) //restart from the first frame at the end of file
 
 /*
  * Frame status
@@ -109,6 +117,18 @@ __BEGIN_DECLS
 #define FRAME_READY (0)
 #define FRAME_DECODING (1)
 #define FRAME_DONE (2)
+#define FRAME_QUEUED (3) //captured, waiting for a decoder thread
+#define FRAME_IN_USE (4) //decoded and delivered to the client
+
+/*
+ * Latency stages (capture -> decode -> render path)
+ */
+#define LATENCY_DQBUF     (0) //frame wait and VIDIOC_DQBUF
+#define LATENCY_DECODE    (1) //frame decoding
+#define LATENCY_AUTOFOCUS (2) //software autofocus
+#define LATENCY_RENDER    (3) //frame render (recorded by the client)
+#define LATENCY_QBUF      (4) //frame release and VIDIOC_QBUF
+#define LATENCY_STAGES    (5)
 
 /*
  * software autofocus sort method
@@ -130,11 +150,26 @@ __BEGIN_DECLS
 #define IMG_FMT_PNG     (2)
 #define IMG_FMT_BMP     (3)
 
+/*
+ * yuv colorimetry (yuv to rgb conversion of image snapshots)
+ *   auto - from the driver format (uncompressed yuv) or bt601 full range
+ */
+#define YUV_MATRIX_AUTO   (0)
+#define YUV_MATRIX_BT601  (1)
+#define YUV_MATRIX_BT709  (2)
+#define YUV_MATRIX_BT2020 (3)
+
+#define YUV_RANGE_AUTO    (0)
+#define YUV_RANGE_FULL    (1)
+#define YUV_RANGE_LIMITED (2)
 
 /*
  * buffer number (for driver mmap ops)
+ *   default, min and max number of driver buffers
  */
 #define NB_BUFFER 4
+#define NB_BUFFER_MIN 2
+#define NB_BUFFER_MAX 32
 
 /*jpeg header def*/
 #define HEADERFRAME1 0xaf
@@ -226,16 +261,55 @@ typedef struct _v4l2_frame_buff_t
 	int status; //frame status {FRAME_DECODING; FRAME_DONE; FRAME_READY}
 	
 	uint8_t *raw_frame; // pointer to raw frame
+	int dmabuf_fd; // dma-buf fd exported for the raw frame buffer (-1 if not available, see v4l2core_dev_get_frame_dmabuf_fd)
 	size_t raw_frame_size; // raw frame size (bytes)
 	size_t raw_frame_max_size; //maximum size for raw frame (bytes)
 	uint8_t *yuv_frame; // pointer to decoded yuv frame
+	uint16_t *luma16_frame; // 16 bit luma (Y10B/Y16 in 16 bit luma mode): yuv_frame is the 8 bit display copy
+	int luma16_bits; // significant bits in luma16_frame (10 or 16; 0 - not decoded)
+	int yuv_scale; // yuv_frame scale denominator (>1 - decoded at the preview size by the pipeline)
 	
-	uint64_t timestamp; // captured frame timestamp
+	uint64_t timestamp; // captured frame timestamp (driver monotonic timestamp if available)
+	uint64_t frame_index; // captured frame index (sequential)
+	uint32_t sequence; // driver frame sequence number
 	
 	uint8_t *tmp_buffer; //temporary buffer used in decoding
 	size_t tmp_buffer_max_size; //maximum size for temp buffer (bytes)
 } v4l2_frame_buff_t;
 
+/*
+ * video stream statistics (reset on stream start, kept across frame rate
+ *   and buffer count changes)
+ *   times in nanoseconds
+ */
+typedef struct _v4l2_stream_stats_t
+{
+	uint64_t frames; // frames dequeued
+	uint64_t dropped; // frames dropped by the driver (sequence gaps)
+	uint64_t corrupt; // damaged frames dropped before decoding
+	uint64_t skipped; // stale frames requeued undecoded (low latency mode)
+	int driver_timestamps; // 1 - timestamps from driver (monotonic); 0 - dequeue time
+	uint64_t frame_interval; // smoothed interval between frames
+	uint64_t jitter; // smoothed inter-frame jitter (interval variation)
+	uint64_t max_jitter; // maximum inter-frame jitter
+	uint64_t dequeue_delay; // smoothed capture to dequeue delay (driver timestamps only)
+	uint64_t max_dequeue_delay; // maximum capture to dequeue delay (driver timestamps only)
+} v4l2_stream_stats_t;
+
+/*
+ * latency summary for a stage (times in nanoseconds)
+ */
+typedef struct _v4l2_latency_stats_t
+{
+	uint64_t count; // number of recorded values
+	uint64_t min; // minimum latency
+	uint64_t mean; // mean latency
+	uint64_t p50; // median latency
+	uint64_t p99; // 99th percentile latency
+	uint64_t p999; // 99.9th percentile latency
+	uint64_t max; // maximum latency
+} v4l2_latency_stats_t;
+
 /*
  * v4l2 devices list data
  */
@@ -248,6 +322,11 @@ typedef struct _v4l2_device_list_t
     int num_devices;                    // number of available v4l2 devices
 } v4l2_device_list;
 
+/*
+ * video device handle (opaque)
+ */
+typedef struct _v4l2_dev_t *v4l2core_dev_handle;
+
 
 /*
  * ioctl with a number of retries in the case of I/O failure
@@ -275,6 +354,20 @@ int xioctl(int fd, int IOCTL_X, void *arg);
  */
 void v4l2core_set_verbosity(int level);
 
+/*
+ * set the frame queue size (number of frames that can be in flight)
+ *   must be called before opening the device, and should be bigger
+ *   than 1 for the decoding pipeline to have any effect
+ * args:
+ *   size - frame queue size (def = 1)
+ *
+ * asserts:
+ *   none
+ *
+ * returns - void
+ */
+void v4l2core_set_frame_queue_size(int size);
+
 /*
  * define fps values
  * args:
@@ -432,10 +525,139 @@ int v4l2core_fourcc_2_v4l2_pixelformat(const char *fourcc);
  */
 double v4l2core_get_realfps();
 
+/*
+ * get the video stream statistics
+ * args:
+ *   stats - pointer to stats struct to fill
+ *
+ * asserts:
+ *   stats is not null
+ *
+ * returns: none
+ */
+void v4l2core_get_stream_stats(v4l2_stream_stats_t *stats);
+
+/*
+ * enable/disable the per stage latency histograms
+ * args:
+ *   enable - 1 enable; 0 disable
+ *   dump_interval - interval in seconds for printing the
+ *      latency summary to stdout (0 - don't print)
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+void v4l2core_set_latency_stats(int enable, int dump_interval);
+
+/*
+ * record a latency value for a stage measured by the client
+ *   (e.g. LATENCY_RENDER)
+ * args:
+ *   stage - latency stage (LATENCY_DQBUF, ...)
+ *   latency - latency in ns
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+void v4l2core_record_latency(int stage, uint64_t latency);
+
+/*
+ * get the latency summary for a stage
+ * args:
+ *   stage - latency stage (LATENCY_DQBUF, ...)
+ *   stats - pointer to stats struct to fill
+ *
+ * asserts:
+ *   stats is not null
+ *
+ * returns: error code (E_NO_DATA if latency stats were never enabled)
+ */
+int v4l2core_get_latency_stats(int stage, v4l2_latency_stats_t *stats);
+
+/*
+ * clear the latency histograms
+ * args:
+ *   none
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+void v4l2core_reset_latency_stats();
+
+/*
+ * print the latency summary of all stages to stdout
+ * args:
+ *   none
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+void v4l2core_print_latency_stats();
+
+/*
+ * set the replay flags (IO_REPLAY only)
+ * args:
+ *   flags - replay flags (REPLAY_TIMED | REPLAY_LOOP)
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+void v4l2core_set_replay_flags(int flags);
+
+/*
+ * check for the end of the replay (IO_REPLAY only)
+ *   get_frame returns NULL from then on, unless
+ *   the replay is looping (REPLAY_LOOP)
+ * args:
+ *   none
+ *
+ * asserts:
+ *   none
+ *
+ * returns: 1 at end of replay file, 0 otherwise
+ */
+int v4l2core_is_replay_eof();
+
+/*
+ * start recording the raw frames to a replay file
+ *   the file can later be opened as the video device
+ * args:
+ *   filename - replay file name
+ *
+ * asserts:
+ *   filename is not null
+ *
+ * returns: error code (0- E_OK)
+ */
+int v4l2core_start_replay_record(const char *filename);
+
+/*
+ * stop recording raw frames
+ * args:
+ *   none
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+void v4l2core_stop_replay_record();
+
 /*
  * Set v4l2 capture method
  * args:
- *   method - capture method (IO_READ or IO_MMAP)
+ *   method - capture method (IO_READ, IO_MMAP or IO_USERPTR)
+ *      (IO_REPLAY is set when a replay file is opened)
  *
  * asserts:
  *   none
@@ -771,6 +993,18 @@ v4l2_frame_buff_t *v4l2core_get_frame();
  */
 int v4l2core_release_frame(v4l2_frame_buff_t *frame);
 
+/*
+ * get the dma-buf fd exported for the frame raw buffer
+ * args:
+ *   frame - pointer to frame buffer (from v4l2core_get_frame)
+ *
+ * asserts:
+ *   none
+ *
+ * returns: dma-buf fd or -1 if not available
+ */
+int v4l2core_get_frame_dmabuf_fd(v4l2_frame_buff_t *frame);
+
 /*
  * gets the next video frame and decodes it
  * args:
@@ -780,6 +1014,57 @@ int v4l2core_release_frame(v4l2_frame_buff_t *frame);
  */
 v4l2_frame_buff_t *v4l2core_get_decoded_frame();
 
+/*
+ * decodes a frame (from v4l2core_get_frame)
+ *   if planes is set the frame is decoded straight into them
+ *   (e.g. a locked render buffer) honouring the plane pitches,
+ *   saving a full frame copy; frame->yuv_frame may then not
+ *   hold the decoded frame
+ * args:
+ *   frame - pointer to frame buffer
+ *   planes - output planes (yu12: y, u, v; yuyv: a single plane)
+ *      or null to decode to frame->yuv_frame
+ *   pitches - output plane pitches
+ *
+ * asserts:
+ *   frame is not null
+ *
+ * returns: error code (0- E_OK)
+ */
+int v4l2core_decode_frame(v4l2_frame_buff_t *frame, uint8_t **planes, int *pitches);
+
+/*
+ * decodes a frame (from v4l2core_get_frame) to frame->yuv_frame
+ *   at the preview size (see v4l2core_set_preview_scale):
+ *   frame->yuv_scale is set to the scale used
+ * args:
+ *   frame - pointer to frame buffer
+ *
+ * asserts:
+ *   frame is not null
+ *
+ * returns: error code (0- E_OK)
+ */
+int v4l2core_decode_preview_frame(v4l2_frame_buff_t *frame);
+
+/*
+ * copies a decoded frame (frame->yuv_frame) to the given planes
+ *   honouring the plane pitches and decimated to the preview size
+ *   (e.g. a locked render buffer) without decoding it again
+ * args:
+ *   frame - pointer to decoded frame buffer
+ *   planes - output planes (yu12: y, u, v; yuyv: a single plane)
+ *   pitches - output plane pitches
+ *
+ * asserts:
+ *   frame is not null
+ *   planes is not null
+ *   pitches is not null
+ *
+ * returns: error code (0- E_OK)
+ */
+int v4l2core_copy_frame(v4l2_frame_buff_t *frame, uint8_t **planes, int *pitches);
+
 /*
  * clean v4l2 buffers
  * args:
@@ -866,196 +1151,1403 @@ int v4l2core_request_stop_stream();
 int v4l2core_stop_stream();
 
 /*
- *  ######### CONTROLS ##########
+ * wakes up any thread waiting for a frame
+ *   (e.g. after a stop or format change request)
+ * args:
+ *   none
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
  */
+void v4l2core_wakeup();
 
 /*
- * return the control associated to id from device list
+ * sets a periodic timer on the device event loop
+ *   the frame wait returns (without a frame) on every expiration
  * args:
- *   id - control id
+ *   interval - timer interval in ns (0 disables the timer)
  *
  * asserts:
  *   none
  *
- * returns: pointer to v4l2_control if succeded or null otherwise
+ * returns: error code (0- E_OK)
  */
-v4l2_ctrl_t* v4l2core_get_control_by_id(int id);
+int v4l2core_set_timer(uint64_t interval);
 
 /*
- * sets the value of control id in device
+ * gets (and clears) the number of timer expirations
  * args:
- *  id - control id 
+ *   none
  *
  * asserts:
  *   none
  *
- * returns: ioctl result
+ * returns: number of timer expirations since last call
  */
-int v4l2core_set_control_value_by_id(int id);
+uint64_t v4l2core_get_timer_expirations();
 
 /*
- * updates the value for control id from the device
- * also updates control flags
+ * sets the number of driver buffers
+ *   if the stream is running the change is applied
+ *   as soon as no frame holds a driver buffer
  * args:
- *   id - control id
+ *   count - number of buffers [NB_BUFFER_MIN - NB_BUFFER_MAX]
  *
  * asserts:
  *   none
  *
- * returns: ioctl result
+ * returns: none
  */
-int v4l2core_get_control_value_by_id(int id);
+void v4l2core_set_buffer_count(int count);
 
 /*
- * goes trough the control list and sets values in device to default
+ * gets the number of driver buffers
  * args:
  *   none
  *
  * asserts:
  *   none
  *
- * returns: void
+ * returns: number of driver buffers
  */
-void v4l2core_set_control_defaults();
+int v4l2core_get_buffer_count();
 
 /*
- * set autofocus sort method
+ * sets the adaptive buffer count range:
+ *   the number of buffers grows when the driver drops frames
+ *   and shrinks back after a sustained period without drops
  * args:
- *    method - sort method
+ *   min_count - minimum number of buffers
+ *   max_count - maximum number of buffers (0 - disable)
  *
  * asserts:
- *    none
+ *   none
  *
  * returns: none
  */
-void v4l2core_soft_autofocus_set_sort(int method);
+void v4l2core_set_adaptive_buffers(int min_count, int max_count);
 
 /*
- * initiate software autofocus
+ * sets the low latency (latest frame wins) mode:
+ *   all the ready driver buffers are dequeued after each wait
+ *   and only the newest frame is returned, the stale ones are
+ *   requeued without decoding (counted in the stream stats)
  * args:
- *    none
+ *   enable - 1 to enable; 0 to disable
  *
  * asserts:
- *    none
+ *   none
  *
- * returns: error code (0 - E_OK)
+ * returns: none
  */
-int v4l2core_soft_autofocus_init ();
+void v4l2core_set_low_latency(int enable);
 
 /*
- * run the software autofocus
+ * starts the decoding pipeline for the video stream:
+ *   a dequeue thread and ndecoders decoder threads
  * args:
- *    frame - pointer to frame buffer
+ *   ndecoders - number of decoder threads
  *
  * asserts:
- *    none
+ *   none
  *
- * returns: 1 - running  0- focused
- * 	(only matters for non-continue focus)
+ * returns: error code (0- E_OK)
  */
-int v4l2core_soft_autofocus_run(v4l2_frame_buff_t *frame);
+int v4l2core_start_pipeline(int ndecoders);
 
 /*
- * sets a focus loop while autofocus is on
+ * stops the decoding pipeline
  * args:
- *    none
+ *   none
  *
  * asserts:
- *    focus_ctx is not null
+ *   none
  *
  * returns: none
  */
-void v4l2core_soft_autofocus_set_focus();
+void v4l2core_stop_pipeline();
 
 /*
- * close and clean software autofocus
+ * set the number of (m)jpeg band decoding threads
+ *   frames with restart markers are split in bands of MCU rows
+ *   decoded in parallel (lower latency for a single large frame)
  * args:
+ *   nthreads - number of band threads (0 - disabled)
+ *
+ * asserts:
  *   none
  *
+ * returns: none
+ */
+void v4l2core_set_jpeg_band_threads(int nthreads);
+
+/*
+ * set the number of raw bayer stripe decoding threads
+ *   bayer frames are split in stripes of rows decoded in parallel
+ * args:
+ *   nthreads - number of stripe threads (0 - disabled)
+ *
  * asserts:
  *   none
  *
  * returns: none
  */
-void v4l2core_soft_autofocus_close();
+void v4l2core_set_bayer_threads(int nthreads);
 
 /*
- * ########### H264 controls ###########
+ * set the number of raw frame conversion band threads
+ *   uncompressed frames are converted in bands of rows in parallel
+ * args:
+ *   nthreads - number of band threads (0 - disabled)
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
  */
+void v4l2core_set_convert_threads(int nthreads);
 
 /*
- * get lenght of xu control defined by unit id and selector
+ * set the yuv colorimetry used for rgb image snapshots
  * args:
- *   unit - unit id of xu control
- *   selector - selector for control
+ *   matrix - YUV_MATRIX_xxx (YUV_MATRIX_AUTO - from the format)
+ *   range - YUV_RANGE_xxx (YUV_RANGE_AUTO - from the format)
  *
  * asserts:
  *   none
  *
- * returns: length of xu control
+ * returns: none
  */
-uint16_t v4l2core_get_length_xu_control(uint8_t unit, uint8_t selector);
+void v4l2core_set_yuv_colorimetry(int matrix, int range);
 
 /*
- * get uvc info for xu control defined by unit id and selector
+ * set the 16 bit luma mode (Y10B and Y16 formats)
  * args:
- *   unit - unit id of xu control
- *   selector - selector for control
+ *   enable - 1: keep 16 bit luma in frame->luma16_frame; 0: 8 bit only
  *
  * asserts:
  *   none
  *
- * returns: info of xu control
+ * returns: none
  */
-uint8_t v4l2core_get_info_xu_control(uint8_t unit, uint8_t selector);
+void v4l2core_set_luma16_mode(int enable);
 
 /*
- * runs a query on xu control defined by unit id and selector
+ * set the preview scale denominator
+ *   (m)jpeg frames decoded into client planes (v4l2core_decode_frame)
+ *   are scaled down in the idct, for a cheaper preview
  * args:
- *   unit - unit id of xu control
- *   selector - selector for control
- *   query - query type
- *   data - pointer to query data
+ *   scale - preview scale denominator (1, 2, 4 or 8)
  *
  * asserts:
  *   none
  *
- * returns: 0 if query succeded or errno otherwise
+ * returns: none
  */
-int v4l2core_query_xu_control(uint8_t unit, uint8_t selector, uint8_t query, void *data);
+void v4l2core_set_preview_scale(int scale);
 
 /*
- *  ########### FILE IO ###############
+ * set the pipeline preview mode
+ *   the decoding pipeline decodes (m)jpeg frames at the preview
+ *   scale (frame->yuv_scale), for clients that only display them;
+ *   full size frames are decoded again with v4l2core_decode_frame
+ * args:
+ *   enable - 1 enable, 0 disable (default)
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
  */
+void v4l2core_set_pipeline_preview(int enable);
+
 /*
- * save data to file
+ * get the preview width
  * args:
- *   filename - string with filename
- *   data - pointer to data
- *   size - data size in bytes = sizeof(uint8_t)
+ *   none
  *
  * asserts:
  *   none
  *
- * returns: error code
+ * returns: preview width
  */
-int v4l2core_save_data_to_file(const char *filename, uint8_t *data, int size);
+int v4l2core_get_preview_width();
 
 /*
- * save the current frame to file
+ * get the preview height
  * args:
- *    frame - pointer to frame buffer
- *    filename - output file name
- *    format - image type
- *           (IMG_FMT_RAW, IMG_FMT_JPG, IMG_FMT_PNG, IMG_FMT_BMP)
+ *   none
  *
  * asserts:
- *    none
+ *   none
  *
- * returns: error code
+ * returns: preview height
+ */
+int v4l2core_get_preview_height();
+
+/*
+ *  ######### CONTROLS ##########
+ */
+
+/*
+ * return the control associated to id from device list
+ * args:
+ *   id - control id
+ *
+ * asserts:
+ *   none
+ *
+ * returns: pointer to v4l2_control if succeded or null otherwise
+ */
+v4l2_ctrl_t* v4l2core_get_control_by_id(int id);
+
+/*
+ * sets the value of control id in device
+ * args:
+ *  id - control id 
+ *
+ * asserts:
+ *   none
+ *
+ * returns: ioctl result
+ */
+int v4l2core_set_control_value_by_id(int id);
+
+/*
+ * updates the value for control id from the device
+ * also updates control flags
+ * args:
+ *   id - control id
+ *
+ * asserts:
+ *   none
+ *
+ * returns: ioctl result
+ */
+int v4l2core_get_control_value_by_id(int id);
+
+/*
+ * goes trough the control list and sets values in device to default
+ * args:
+ *   none
+ *
+ * asserts:
+ *   none
+ *
+ * returns: void
+ */
+void v4l2core_set_control_defaults();
+
+/*
+ * set autofocus sort method
+ * args:
+ *    method - sort method
+ *
+ * asserts:
+ *    none
+ *
+ * returns: none
+ */
+void v4l2core_soft_autofocus_set_sort(int method);
+
+/*
+ * initiate software autofocus
+ * args:
+ *    none
+ *
+ * asserts:
+ *    none
+ *
+ * returns: error code (0 - E_OK)
+ */
+int v4l2core_soft_autofocus_init ();
+
+/*
+ * run the software autofocus
+ * args:
+ *    frame - pointer to frame buffer
+ *
+ * asserts:
+ *    none
+ *
+ * returns: 1 - running  0- focused
+ * 	(only matters for non-continue focus)
+ */
+int v4l2core_soft_autofocus_run(v4l2_frame_buff_t *frame);
+
+/*
+ * sets a focus loop while autofocus is on
+ * args:
+ *    none
+ *
+ * asserts:
+ *    focus_ctx is not null
+ *
+ * returns: none
+ */
+void v4l2core_soft_autofocus_set_focus();
+
+/*
+ * close and clean software autofocus
+ * args:
+ *   none
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+void v4l2core_soft_autofocus_close();
+
+/*
+ * ########### H264 controls ###########
+ */
+
+/*
+ * get lenght of xu control defined by unit id and selector
+ * args:
+ *   unit - unit id of xu control
+ *   selector - selector for control
+ *
+ * asserts:
+ *   none
+ *
+ * returns: length of xu control
+ */
+uint16_t v4l2core_get_length_xu_control(uint8_t unit, uint8_t selector);
+
+/*
+ * get uvc info for xu control defined by unit id and selector
+ * args:
+ *   unit - unit id of xu control
+ *   selector - selector for control
+ *
+ * asserts:
+ *   none
+ *
+ * returns: info of xu control
+ */
+uint8_t v4l2core_get_info_xu_control(uint8_t unit, uint8_t selector);
+
+/*
+ * runs a query on xu control defined by unit id and selector
+ * args:
+ *   unit - unit id of xu control
+ *   selector - selector for control
+ *   query - query type
+ *   data - pointer to query data
+ *
+ * asserts:
+ *   none
+ *
+ * returns: 0 if query succeded or errno otherwise
+ */
+int v4l2core_query_xu_control(uint8_t unit, uint8_t selector, uint8_t query, void *data);
+
+/*
+ *  ######### MULTIPLE DEVICE API ##########
+ *  each device opened with v4l2core_dev_open has its own
+ *  frame queue, decoder, fps counters and lock, so several
+ *  devices can stream concurrently (one capture thread per device)
+ */
+
+/*
+ * Open a video device and initiate its data with default values
+ * args:
+ *   device - device name (e.g: "/dev/video0")
+ *
+ * asserts:
+ *   device is not null
+ *
+ * returns: handle to the new device data (NULL on error)
+ */
+v4l2core_dev_handle v4l2core_dev_open(const char *device);
+
+/*
+ * cleans video device data and allocations
+ * args:
+ *   vd - video device handle
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: void
+ */
+void v4l2core_dev_close(v4l2core_dev_handle vd);
+
+/*
+ * get the default device handle (the one used by the single device api)
+ * args:
+ *   none
+ *
+ * asserts:
+ *   none
+ *
+ * returns: default device handle (NULL if v4l2core_init_dev was not called)
+ */
+v4l2core_dev_handle v4l2core_get_default_dev();
+
+/*
+ * Set v4l2 capture method
+ * args:
+ *   vd - video device handle
+ *   method - capture method (IO_READ, IO_MMAP or IO_USERPTR)
+ *      (IO_REPLAY is set when a replay file is opened)
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: VIDIOC_STREAMON ioctl result (E_OK or E_STREAMON_ERR)
+*/
+void v4l2core_dev_set_capture_method(v4l2core_dev_handle vd, int method);
+
+/*
+ * define fps values
+ * args:
+ *   vd - video device handle
+ *   num - fps numerator
+ *   denom - fps denominator
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns - void
+ */
+void v4l2core_dev_define_fps(v4l2core_dev_handle vd, int num, int denom);
+
+/*
+ * get requested fps numerator
+ * args:
+ *   vd - video device handle
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns - requested fps numerator
+ */
+int v4l2core_dev_get_fps_num(v4l2core_dev_handle vd);
+
+/*
+ * get requested fps denominator
+ * args:
+ *   vd - video device handle
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns - requested fps denominator
+ */
+int v4l2core_dev_get_fps_denom(v4l2core_dev_handle vd);
+
+/*
+ * gets video device defined frame rate (not real - consider it a maximum value)
+ * args:
+ *   vd - video device handle
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: VIDIOC_G_PARM ioctl result value
+ * (sets vd->fps_denom and vd->fps_num to device value)
+ */
+int v4l2core_dev_get_framerate(v4l2core_dev_handle vd);
+
+/*
+ * request a fps update - this locks the mutex
+ *   (can't be called while the mutex is being locked)
+ * args:
+ *   vd - video device handle
+ *
+ * asserts:
+ *    vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_request_framerate_update(v4l2core_dev_handle vd);
+
+/*
+ * get real fps
+ * args:
+ *   vd - video device handle
+ *
+ * asserts:
+ *   none
+ *
+ * returns: double with real fps value
+ */
+double v4l2core_dev_get_realfps(v4l2core_dev_handle vd);
+
+/*
+ * get the video stream statistics
+ * args:
+ *   vd - video device handle
+ *   stats - pointer to stats struct to fill
+ *
+ * asserts:
+ *   vd is not null
+ *   stats is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_get_stream_stats(v4l2core_dev_handle vd, v4l2_stream_stats_t *stats);
+
+/*
+ * enable/disable the per stage latency histograms
+ *   recording overhead is a flag check while disabled
+ * args:
+ *   vd - video device handle
+ *   enable - 1 enable; 0 disable
+ *   dump_interval - interval in seconds for printing the
+ *      latency summary to stdout (0 - don't print)
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_set_latency_stats(v4l2core_dev_handle vd, int enable, int dump_interval);
+
+/*
+ * record a latency value for a stage measured by the client
+ *   (e.g. LATENCY_RENDER)
+ * args:
+ *   vd - video device handle
+ *   stage - latency stage (LATENCY_DQBUF, ...)
+ *   latency - latency in ns
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_record_latency(v4l2core_dev_handle vd, int stage, uint64_t latency);
+
+/*
+ * get the latency summary for a stage
+ * args:
+ *   vd - video device handle
+ *   stage - latency stage (LATENCY_DQBUF, ...)
+ *   stats - pointer to stats struct to fill
+ *
+ * asserts:
+ *   vd is not null
+ *   stats is not null
+ *
+ * returns: error code (E_NO_DATA if latency stats were never enabled)
+ */
+int v4l2core_dev_get_latency_stats(v4l2core_dev_handle vd, int stage, v4l2_latency_stats_t *stats);
+
+/*
+ * clear the latency histograms
+ * args:
+ *   vd - video device handle
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_reset_latency_stats(v4l2core_dev_handle vd);
+
+/*
+ * print the latency summary of all stages to stdout
+ * args:
+ *   vd - video device handle
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_print_latency_stats(v4l2core_dev_handle vd);
+
+/*
+ * set the replay flags (IO_REPLAY only)
+ * args:
+ *   vd - video device handle
+ *   flags - replay flags (REPLAY_TIMED | REPLAY_LOOP)
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_set_replay_flags(v4l2core_dev_handle vd, int flags);
+
+/*
+ * check for the end of the replay (IO_REPLAY only)
+ *   v4l2core_dev_get_frame returns NULL from then on, unless
+ *   the replay is looping (REPLAY_LOOP): clients should
+ *   stop capturing
+ * args:
+ *   vd - video device handle
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: 1 at end of replay file, 0 otherwise
+ */
+int v4l2core_dev_is_replay_eof(v4l2core_dev_handle vd);
+
+/*
+ * start recording the raw frames to a replay file
+ *   the file can later be opened as the video device
+ * args:
+ *   vd - video device handle
+ *   filename - replay file name
+ *
+ * asserts:
+ *   vd is not null
+ *   filename is not null
+ *
+ * returns: error code (0- E_OK)
+ */
+int v4l2core_dev_start_replay_record(v4l2core_dev_handle vd, const char *filename);
+
+/*
+ * stop recording raw frames
+ * args:
+ *   vd - video device handle
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_stop_replay_record(v4l2core_dev_handle vd);
+
+/*
+ * get videodevice string
+ * args:
+ *   vd - video device handle
+ *
+ * asserts:
+ *    none
+ *
+ * return: videodevice string
+ */
+const char *v4l2core_dev_get_videodevice(v4l2core_dev_handle vd);
+
+/*
+ * get device available number of formats
+ * args:
+ *   vd - video device handle
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns - number of formats for device
+ */
+int v4l2core_dev_get_number_formats(v4l2core_dev_handle vd);
+
+/*
+ * get stream frame format list for device
+ * args:
+ *   vd - video device handle
+ *
+ * asserts:
+ *    vd is not null
+ *
+ * return: pointer to first format in the list
+ */
+v4l2_stream_formats_t *v4l2core_dev_get_formats_list(v4l2core_dev_handle vd);
+
+/* get frame format index from format list
+ * args:
+ *   vd - video device handle
+ *   format - v4l2 pixel format
+ *
+ * asserts:
+ *   vd is not null
+ *   vd->list_stream_formats is not null
+ *
+ * returns: format list index or -1 if not available
+ */
+int v4l2core_dev_get_frame_format_index(v4l2core_dev_handle vd, int format);
+
+/* get resolution index for format index from format list
+ * args:
+ *   vd - video device handle
+ *   format - format index from format list
+ *   width - requested width
+ *   height - requested height
+ *
+ * asserts:
+ *   vd is not null
+ *   vd->list_stream_formats is not null
+ *
+ * returns: resolution list index for format index or -1 if not available
+ */
+int v4l2core_dev_get_format_resolution_index(v4l2core_dev_handle vd, int format, int width, int height);
+
+/*
+ * prepare a valid format (first in the format list)
+ * args:
+ *   vd - video device handle
+ *
+ * asserts:
+ *    vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_prepare_valid_format(v4l2core_dev_handle vd);
+
+/*
+ * prepare new format
+ * args:
+ *   vd - video device handle
+ *   new_format - new format
+ *
+ * asserts:
+ *    vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_prepare_new_format(v4l2core_dev_handle vd, int new_format);
+
+/*
+ * prepare valid resolution (first in the resolution list for the format)
+ * args:
+ *   vd - video device handle
+ *
+ * asserts:
+ *    vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_prepare_valid_resolution(v4l2core_dev_handle vd);
+
+/*
+ * prepare new resolution
+ * args:
+ *   vd - video device handle
+ *   new_width - new width
+ *   new_height - new height
+ *
+ * asserts:
+ *    vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_prepare_new_resolution(v4l2core_dev_handle vd, int new_width, int new_height);
+
+/*
+ * update the current format (pixelformat, width and height)
+ * args:
+ *   vd - video device handle
+ *
+ * asserts:
+ *    vd is not null
+ *
+ * returns:
+ *    error code
+ */
+int v4l2core_dev_update_current_format(v4l2core_dev_handle vd);
+
+/*
+ * get requested frame format
+ * args:
+ *   vd - video device handle
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: requested frame format
+ */
+int v4l2core_dev_get_requested_frame_format(v4l2core_dev_handle vd);
+
+/*
+ * get frame width
+ * args:
+ *   vd - video device handle
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: frame width
+ */
+int v4l2core_dev_get_frame_width(v4l2core_dev_handle vd);
+
+/*
+ * get frame height
+ * args:
+ *   vd - video device handle
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: frame height
+ */
+int v4l2core_dev_get_frame_height(v4l2core_dev_handle vd);
+
+/*
+ * Start video stream
+ * args:
+ *   vd - video device handle
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: VIDIOC_STREAMON ioctl result (E_OK or E_STREAMON_ERR)
+*/
+int v4l2core_dev_start_stream(v4l2core_dev_handle vd);
+
+/*
+ * request video stream to stop
+ * args:
+ *   vd - video device handle
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: error code (0 -OK)
+*/
+int v4l2core_dev_request_stop_stream(v4l2core_dev_handle vd);
+
+/*
+ * Stops the video stream
+ * args:
+ *   vd - video device handle
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: VIDIOC_STREAMON ioctl result (E_OK)
+*/
+int v4l2core_dev_stop_stream(v4l2core_dev_handle vd);
+
+/*
+ * wakes up any thread waiting for a frame on the device
+ *   (e.g. after a stop or format change request)
+ * args:
+ *   vd - video device handle
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_wakeup(v4l2core_dev_handle vd);
+
+/*
+ * sets a periodic timer on the device event loop
+ *   the frame wait returns (without a frame) on every expiration
+ * args:
+ *   vd - video device handle
+ *   interval - timer interval in ns (0 disables the timer)
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: error code (0- E_OK)
+ */
+int v4l2core_dev_set_timer(v4l2core_dev_handle vd, uint64_t interval);
+
+/*
+ * gets (and clears) the number of timer expirations
+ * args:
+ *   vd - video device handle
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: number of timer expirations since last call
+ */
+uint64_t v4l2core_dev_get_timer_expirations(v4l2core_dev_handle vd);
+
+/*
+ * sets the number of driver buffers
+ *   if the stream is running the change is applied
+ *   as soon as no frame holds a driver buffer
+ * args:
+ *   vd - video device handle
+ *   count - number of buffers [NB_BUFFER_MIN - NB_BUFFER_MAX]
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_set_buffer_count(v4l2core_dev_handle vd, int count);
+
+/*
+ * gets the number of driver buffers
+ * args:
+ *   vd - video device handle
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: number of driver buffers
+ */
+int v4l2core_dev_get_buffer_count(v4l2core_dev_handle vd);
+
+/*
+ * sets the adaptive buffer count range
+ * args:
+ *   vd - video device handle
+ *   min_count - minimum number of buffers
+ *   max_count - maximum number of buffers (0 - disable)
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_set_adaptive_buffers(v4l2core_dev_handle vd, int min_count, int max_count);
+
+/*
+ * sets the low latency (latest frame wins) mode:
+ *   all the ready driver buffers are dequeued after each wait
+ *   and only the newest frame is returned, the stale ones are
+ *   requeued without decoding (counted in the stream stats);
+ *   only used with streaming i/o (IO_MMAP or IO_USERPTR)
+ * args:
+ *   vd - video device handle
+ *   enable - 1 to enable; 0 to disable
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_set_low_latency(v4l2core_dev_handle vd, int enable);
+
+/*
+ * gets the next video frame (must be released after processing)
+ *   damaged compressed frames are dropped (counted in stream stats)
+ * args:
+ *   vd - video device handle
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: pointer frame buffer (NULL on error)
+ */
+v4l2_frame_buff_t *v4l2core_dev_get_frame(v4l2core_dev_handle vd);
+
+/*
+ * releases the video frame (so that it can be reused by the driver)
+ * args:
+ *   vd - video device handle
+ *   frame - pointer to decoded frame buffer
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: error code (E_OK)
+ */
+int v4l2core_dev_release_frame(v4l2core_dev_handle vd, v4l2_frame_buff_t *frame);
+
+/*
+ * get the dma-buf fd exported for the frame raw buffer
+ *   (mmap capture method only): other stages or processes
+ *   (recording, shared memory fan-out) can map or import the
+ *   driver buffer without a copy; the fd is owned by the device
+ *   and closed when the driver buffers are unmapped (stream off,
+ *   fps or buffer count change), dup() it to keep it longer;
+ *   the buffer content is only valid until the frame is released
+ * args:
+ *   vd - video device handle
+ *   frame - pointer to frame buffer (from v4l2core_dev_get_frame)
+ *
+ * asserts:
+ *   vd is not null
+ *   frame is not null
+ *
+ * returns: dma-buf fd or -1 if not available
+ */
+int v4l2core_dev_get_frame_dmabuf_fd(v4l2core_dev_handle vd, v4l2_frame_buff_t *frame);
+
+/*
+ * gets the next video frame and decodes it
+ *   if the decoding pipeline is running the next decoded
+ *   frame (in capture order) is taken from the pipeline
+ * args:
+ *   vd - video device handle
+ *
+ * returns: pointer to decoded frame buffer ( NULL on error)
+ */
+v4l2_frame_buff_t *v4l2core_dev_get_decoded_frame(v4l2core_dev_handle vd);
+
+/*
+ * decodes a frame (from v4l2core_dev_get_frame)
+ *   if planes is set the frame is decoded straight into them
+ *   (e.g. a locked render buffer) honouring the plane pitches,
+ *   saving a full frame copy; frame->yuv_frame may then not
+ *   hold the decoded frame
+ * args:
+ *   vd - video device handle
+ *   frame - pointer to frame buffer
+ *   planes - output planes (yu12: y, u, v; yuyv: a single plane)
+ *      or null to decode to frame->yuv_frame
+ *   pitches - output plane pitches
+ *
+ * asserts:
+ *   vd is not null
+ *   frame is not null
+ *
+ * returns: error code (0- E_OK)
+ */
+int v4l2core_dev_decode_frame(v4l2core_dev_handle vd, v4l2_frame_buff_t *frame, uint8_t **planes, int *pitches);
+
+/*
+ * decodes a frame (from v4l2core_dev_get_frame) to frame->yuv_frame
+ *   at the preview size (see v4l2core_dev_set_preview_scale):
+ *   frame->yuv_scale is set to the scale used
+ * args:
+ *   vd - video device handle
+ *   frame - pointer to frame buffer
+ *
+ * asserts:
+ *   vd is not null
+ *   frame is not null
+ *
+ * returns: error code (0- E_OK)
+ */
+int v4l2core_dev_decode_preview_frame(v4l2core_dev_handle vd, v4l2_frame_buff_t *frame);
+
+/*
+ * copies a decoded frame (frame->yuv_frame) to the given planes
+ *   honouring the plane pitches and decimated to the preview size
+ *   (e.g. a locked render buffer) without decoding it again
+ * args:
+ *   vd - video device handle
+ *   frame - pointer to decoded frame buffer
+ *   planes - output planes (yu12: y, u, v; yuyv: a single plane)
+ *   pitches - output plane pitches
+ *
+ * asserts:
+ *   vd is not null
+ *   frame is not null
+ *   planes is not null
+ *   pitches is not null
+ *
+ * returns: error code (0- E_OK)
+ */
+int v4l2core_dev_copy_frame(v4l2core_dev_handle vd, v4l2_frame_buff_t *frame, uint8_t **planes, int *pitches);
+
+/*
+ * starts the decoding pipeline for the video stream:
+ *   a dequeue thread and ndecoders decoder threads
+ *   (not available for the read capture method)
+ *   at most ndecoders + 1 frames are in flight, and always
+ *   less than the number of driver buffers
+ * args:
+ *   vd - video device handle
+ *   ndecoders - number of decoder threads
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: error code (0- E_OK)
+ */
+int v4l2core_dev_start_pipeline(v4l2core_dev_handle vd, int ndecoders);
+
+/*
+ * stops the decoding pipeline
+ *   frames not yet delivered are returned to the driver
+ * args:
+ *   vd - video device handle
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_stop_pipeline(v4l2core_dev_handle vd);
+
+/*
+ * set the number of (m)jpeg band decoding threads
+ *   frames with restart markers (DRI/RSTn) aligned to MCU rows
+ *   are split in bands of MCU rows decoded in parallel, which
+ *   cuts the decoding latency of a single large frame
+ *   (frames without restart markers are decoded as a whole)
+ * args:
+ *   vd - video device handle
+ *   nthreads - number of band threads (0 - disabled)
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_set_jpeg_band_threads(v4l2core_dev_handle vd, int nthreads);
+
+/*
+ * set the number of raw bayer stripe decoding threads
+ *   raw bayer frames (and logitech bayer yuyv) are demosaiced and
+ *   converted to yu12 in stripes of rows, decoded in parallel by
+ *   the stripe threads and the decoding thread
+ * args:
+ *   vd - video device handle
+ *   nthreads - number of stripe threads (0 - disabled)
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_set_bayer_threads(v4l2core_dev_handle vd, int nthreads);
+
+/*
+ * set the number of raw frame conversion band threads
+ *   uncompressed yuv and grey frames (yuyv, uyvy, nv12, nv16, ...)
+ *   are converted to yu12 in cache sized bands of rows, run by the
+ *   device band threads and the decoding thread (the device keeps a
+ *   single pool for the jpeg, bayer and raw frame decoders, with the
+ *   largest number of threads set)
+ * args:
+ *   vd - video device handle
+ *   nthreads - number of band threads (0 - disabled)
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_set_convert_threads(v4l2core_dev_handle vd, int nthreads);
+
+/*
+ * set the yuv colorimetry used for rgb image snapshots (bmp and png)
+ *   in auto mode uncompressed yuv formats use the driver reported
+ *   ycbcr encoding and quantization, all other formats (mjpeg, bayer,
+ *   grey, ...) are converted with bt601 full range (jpeg)
+ * args:
+ *   vd - video device handle
+ *   matrix - YUV_MATRIX_xxx (YUV_MATRIX_AUTO - from the format)
+ *   range - YUV_RANGE_xxx (YUV_RANGE_AUTO - from the format)
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_set_yuv_colorimetry(v4l2core_dev_handle vd, int matrix, int range);
+
+/*
+ * set the 16 bit luma mode (Y10B and Y16 formats)
+ *   decoded frames keep the full precision luma in frame->luma16_frame
+ *   (frame->luma16_bits significant bits) and yuv_frame holds an
+ *   8 bit copy for rendering; png snapshots are saved as 16 bit grey
+ * args:
+ *   vd - video device handle
+ *   enable - 1: keep 16 bit luma; 0: 8 bit only (default)
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_set_luma16_mode(v4l2core_dev_handle vd, int enable);
+
+/*
+ * set the preview scale denominator
+ *   (m)jpeg frames decoded into client planes (v4l2core_dev_decode_frame)
+ *   are scaled down in the idct (1/2, 1/4 or 1/8 of the dct
+ *   coefficients are used), for a cheaper preview of large frames;
+ *   the frame buffer (yuv_frame) is always at full resolution
+ *   (the scale is reduced if the preview size would be odd)
+ * args:
+ *   vd - video device handle
+ *   scale - preview scale denominator (1, 2, 4 or 8)
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_set_preview_scale(v4l2core_dev_handle vd, int scale);
+
+/*
+ * set the pipeline preview mode
+ *   the decoding pipeline decodes (m)jpeg frames at the preview
+ *   scale into yuv_frame (contiguous planes at the preview size,
+ *   frame->yuv_scale set to the scale), for clients that only
+ *   display them; a full size frame (photo, autofocus) is decoded
+ *   again from the raw frame with v4l2core_dev_decode_frame
+ * args:
+ *   vd - video device handle
+ *   enable - 1 enable, 0 disable (default)
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_set_pipeline_preview(v4l2core_dev_handle vd, int enable);
+
+/*
+ * get the preview width
+ *   (the frame width scaled down by the preview scale)
+ * args:
+ *   vd - video device handle
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: preview width
+ */
+int v4l2core_dev_get_preview_width(v4l2core_dev_handle vd);
+
+/*
+ * get the preview height
+ *   (the frame height scaled down by the preview scale)
+ * args:
+ *   vd - video device handle
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: preview height
+ */
+int v4l2core_dev_get_preview_height(v4l2core_dev_handle vd);
+
+/*
+ * clean v4l2 buffers
+ * args:
+ *   vd - video device handle
+ *
+ * asserts:
+ *    vd is not null
+ *
+ * return: none
+ */
+void v4l2core_dev_clean_buffers(v4l2core_dev_handle vd);
+
+/*
+ * get device control list
+ * args:
+ *   vd - video device handle
+ *
+ * asserts:
+ *    vd is not null
+ *
+ * return: pointer to first control in the list
+ */
+v4l2_ctrl_t *v4l2core_dev_get_control_list(v4l2core_dev_handle vd);
+
+/*
+ * return the control associated to id from device list
+ * args:
+ *   vd - video device handle
+ *   id - control id
+ *
+ * asserts:
+ *   vd is not null
+ *   vd->list_device_controls is not null
+ *
+ * returns: pointer to v4l2_control if succeded or null otherwise
+ */
+v4l2_ctrl_t *v4l2core_dev_get_control_by_id(v4l2core_dev_handle vd, int id);
+
+/*
+ * updates the value for control id from the device
+ * also updates control flags
+ * args:
+ *   vd - video device handle
+ *   id -control id
+ *
+ * asserts:
+ *   none
+ *
+ * returns: ioctl result
+ */
+int v4l2core_dev_get_control_value_by_id(v4l2core_dev_handle vd, int id);
+
+/*
+ * sets the value of control id in device
+ * args:
+ *   vd - video device handle
+ *   id - control id
+ *
+ * asserts:
+ *   none
+ *
+ * returns: ioctl result
+ */
+int v4l2core_dev_set_control_value_by_id(v4l2core_dev_handle vd, int id);
+
+/*
+ * goes trough the control list and sets values in device to default
+ * args:
+ *   vd - video device handle
+ *
+ * asserts:
+ *   none
+ *
+ * returns: void
+ */
+void v4l2core_dev_set_control_defaults(v4l2core_dev_handle vd);
+
+/*
+ *  ########### FILE IO ###############
+ */
+/*
+ * save data to file
+ * args:
+ *   filename - string with filename
+ *   data - pointer to data
+ *   size - data size in bytes = sizeof(uint8_t)
+ *
+ * asserts:
+ *   none
+ *
+ * returns: error code
+ */
+int v4l2core_save_data_to_file(const char *filename, uint8_t *data, int size);
+
+/*
+ * save the current frame to file
+ *   the frame data is copied and the image is encoded and
+ *   written by a background thread (the frame can be released
+ *   as soon as this returns)
+ * args:
+ *    frame - pointer to frame buffer
+ *    filename - output file name
+ *    format - image type
+ *           (IMG_FMT_RAW, IMG_FMT_JPG, IMG_FMT_PNG, IMG_FMT_BMP)
+ *
+ * asserts:
+ *    none
+ *
+ * returns: error code (E_OK if the image was queued)
  */
 int v4l2core_save_image(v4l2_frame_buff_t *frame, const char *filename, int format);
 
+/*
+ * save the current frame to file (asynchronous)
+ * args:
+ *    vd - video device handle
+ *    frame - pointer to frame buffer
+ *    filename - output file name
+ *    format - image type
+ *           (IMG_FMT_RAW, IMG_FMT_JPG, IMG_FMT_PNG, IMG_FMT_BMP)
+ *
+ * asserts:
+ *    vd is not null
+ *    frame is not null
+ *    filename is not null
+ *
+ * returns: error code (E_OK if the image was queued)
+ */
+int v4l2core_dev_save_image(v4l2core_dev_handle vd, v4l2_frame_buff_t *frame, const char *filename, int format);
+
+/*
+ * wait for all queued images to be written and
+ *   stop the image writer thread
+ * args:
+ *   none
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+void v4l2core_save_image_flush();
+
 /*
  * ############### TIME DATA ##############
  */
@@ -40,71 +40,997 @@
 #include "gviewv4l2core.h"
 #include "colorspaces.h"
 #include "jpeg_decoder.h"
+#include "band_executor.h"
 #include "gview.h"
 
 #include "turbojpeg.h"
 
-typedef struct _jpeg_decoder_context_t
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+extern int verbosity;
+
+/*maximum number of decoder handles in the pool*/
+#define JPEG_DECODER_MAX_HANDLES (32)
+
+/*maximum padding after EOI accepted by jpeg_check_frame*/
+#define JPEG_CHECK_MAX_PADDING (1024)
+
+#define PAD(v, p) (((v) + (p) - 1) & (~((p) - 1)))
+
+/*
+ * band of MCU rows (restart interval decoding)
+ *   a band is rebuilt as a standalone jpeg (headers with the band
+ *   height + the band restart intervals, renumbered from RST0)
+ *   and decoded straight into its slice of the output planes
+ */
+typedef struct _jpeg_band_t
 {
-	tjhandle tjInstance;
+	int first_seg;       //first restart interval of the band
+	int last_seg;        //last restart interval of the band (exclusive)
+	int height;          //band height in pixels
+} jpeg_band_t;
 
-	int width;
-	int height;
-	
-	uint8_t* tmp_frame; //temp frame buffer	
-}
-jpeg_decoder_context_t;
+/*
+ * band jpeg buffer (one per band thread)
+ */
+typedef struct _jpeg_band_buf_t
+{
+	uint8_t *data;       //band jpeg
+	size_t size;         //allocated size
+} jpeg_band_buf_t;
+
+/*
+ * parsed frame for restart interval decoding
+ */
+typedef struct _jpeg_frame_t
+{
+	const uint8_t *data;
+	size_t size;
+
+	size_t sof_pos;      //offset of the SOF marker
+	size_t sos_pos;      //offset of the SOS marker
+	size_t scan_pos;     //offset of the entropy coded data
+	int restart_interval; //restart interval in MCUs (0 - no DRI)
+
+	int nsegs;           //number of restart intervals found
+	size_t *seg_start;   //start offset of each restart interval
+	size_t *seg_end;     //end offset of each restart interval (RST marker or EOI)
+	int seg_max;         //allocated size of the segment arrays
+} jpeg_frame_t;
+
+/*
+ * frame header info (kept in the header cache)
+ *   positions are in the frame as sent by the camera
+ */
+typedef struct _jpeg_header_info_t
+{
+	int width;           //frame width
+	int height;          //frame height
+	int subsamp;         //chroma subsampling (TJSAMP_xxx)
+
+	size_t sof_pos;      //offset of the SOF marker
+	size_t sos_pos;      //offset of the SOS marker
+	size_t scan_pos;     //offset of the entropy coded data
+	int restart_interval; //restart interval in MCUs (0 - no band decoding)
+} jpeg_header_info_t;
+
+/*
+ * frame header cache
+ *   uvc cameras send the same headers (DQT, DHT, SOF, SOS)
+ *   with every frame: a frame whose header bytes match the
+ *   cached header skips all header parsing
+ */
+typedef struct _jpeg_header_cache_t
+{
+	uint8_t *data;       //header as sent by the camera (SOI up to the scan data)
+	size_t size;         //header size (0 - empty cache)
+	size_t max_size;     //header allocated size
+
+	jpeg_header_info_t info; //parsed header
+
+	uint64_t hits;       //frames with the cached header
+	uint64_t misses;     //header changes
+} jpeg_header_cache_t;
+
+/*
+ * decoder handle: turbojpeg decompressor and its
+ *   scratch buffer (chroma planes not in the output layout)
+ *   and restart interval positions (band decoding)
+ */
+typedef struct _jpeg_handle_t
+{
+	tjhandle tj;         //turbojpeg decompressor
+	uint8_t *buf;        //scratch buffer
+	size_t buf_size;     //scratch buffer allocated size
+	jpeg_frame_t frame;  //frame decoded in bands
+} jpeg_handle_t;
+
+/*
+ * pool of turbojpeg decompressors
+ *   a tjhandle is not reentrant, so each concurrent decode
+ *   takes a handle of its own from the pool (created on demand,
+ *   so there will be one per decoder thread) and returns it
+ *   when done; the mutex only protects the free list
+ */
+struct _jpeg_decoder_context_t
+{
+	jpeg_handle_t handles[JPEG_DECODER_MAX_HANDLES]; //all handles in the pool
+	int nhandles;                               //number of handles created
 
-static jpeg_decoder_context_t* jpeg_ctx = NULL;
+	jpeg_handle_t *free_handles[JPEG_DECODER_MAX_HANDLES]; //handles not in use (LIFO)
+	int nfree;                                  //number of free handles
+
+	__MUTEX_TYPE mutex; //pool mutex
+	__COND_TYPE cond;   //signaled when a handle is returned to the pool
+
+	/*restart interval (band) decoding*/
+	band_executor_t *band_exec; //device band executor (NULL - disabled)
+	jpeg_band_buf_t band_bufs[BAND_EXECUTOR_MAX_THREADS + 1]; //one per band thread
+
+	/*frame header cache*/
+	jpeg_header_cache_t header;
+	__MUTEX_TYPE header_mutex;
+};
+
+/*
+ * frame decoded in bands of MCU rows (band executor job)
+ *   the job rows are units: the smallest groups of
+ *   restart intervals with whole MCU rows
+ */
+typedef struct _jpeg_band_job_t
+{
+	jpeg_decoder_context_t *jpeg_ctx;
+	const jpeg_frame_t *frame; //parsed frame
+	int width;           //frame width
+	int height;          //frame height
+	int mcu_height;      //MCU height in pixels
+	int unit_rows;       //MCU rows per unit
+	int unit_segs;       //restart intervals per unit
+	int nplanes;         //number of output planes
+	uint8_t *planes[3];  //output planes
+	int strides[3];      //output plane strides
+	int ret;             //decode result (0 - all bands decoded)
+} jpeg_band_job_t;
 
 /*
- * init (m)jpeg decoder context
+ * init (m)jpeg decoder context (handle pool)
+ *   the context does not depend on the frame format so it is
+ *   created once and kept across format changes
  * args:
- *    width - image width
- *    height - image height
+ *    none
  *
  * asserts:
  *    none
  *
- * returns: error code (0 - E_OK)
+ * returns: pointer to newly allocated decoder context
  */
-int jpeg_init_decoder(int width, int height)
+jpeg_decoder_context_t *jpeg_init_decoder()
 {
-	if (jpeg_ctx != NULL)
-		jpeg_close_decoder();
-
-	jpeg_ctx = calloc(1, sizeof(jpeg_decoder_context_t));
+	jpeg_decoder_context_t *jpeg_ctx = calloc(1, sizeof(jpeg_decoder_context_t));
 	if (jpeg_ctx == NULL)
 	{
 		fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (jpeg_init_decoder): %s\n", strerror(errno));
 		exit(-1);
 	}
 
-	if ((jpeg_ctx->tjInstance = tjInitDecompress()) == NULL)
+	__INIT_MUTEX(&jpeg_ctx->mutex);
+	__INIT_COND(&jpeg_ctx->cond);
+	__INIT_MUTEX(&jpeg_ctx->header_mutex);
+
+	/*at least one handle for the capture thread*/
+	if(jpeg_decoder_reserve(jpeg_ctx, 1) < 1)
 	{
-		fprintf(stderr, "V4L2_CORE: FATAL jpeg decoder initialization failure (jpeg_init_decoder): %s\n", strerror(errno));
+		fprintf(stderr, "V4L2_CORE: FATAL jpeg decoder initialization failure (jpeg_init_decoder): %s\n", tjGetErrorStr());
 		exit(-1);
 	}
 
-	/*alloc temp buffer*/
-	jpeg_ctx->tmp_frame = calloc(width*height*2, sizeof(uint8_t));
-	if (jpeg_ctx->tmp_frame == NULL)
+	return jpeg_ctx;
+}
+
+/*
+ * make sure the pool has at least nhandles decoder handles
+ *   (e.g. one per decoder thread, so that no handle is
+ *    created while streaming)
+ * args:
+ *    jpeg_ctx - pointer to decoder context
+ *    nhandles - number of handles
+ *
+ * asserts:
+ *    jpeg_ctx is not null
+ *
+ * returns: number of handles in the pool
+ */
+int jpeg_decoder_reserve(jpeg_decoder_context_t *jpeg_ctx, int nhandles)
+{
+	/*asserts*/
+	assert(jpeg_ctx != NULL);
+
+	if(nhandles > JPEG_DECODER_MAX_HANDLES)
+		nhandles = JPEG_DECODER_MAX_HANDLES;
+
+	__LOCK_MUTEX(&jpeg_ctx->mutex);
+	while(jpeg_ctx->nhandles < nhandles)
 	{
-		fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (jpeg_init_decoder): %s\n", strerror(errno));
-		exit(-1);
+		tjhandle tj = tjInitDecompress();
+		if(tj == NULL)
+		{
+			fprintf(stderr, "V4L2_CORE: (jpeg decoder) couldn't create decoder handle: %s\n", tjGetErrorStr());
+			break;
+		}
+		jpeg_ctx->handles[jpeg_ctx->nhandles].tj = tj;
+		jpeg_ctx->free_handles[jpeg_ctx->nfree++] = &jpeg_ctx->handles[jpeg_ctx->nhandles];
+		jpeg_ctx->nhandles++;
+	}
+	int ret = jpeg_ctx->nhandles;
+	__UNLOCK_MUTEX(&jpeg_ctx->mutex);
+
+	return ret;
+}
+
+/*
+ * take a decoder handle from the pool
+ *   creates a new handle if none is free (up to the pool limit)
+ *   or waits for one to be returned
+ * args:
+ *    jpeg_ctx - pointer to decoder context
+ *
+ * asserts:
+ *    none
+ *
+ * returns: decoder handle
+ */
+static jpeg_handle_t *get_handle(jpeg_decoder_context_t *jpeg_ctx)
+{
+	jpeg_handle_t *handle = NULL;
+	tjhandle tj = NULL;
+
+	__LOCK_MUTEX(&jpeg_ctx->mutex);
+	while(jpeg_ctx->nfree == 0)
+	{
+		if(jpeg_ctx->nhandles < JPEG_DECODER_MAX_HANDLES &&
+			(tj = tjInitDecompress()) != NULL)
+		{
+			handle = &jpeg_ctx->handles[jpeg_ctx->nhandles++];
+			handle->tj = tj;
+			__UNLOCK_MUTEX(&jpeg_ctx->mutex);
+
+			if(verbosity > 1)
+				printf("V4L2_CORE: (jpeg decoder) pool grown to %i handles\n", jpeg_ctx->nhandles);
+			return handle;
+		}
+		__COND_WAIT(&jpeg_ctx->cond, &jpeg_ctx->mutex);
+	}
+	handle = jpeg_ctx->free_handles[--jpeg_ctx->nfree];
+	__UNLOCK_MUTEX(&jpeg_ctx->mutex);
+
+	return handle;
+}
+
+/*
+ * return a decoder handle to the pool
+ * args:
+ *    jpeg_ctx - pointer to decoder context
+ *    handle - decoder handle
+ *
+ * asserts:
+ *    none
+ *
+ * returns: none
+ */
+static void put_handle(jpeg_decoder_context_t *jpeg_ctx, jpeg_handle_t *handle)
+{
+	__LOCK_MUTEX(&jpeg_ctx->mutex);
+	jpeg_ctx->free_handles[jpeg_ctx->nfree++] = handle;
+	__COND_BCAST(&jpeg_ctx->cond);
+	__UNLOCK_MUTEX(&jpeg_ctx->mutex);
+}
+
+/*
+ * parse the frame headers (SOF, DRI and SOS positions)
+ * args:
+ *    frame - pointer to frame data (data and size must be set,
+ *      data can hold just the headers)
+ *
+ * asserts:
+ *    none
+ *
+ * returns: 0 if the frame can be decoded in bands; -1 otherwise
+ */
+static int parse_header(jpeg_frame_t *frame)
+{
+	const uint8_t *data = frame->data;
+	size_t size = frame->size;
+	size_t pos = 2;
+
+	frame->sof_pos = 0;
+	frame->sos_pos = 0;
+	frame->restart_interval = 0;
+	frame->nsegs = 0;
+
+	if(size < 4 || data[0] != 0xFF || data[1] != 0xD8)
+		return -1;
+
+	/*headers*/
+	while(pos + 4 <= size)
+	{
+		if(data[pos] != 0xFF)
+			return -1;
+
+		uint8_t marker = data[pos + 1];
+		if(marker == 0xFF) /*fill byte*/
+		{
+			pos++;
+			continue;
+		}
+
+		size_t len = (data[pos + 2] << 8) | data[pos + 3];
+
+		if(marker == 0xC0 || marker == 0xC1) /*baseline/extended huffman SOF*/
+			frame->sof_pos = pos;
+		else if(marker == 0xC2 || marker == 0xC3 || (marker >= 0xC5 && marker <= 0xCF && marker != 0xC8 && marker != 0xCC))
+			return -1; /*progressive, lossless or arithmetic*/
+		else if(marker == 0xDD && pos + 6 <= size) /*DRI*/
+			frame->restart_interval = (data[pos + 4] << 8) | data[pos + 5];
+		else if(marker == 0xDA) /*SOS*/
+		{
+			frame->sos_pos = pos;
+			frame->scan_pos = pos + 2 + len;
+			break;
+		}
+
+		pos += 2 + len;
+	}
+
+	if(frame->sof_pos == 0 || frame->sos_pos == 0 ||
+		frame->restart_interval == 0 || frame->scan_pos > size)
+		return -1;
+
+	/*only a single (interleaved) scan with all components*/
+	if(data[frame->sos_pos + 4] != data[frame->sof_pos + 9])
+		return -1;
+
+	return 0;
+}
+
+/*
+ * find the restart intervals in the entropy coded data
+ * args:
+ *    frame - pointer to frame data (data, size and the
+ *      header positions must be set)
+ *
+ * asserts:
+ *    none
+ *
+ * returns: 0 if the frame can be decoded in bands; -1 otherwise
+ */
+static int parse_restart_markers(jpeg_frame_t *frame)
+{
+	const uint8_t *data = frame->data;
+	size_t size = frame->size;
+	size_t pos = frame->scan_pos;
+
+	frame->nsegs = 0;
+
+	if(pos >= size)
+		return -1;
+
+	/*entropy coded data: split at the RSTn markers*/
+	size_t start = pos;
+	while(pos + 1 < size)
+	{
+		const uint8_t *ff = memchr(data + pos, 0xFF, size - pos - 1);
+		if(ff == NULL)
+			break;
+		pos = ff - data;
+
+		uint8_t marker = data[pos + 1];
+		if(marker == 0x00 || marker == 0xFF) /*stuffed byte or fill*/
+		{
+			pos += (marker == 0x00) ? 2 : 1;
+			continue;
+		}
+
+		if(frame->nsegs >= frame->seg_max)
+		{
+			frame->seg_max = frame->seg_max ? frame->seg_max * 2 : 256;
+			frame->seg_start = realloc(frame->seg_start, frame->seg_max * sizeof(size_t));
+			frame->seg_end = realloc(frame->seg_end, frame->seg_max * sizeof(size_t));
+			if(frame->seg_start == NULL || frame->seg_end == NULL)
+			{
+				fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (jpeg decoder): %s\n", strerror(errno));
+				exit(-1);
+			}
+		}
+		frame->seg_start[frame->nsegs] = start;
+		frame->seg_end[frame->nsegs] = pos;
+		frame->nsegs++;
+
+		if(marker < 0xD0 || marker > 0xD7) /*EOI (or unexpected marker)*/
+			return (marker == 0xD9) ? 0 : -1;
+
+		pos += 2;
+		start = pos;
+	}
+
+	/*no EOI*/
+	return -1;
+}
+
+/*
+ * build the band jpeg: frame headers with the band height,
+ *   the band restart intervals (renumbered from RST0) and EOI
+ * args:
+ *    frame - pointer to parsed frame
+ *    band - pointer to band
+ *    buf - pointer to band jpeg buffer
+ *
+ * asserts:
+ *    none
+ *
+ * returns: band jpeg size
+ */
+static size_t build_band(const jpeg_frame_t *frame, const jpeg_band_t *band, jpeg_band_buf_t *buf)
+{
+	size_t size = frame->scan_pos + 2;
+	int i = 0;
+
+	for(i = band->first_seg; i < band->last_seg; i++)
+		size += frame->seg_end[i] - frame->seg_start[i] + 2;
+
+	if(size > buf->size)
+	{
+		buf->data = realloc(buf->data, size);
+		if(buf->data == NULL)
+		{
+			fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (jpeg decoder): %s\n", strerror(errno));
+			exit(-1);
+		}
+		buf->size = size;
+	}
+
+	uint8_t *p = buf->data;
+
+	memcpy(p, frame->data, frame->scan_pos);
+	/*SOF height*/
+	p[frame->sof_pos + 5] = (band->height >> 8) & 0xFF;
+	p[frame->sof_pos + 6] = band->height & 0xFF;
+	p += frame->scan_pos;
+
+	for(i = band->first_seg; i < band->last_seg; i++)
+	{
+		size_t len = frame->seg_end[i] - frame->seg_start[i];
+		memcpy(p, frame->data + frame->seg_start[i], len);
+		p += len;
+		*p++ = 0xFF;
+		*p++ = (i + 1 < band->last_seg) ? 0xD0 + ((i - band->first_seg) & 0x07) : 0xD9;
+	}
+
+	return p - buf->data;
+}
+
+/*
+ * band function: decode the units [unit0, unit1) as a band
+ *   into its slice of the output planes
+ * args:
+ *    data - pointer to band job
+ *    unit0 - first unit
+ *    unit1 - last unit (exclusive)
+ *    worker - band thread index (-1 - not a band thread)
+ *
+ * asserts:
+ *    none
+ *
+ * returns: none (errors in job->ret)
+ */
+static void decode_band(void *data, int unit0, int unit1, int worker)
+{
+	jpeg_band_job_t *job = (jpeg_band_job_t *) data;
+	const jpeg_frame_t *frame = job->frame;
+
+	/*the executor is busy with another job: decode the whole frame instead*/
+	if(worker < 0)
+	{
+		job->ret = -1;
+		return;
+	}
+
+	int row0 = unit0 * job->unit_rows * job->mcu_height;
+	int row1 = unit1 * job->unit_rows * job->mcu_height;
+	if(row1 > job->height)
+		row1 = job->height;
+
+	jpeg_band_t band;
+	band.first_seg = unit0 * job->unit_segs;
+	band.last_seg = unit1 * job->unit_segs;
+	if(band.last_seg > frame->nsegs)
+		band.last_seg = frame->nsegs;
+	band.height = row1 - row0;
+
+	uint8_t *planes[3] = {NULL, NULL, NULL};
+	int i = 0;
+	for(i = 0; i < job->nplanes; i++)
+	{
+		/*every component has 8 rows per MCU row*/
+		int plane_row = (i == 0) ? row0 : row0 * 8 / job->mcu_height;
+		planes[i] = job->planes[i] + plane_row * job->strides[i];
+	}
+
+	jpeg_band_buf_t *buf = &job->jpeg_ctx->band_bufs[worker];
+	size_t size = build_band(frame, &band, buf);
+
+	jpeg_handle_t *handle = get_handle(job->jpeg_ctx);
+	if(tjDecompressToYUVPlanes(handle->tj, buf->data, size, planes,
+		job->width, job->strides, band.height, 0) < 0)
+		job->ret = -1;
+	put_handle(job->jpeg_ctx, handle);
+}
+
+/*
+ * decode a frame in bands of MCU rows (band executor job)
+ *   the frame must have restart intervals aligned with
+ *   whole MCU rows; the planes are in the frame (native) subsampling
+ * args:
+ *    jpeg_ctx - pointer to decoder context
+ *    handle - decoder handle (holds the parsed frame)
+ *    info - frame header info
+ *    dst_planes - output planes
+ *    dst_strides - output plane strides
+ *    in_buf - pointer to jpeg data
+ *    size - in_buf size
+ *
+ * asserts:
+ *    none
+ *
+ * returns: 0 if decoded; -1 if the frame must be decoded as a whole
+ */
+static int decode_bands(jpeg_decoder_context_t *jpeg_ctx, jpeg_handle_t *handle,
+	const jpeg_header_info_t *info, uint8_t **dst_planes, int *dst_strides, uint8_t *in_buf, int size)
+{
+	__LOCK_MUTEX(&jpeg_ctx->mutex);
+	band_executor_t *exec = jpeg_ctx->band_exec;
+	__UNLOCK_MUTEX(&jpeg_ctx->mutex);
+
+	if(exec == NULL || band_executor_get_threads(exec) == 0)
+		return -1;
+
+	jpeg_frame_t *frame = &handle->frame;
+	frame->data = in_buf;
+	frame->size = size;
+	frame->sof_pos = info->sof_pos;
+	frame->sos_pos = info->sos_pos;
+	frame->scan_pos = info->scan_pos;
+	frame->restart_interval = info->restart_interval;
+
+	if(frame->restart_interval == 0 ||
+		parse_restart_markers(frame) < 0)
+		return -1;
+
+	jpeg_band_job_t job;
+	job.jpeg_ctx = jpeg_ctx;
+	job.frame = frame;
+	job.width = info->width;
+	job.height = info->height;
+	job.mcu_height = tjMCUHeight[info->subsamp];
+	job.nplanes = (info->subsamp == TJSAMP_GRAY) ? 1 : 3;
+	job.ret = 0;
+
+	int mcu_width = tjMCUWidth[info->subsamp];
+	int mcus_per_row = (job.width + mcu_width - 1) / mcu_width;
+	int mcu_rows = (job.height + job.mcu_height - 1) / job.mcu_height;
+	int ri = frame->restart_interval;
+
+	if(frame->nsegs != (mcus_per_row * mcu_rows + ri - 1) / ri)
+		return -1;
+
+	/*a unit is the smallest group of restart intervals with whole MCU rows*/
+	job.unit_segs = 1;
+	job.unit_rows = 1;
+	if(ri % mcus_per_row == 0)
+		job.unit_rows = ri / mcus_per_row;
+	else if(mcus_per_row % ri == 0)
+		job.unit_segs = mcus_per_row / ri;
+	else
+		return -1;
+
+	int nunits = (frame->nsegs + job.unit_segs - 1) / job.unit_segs;
+	if(nunits < 2)
+		return -1;
+
+	int i = 0;
+	for(i = 0; i < 3; i++)
+	{
+		job.planes[i] = (i < job.nplanes) ? dst_planes[i] : NULL;
+		job.strides[i] = (i < job.nplanes) ? dst_strides[i] : 0;
+	}
+
+	/*
+	 * every band pays for a decoder setup and the frame headers:
+	 * one band per thread (no per band working set limit)
+	 */
+	band_executor_run(exec, decode_band, &job, nunits, 1, 0);
+
+	if(job.ret < 0 && verbosity > 0)
+		fprintf(stderr, "V4L2_CORE: (jpeg decoder) band decoding failed - decoding the whole frame\n");
+
+	return job.ret;
+}
+
+/*
+ * set the band executor for restart interval (band) decoding
+ * args:
+ *    jpeg_ctx - pointer to decoder context
+ *    exec - pointer to band executor (NULL - disable band decoding)
+ *
+ * asserts:
+ *    jpeg_ctx is not null
+ *
+ * returns: none
+ */
+void jpeg_decoder_set_band_executor(jpeg_decoder_context_t *jpeg_ctx, band_executor_t *exec)
+{
+	/*asserts*/
+	assert(jpeg_ctx != NULL);
+
+	/*one decoder handle per band (+ the one held by the caller)*/
+	if(exec != NULL)
+		jpeg_decoder_reserve(jpeg_ctx, band_executor_get_threads(exec) + 2);
+
+	__LOCK_MUTEX(&jpeg_ctx->mutex);
+	jpeg_ctx->band_exec = exec;
+	__UNLOCK_MUTEX(&jpeg_ctx->mutex);
+}
+
+/*
+ * check the (m)jpeg frame structure before decoding
+ *   (SOI, header segment lengths, frame size and EOI), this
+ *   catches truncated and most damaged usb payloads without
+ *   touching the entropy coded data
+ * args:
+ *    in_buf - pointer to jpeg data
+ *    size - in_buf size
+ *    width - expected frame width
+ *    height - expected frame height
+ *
+ * asserts:
+ *    in_buf is not null
+ *
+ * returns: error code (0 - E_OK)
+ */
+int jpeg_check_frame(const uint8_t *in_buf, int size, int width, int height)
+{
+	/*asserts*/
+	assert(in_buf != NULL);
+
+	if(size < 4 || in_buf[0] != 0xFF || in_buf[1] != 0xD8)
+		return E_NO_SOI_ERR;
+
+	/*
+	 * some cameras pad the payload after EOI
+	 * (0xFFD9 can't show up in the entropy coded data)
+	 */
+	int end = size;
+	int min_end = (size > JPEG_CHECK_MAX_PADDING) ? size - JPEG_CHECK_MAX_PADDING : 4;
+	while(end > min_end && (in_buf[end - 2] != 0xFF || in_buf[end - 1] != 0xD9))
+		end--;
+	if(in_buf[end - 2] != 0xFF || in_buf[end - 1] != 0xD9)
+		return E_NO_EOI_ERR;
+	end -= 2;
+
+	/*header segments up to the start of scan*/
+	int pos = 2;
+	int has_sof = 0;
+	while(pos + 4 <= end)
+	{
+		if(in_buf[pos] != 0xFF)
+			return E_WRONG_MARKER_ERR;
+
+		uint8_t marker = in_buf[pos + 1];
+		if(marker == 0xFF) /*fill byte*/
+		{
+			pos++;
+			continue;
+		}
+		/*standalone markers (SOI, EOI, RSTn) are not expected in the headers*/
+		if(marker == 0x00 || marker == 0xD8 || marker == 0xD9 || (marker >= 0xD0 && marker <= 0xD7))
+			return E_WRONG_MARKER_ERR;
+
+		int len = (in_buf[pos + 2] << 8) | in_buf[pos + 3];
+		if(len < 2 || pos + 2 + len > end)
+			return E_WRONG_MARKER_ERR;
+
+		/*SOFn (0xC4 - DHT, 0xC8 - JPG, 0xCC - DAC)*/
+		if(marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC)
+		{
+			if(len < 8)
+				return E_WRONG_MARKER_ERR;
+			int sof_height = (in_buf[pos + 5] << 8) | in_buf[pos + 6];
+			int sof_width = (in_buf[pos + 7] << 8) | in_buf[pos + 8];
+			if(sof_width != width || sof_height != height)
+				return E_BAD_WIDTH_OR_HEIGHT_ERR;
+			has_sof = 1;
+		}
+		else if(marker == 0xDA) /*SOS: there must be some scan data*/
+			return (has_sof && pos + 2 + len < end) ? E_OK : E_WRONG_MARKER_ERR;
+
+		pos += 2 + len;
+	}
+
+	/*no start of scan*/
+	return E_WRONG_MARKER_ERR;
+}
+
+/*
+ * find the start of the entropy coded data
+ * args:
+ *    data - pointer to jpeg data
+ *    size - data size
+ *    sos_pos - pointer to SOS marker offset (set on return)
+ *    scan_pos - pointer to scan data offset (set on return)
+ *    has_dht - pointer to DHT flag (set on return)
+ *
+ * asserts:
+ *    none
+ *
+ * returns: 0 on success; -1 if no scan data is found
+ */
+static int find_scan(const uint8_t *data, size_t size, size_t *sos_pos, size_t *scan_pos, int *has_dht)
+{
+	size_t pos = 2;
+
+	*has_dht = 0;
+
+	if(size < 4 || data[0] != 0xFF || data[1] != 0xD8)
+		return -1;
+
+	while(pos + 4 <= size)
+	{
+		if(data[pos] != 0xFF)
+			return -1;
+
+		uint8_t marker = data[pos + 1];
+		if(marker == 0xFF) /*fill byte*/
+		{
+			pos++;
+			continue;
+		}
+
+		size_t len = (data[pos + 2] << 8) | data[pos + 3];
+
+		if(marker == 0xC4)
+			*has_dht = 1;
+		else if(marker == 0xDA)
+		{
+			*sos_pos = pos;
+			*scan_pos = pos + 2 + len;
+			return (*scan_pos < size) ? 0 : -1;
+		}
+
+		pos += 2 + len;
+	}
+
+	return -1;
+}
+
+/*
+ * parse a new frame header into the header cache
+ *   (must be called with the header mutex locked)
+ * args:
+ *    jpeg_ctx - pointer to decoder context
+ *    handle - decoder handle
+ *    in_buf - pointer to jpeg data
+ *    size - in_buf size
+ *
+ * asserts:
+ *    none
+ *
+ * returns: 0 on success; -1 on error
+ */
+static int update_header_cache(jpeg_decoder_context_t *jpeg_ctx, jpeg_handle_t *handle, const uint8_t *in_buf, size_t size)
+{
+	jpeg_header_cache_t *cache = &jpeg_ctx->header;
+	size_t sos_pos = 0;
+	size_t scan_pos = 0;
+	int has_dht = 0;
+
+	/*empty the cache*/
+	cache->size = 0;
+
+	if(find_scan(in_buf, size, &sos_pos, &scan_pos, &has_dht) < 0)
+		return -1;
+
+	if(scan_pos > cache->max_size)
+	{
+		cache->data = realloc(cache->data, scan_pos);
+		if(cache->data == NULL)
+		{
+			fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (jpeg decoder): %s\n", strerror(errno));
+			exit(-1);
+		}
+		cache->max_size = scan_pos;
+	}
+	memcpy(cache->data, in_buf, scan_pos);
+
+	/*
+	 * DHT-less (AVI1) frames are decoded as sent:
+	 * libjpeg-turbo falls back to the standard huffman tables
+	 */
+	jpeg_header_info_t *info = &cache->info;
+	int colorspace = 0;
+	if(tjDecompressHeader3(handle->tj, cache->data, scan_pos,
+		&info->width, &info->height, &info->subsamp, &colorspace) < 0 ||
+		info->subsamp < 0 || info->subsamp >= TJ_NUMSAMP)
+		return -1;
+
+	/*band decoding positions*/
+	jpeg_frame_t frame;
+	memset(&frame, 0, sizeof(jpeg_frame_t));
+	frame.data = cache->data;
+	frame.size = scan_pos;
+	if(parse_header(&frame) == 0)
+	{
+		info->sof_pos = frame.sof_pos;
+		info->sos_pos = frame.sos_pos;
+		info->scan_pos = frame.scan_pos;
+		info->restart_interval = frame.restart_interval;
+	}
+	else
+		info->restart_interval = 0;
+
+	cache->size = scan_pos;
+
+	if(verbosity > 1)
+		printf("V4L2_CORE: (jpeg decoder) new frame header (%ix%i subsamp %i%s)\n",
+			info->width, info->height, info->subsamp, has_dht ? "" : " - standard huffman tables");
+
+	return 0;
+}
+
+/*
+ * get the frame header info (from the header cache)
+ * args:
+ *    jpeg_ctx - pointer to decoder context
+ *    handle - decoder handle
+ *    in_buf - pointer to jpeg data
+ *    size - in_buf size
+ *    info - pointer to header info (set on return)
+ *
+ * asserts:
+ *    none
+ *
+ * returns: 0 on success; -1 on error
+ */
+static int read_header(jpeg_decoder_context_t *jpeg_ctx, jpeg_handle_t *handle,
+	uint8_t *in_buf, int size, jpeg_header_info_t *info)
+{
+	jpeg_header_cache_t *cache = &jpeg_ctx->header;
+
+	__LOCK_MUTEX(&jpeg_ctx->header_mutex);
+
+	/*same header bytes as the last frame: nothing to parse*/
+	if(cache->size > 0 && cache->size < (size_t) size &&
+		memcmp(cache->data, in_buf, cache->size) == 0)
+		cache->hits++;
+	else
+	{
+		cache->misses++;
+		if(update_header_cache(jpeg_ctx, handle, in_buf, size) < 0)
+		{
+			__UNLOCK_MUTEX(&jpeg_ctx->header_mutex);
+			return -1;
+		}
+	}
+
+	*info = cache->info;
+
+	__UNLOCK_MUTEX(&jpeg_ctx->header_mutex);
+
+	return 0;
+}
+
+/*
+ * average two rows (vertical 2:1 chroma downsampling)
+ * args:
+ *    dst - output row
+ *    a - first row
+ *    b - second row
+ *    width - row width
+ *
+ * asserts:
+ *    none
+ *
+ * returns: none
+ */
+static void average_rows(uint8_t *dst, const uint8_t *a, const uint8_t *b, int width)
+{
+	int x = 0;
+#ifdef __SSE2__
+	for(; x + 16 <= width; x += 16)
+	{
+		__m128i va = _mm_loadu_si128((const __m128i *) (a + x));
+		__m128i vb = _mm_loadu_si128((const __m128i *) (b + x));
+		_mm_storeu_si128((__m128i *) (dst + x), _mm_avg_epu8(va, vb));
 	}
-	
-	jpeg_ctx->width = width;
-	jpeg_ctx->height = height;
+#endif
+	/*same rounding as pavgb (other archs get it auto vectorized)*/
+	for(; x < width; x++)
+		dst[x] = (uint8_t) ((a[x] + b[x] + 1) >> 1);
+}
+
+/*
+ * convert a chroma plane to 4:2:0 size
+ *   4:2:2 (the usual uvc mjpeg) averages row pairs, 4:4:4 and
+ *   4:4:0 average 2x2 / 2x1 blocks, other layouts are resampled
+ * args:
+ *    src - source plane
+ *    src_width - source plane width
+ *    src_height - source plane height
+ *    src_stride - source plane stride
+ *    dst - output plane
+ *    dst_width - output plane width
+ *    dst_height - output plane height
+ *    dst_stride - output plane stride
+ *
+ * asserts:
+ *    none
+ *
+ * returns: none
+ */
+static void chroma_to_420(const uint8_t *src, int src_width, int src_height, int src_stride,
+	uint8_t *dst, int dst_width, int dst_height, int dst_stride)
+{
+	int x = 0, y = 0;
+
+	for(y = 0; y < dst_height; y++)
+	{
+		uint8_t *out = dst + y * dst_stride;
 
-	return E_OK;
+		if(src_height == 2 * dst_height)
+		{
+			const uint8_t *a = src + 2 * y * src_stride;
+			const uint8_t *b = a + src_stride;
+
+			if(src_width == dst_width) /*4:2:2*/
+				average_rows(out, a, b, dst_width);
+			else if(src_width == 2 * dst_width) /*4:4:4*/
+			{
+				for(x = 0; x < dst_width; x++)
+					out[x] = (uint8_t) ((a[2 * x] + a[2 * x + 1] + b[2 * x] + b[2 * x + 1] + 2) >> 2);
+			}
+			else
+			{
+				for(x = 0; x < dst_width; x++)
+					out[x] = a[x * src_width / dst_width];
+			}
+		}
+		else
+		{
+			const uint8_t *a = src + (y * src_height / dst_height) * src_stride;
+
+			if(src_width == 2 * dst_width) /*4:4:0*/
+			{
+				for(x = 0; x < dst_width; x++)
+					out[x] = (uint8_t) ((a[2 * x] + a[2 * x + 1] + 1) >> 1);
+			}
+			else
+			{
+				for(x = 0; x < dst_width; x++)
+					out[x] = a[x * src_width / dst_width];
+			}
+		}
+	}
 }
 
 /*
- * decode (m)jpeg frame
+ * decode (m)jpeg frame to a yu12 (4:2:0 planar) buffer
+ *   can be called concurrently from several decoder threads
  * args:
- *    out_buf - pointer to decoded data
- *    in_buf - pointer to h264 data
+ *    jpeg_ctx - pointer to decoder context
+ *    out_buf - pointer to decoded data (width * height * 3/2)
+ *    width - frame width
+ *    height - frame height
+ *    in_buf - pointer to jpeg data
  *    size - in_buf size
  *
  * asserts:
@@ -112,47 +1038,197 @@ int jpeg_init_decoder(int width, int height)
  *    in_buf is not null
  *    out_buf is not null
  *
- * returns: decoded data size
+ * returns: decoded data size (0 on error)
  */
-int jpeg_decode(uint8_t* out_buf, uint8_t* in_buf, int size)
+int jpeg_decode(jpeg_decoder_context_t *jpeg_ctx, uint8_t *out_buf, int width, int height, uint8_t *in_buf, int size)
 {
 	/*asserts*/
 	assert(jpeg_ctx != NULL);
 	assert(in_buf != NULL);
 	assert(out_buf != NULL);
 
-	int flags = 0;
-	if (tjDecompressToYUV(jpeg_ctx->tjInstance, in_buf, size, out_buf, flags) < 0)
+	uint8_t *planes[3] =
+	{
+		out_buf,
+		out_buf + width * height,
+		out_buf + width * height + (width / 2) * (height / 2)
+	};
+	int strides[3] = {width, width / 2, width / 2};
+
+	int ret = jpeg_decode_planes(jpeg_ctx, planes, strides, width, height, 1, in_buf, size);
+	if(ret < 0)
+	{
+		fprintf(stderr, "V4L2_CORE: (jpeg decoder) frame doesn't match the stream format (%ix%i)\n", width, height);
+		ret = 0;
+	}
+
+	return ret;
+}
+
+/*
+ * decode (m)jpeg frame straight into yu12 planes with the given strides
+ *   (e.g. a render overlay); the subsampling is read from the frame
+ *   header: 4:2:0 (and luma) is decoded into the output planes, other
+ *   chroma layouts are decoded to a scratch buffer and converted to 4:2:0
+ *   with scale > 1 the idct is done at a reduced size (dropping
+ *   dct coefficients), the output size is width/scale x height/scale
+ *   can be called concurrently from several decoder threads
+ * args:
+ *    jpeg_ctx - pointer to decoder context
+ *    planes - output planes (y, u, v)
+ *    strides - output plane strides
+ *    width - frame width
+ *    height - frame height
+ *    scale - output scale denominator (1, 2, 4 or 8)
+ *    in_buf - pointer to jpeg data
+ *    size - in_buf size
+ *
+ * asserts:
+ *    jpeg_ctx is not null
+ *    planes is not null
+ *    strides is not null
+ *    in_buf is not null
+ *
+ * returns: decoded data size (0 on decoding error;
+ *    -1 if the frame size doesn't match)
+ */
+int jpeg_decode_planes(jpeg_decoder_context_t *jpeg_ctx, uint8_t **planes, int *strides,
+	int width, int height, int scale, uint8_t *in_buf, int size)
+{
+	/*asserts*/
+	assert(jpeg_ctx != NULL);
+	assert(planes != NULL);
+	assert(strides != NULL);
+	assert(in_buf != NULL);
+
+	jpeg_header_info_t info;
+	int ret = size;
+	int i = 0;
+
+	jpeg_handle_t *handle = get_handle(jpeg_ctx);
+
+	if(read_header(jpeg_ctx, handle, in_buf, size, &info) < 0)
+	{
+		fprintf(stderr, "V4L2_CORE: (jpeg decoder) couldn't read the frame header\n");
+		put_handle(jpeg_ctx, handle);
+		return 0;
+	}
+
+	if(info.width != width || info.height != height)
+	{
+		put_handle(jpeg_ctx, handle);
+		return -1;
+	}
+
+	int subsamp = info.subsamp;
+
+	/*turbojpeg picks the (dct) scaling factor from the output size*/
+	tjscalingfactor sf = {1, scale};
+	int out_width = TJSCALED(width, sf);
+	int out_height = TJSCALED(height, sf);
+
+	/*decode in the frame subsampling: luma always goes to the output*/
+	uint8_t *dec_planes[3] = {planes[0], planes[1], planes[2]};
+	int dec_strides[3] = {strides[0], strides[1], strides[2]};
+	int chroma_width = 0;
+	int chroma_height = 0;
+
+	if(subsamp != TJSAMP_420 && subsamp != TJSAMP_GRAY)
+	{
+		chroma_width = tjPlaneWidth(1, out_width, subsamp);
+		chroma_height = tjPlaneHeight(1, out_height, subsamp);
+		int chroma_stride = PAD(chroma_width, 16);
+		size_t buf_size = (size_t) chroma_stride * chroma_height * 2;
+
+		if(buf_size > handle->buf_size)
+		{
+			free(handle->buf);
+			handle->buf = malloc(buf_size);
+			if(handle->buf == NULL)
+			{
+				fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (jpeg decoder): %s\n", strerror(errno));
+				exit(-1);
+			}
+			handle->buf_size = buf_size;
+		}
+
+		dec_planes[1] = handle->buf;
+		dec_planes[2] = handle->buf + chroma_stride * chroma_height;
+		dec_strides[1] = chroma_stride;
+		dec_strides[2] = chroma_stride;
+	}
+
+	/*low latency: split the frame at the restart markers*/
+	int decoded = (scale == 1 &&
+		decode_bands(jpeg_ctx, handle, &info, dec_planes, dec_strides, in_buf, size) == 0);
+
+	if (!decoded && tjDecompressToYUVPlanes(handle->tj, in_buf, size, dec_planes,
+		out_width, dec_strides, out_height, 0) < 0)
 	{
 		fprintf(stderr, "V4L2_CORE: (jpeg decoder) error while decoding frame\n");
+		put_handle(jpeg_ctx, handle);
 		return 0;
 	}
-      
-	return size;
+
+	/*chroma to 4:2:0*/
+	if(subsamp == TJSAMP_GRAY)
+	{
+		for(i = 0; i < out_height / 2; i++)
+		{
+			memset(planes[1] + i * strides[1], 0x80, out_width / 2);
+			memset(planes[2] + i * strides[2], 0x80, out_width / 2);
+		}
+	}
+	else if(subsamp != TJSAMP_420)
+	{
+		for(i = 1; i < 3; i++)
+			chroma_to_420(dec_planes[i], chroma_width, chroma_height, dec_strides[i],
+				planes[i], out_width / 2, out_height / 2, strides[i]);
+	}
+
+	put_handle(jpeg_ctx, handle);
+
+	return ret;
 }
 
 /*
  * close (m)jpeg decoder context
+ *   (no decoding can be in progress)
  * args:
- *    none
+ *    jpeg_ctx - pointer to decoder context (can be null)
  *
  * asserts:
  *    none
  *
  * returns: none
  */
-void jpeg_close_decoder()
+void jpeg_close_decoder(jpeg_decoder_context_t *jpeg_ctx)
 {
 	if (jpeg_ctx == NULL)
 		return;
 
-	tjDestroy(jpeg_ctx->tjInstance);
-	jpeg_ctx->tjInstance = NULL;
+	int i = 0;
+	for(i = 0; i < BAND_EXECUTOR_MAX_THREADS + 1; i++)
+		free(jpeg_ctx->band_bufs[i].data);
+
+	for(i = 0; i < jpeg_ctx->nhandles; i++)
+	{
+		tjDestroy(jpeg_ctx->handles[i].tj);
+		free(jpeg_ctx->handles[i].buf);
+		free(jpeg_ctx->handles[i].frame.seg_start);
+		free(jpeg_ctx->handles[i].frame.seg_end);
+	}
+
+	if(verbosity > 0 && jpeg_ctx->header.misses > 0)
+		printf("V4L2_CORE: (jpeg decoder) header cache: %" PRIu64 " hits, %" PRIu64 " header changes\n",
+			jpeg_ctx->header.hits, jpeg_ctx->header.misses);
+	free(jpeg_ctx->header.data);
+	__CLOSE_MUTEX(&jpeg_ctx->header_mutex);
+	jpeg_ctx->nhandles = 0;
+	jpeg_ctx->nfree = 0;
+
+	__CLOSE_COND(&jpeg_ctx->cond);
+	__CLOSE_MUTEX(&jpeg_ctx->mutex);
 
-	if (jpeg_ctx->tmp_frame)
-		free(jpeg_ctx->tmp_frame);
-		
 	free(jpeg_ctx);
-	jpeg_ctx = NULL;
 }
-
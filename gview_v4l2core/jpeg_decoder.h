@@ -28,6 +28,8 @@
 #ifndef JPEG_DECODER_H
 #define JPEG_DECODER_H
 
+#include "band_executor.h"
+
 #define HEADERFRAME1 0xaf
 
 /*******Error codes *******/
@@ -47,45 +49,131 @@
 #define ERR_BAD_TABLES 14
 #define ERR_DEPTH_MISMATCH 15
 
+typedef struct _jpeg_decoder_context_t jpeg_decoder_context_t;
+
 /*
- * init (m)jpeg decoder context
+ * init (m)jpeg decoder context (handle pool)
+ *   the context does not depend on the frame format so it is
+ *   created once and kept across format changes
  * args:
- *    width - image width
- *    height - image height
+ *    none
  *
  * asserts:
  *    none
  *
+ * returns: pointer to newly allocated decoder context
+ */
+jpeg_decoder_context_t *jpeg_init_decoder();
+
+/*
+ * make sure the pool has at least nhandles decoder handles
+ *   (e.g. one per decoder thread, so that no handle is
+ *    created while streaming)
+ * args:
+ *    jpeg_ctx - pointer to decoder context
+ *    nhandles - number of handles
+ *
+ * asserts:
+ *    jpeg_ctx is not null
+ *
+ * returns: number of handles in the pool
+ */
+int jpeg_decoder_reserve(jpeg_decoder_context_t *jpeg_ctx, int nhandles);
+
+/*
+ * set the band executor for restart interval (band) decoding
+ *   frames with restart markers (DRI/RSTn) aligned to MCU rows
+ *   are split in bands of MCU rows, decoded in parallel by the
+ *   band threads and the calling thread, to cut the latency of
+ *   a single frame; other frames (or frames arriving while the
+ *   executor is busy) are decoded as a whole
+ * args:
+ *    jpeg_ctx - pointer to decoder context
+ *    exec - pointer to band executor (NULL - disable band decoding)
+ *
+ * asserts:
+ *    jpeg_ctx is not null
+ *
+ * returns: none
+ */
+void jpeg_decoder_set_band_executor(jpeg_decoder_context_t *jpeg_ctx, band_executor_t *exec);
+
+/*
+ * check the (m)jpeg frame structure before decoding
+ *   (SOI, header segment lengths, frame size and EOI)
+ * args:
+ *    in_buf - pointer to jpeg data
+ *    size - in_buf size
+ *    width - expected frame width
+ *    height - expected frame height
+ *
+ * asserts:
+ *    in_buf is not null
+ *
  * returns: error code (0 - E_OK)
  */
-int jpeg_init_decoder(int width, int height);
+int jpeg_check_frame(const uint8_t *in_buf, int size, int width, int height);
 
 /*
- * jpeg decode
+ * jpeg decode (to a yu12 buffer, whatever the frame subsampling)
+ *   can be called concurrently from several decoder threads
  * args:
- *   out_buf -  pointer to picture data ( decoded image - yuyv format)
+ *   jpeg_ctx - pointer to decoder context
+ *   out_buf -  pointer to picture data ( decoded image - yu12 format)
+ *   width - frame width
+ *   height - frame height
  *   in_buf -  pointer to input data ( compressed jpeg )
  *   size - picture size
  *
  * asserts:
+ *   jpeg_ctx is not null
  *   out_buf not null
  *   in_buf not null
  *
  * returns: error code (0 - OK)
  */
-int jpeg_decode(uint8_t *out_buf, uint8_t *in_buf, int size);
+int jpeg_decode(jpeg_decoder_context_t *jpeg_ctx, uint8_t *out_buf, int width, int height, uint8_t *in_buf, int size);
+
+/*
+ * decode (m)jpeg frame straight into yu12 planes with the given strides
+ *   (e.g. a render overlay); chroma is converted to 4:2:0 if the
+ *   frame has a different subsampling
+ *   with scale > 1 the idct is done at a reduced size (dropping
+ *   dct coefficients), the output size is width/scale x height/scale
+ * args:
+ *    jpeg_ctx - pointer to decoder context
+ *    planes - output planes (y, u, v)
+ *    strides - output plane strides
+ *    width - frame width
+ *    height - frame height
+ *    scale - output scale denominator (1, 2, 4 or 8)
+ *    in_buf - pointer to jpeg data
+ *    size - in_buf size
+ *
+ * asserts:
+ *    jpeg_ctx is not null
+ *    planes is not null
+ *    strides is not null
+ *    in_buf is not null
+ *
+ * returns: decoded data size (0 on decoding error;
+ *    -1 if the frame size doesn't match)
+ */
+int jpeg_decode_planes(jpeg_decoder_context_t *jpeg_ctx, uint8_t **planes, int *strides,
+	int width, int height, int scale, uint8_t *in_buf, int size);
 
 /*
  * close (m)jpeg decoder context
+ *   (no decoding can be in progress)
  * args:
- *    none
+ *    jpeg_ctx - pointer to decoder context (can be null)
  *
  * asserts:
  *    none
  *
  * returns: none
  */
-void jpeg_close_decoder();
+void jpeg_close_decoder(jpeg_decoder_context_t *jpeg_ctx);
 
 #endif
 
@@ -0,0 +1,363 @@
+/*******************************************************************************#
+#           guvcview              http://guvcview.sourceforge.net               #
+#                                                                               #
+#           Paulo Assis <pj.assis@gmail.com>                                    #
+#                                                                               #
+# This program is free software; you can redistribute it and/or modify          #
+# it under the terms of the GNU General Public License as published by          #
+# the Free Software Foundation; either version 2 of the License, or             #
+# (at your option) any later version.                                           #
+#                                                                               #
+# This program is distributed in the hope that it will be useful,               #
+# but WITHOUT ANY WARRANTY; without even the implied warranty of                #
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 #
+# GNU General Public License for more details.                                  #
+#                                                                               #
+# You should have received a copy of the GNU General Public License             #
+# along with this program; if not, write to the Free Software                   #
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA     #
+#                                                                               #
+********************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+
+#include "gviewv4l2core.h"
+#include "v4l2_core.h"
+#include "core_time.h"
+#include "latency_stats.h"
+#include "gview.h"
+
+/*
+ * log-linear histogram buckets (HDR style):
+ *   values below LATENCY_SUB_COUNT get their own bucket,
+ *   every power of two above that is split in LATENCY_SUB_COUNT
+ *   linear sub-buckets (~6% precision over the full 64 bit range)
+ */
+#define LATENCY_SUB_BITS  (4)
+#define LATENCY_SUB_COUNT (1 << LATENCY_SUB_BITS)
+#define LATENCY_BUCKETS   ((64 - LATENCY_SUB_BITS + 1) * LATENCY_SUB_COUNT)
+
+typedef struct _latency_hist_t
+{
+	uint64_t count;                     //number of recorded values
+	uint64_t sum;                       //sum of recorded values (ns)
+	uint64_t min;                       //minimum recorded value (ns)
+	uint64_t max;                       //maximum recorded value (ns)
+	uint64_t buckets[LATENCY_BUCKETS];  //value counts
+} latency_hist_t;
+
+struct _latency_stats_t
+{
+	__MUTEX_TYPE mutex;                 //stages are recorded from several threads
+	latency_hist_t hist[LATENCY_STAGES];
+};
+
+static const char *stage_names[LATENCY_STAGES] =
+{
+	"dqbuf",
+	"decode",
+	"autofocus",
+	"render",
+	"qbuf"
+};
+
+/*
+ * get the bucket index for a value
+ * args:
+ *   value - latency value (ns)
+ *
+ * asserts:
+ *   none
+ *
+ * returns: bucket index
+ */
+static int bucket_index(uint64_t value)
+{
+	if(value < LATENCY_SUB_COUNT)
+		return (int) value;
+
+	int msb = 63 - __builtin_clzll(value);
+
+	return (msb - LATENCY_SUB_BITS + 1) * LATENCY_SUB_COUNT +
+		(int) ((value >> (msb - LATENCY_SUB_BITS)) & (LATENCY_SUB_COUNT - 1));
+}
+
+/*
+ * get the highest value that falls in a bucket
+ * args:
+ *   index - bucket index
+ *
+ * asserts:
+ *   none
+ *
+ * returns: bucket upper bound (ns)
+ */
+static uint64_t bucket_upper_value(int index)
+{
+	if(index < LATENCY_SUB_COUNT)
+		return (uint64_t) index;
+
+	int mag = index / LATENCY_SUB_COUNT;
+	int sub = index % LATENCY_SUB_COUNT;
+
+	uint64_t width = ((uint64_t) 1) << (mag - 1);
+
+	return ((uint64_t) (LATENCY_SUB_COUNT + sub) << (mag - 1)) + width - 1;
+}
+
+/*
+ * get the value at percentile p of a histogram
+ *   (must be called with the stats mutex locked)
+ * args:
+ *   hist - pointer to histogram
+ *   p - percentile [0.0 - 1.0]
+ *
+ * asserts:
+ *   none
+ *
+ * returns: value at percentile p (ns)
+ */
+static uint64_t hist_percentile(latency_hist_t *hist, double p)
+{
+	if(hist->count == 0)
+		return 0;
+
+	uint64_t target = (uint64_t) (p * (double) hist->count + 0.5);
+	if(target < 1)
+		target = 1;
+
+	uint64_t total = 0;
+	int i = 0;
+	for(i = 0; i < LATENCY_BUCKETS; ++i)
+	{
+		total += hist->buckets[i];
+		if(total >= target)
+		{
+			uint64_t value = bucket_upper_value(i);
+			return (value > hist->max) ? hist->max : value;
+		}
+	}
+
+	return hist->max;
+}
+
+/*
+ * allocate a new set of latency histograms (one per stage)
+ * args:
+ *   none
+ *
+ * asserts:
+ *   none
+ *
+ * returns: pointer to latency histograms
+ */
+latency_stats_t *latency_stats_new()
+{
+	latency_stats_t *ls = calloc(1, sizeof(latency_stats_t));
+	if(ls == NULL)
+	{
+		fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (latency_stats_new): %s\n", strerror(errno));
+		exit(-1);
+	}
+
+	__INIT_MUTEX(&ls->mutex);
+
+	latency_stats_reset(ls);
+
+	return ls;
+}
+
+/*
+ * free the latency histograms
+ * args:
+ *   ls - pointer to latency histograms
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+void latency_stats_delete(latency_stats_t *ls)
+{
+	if(ls == NULL)
+		return;
+
+	__CLOSE_MUTEX(&ls->mutex);
+	free(ls);
+}
+
+/*
+ * clear all latency histograms
+ * args:
+ *   ls - pointer to latency histograms
+ *
+ * asserts:
+ *   ls is not null
+ *
+ * returns: none
+ */
+void latency_stats_reset(latency_stats_t *ls)
+{
+	/*assertions*/
+	assert(ls != NULL);
+
+	__LOCK_MUTEX(&ls->mutex);
+	memset(ls->hist, 0, sizeof(ls->hist));
+	int i = 0;
+	for(i = 0; i < LATENCY_STAGES; ++i)
+		ls->hist[i].min = UINT64_MAX;
+	__UNLOCK_MUTEX(&ls->mutex);
+}
+
+/*
+ * get the start timestamp for a stage measurement
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   none
+ *
+ * returns: monotonic time in ns (0 if latency stats are disabled)
+ */
+uint64_t latency_stats_start(v4l2_dev_t *vd)
+{
+	if(!vd->latency_enabled)
+		return 0;
+
+	return ns_time_monotonic();
+}
+
+/*
+ * record the stage latency measured from start
+ * args:
+ *   vd - pointer to video device data
+ *   stage - latency stage (LATENCY_DQBUF, ...)
+ *   start - start timestamp from latency_stats_start
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+void latency_stats_stop(v4l2_dev_t *vd, int stage, uint64_t start)
+{
+	if(start == 0 || !vd->latency_enabled || vd->latency == NULL)
+		return;
+
+	uint64_t now = ns_time_monotonic();
+	if(now < start)
+		return;
+
+	latency_stats_record(vd->latency, stage, now - start);
+}
+
+/*
+ * add a latency value to a stage histogram
+ * args:
+ *   ls - pointer to latency histograms
+ *   stage - latency stage (LATENCY_DQBUF, ...)
+ *   value - latency in ns
+ *
+ * asserts:
+ *   ls is not null
+ *
+ * returns: none
+ */
+void latency_stats_record(latency_stats_t *ls, int stage, uint64_t value)
+{
+	/*assertions*/
+	assert(ls != NULL);
+
+	if(stage < 0 || stage >= LATENCY_STAGES)
+		return;
+
+	latency_hist_t *hist = &ls->hist[stage];
+
+	__LOCK_MUTEX(&ls->mutex);
+	hist->count++;
+	hist->sum += value;
+	if(value < hist->min)
+		hist->min = value;
+	if(value > hist->max)
+		hist->max = value;
+	hist->buckets[bucket_index(value)]++;
+	__UNLOCK_MUTEX(&ls->mutex);
+}
+
+/*
+ * get the latency summary for a stage
+ * args:
+ *   ls - pointer to latency histograms
+ *   stage - latency stage (LATENCY_DQBUF, ...)
+ *   stats - pointer to stats struct to fill
+ *
+ * asserts:
+ *   ls is not null
+ *   stats is not null
+ *
+ * returns: none
+ */
+void latency_stats_get(latency_stats_t *ls, int stage, v4l2_latency_stats_t *stats)
+{
+	/*assertions*/
+	assert(ls != NULL);
+	assert(stats != NULL);
+
+	memset(stats, 0, sizeof(v4l2_latency_stats_t));
+
+	if(stage < 0 || stage >= LATENCY_STAGES)
+		return;
+
+	latency_hist_t *hist = &ls->hist[stage];
+
+	__LOCK_MUTEX(&ls->mutex);
+	if(hist->count > 0)
+	{
+		stats->count = hist->count;
+		stats->min = hist->min;
+		stats->max = hist->max;
+		stats->mean = hist->sum / hist->count;
+		stats->p50 = hist_percentile(hist, 0.50);
+		stats->p99 = hist_percentile(hist, 0.99);
+		stats->p999 = hist_percentile(hist, 0.999);
+	}
+	__UNLOCK_MUTEX(&ls->mutex);
+}
+
+/*
+ * print the latency summary of all stages to stdout
+ * args:
+ *   ls - pointer to latency histograms
+ *
+ * asserts:
+ *   ls is not null
+ *
+ * returns: none
+ */
+void latency_stats_print(latency_stats_t *ls)
+{
+	/*assertions*/
+	assert(ls != NULL);
+
+	printf("V4L2_CORE: latency (us)   count      min      p50      p99     p999      max\n");
+
+	int i = 0;
+	for(i = 0; i < LATENCY_STAGES; ++i)
+	{
+		v4l2_latency_stats_t stats;
+		latency_stats_get(ls, i, &stats);
+
+		if(stats.count == 0)
+			continue;
+
+		printf("V4L2_CORE:  %-10s %10"PRIu64" %8.1f %8.1f %8.1f %8.1f %8.1f\n",
+			stage_names[i], stats.count,
+			stats.min / 1000.0, stats.p50 / 1000.0, stats.p99 / 1000.0,
+			stats.p999 / 1000.0, stats.max / 1000.0);
+	}
+}
@@ -0,0 +1,133 @@
+/*******************************************************************************#
+#           guvcview              http://guvcview.sourceforge.net               #
+#                                                                               #
+#           Paulo Assis <pj.assis@gmail.com>                                    #
+#                                                                               #
+# This program is free software; you can redistribute it and/or modify          #
+# it under the terms of the GNU General Public License as published by          #
+# the Free Software Foundation; either version 2 of the License, or             #
+# (at your option) any later version.                                           #
+#                                                                               #
+# This program is distributed in the hope that it will be useful,               #
+# but WITHOUT ANY WARRANTY; without even the implied warranty of                #
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 #
+# GNU General Public License for more details.                                  #
+#                                                                               #
+# You should have received a copy of the GNU General Public License             #
+# along with this program; if not, write to the Free Software                   #
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA     #
+#                                                                               #
+********************************************************************************/
+
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#include "gviewv4l2core.h"
+#include "v4l2_core.h"
+
+typedef struct _latency_stats_t latency_stats_t;
+
+/*
+ * allocate a new set of latency histograms (one per stage)
+ * args:
+ *   none
+ *
+ * asserts:
+ *   none
+ *
+ * returns: pointer to latency histograms
+ */
+latency_stats_t *latency_stats_new();
+
+/*
+ * free the latency histograms
+ * args:
+ *   ls - pointer to latency histograms
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+void latency_stats_delete(latency_stats_t *ls);
+
+/*
+ * clear all latency histograms
+ * args:
+ *   ls - pointer to latency histograms
+ *
+ * asserts:
+ *   ls is not null
+ *
+ * returns: none
+ */
+void latency_stats_reset(latency_stats_t *ls);
+
+/*
+ * get the start timestamp for a stage measurement
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   none
+ *
+ * returns: monotonic time in ns (0 if latency stats are disabled)
+ */
+uint64_t latency_stats_start(v4l2_dev_t *vd);
+
+/*
+ * record the stage latency measured from start
+ * args:
+ *   vd - pointer to video device data
+ *   stage - latency stage (LATENCY_DQBUF, ...)
+ *   start - start timestamp from latency_stats_start
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+void latency_stats_stop(v4l2_dev_t *vd, int stage, uint64_t start);
+
+/*
+ * add a latency value to a stage histogram
+ * args:
+ *   ls - pointer to latency histograms
+ *   stage - latency stage (LATENCY_DQBUF, ...)
+ *   value - latency in ns
+ *
+ * asserts:
+ *   ls is not null
+ *
+ * returns: none
+ */
+void latency_stats_record(latency_stats_t *ls, int stage, uint64_t value);
+
+/*
+ * get the latency summary for a stage
+ * args:
+ *   ls - pointer to latency histograms
+ *   stage - latency stage (LATENCY_DQBUF, ...)
+ *   stats - pointer to stats struct to fill
+ *
+ * asserts:
+ *   ls is not null
+ *   stats is not null
+ *
+ * returns: none
+ */
+void latency_stats_get(latency_stats_t *ls, int stage, v4l2_latency_stats_t *stats);
+
+/*
+ * print the latency summary of all stages to stdout
+ * args:
+ *   ls - pointer to latency histograms
+ *
+ * asserts:
+ *   ls is not null
+ *
+ * returns: none
+ */
+void latency_stats_print(latency_stats_t *ls);
+
+#endif
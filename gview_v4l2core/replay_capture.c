@@ -0,0 +1,591 @@
+/*******************************************************************************#
+#           guvcview              http://guvcview.sourceforge.net               #
+#                                                                               #
+#           Paulo Assis <pj.assis@gmail.com>                                    #
+#                                                                               #
+# This program is free software; you can redistribute it and/or modify          #
+# it under the terms of the GNU General Public License as published by          #
+# the Free Software Foundation; either version 2 of the License, or             #
+# (at your option) any later version.                                           #
+#                                                                               #
+# This program is distributed in the hope that it will be useful,               #
+# but WITHOUT ANY WARRANTY; without even the implied warranty of                #
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 #
+# GNU General Public License for more details.                                  #
+#                                                                               #
+# You should have received a copy of the GNU General Public License             #
+# along with this program; if not, write to the Free Software                   #
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA     #
+#                                                                               #
+********************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+
+#include "gviewv4l2core.h"
+#include "v4l2_core.h"
+#include "v4l2_formats.h"
+#include "core_time.h"
+#include "replay_capture.h"
+#include "gview.h"
+
+extern int verbosity;
+
+/*file header: magic + 6 uint32 fields*/
+#define REPLAY_MAGIC_SIZE (8)
+#define REPLAY_HEADER_FIELDS (6)
+
+struct _replay_t
+{
+	FILE *file;                         //replay file
+	int flags;                          //REPLAY_TIMED | REPLAY_LOOP
+
+	uint32_t pixelformat;               //recorded pixel format
+	uint32_t width;                     //recorded width
+	uint32_t height;                    //recorded height
+	uint32_t fps_num;                   //recorded fps numerator
+	uint32_t fps_denom;                 //recorded fps denominator
+
+	long data_offset;                   //file offset of the first frame
+
+	int has_next;                       //set to 1 if the next frame header was read
+	uint64_t next_ts;                   //recorded timestamp of the next frame
+	uint32_t next_size;                 //size of the next frame
+
+	uint64_t ref_ts;                    //recorded timestamp matching start_ts
+	uint64_t start_ts;                  //monotonic time at which ref_ts is due (0 - not set)
+	uint32_t sequence;                  //replayed frame counter
+	int eof;                            //set to 1 at end of file (not looping)
+};
+
+/*
+ * read the next frame header (if not yet read)
+ * args:
+ *   replay - pointer to replay data
+ *
+ * asserts:
+ *   none
+ *
+ * returns: 1 if a frame is available, 0 at end of file
+ */
+static int read_next_header(replay_t *replay)
+{
+	if(replay->has_next)
+		return 1;
+
+	int loops = 0;
+	while(loops < 2)
+	{
+		uint64_t ts = 0;
+		uint32_t fields[2] = {0, 0}; /*size, reserved*/
+
+		if(fread(&ts, sizeof(uint64_t), 1, replay->file) == 1 &&
+			fread(fields, sizeof(uint32_t), 2, replay->file) == 2)
+		{
+			replay->next_ts = ts;
+			replay->next_size = fields[0];
+			replay->has_next = 1;
+			replay->eof = 0;
+			return 1;
+		}
+
+		if(!(replay->flags & REPLAY_LOOP))
+			break;
+
+		/*restart from the first frame*/
+		if(verbosity > 0)
+			printf("V4L2_CORE: (replay) end of file - restarting\n");
+		if(fseek(replay->file, replay->data_offset, SEEK_SET) != 0)
+			break;
+		clearerr(replay->file);
+		replay->start_ts = 0;
+		loops++;
+	}
+
+	replay->eof = 1;
+	return 0;
+}
+
+/*
+ * checks if a file is a replay file
+ * args:
+ *   filename - file name
+ *
+ * asserts:
+ *   filename is not null
+ *
+ * returns: 1 if it's a replay file, 0 otherwise
+ */
+int replay_check_file(const char *filename)
+{
+	/*assertions*/
+	assert(filename != NULL);
+
+	FILE *file = fopen(filename, "rb");
+	if(file == NULL)
+		return 0;
+
+	char magic[REPLAY_MAGIC_SIZE];
+	int ret = (fread(magic, 1, REPLAY_MAGIC_SIZE, file) == REPLAY_MAGIC_SIZE &&
+		memcmp(magic, REPLAY_MAGIC, REPLAY_MAGIC_SIZE) == 0);
+
+	fclose(file);
+
+	return ret;
+}
+
+/*
+ * open a replay file as the device frame source
+ *   sets the device stream format list (a single format,
+ *   resolution and frame rate) from the file header
+ * args:
+ *   vd - pointer to video device data
+ *   filename - replay file name
+ *
+ * asserts:
+ *   vd is not null
+ *   filename is not null
+ *
+ * returns: error code (0- E_OK)
+ */
+int replay_open(v4l2_dev_t *vd, const char *filename)
+{
+	/*assertions*/
+	assert(vd != NULL);
+	assert(filename != NULL);
+
+	FILE *file = fopen(filename, "rb");
+	if(file == NULL)
+	{
+		fprintf(stderr, "V4L2_CORE: (replay) couldn't open %s: %s\n", filename, strerror(errno));
+		return E_FILE_IO_ERR;
+	}
+
+	char magic[REPLAY_MAGIC_SIZE];
+	uint32_t fields[REPLAY_HEADER_FIELDS];
+
+	if(fread(magic, 1, REPLAY_MAGIC_SIZE, file) != REPLAY_MAGIC_SIZE ||
+		memcmp(magic, REPLAY_MAGIC, REPLAY_MAGIC_SIZE) != 0 ||
+		fread(fields, sizeof(uint32_t), REPLAY_HEADER_FIELDS, file) != REPLAY_HEADER_FIELDS)
+	{
+		fprintf(stderr, "V4L2_CORE: (replay) %s is not a replay file\n", filename);
+		fclose(file);
+		return E_FORMAT_ERR;
+	}
+
+	if(fields[0] != REPLAY_VERSION || fields[2] == 0 || fields[3] == 0)
+	{
+		fprintf(stderr, "V4L2_CORE: (replay) unsupported replay file (version %u, %ux%u)\n",
+			fields[0], fields[2], fields[3]);
+		fclose(file);
+		return E_FORMAT_ERR;
+	}
+
+	replay_t *replay = calloc(1, sizeof(replay_t));
+	if(replay == NULL)
+	{
+		fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (replay_open): %s\n", strerror(errno));
+		exit(-1);
+	}
+
+	replay->file = file;
+	replay->flags = REPLAY_TIMED;
+	replay->pixelformat = fields[1];
+	replay->width = fields[2];
+	replay->height = fields[3];
+	replay->fps_num = fields[4] > 0 ? fields[4] : 1;
+	replay->fps_denom = fields[5] > 0 ? fields[5] : 25;
+	replay->data_offset = ftell(file);
+
+	/*a single format, resolution and frame rate*/
+	vd->list_stream_formats = calloc(1, sizeof(v4l2_stream_formats_t));
+	if(vd->list_stream_formats == NULL)
+	{
+		fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (replay_open): %s\n", strerror(errno));
+		exit(-1);
+	}
+	vd->numb_formats = 1;
+
+	v4l2_stream_formats_t *format = &vd->list_stream_formats[0];
+	format->dec_support = can_decode_format(replay->pixelformat);
+	format->format = replay->pixelformat;
+	snprintf(format->fourcc, 5, "%c%c%c%c",
+		replay->pixelformat & 0xFF, (replay->pixelformat >> 8) & 0xFF,
+		(replay->pixelformat >> 16) & 0xFF, (replay->pixelformat >> 24) & 0xFF);
+	format->numb_res = 1;
+	format->list_stream_cap = calloc(1, sizeof(v4l2_stream_cap_t));
+	if(format->list_stream_cap == NULL)
+	{
+		fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (replay_open): %s\n", strerror(errno));
+		exit(-1);
+	}
+	format->list_stream_cap[0].width = replay->width;
+	format->list_stream_cap[0].height = replay->height;
+	format->list_stream_cap[0].numb_frates = 1;
+	format->list_stream_cap[0].framerate_num = calloc(1, sizeof(int));
+	format->list_stream_cap[0].framerate_denom = calloc(1, sizeof(int));
+	if(format->list_stream_cap[0].framerate_num == NULL ||
+		format->list_stream_cap[0].framerate_denom == NULL)
+	{
+		fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (replay_open): %s\n", strerror(errno));
+		exit(-1);
+	}
+	format->list_stream_cap[0].framerate_num[0] = replay->fps_num;
+	format->list_stream_cap[0].framerate_denom[0] = replay->fps_denom;
+
+	vd->fps_num = replay->fps_num;
+	vd->fps_denom = replay->fps_denom;
+
+	if(verbosity > 0)
+		printf("V4L2_CORE: (replay) %s: %s %ux%u (%u/%u)\n",
+			filename, format->fourcc, replay->width, replay->height,
+			replay->fps_num, replay->fps_denom);
+
+	if(!format->dec_support)
+		fprintf(stderr, "V4L2_CORE: (replay) format %s not supported by decoder\n", format->fourcc);
+
+	vd->replay = replay;
+
+	return E_OK;
+}
+
+/*
+ * close the replay file
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void replay_close(v4l2_dev_t *vd)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	if(vd->replay == NULL)
+		return;
+
+	if(vd->replay->file)
+		fclose(vd->replay->file);
+
+	free(vd->replay);
+	vd->replay = NULL;
+}
+
+/*
+ * set the replay flags
+ * args:
+ *   vd - pointer to video device data
+ *   flags - replay flags (REPLAY_TIMED | REPLAY_LOOP)
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void replay_set_flags(v4l2_dev_t *vd, int flags)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	if(vd->replay == NULL)
+		return;
+
+	vd->replay->flags = flags;
+	vd->replay->start_ts = 0;
+}
+
+/*
+ * resume the replay: the next frame is due now
+ *   (called on stream start)
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void replay_resume(v4l2_dev_t *vd)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	if(vd->replay == NULL)
+		return;
+
+	vd->replay->start_ts = 0;
+}
+
+/*
+ * get the time until the next frame is due
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: time in ns until next frame (0 - now; -1 - end of file)
+ */
+int64_t replay_next_frame_delay(v4l2_dev_t *vd)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	replay_t *replay = vd->replay;
+
+	if(replay == NULL || !read_next_header(replay))
+		return -1;
+
+	if(!(replay->flags & REPLAY_TIMED))
+		return 0;
+
+	uint64_t now = ns_time_monotonic();
+
+	/*first frame after open, resume or loop is due now*/
+	if(replay->start_ts == 0 || replay->next_ts < replay->ref_ts)
+	{
+		replay->start_ts = now;
+		replay->ref_ts = replay->next_ts;
+		return 0;
+	}
+
+	uint64_t due = replay->start_ts + (replay->next_ts - replay->ref_ts);
+
+	return (due > now) ? (int64_t) (due - now) : 0;
+}
+
+/*
+ * check for the end of the replay file
+ *   (a looping replay only ends if the file has no frames)
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: 1 at end of file, 0 otherwise
+ */
+int replay_is_eof(v4l2_dev_t *vd)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	return (vd->replay != NULL && vd->replay->eof) ? 1 : 0;
+}
+
+/*
+ * read the next frame from the replay file
+ *   (must be called with the device mutex locked)
+ * args:
+ *   vd - pointer to video device data
+ *   buffer - frame data buffer
+ *   size - buffer size
+ *   buf - v4l2 buffer to fill (bytesused and sequence)
+ *
+ * asserts:
+ *   vd is not null
+ *   buffer is not null
+ *   buf is not null
+ *
+ * returns: error code (0- E_OK; E_NO_DATA at end of file)
+ */
+int replay_read_frame(v4l2_dev_t *vd, uint8_t *buffer, size_t size, struct v4l2_buffer *buf)
+{
+	/*assertions*/
+	assert(vd != NULL);
+	assert(buffer != NULL);
+	assert(buf != NULL);
+
+	replay_t *replay = vd->replay;
+
+	if(replay == NULL || !read_next_header(replay))
+		return E_NO_DATA;
+
+	replay->has_next = 0;
+
+	size_t frame_size = replay->next_size;
+	if(frame_size > size)
+	{
+		fprintf(stderr, "V4L2_CORE: (replay) clipping frame of %u bytes (max %u)\n",
+			replay->next_size, (unsigned int) size);
+		frame_size = size;
+	}
+
+	if(fread(buffer, 1, frame_size, replay->file) != frame_size ||
+		(frame_size < replay->next_size &&
+			fseek(replay->file, replay->next_size - frame_size, SEEK_CUR) != 0))
+	{
+		fprintf(stderr, "V4L2_CORE: (replay) truncated frame\n");
+		return E_NO_DATA;
+	}
+
+	buf->bytesused = frame_size;
+	buf->sequence = replay->sequence++;
+
+	return E_OK;
+}
+
+/*
+ * start recording the raw frames of the stream to a replay file
+ * args:
+ *   vd - pointer to video device data
+ *   filename - replay file name
+ *
+ * asserts:
+ *   vd is not null
+ *   filename is not null
+ *
+ * returns: error code (0- E_OK)
+ */
+int replay_record_start(v4l2_dev_t *vd, const char *filename)
+{
+	/*assertions*/
+	assert(vd != NULL);
+	assert(filename != NULL);
+
+	if(vd->format.fmt.pix.width == 0 || vd->format.fmt.pix.height == 0)
+	{
+		fprintf(stderr, "V4L2_CORE: (replay record) stream format must be set first\n");
+		return E_FORMAT_ERR;
+	}
+
+	FILE *file = fopen(filename, "wb");
+	if(file == NULL)
+	{
+		fprintf(stderr, "V4L2_CORE: (replay record) couldn't open %s: %s\n", filename, strerror(errno));
+		return E_FILE_IO_ERR;
+	}
+
+	replay_t *record = calloc(1, sizeof(replay_t));
+	if(record == NULL)
+	{
+		fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (replay_record_start): %s\n", strerror(errno));
+		exit(-1);
+	}
+
+	record->file = file;
+	/*
+	 * use the requested format since it may differ
+	 * from format.fmt.pix.pixelformat (muxed H264)
+	 */
+	record->pixelformat = vd->requested_fmt;
+	record->width = vd->format.fmt.pix.width;
+	record->height = vd->format.fmt.pix.height;
+	record->fps_num = vd->fps_num;
+	record->fps_denom = vd->fps_denom;
+
+	uint32_t fields[REPLAY_HEADER_FIELDS] =
+	{
+		REPLAY_VERSION,
+		record->pixelformat,
+		record->width,
+		record->height,
+		record->fps_num,
+		record->fps_denom
+	};
+
+	if(fwrite(REPLAY_MAGIC, 1, REPLAY_MAGIC_SIZE, file) != REPLAY_MAGIC_SIZE ||
+		fwrite(fields, sizeof(uint32_t), REPLAY_HEADER_FIELDS, file) != REPLAY_HEADER_FIELDS)
+	{
+		fprintf(stderr, "V4L2_CORE: (replay record) couldn't write to %s: %s\n", filename, strerror(errno));
+		fclose(file);
+		free(record);
+		return E_FILE_IO_ERR;
+	}
+
+	__LOCK_MUTEX( &vd->mutex );
+	replay_t *old = vd->replay_record;
+	vd->replay_record = record;
+	__UNLOCK_MUTEX( &vd->mutex );
+
+	if(old != NULL)
+	{
+		fclose(old->file);
+		free(old);
+	}
+
+	if(verbosity > 0)
+		printf("V4L2_CORE: (replay record) recording raw frames to %s\n", filename);
+
+	return E_OK;
+}
+
+/*
+ * add a raw frame to the replay file being recorded
+ *   (must be called with the device mutex locked)
+ * args:
+ *   vd - pointer to video device data
+ *   frame - pointer to frame buffer
+ *
+ * asserts:
+ *   vd is not null
+ *   frame is not null
+ *
+ * returns: none
+ */
+void replay_record_frame(v4l2_dev_t *vd, v4l2_frame_buff_t *frame)
+{
+	/*assertions*/
+	assert(vd != NULL);
+	assert(frame != NULL);
+
+	replay_t *record = vd->replay_record;
+
+	if(record == NULL || frame->raw_frame == NULL || frame->raw_frame_size == 0)
+		return;
+
+	/*the file header only describes the format it was started with*/
+	if(record->pixelformat != (uint32_t) vd->requested_fmt ||
+		record->width != vd->format.fmt.pix.width ||
+		record->height != vd->format.fmt.pix.height)
+	{
+		if(verbosity > 1)
+			printf("V4L2_CORE: (replay record) format changed - frame not recorded\n");
+		return;
+	}
+
+	uint64_t ts = frame->timestamp;
+	uint32_t fields[2] = {(uint32_t) frame->raw_frame_size, 0}; /*size, reserved*/
+
+	if(fwrite(&ts, sizeof(uint64_t), 1, record->file) != 1 ||
+		fwrite(fields, sizeof(uint32_t), 2, record->file) != 2 ||
+		fwrite(frame->raw_frame, 1, frame->raw_frame_size, record->file) != frame->raw_frame_size)
+		fprintf(stderr, "V4L2_CORE: (replay record) write error: %s\n", strerror(errno));
+}
+
+/*
+ * stop recording raw frames
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void replay_record_stop(v4l2_dev_t *vd)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	__LOCK_MUTEX( &vd->mutex );
+	replay_t *record = vd->replay_record;
+	vd->replay_record = NULL;
+	__UNLOCK_MUTEX( &vd->mutex );
+
+	if(record == NULL)
+		return;
+
+	fclose(record->file);
+	free(record);
+
+	if(verbosity > 0)
+		printf("V4L2_CORE: (replay record) recording stopped\n");
+}
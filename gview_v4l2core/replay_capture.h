@@ -0,0 +1,190 @@
+/*******************************************************************************#
+#           guvcview              http://guvcview.sourceforge.net               #
+#                                                                               #
+#           Paulo Assis <pj.assis@gmail.com>                                    #
+#                                                                               #
+# This program is free software; you can redistribute it and/or modify          #
+# it under the terms of the GNU General Public License as published by          #
+# the Free Software Foundation; either version 2 of the License, or             #
+# (at your option) any later version.                                           #
+#                                                                               #
+# This program is distributed in the hope that it will be useful,               #
+# but WITHOUT ANY WARRANTY; without even the implied warranty of                #
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 #
+# GNU General Public License for more details.                                  #
+#                                                                               #
+# You should have received a copy of the GNU General Public License             #
+# along with this program; if not, write to the Free Software                   #
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA     #
+#                                                                               #
+********************************************************************************/
+
+#ifndef REPLAY_CAPTURE_H
+#define REPLAY_CAPTURE_H
+
+#include "gviewv4l2core.h"
+#include "v4l2_core.h"
+
+/*
+ * replay file layout (host byte order):
+ *   header: "GVREPLAY" magic, then uint32 version, pixelformat,
+ *           width, height, fps numerator and fps denominator
+ *   frames: uint64 capture timestamp (ns), uint32 size,
+ *           uint32 reserved (0), followed by size bytes of raw frame data
+ */
+#define REPLAY_MAGIC "GVREPLAY"
+#define REPLAY_VERSION (1)
+
+typedef struct _replay_t replay_t;
+
+/*
+ * checks if a file is a replay file
+ * args:
+ *   filename - file name
+ *
+ * asserts:
+ *   filename is not null
+ *
+ * returns: 1 if it's a replay file, 0 otherwise
+ */
+int replay_check_file(const char *filename);
+
+/*
+ * open a replay file as the device frame source
+ *   sets the device stream format list (a single format,
+ *   resolution and frame rate) from the file header
+ * args:
+ *   vd - pointer to video device data
+ *   filename - replay file name
+ *
+ * asserts:
+ *   vd is not null
+ *   filename is not null
+ *
+ * returns: error code (0- E_OK)
+ */
+int replay_open(v4l2_dev_t *vd, const char *filename);
+
+/*
+ * close the replay file
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void replay_close(v4l2_dev_t *vd);
+
+/*
+ * set the replay flags
+ * args:
+ *   vd - pointer to video device data
+ *   flags - replay flags (REPLAY_TIMED | REPLAY_LOOP)
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void replay_set_flags(v4l2_dev_t *vd, int flags);
+
+/*
+ * resume the replay: the next frame is due now
+ *   (called on stream start)
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void replay_resume(v4l2_dev_t *vd);
+
+/*
+ * get the time until the next frame is due
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: time in ns until next frame (0 - now; -1 - end of file)
+ */
+int64_t replay_next_frame_delay(v4l2_dev_t *vd);
+
+/*
+ * check for the end of the replay file
+ *   (a looping replay only ends if the file has no frames)
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: 1 at end of file, 0 otherwise
+ */
+int replay_is_eof(v4l2_dev_t *vd);
+
+/*
+ * read the next frame from the replay file
+ *   (must be called with the device mutex locked)
+ * args:
+ *   vd - pointer to video device data
+ *   buffer - frame data buffer
+ *   size - buffer size
+ *   buf - v4l2 buffer to fill (bytesused and sequence)
+ *
+ * asserts:
+ *   vd is not null
+ *   buffer is not null
+ *   buf is not null
+ *
+ * returns: error code (0- E_OK; E_NO_DATA at end of file)
+ */
+int replay_read_frame(v4l2_dev_t *vd, uint8_t *buffer, size_t size, struct v4l2_buffer *buf);
+
+/*
+ * start recording the raw frames of the stream to a replay file
+ * args:
+ *   vd - pointer to video device data
+ *   filename - replay file name
+ *
+ * asserts:
+ *   vd is not null
+ *   filename is not null
+ *
+ * returns: error code (0- E_OK)
+ */
+int replay_record_start(v4l2_dev_t *vd, const char *filename);
+
+/*
+ * add a raw frame to the replay file being recorded
+ *   (must be called with the device mutex locked)
+ * args:
+ *   vd - pointer to video device data
+ *   frame - pointer to frame buffer
+ *
+ * asserts:
+ *   vd is not null
+ *   frame is not null
+ *
+ * returns: none
+ */
+void replay_record_frame(v4l2_dev_t *vd, v4l2_frame_buff_t *frame);
+
+/*
+ * stop recording raw frames
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void replay_record_stop(v4l2_dev_t *vd);
+
+#endif
@@ -0,0 +1,653 @@
+/*******************************************************************************#
+#           guvcview              http://guvcview.sourceforge.net               #
+#                                                                               #
+#           Paulo Assis <pj.assis@gmail.com>                                    #
+#                                                                               #
+# This program is free software; you can redistribute it and/or modify          #
+# it under the terms of the GNU General Public License as published by          #
+# the Free Software Foundation; either version 2 of the License, or             #
+# (at your option) any later version.                                           #
+#                                                                               #
+# This program is distributed in the hope that it will be useful,               #
+# but WITHOUT ANY WARRANTY; without even the implied warranty of                #
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 #
+# GNU General Public License for more details.                                  #
+#                                                                               #
+# You should have received a copy of the GNU General Public License             #
+# along with this program; if not, write to the Free Software                   #
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA     #
+#                                                                               #
+********************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/types.h>
+#include <sys/syscall.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <png.h>
+
+#include "gviewv4l2core.h"
+#include "v4l2_core.h"
+#include "colorspaces.h"
+#include "frame_decoder.h"
+#include "gview.h"
+
+#include "turbojpeg.h"
+
+/*maximum number of images waiting to be encoded/written*/
+#define SAVE_IMAGE_MAX_QUEUE (4)
+/*quality used for jpeg encoding*/
+#define SAVE_IMAGE_JPG_QUALITY (90)
+
+extern int verbosity;
+
+/*
+ * image job:
+ *   a private copy of the frame data, so that the capture
+ *   buffer is released right away and encoding and file
+ *   writing happen on the writer thread
+ */
+typedef struct _image_job_t
+{
+	char *filename;
+	int format;      //IMG_FMT_RAW, IMG_FMT_JPG, IMG_FMT_PNG or IMG_FMT_BMP
+	int width;
+	int height;
+	int encoded;     //1 - data is already in the output format (written as is)
+	int matrix;      //yuv to rgb matrix (YUV_MATRIX_xxx)
+	int range;       //yuv to rgb range (YUV_RANGE_xxx)
+	int luma16_bits; //>0 - data is 16 bit luma (png only) with luma16_bits significant bits
+	uint8_t *data;
+	size_t size;
+	struct _image_job_t *next;
+} image_job_t;
+
+static __MUTEX_TYPE writer_mutex = __STATIC_MUTEX_INIT;
+static __COND_TYPE writer_cond = PTHREAD_COND_INITIALIZER;
+static __THREAD_TYPE writer_thread;
+static int writer_running = 0; //writer thread was started
+static int writer_quit = 0;    //writer thread should exit when the queue is empty
+static image_job_t *queue_head = NULL;
+static image_job_t *queue_tail = NULL;
+static int queue_size = 0;
+
+/*
+ * save data to file
+ * args:
+ *   filename - string with filename
+ *   data - pointer to data
+ *   size - data size in bytes = sizeof(uint8_t)
+ *
+ * asserts:
+ *   none
+ *
+ * returns: error code
+ */
+int v4l2core_save_data_to_file(const char *filename, uint8_t *data, int size)
+{
+	FILE *fp;
+	int ret = E_OK;
+
+	if((fp = fopen(filename, "wb")) != NULL)
+	{
+		if(fwrite(data, size, 1, fp) != 1)
+		{
+			fprintf(stderr, "V4L2_CORE: (save_data_to_file) couldn't write %s: %s\n", filename, strerror(errno));
+			ret = E_FILE_IO_ERR;
+		}
+		if(fclose(fp) != 0)
+			ret = E_FILE_IO_ERR;
+	}
+	else
+	{
+		fprintf(stderr, "V4L2_CORE: (save_data_to_file) couldn't open %s for write: %s\n", filename, strerror(errno));
+		ret = E_FILE_IO_ERR;
+	}
+
+	return ret;
+}
+
+/*
+ * check if a jpeg buffer carries its own huffman tables
+ *   (MJPEG frames usually don't and need the default ones)
+ * args:
+ *   data - pointer to jpeg data
+ *   size - data size
+ *
+ * asserts:
+ *   none
+ *
+ * returns: 1 if a DHT marker is found before the scan data; 0 otherwise
+ */
+static int jpeg_has_huffman_tables(const uint8_t *data, size_t size)
+{
+	size_t pos = 2; /*skip SOI*/
+
+	if(size < 4 || data[0] != 0xFF || data[1] != 0xD8)
+		return 0;
+
+	while(pos + 4 <= size)
+	{
+		if(data[pos] != 0xFF)
+			return 0;
+
+		uint8_t marker = data[pos + 1];
+		if(marker == 0xC4) /*DHT*/
+			return 1;
+		if(marker == 0xDA) /*SOS*/
+			return 0;
+
+		pos += 2 + ((data[pos + 2] << 8) | data[pos + 3]);
+	}
+
+	return 0;
+}
+
+/*
+ * convert the job yuv data to rgb (or bgr bottom-up for bitmaps)
+ * args:
+ *   job - pointer to image job
+ *   bmp - 1 for DIB24 (bgr, lines upside down); 0 for rgb24
+ *
+ * asserts:
+ *   none
+ *
+ * returns: pointer to newly allocated buffer (must free)
+ */
+static uint8_t *job_to_rgb(image_job_t *job, int bmp)
+{
+	uint8_t *rgb = malloc(job->width * job->height * 3);
+	if(rgb == NULL)
+	{
+		fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (save_image): %s\n", strerror(errno));
+		exit(-1);
+	}
+
+	int flags = bmp ? (CS_RGB_BGR | CS_RGB_FLIP) : 0;
+
+#ifdef USE_PLANAR_YUV
+	yu12_to_rgb(rgb, job->data, job->width, job->height, job->matrix, job->range, flags);
+#else
+	yuyv_to_rgb(rgb, job->data, job->width, job->height, job->matrix, job->range, flags);
+#endif
+
+	return rgb;
+}
+
+/*
+ * encode and save a jpeg image
+ * args:
+ *   tj - pointer to the writer turbojpeg compressor (created on first use)
+ *   job - pointer to image job
+ *
+ * asserts:
+ *   none
+ *
+ * returns: error code
+ */
+static int save_jpeg(tjhandle *tj, image_job_t *job)
+{
+	unsigned char *jpeg = NULL;
+	unsigned long jpeg_size = 0;
+	int ret = 0;
+
+	if(*tj == NULL && (*tj = tjInitCompress()) == NULL)
+	{
+		fprintf(stderr, "V4L2_CORE: (save_image) couldn't init jpeg encoder: %s\n", tjGetErrorStr());
+		return E_NO_CODEC;
+	}
+
+#ifdef USE_PLANAR_YUV
+	ret = tjCompressFromYUV(*tj, job->data, job->width, 1, job->height,
+		TJSAMP_420, &jpeg, &jpeg_size, SAVE_IMAGE_JPG_QUALITY, 0);
+#else
+	uint8_t *rgb = job_to_rgb(job, 0);
+	ret = tjCompress2(*tj, rgb, job->width, 0, job->height, TJPF_RGB,
+		&jpeg, &jpeg_size, TJSAMP_420, SAVE_IMAGE_JPG_QUALITY, 0);
+	free(rgb);
+#endif
+
+	if(ret < 0)
+	{
+		fprintf(stderr, "V4L2_CORE: (save_image) jpeg encoding failed: %s\n", tjGetErrorStr2(*tj));
+		if(jpeg)
+			tjFree(jpeg);
+		return E_UNKNOWN_ERR;
+	}
+
+	ret = v4l2core_save_data_to_file(job->filename, jpeg, (int) jpeg_size);
+
+	tjFree(jpeg);
+	return ret;
+}
+
+/*
+ * encode and save a png image
+ * args:
+ *   job - pointer to image job
+ *
+ * asserts:
+ *   none
+ *
+ * returns: error code
+ */
+static int save_png(image_job_t *job)
+{
+	FILE *fp = fopen(job->filename, "wb");
+	if(fp == NULL)
+	{
+		fprintf(stderr, "V4L2_CORE: (save_image) couldn't open %s for write: %s\n", job->filename, strerror(errno));
+		return E_FILE_IO_ERR;
+	}
+
+	png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+	png_infop info_ptr = png_ptr ? png_create_info_struct(png_ptr) : NULL;
+	if(info_ptr == NULL)
+	{
+		fprintf(stderr, "V4L2_CORE: (save_image) couldn't init png encoder\n");
+		png_destroy_write_struct(&png_ptr, NULL);
+		fclose(fp);
+		return E_NO_CODEC;
+	}
+
+	/*16 bit luma is saved as 16 bit grey, everything else as rgb*/
+	uint8_t *rgb = (job->luma16_bits > 0) ? NULL : job_to_rgb(job, 0);
+	png_bytep *rows = calloc(job->height, sizeof(png_bytep));
+	if(rows == NULL)
+	{
+		fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (save_png): %s\n", strerror(errno));
+		exit(-1);
+	}
+
+	int i = 0;
+	for(i = 0; i < job->height; i++)
+		rows[i] = (rgb != NULL) ? rgb + i * job->width * 3 : job->data + i * job->width * 2;
+
+	int ret = E_OK;
+	if(setjmp(png_jmpbuf(png_ptr)))
+	{
+		fprintf(stderr, "V4L2_CORE: (save_image) png encoding failed for %s\n", job->filename);
+		ret = E_FILE_IO_ERR;
+	}
+	else
+	{
+		png_init_io(png_ptr, fp);
+		/*speed over size: the default zlib level is too slow for large frames*/
+		png_set_compression_level(png_ptr, 1);
+		if(rgb != NULL)
+		{
+			png_set_IHDR(png_ptr, info_ptr, job->width, job->height, 8,
+				PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE,
+				PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+			png_write_info(png_ptr, info_ptr);
+		}
+		else
+		{
+			png_color_8 sig_bit;
+			memset(&sig_bit, 0, sizeof(png_color_8));
+			sig_bit.gray = job->luma16_bits;
+
+			png_set_IHDR(png_ptr, info_ptr, job->width, job->height, 16,
+				PNG_COLOR_TYPE_GRAY, PNG_INTERLACE_NONE,
+				PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+			png_set_sBIT(png_ptr, info_ptr, &sig_bit);
+			png_write_info(png_ptr, info_ptr);
+			/*samples are in the low bits and host (little endian) order*/
+			png_set_shift(png_ptr, &sig_bit);
+			png_set_swap(png_ptr);
+		}
+		png_write_image(png_ptr, rows);
+		png_write_end(png_ptr, info_ptr);
+	}
+
+	png_destroy_write_struct(&png_ptr, &info_ptr);
+	if(fclose(fp) != 0)
+		ret = E_FILE_IO_ERR;
+
+	free(rows);
+	free(rgb);
+	return ret;
+}
+
+/*
+ * store a little endian value in a byte buffer
+ * args:
+ *   p - pointer to buffer
+ *   val - value
+ *   n - number of bytes
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+static void put_le(uint8_t *p, uint32_t val, int n)
+{
+	int i = 0;
+	for(i = 0; i < n; i++)
+		p[i] = (val >> (8 * i)) & 0xff;
+}
+
+/*
+ * save a bitmap (DIB24) image
+ * args:
+ *   job - pointer to image job
+ *
+ * asserts:
+ *   none
+ *
+ * returns: error code
+ */
+static int save_bmp(image_job_t *job)
+{
+	int stride = (job->width * 3 + 3) & ~3; /*rows are 4 byte aligned*/
+	uint32_t image_size = stride * job->height;
+	uint8_t header[54];
+
+	memset(header, 0, sizeof(header));
+	/*BITMAPFILEHEADER*/
+	header[0] = 'B';
+	header[1] = 'M';
+	put_le(header + 2, sizeof(header) + image_size, 4);
+	put_le(header + 10, sizeof(header), 4);
+	/*BITMAPINFOHEADER*/
+	put_le(header + 14, 40, 4);
+	put_le(header + 18, job->width, 4);
+	put_le(header + 22, job->height, 4);
+	put_le(header + 26, 1, 2);
+	put_le(header + 28, 24, 2);
+	put_le(header + 34, image_size, 4);
+
+	uint8_t *bgr = job_to_rgb(job, 1);
+
+	FILE *fp = fopen(job->filename, "wb");
+	if(fp == NULL)
+	{
+		fprintf(stderr, "V4L2_CORE: (save_image) couldn't open %s for write: %s\n", job->filename, strerror(errno));
+		free(bgr);
+		return E_FILE_IO_ERR;
+	}
+
+	int ret = E_OK;
+	uint8_t pad[3] = {0, 0, 0};
+	int i = 0;
+
+	if(fwrite(header, sizeof(header), 1, fp) != 1)
+		ret = E_FILE_IO_ERR;
+	for(i = 0; i < job->height && ret == E_OK; i++)
+	{
+		if(fwrite(bgr + i * job->width * 3, job->width * 3, 1, fp) != 1 ||
+			(stride > job->width * 3 && fwrite(pad, stride - job->width * 3, 1, fp) != 1))
+			ret = E_FILE_IO_ERR;
+	}
+
+	if(fclose(fp) != 0)
+		ret = E_FILE_IO_ERR;
+
+	if(ret != E_OK)
+		fprintf(stderr, "V4L2_CORE: (save_image) couldn't write %s: %s\n", job->filename, strerror(errno));
+
+	free(bgr);
+	return ret;
+}
+
+/*
+ * free an image job
+ * args:
+ *   job - pointer to image job
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+static void free_job(image_job_t *job)
+{
+	free(job->filename);
+	free(job->data);
+	free(job);
+}
+
+/*
+ * image writer thread: encodes and writes the queued images
+ * args:
+ *   data - not used
+ *
+ * asserts:
+ *   none
+ *
+ * returns: NULL
+ */
+static void *image_writer_thread(void *data)
+{
+	(void) data;
+
+	tjhandle tj = NULL;
+
+	if(verbosity > 1)
+		printf("V4L2_CORE: image writer thread (tid: %u)\n",
+			(unsigned int) syscall (SYS_gettid));
+
+	__LOCK_MUTEX(&writer_mutex);
+	while(1)
+	{
+		while(queue_head == NULL && !writer_quit)
+			__COND_WAIT(&writer_cond, &writer_mutex);
+
+		if(queue_head == NULL)
+			break; /*quit with an empty queue*/
+
+		image_job_t *job = queue_head;
+		queue_head = job->next;
+		if(queue_head == NULL)
+			queue_tail = NULL;
+		queue_size--;
+		__UNLOCK_MUTEX(&writer_mutex);
+
+		int ret = E_OK;
+		if(job->encoded)
+			ret = v4l2core_save_data_to_file(job->filename, job->data, (int) job->size);
+		else switch(job->format)
+		{
+			case IMG_FMT_JPG:
+				ret = save_jpeg(&tj, job);
+				break;
+			case IMG_FMT_PNG:
+				ret = save_png(job);
+				break;
+			case IMG_FMT_BMP:
+				ret = save_bmp(job);
+				break;
+		}
+
+		if(verbosity > 0 && ret == E_OK)
+			printf("V4L2_CORE: saved image to %s\n", job->filename);
+
+		free_job(job);
+
+		__LOCK_MUTEX(&writer_mutex);
+	}
+	__UNLOCK_MUTEX(&writer_mutex);
+
+	if(tj)
+		tjDestroy(tj);
+
+	return NULL;
+}
+
+/*
+ * save the frame to an image file
+ *   the frame data is copied and queued: encoding and
+ *   writing are done asynchronously by the image writer
+ *   thread, so the frame can be released right away
+ * args:
+ *    vd - pointer to video device data
+ *    frame - pointer to frame buffer
+ *    filename - output file name
+ *    format - image type
+ *           (IMG_FMT_RAW, IMG_FMT_JPG, IMG_FMT_PNG, IMG_FMT_BMP)
+ *
+ * asserts:
+ *    vd is not null
+ *    frame is not null
+ *    filename is not null
+ *
+ * returns: error code
+ */
+int v4l2core_dev_save_image(v4l2_dev_t *vd, v4l2_frame_buff_t *frame, const char *filename, int format)
+{
+	/*assertions*/
+	assert(vd != NULL);
+	assert(frame != NULL);
+	assert(filename != NULL);
+
+	int width = vd->format.fmt.pix.width;
+	int height = vd->format.fmt.pix.height;
+
+	image_job_t *job = calloc(1, sizeof(image_job_t));
+	if(job == NULL)
+	{
+		fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (v4l2core_save_image): %s\n", strerror(errno));
+		exit(-1);
+	}
+
+	job->format = format;
+	job->width = width;
+	job->height = height;
+	get_yuv_colorimetry(vd, &job->matrix, &job->range);
+
+	uint8_t *src = NULL;
+	switch(format)
+	{
+		case IMG_FMT_RAW:
+			src = frame->raw_frame;
+			job->size = frame->raw_frame_size;
+			job->encoded = 1;
+			break;
+
+		case IMG_FMT_JPG:
+			/*complete jpeg frames from the device are stored as is*/
+			if((vd->requested_fmt == V4L2_PIX_FMT_MJPEG || vd->requested_fmt == V4L2_PIX_FMT_JPEG) &&
+				jpeg_has_huffman_tables(frame->raw_frame, frame->raw_frame_size))
+			{
+				src = frame->raw_frame;
+				job->size = frame->raw_frame_size;
+				job->encoded = 1;
+				break;
+			}
+			/*fall through*/
+		case IMG_FMT_PNG:
+			/*16 bit luma mode: keep the full precision*/
+			if(format == IMG_FMT_PNG && frame->luma16_frame != NULL && frame->luma16_bits > 0)
+			{
+				src = (uint8_t *) frame->luma16_frame;
+				job->size = width * height * sizeof(uint16_t);
+				job->luma16_bits = frame->luma16_bits;
+				break;
+			}
+			/*fall through*/
+		case IMG_FMT_BMP:
+			src = frame->yuv_frame;
+#ifdef USE_PLANAR_YUV
+			job->size = width * height * 3 / 2;
+#else
+			job->size = width * height * 2;
+#endif
+			break;
+
+		default:
+			fprintf(stderr, "V4L2_CORE: (save_image) unknown image format %i\n", format);
+			free(job);
+			return E_FORMAT_ERR;
+	}
+
+	if(src == NULL || job->size == 0)
+	{
+		fprintf(stderr, "V4L2_CORE: (save_image) no frame data to save\n");
+		free(job);
+		return E_NO_DATA;
+	}
+
+	__LOCK_MUTEX(&writer_mutex);
+	int full = (queue_size >= SAVE_IMAGE_MAX_QUEUE);
+	__UNLOCK_MUTEX(&writer_mutex);
+
+	if(full)
+	{
+		fprintf(stderr, "V4L2_CORE: (save_image) image writer is busy - dropping %s\n", filename);
+		free(job);
+		return E_FILE_IO_ERR;
+	}
+
+	job->data = malloc(job->size);
+	job->filename = strdup(filename);
+	if(job->data == NULL || job->filename == NULL)
+	{
+		fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (v4l2core_save_image): %s\n", strerror(errno));
+		exit(-1);
+	}
+	memcpy(job->data, src, job->size);
+
+	__LOCK_MUTEX(&writer_mutex);
+	if(!writer_running)
+	{
+		writer_quit = 0;
+		if(__THREAD_CREATE(&writer_thread, image_writer_thread, NULL) != 0)
+		{
+			__UNLOCK_MUTEX(&writer_mutex);
+			fprintf(stderr, "V4L2_CORE: (save_image) couldn't start the image writer thread\n");
+			free_job(job);
+			return E_UNKNOWN_ERR;
+		}
+		writer_running = 1;
+	}
+
+	if(queue_tail)
+		queue_tail->next = job;
+	else
+		queue_head = job;
+	queue_tail = job;
+	queue_size++;
+
+	__COND_BCAST(&writer_cond);
+	__UNLOCK_MUTEX(&writer_mutex);
+
+	return E_OK;
+}
+
+/*
+ * wait for all queued images to be written and
+ *   stop the image writer thread
+ * args:
+ *   none
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+void v4l2core_save_image_flush()
+{
+	__LOCK_MUTEX(&writer_mutex);
+	if(!writer_running)
+	{
+		__UNLOCK_MUTEX(&writer_mutex);
+		return;
+	}
+
+	/*the writer thread exits once the queue is empty*/
+	writer_quit = 1;
+	__COND_BCAST(&writer_cond);
+	__UNLOCK_MUTEX(&writer_mutex);
+
+	__THREAD_JOIN(writer_thread);
+
+	__LOCK_MUTEX(&writer_mutex);
+	writer_running = 0;
+	writer_quit = 0;
+	__UNLOCK_MUTEX(&writer_mutex);
+}
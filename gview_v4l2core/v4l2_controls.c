@@ -573,7 +573,7 @@ static void update_ctrl_flags(v4l2_dev_t *vd, int id)
     {
         case V4L2_CID_EXPOSURE_AUTO:
             {
-                v4l2_ctrl_t *ctrl_this = v4l2core_get_control_by_id(id);
+                v4l2_ctrl_t *ctrl_this = get_control_by_id(vd, id);
                 if(ctrl_this == NULL)
                     break;
 
@@ -581,16 +581,16 @@ static void update_ctrl_flags(v4l2_dev_t *vd, int id)
                 {
                     case V4L2_EXPOSURE_AUTO:
                         {
-                            v4l2_ctrl_t *ctrl_that = v4l2core_get_control_by_id(
+                            v4l2_ctrl_t *ctrl_that = get_control_by_id(vd,
                                 V4L2_CID_IRIS_ABSOLUTE );
                             if (ctrl_that)
                                 ctrl_that->control.flags |= V4L2_CTRL_FLAG_GRABBED;
 
-                            ctrl_that = v4l2core_get_control_by_id(
+                            ctrl_that = get_control_by_id(vd,
                                 V4L2_CID_IRIS_RELATIVE );
                             if (ctrl_that)
                                 ctrl_that->control.flags |= V4L2_CTRL_FLAG_GRABBED;
-                            ctrl_that = v4l2core_get_control_by_id(
+                            ctrl_that = get_control_by_id(vd,
                                 V4L2_CID_EXPOSURE_ABSOLUTE );
                             if (ctrl_that)
                                 ctrl_that->control.flags |= V4L2_CTRL_FLAG_GRABBED;
@@ -599,15 +599,15 @@ static void update_ctrl_flags(v4l2_dev_t *vd, int id)
 
                     case V4L2_EXPOSURE_APERTURE_PRIORITY:
                         {
-                            v4l2_ctrl_t *ctrl_that = v4l2core_get_control_by_id(
+                            v4l2_ctrl_t *ctrl_that = get_control_by_id(vd,
                                 V4L2_CID_EXPOSURE_ABSOLUTE );
                             if (ctrl_that)
                                 ctrl_that->control.flags |= V4L2_CTRL_FLAG_GRABBED;
-                            ctrl_that = v4l2core_get_control_by_id(
+                            ctrl_that = get_control_by_id(vd,
                                 V4L2_CID_IRIS_ABSOLUTE );
                             if (ctrl_that)
                                 ctrl_that->control.flags &= !(V4L2_CTRL_FLAG_GRABBED);
-                            ctrl_that = v4l2core_get_control_by_id(
+                            ctrl_that = get_control_by_id(vd,
                                 V4L2_CID_IRIS_RELATIVE );
                             if (ctrl_that)
                                 ctrl_that->control.flags &= !(V4L2_CTRL_FLAG_GRABBED);
@@ -616,16 +616,16 @@ static void update_ctrl_flags(v4l2_dev_t *vd, int id)
 
                     case V4L2_EXPOSURE_SHUTTER_PRIORITY:
                         {
-                            v4l2_ctrl_t *ctrl_that = v4l2core_get_control_by_id(
+                            v4l2_ctrl_t *ctrl_that = get_control_by_id(vd,
                                 V4L2_CID_IRIS_ABSOLUTE );
                             if (ctrl_that)
                                 ctrl_that->control.flags |= V4L2_CTRL_FLAG_GRABBED;
 
-                            ctrl_that = v4l2core_get_control_by_id(
+                            ctrl_that = get_control_by_id(vd,
                                 V4L2_CID_IRIS_RELATIVE );
                             if (ctrl_that)
                                 ctrl_that->control.flags |= V4L2_CTRL_FLAG_GRABBED;
-                            ctrl_that = v4l2core_get_control_by_id(
+                            ctrl_that = get_control_by_id(vd,
                                 V4L2_CID_EXPOSURE_ABSOLUTE );
                             if (ctrl_that)
                                 ctrl_that->control.flags &= !(V4L2_CTRL_FLAG_GRABBED);
@@ -634,15 +634,15 @@ static void update_ctrl_flags(v4l2_dev_t *vd, int id)
 
                     default:
                         {
-                            v4l2_ctrl_t *ctrl_that = v4l2core_get_control_by_id(
+                            v4l2_ctrl_t *ctrl_that = get_control_by_id(vd,
                                 V4L2_CID_EXPOSURE_ABSOLUTE );
                             if (ctrl_that)
                                 ctrl_that->control.flags &= !(V4L2_CTRL_FLAG_GRABBED);
-                            ctrl_that = v4l2core_get_control_by_id(
+                            ctrl_that = get_control_by_id(vd,
                                 V4L2_CID_IRIS_ABSOLUTE );
                             if (ctrl_that)
                                 ctrl_that->control.flags &= !(V4L2_CTRL_FLAG_GRABBED);
-                            ctrl_that = v4l2core_get_control_by_id(
+                            ctrl_that = get_control_by_id(vd,
                                 V4L2_CID_IRIS_RELATIVE );
                             if (ctrl_that)
                                 ctrl_that->control.flags &= !(V4L2_CTRL_FLAG_GRABBED);
@@ -654,29 +654,29 @@ static void update_ctrl_flags(v4l2_dev_t *vd, int id)
 
         case V4L2_CID_FOCUS_AUTO:
             {
-                v4l2_ctrl_t *ctrl_this = v4l2core_get_control_by_id( id );
+                v4l2_ctrl_t *ctrl_this = get_control_by_id(vd, id);
                 if(ctrl_this == NULL)
                     break;
                 if(ctrl_this->value > 0)
                 {
-                    v4l2_ctrl_t *ctrl_that = v4l2core_get_control_by_id(
+                    v4l2_ctrl_t *ctrl_that = get_control_by_id(vd,
                         V4L2_CID_FOCUS_ABSOLUTE);
                     if (ctrl_that)
                         ctrl_that->control.flags |= V4L2_CTRL_FLAG_GRABBED;
 
-                    ctrl_that = v4l2core_get_control_by_id(
+                    ctrl_that = get_control_by_id(vd,
                         V4L2_CID_FOCUS_RELATIVE);
                     if (ctrl_that)
                         ctrl_that->control.flags |= V4L2_CTRL_FLAG_GRABBED;
                 }
                 else
                 {
-                    v4l2_ctrl_t *ctrl_that = v4l2core_get_control_by_id(
+                    v4l2_ctrl_t *ctrl_that = get_control_by_id(vd,
                         V4L2_CID_FOCUS_ABSOLUTE);
                     if (ctrl_that)
                         ctrl_that->control.flags &= !(V4L2_CTRL_FLAG_GRABBED);
 
-                    ctrl_that = v4l2core_get_control_by_id(
+                    ctrl_that = get_control_by_id(vd,
                         V4L2_CID_FOCUS_RELATIVE);
                     if (ctrl_that)
                         ctrl_that->control.flags &= !(V4L2_CTRL_FLAG_GRABBED);
@@ -686,19 +686,19 @@ static void update_ctrl_flags(v4l2_dev_t *vd, int id)
 
         case V4L2_CID_HUE_AUTO:
             {
-                v4l2_ctrl_t *ctrl_this = v4l2core_get_control_by_id( id );
+                v4l2_ctrl_t *ctrl_this = get_control_by_id(vd, id);
                 if(ctrl_this == NULL)
                     break;
                 if(ctrl_this->value > 0)
                 {
-                    v4l2_ctrl_t *ctrl_that = v4l2core_get_control_by_id(
+                    v4l2_ctrl_t *ctrl_that = get_control_by_id(vd,
                         V4L2_CID_HUE);
                     if (ctrl_that)
                         ctrl_that->control.flags |= V4L2_CTRL_FLAG_GRABBED;
                 }
                 else
                 {
-                    v4l2_ctrl_t *ctrl_that = v4l2core_get_control_by_id(
+                    v4l2_ctrl_t *ctrl_that = get_control_by_id(vd,
                         V4L2_CID_HUE);
                     if (ctrl_that)
                         ctrl_that->control.flags &= !(V4L2_CTRL_FLAG_GRABBED);
@@ -708,36 +708,36 @@ static void update_ctrl_flags(v4l2_dev_t *vd, int id)
 
         case V4L2_CID_AUTO_WHITE_BALANCE:
             {
-                v4l2_ctrl_t *ctrl_this = v4l2core_get_control_by_id( id );
+                v4l2_ctrl_t *ctrl_this = get_control_by_id(vd, id);
                 if(ctrl_this == NULL)
                     break;
 
                 if(ctrl_this->value > 0)
                 {
-                    v4l2_ctrl_t *ctrl_that = v4l2core_get_control_by_id(
+                    v4l2_ctrl_t *ctrl_that = get_control_by_id(vd,
                         V4L2_CID_WHITE_BALANCE_TEMPERATURE);
                     if (ctrl_that)
                         ctrl_that->control.flags |= V4L2_CTRL_FLAG_GRABBED;
-                    ctrl_that = v4l2core_get_control_by_id(
+                    ctrl_that = get_control_by_id(vd,
                         V4L2_CID_BLUE_BALANCE);
                     if (ctrl_that)
                         ctrl_that->control.flags |= V4L2_CTRL_FLAG_GRABBED;
-                    ctrl_that = v4l2core_get_control_by_id(
+                    ctrl_that = get_control_by_id(vd,
                         V4L2_CID_RED_BALANCE);
                     if (ctrl_that)
                         ctrl_that->control.flags |= V4L2_CTRL_FLAG_GRABBED;
                 }
                 else
                 {
-                    v4l2_ctrl_t *ctrl_that = v4l2core_get_control_by_id(
+                    v4l2_ctrl_t *ctrl_that = get_control_by_id(vd,
                         V4L2_CID_WHITE_BALANCE_TEMPERATURE);
                     if (ctrl_that)
                         ctrl_that->control.flags &= !(V4L2_CTRL_FLAG_GRABBED);
-                    ctrl_that = v4l2core_get_control_by_id(
+                    ctrl_that = get_control_by_id(vd,
                         V4L2_CID_BLUE_BALANCE);
                     if (ctrl_that)
                         ctrl_that->control.flags &= !(V4L2_CTRL_FLAG_GRABBED);
-                    ctrl_that = v4l2core_get_control_by_id(
+                    ctrl_that = get_control_by_id(vd,
                         V4L2_CID_RED_BALANCE);
                     if (ctrl_that)
                         ctrl_that->control.flags &= !(V4L2_CTRL_FLAG_GRABBED);
@@ -787,11 +787,11 @@ void disable_special_auto (v4l2_dev_t *vd, int id)
 	/*asserts*/
 	assert(vd != NULL);
 
-    v4l2_ctrl_t *current = v4l2core_get_control_by_id( id);
+    v4l2_ctrl_t *current = get_control_by_id(vd, id);
     if(current && ((id == V4L2_CID_FOCUS_AUTO) || (id == V4L2_CID_HUE_AUTO)))
     {
         current->value = 0;
-        v4l2core_set_control_value_by_id( id);
+        set_control_value_by_id(vd, id);
     }
 }
 
@@ -900,7 +900,7 @@ void get_v4l2_control_values (v4l2_dev_t *vd)
             //fill in the values on the control list
             for(i=0; i<count; i++)
             {
-                v4l2_ctrl_t *ctrl = v4l2core_get_control_by_id(clist[i].id);
+                v4l2_ctrl_t *ctrl = get_control_by_id(vd, clist[i].id);
                 if(!ctrl)
                 {
                     fprintf(stderr, "V4L2_CORE: couldn't get control for id: %i\n", clist[i].id);
@@ -998,7 +998,7 @@ int get_control_value_by_id (v4l2_dev_t *vd, int id)
 	assert(vd != NULL);
 	assert(vd->fd > 0);
 
-    v4l2_ctrl_t *control = v4l2core_get_control_by_id(id );
+    v4l2_ctrl_t *control = get_control_by_id(vd, id );
     int ret = 0;
 
     if(!control)
@@ -1206,7 +1206,7 @@ void set_v4l2_control_values (v4l2_dev_t *vd)
                         ret = xioctl(vd->fd, VIDIOC_S_CTRL, &ctrl);
                         if(ret)
                         {
-                            v4l2_ctrl_t *ctrl = v4l2core_get_control_by_id(clist[i].id);
+                            v4l2_ctrl_t *ctrl = get_control_by_id(vd, clist[i].id);
                             if(ctrl)
                                 fprintf(stderr, "V4L2_CORE: control(0x%08x) \"%s\" failed to set (error %i)\n",
                                     clist[i].id, ctrl->control.name, ret);
@@ -1226,7 +1226,7 @@ void set_v4l2_control_values (v4l2_dev_t *vd)
                         ctrls.controls = &clist[i];
                         ret = xioctl(vd->fd, VIDIOC_S_EXT_CTRLS, &ctrls);
 
-                        v4l2_ctrl_t *ctrl = v4l2core_get_control_by_id(clist[i].id);
+                        v4l2_ctrl_t *ctrl = get_control_by_id(vd, clist[i].id);
 
                         if(ret)
                         {
@@ -1330,7 +1330,7 @@ int set_control_value_by_id(v4l2_dev_t *vd, int id)
 	assert(vd != NULL);
 	assert(vd->fd > 0);
 
-    v4l2_ctrl_t *control = v4l2core_get_control_by_id(id);
+    v4l2_ctrl_t *control = get_control_by_id(vd, id);
     int ret = 0;
 
     if(!control)
@@ -35,7 +35,10 @@
 #include <sys/ioctl.h>
 #include <libv4l2.h>
 #include <sys/mman.h>
-#include <sys/select.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <sys/stat.h>
 #include <errno.h>
 #include <assert.h>
 /* support for internationalization - i18n */
@@ -48,9 +51,16 @@
 #include "soft_autofocus.h"
 #include "core_time.h"
 #include "frame_decoder.h"
+#include "frame_pipeline.h"
+#include "jpeg_decoder.h"
+#include "bayer_decoder.h"
+#include "band_executor.h"
+#include "latency_stats.h"
+#include "replay_capture.h"
 #include "v4l2_formats.h"
 #include "v4l2_controls.h"
 #include "v4l2_devices.h"
+#include "v4l2_xu_ctrls.h"
 #include "config.h"
 
 #ifndef CLEAR
@@ -60,26 +70,27 @@
 #ifndef GETTEXT_PACKAGE_V4L2CORE
 #define GETTEXT_PACKAGE_V4L2CORE "gview_v4l2core"
 #endif
-/*video device data mutex*/
-static __MUTEX_TYPE mutex = __STATIC_MUTEX_INIT;
-#define __PMUTEX &mutex
+/*video device data mutex (one per device)*/
+#define __PMUTEX (&vd->mutex)
 
-/*requested format data*/
-static int my_pixelformat = 0;
-static int my_width = 0;
-static int my_height = 0;
+/*v4l2 memory type for the streaming capture methods*/
+#define V4L2_MEMORY_TYPE(vd) (((vd)->cap_meth == IO_USERPTR) ? V4L2_MEMORY_USERPTR : V4L2_MEMORY_MMAP)
+/*capture methods using driver buffer queues (VIDIOC_REQBUFS)*/
+#define V4L2_STREAMING_IO(vd) ((vd)->cap_meth == IO_MMAP || (vd)->cap_meth == IO_USERPTR)
 
-static double real_fps = 0.0;
-static uint64_t fps_ref_ts = 0;
-static uint32_t fps_frame_count = 0;
+/*adaptive buffer count: fps windows (~3 s each) without drops before shrinking*/
+#define ADAPTIVE_SHRINK_WINDOWS (10)
 
-static uint8_t flag_fps_change = 0; /*set to 1 to request a fps change*/
+/*max number of events handled in a single epoll wakeup*/
+#define MAX_EPOLL_EVENTS (4)
+/*frame wait timeout (ms)*/
+#define FRAME_WAIT_TIMEOUT (1000)
 
 static uint8_t disable_libv4l2 = 0; /*set to 1 to disable libv4l2 calls*/
 
 static int frame_queue_size = 1; /*just one frame in queue (enough for a single thread)*/
 
-v4l2_dev_t* vd = NULL; /*pointer to device data*/
+static v4l2_dev_t *my_vd = NULL; /*default device (used by the single device api)*/
 
 /*
  * ioctl with a number of retries in the case of I/O failure
@@ -115,7 +126,7 @@ int xioctl(int fd, int IOCTL_X, void *arg)
 /*
  * Query video device capabilities and supported formats
  * args:
- *   none
+ *   vd - pointer to video device data
  *
  * asserts:
  *   vd is not null
@@ -123,7 +134,7 @@ int xioctl(int fd, int IOCTL_X, void *arg)
  *
  * returns: error code  (E_OK)
  */
-static int check_v4l2_dev()
+static int check_v4l2_dev(v4l2_dev_t *vd)
 {
 	/*assertions*/
 	assert(vd != NULL);
@@ -152,8 +163,6 @@ static int check_v4l2_dev()
 
 	if(vd->cap_meth == IO_READ)
 	{
-
-		vd->mem[vd->buf.index] = NULL;
 		if (!(vd->cap.capabilities & V4L2_CAP_READWRITE))
 		{
 			fprintf(stderr, "V4L2_CORE: %s does not support read, try with mmap\n",
@@ -177,27 +186,117 @@ static int check_v4l2_dev()
 	/*gets the current control values and sets their flags*/
 	get_v4l2_control_values(vd);
 
-	/*if we have a focus control initiate the software autofocus*/
-	if(vd->has_focus_control_id)
+	return E_OK;
+}
+
+/*
+ * frees the driver buffer arrays
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+static void free_buff_arrays(v4l2_dev_t *vd)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	if(vd->mem)
+		free(vd->mem);
+	vd->mem = NULL;
+	if(vd->buff_length)
+		free(vd->buff_length);
+	vd->buff_length = NULL;
+	if(vd->buff_offset)
+		free(vd->buff_offset);
+	vd->buff_offset = NULL;
+	if(vd->buff_dmabuf_fd)
+		free(vd->buff_dmabuf_fd);
+	vd->buff_dmabuf_fd = NULL;
+
+	vd->num_buffers = 0;
+}
+
+/*
+ * allocs the driver buffer arrays (mem, length, offset and dma-buf fd)
+ * args:
+ *   vd - pointer to video device data
+ *   count - number of driver buffers
+ *
+ * asserts:
+ *   vd is not null
+ *   count > 0
+ *
+ * returns: none
+ */
+static void alloc_buff_arrays(v4l2_dev_t *vd, int count)
+{
+	/*assertions*/
+	assert(vd != NULL);
+	assert(count > 0);
+
+	free_buff_arrays(vd);
+
+	vd->mem = calloc(count, sizeof(void *));
+	vd->buff_length = calloc(count, sizeof(uint32_t));
+	vd->buff_offset = calloc(count, sizeof(uint32_t));
+	vd->buff_dmabuf_fd = calloc(count, sizeof(int));
+	if(vd->mem == NULL || vd->buff_length == NULL ||
+		vd->buff_offset == NULL || vd->buff_dmabuf_fd == NULL)
 	{
-		if(v4l2core_soft_autofocus_init (vd) != E_OK)
-			vd->has_focus_control_id = 0;
+		fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (alloc_buff_arrays): %s\n", strerror(errno));
+		exit(-1);
 	}
 
-	return E_OK;
+	int i = 0;
+	for (i = 0; i < count; i++)
+	{
+		vd->mem[i] = MAP_FAILED; /*not mmaped yet*/
+		vd->buff_dmabuf_fd[i] = -1; /*not exported*/
+	}
+
+	vd->num_buffers = count;
+}
+
+/*
+ * frees the replay frame buffers and the buffer arrays
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+static void free_replay_buffers(v4l2_dev_t *vd)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	if(vd->mem)
+	{
+		int i = 0;
+		for(i = 0; i < vd->num_buffers; ++i)
+			free(vd->mem[i]);
+	}
+
+	free_buff_arrays(vd);
 }
 
 /*
  * unmaps v4l2 buffers
  * args:
- *   none
+ *   vd - pointer to video device data
  *
  * asserts:
  *   vd is not null
  *
  * returns: error code  (0- E_OK)
  */
-static int unmap_buff()
+static int unmap_buff(v4l2_dev_t *vd)
 {
 	/*assertions*/
 	assert(vd != NULL);
@@ -212,15 +311,31 @@ static int unmap_buff()
 		case IO_READ:
 			break;
 
+		case IO_USERPTR:
+			for (i = 0; i < vd->num_buffers; i++)
+			{
+				// free the user buffer pool
+				if(vd->mem[i] != MAP_FAILED)
+					free(vd->mem[i]);
+				vd->mem[i] = MAP_FAILED;
+			}
+			break;
+
 		case IO_MMAP:
-			for (i = 0; i < NB_BUFFER; i++)
+			for (i = 0; i < vd->num_buffers; i++)
 			{
+				// close exported dma-buf
+				if(vd->buff_dmabuf_fd[i] >= 0)
+					close(vd->buff_dmabuf_fd[i]);
+				vd->buff_dmabuf_fd[i] = -1;
+
 				// unmap old buffer
 				if((vd->mem[i] != MAP_FAILED) && vd->buff_length[i])
 					if((ret=v4l2_munmap(vd->mem[i], vd->buff_length[i]))<0)
 					{
 						fprintf(stderr, "V4L2_CORE: couldn't unmap buff: %s\n", strerror(errno));
 					}
+				vd->mem[i] = MAP_FAILED;
 			}
 	}
 	return ret;
@@ -229,14 +344,14 @@ static int unmap_buff()
 /*
  * maps v4l2 buffers
  * args:
- *   none
+ *   vd - pointer to video device data
  *
  * asserts:
  *   vd is not null
  *
  * returns: error code  (0- E_OK)
  */
-static int map_buff()
+static int map_buff(v4l2_dev_t *vd)
 {
 	/*assertions*/
 	assert(vd != NULL);
@@ -246,7 +361,7 @@ static int map_buff()
 
 	int i = 0;
 	// map new buffer
-	for (i = 0; i < NB_BUFFER; i++)
+	for (i = 0; i < vd->num_buffers; i++)
 	{
 		vd->mem[i] = v4l2_mmap( NULL, // start anywhere
 			vd->buff_length[i],
@@ -264,22 +379,90 @@ static int map_buff()
 				i,
 				vd->buff_length[i],
 				vd->mem[i]);
+
+		/*
+		 * export the buffer as a dma-buf, so that other stages
+		 * (or processes) can reference it without a copy
+		 */
+		struct v4l2_exportbuffer expbuf;
+		memset(&expbuf, 0, sizeof(struct v4l2_exportbuffer));
+		expbuf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+		expbuf.index = i;
+		expbuf.flags = O_RDONLY | O_CLOEXEC;
+
+		if(xioctl(vd->fd, VIDIOC_EXPBUF, &expbuf) == 0)
+			vd->buff_dmabuf_fd[i] = expbuf.fd;
+		else
+		{
+			vd->buff_dmabuf_fd[i] = -1;
+			if(verbosity > 1)
+				printf("V4L2_CORE: (VIDIOC_EXPBUF) couldn't export buffer[%i]: %s\n", i, strerror(errno));
+		}
+	}
+
+	return (E_OK);
+}
+
+/*
+ * allocs the user pointer buffer pool (page aligned)
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: error code  (0- E_OK)
+ */
+static int alloc_userptr_buff(v4l2_dev_t *vd)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	if(verbosity > 2)
+		printf("V4L2_CORE: allocating user pointer buffers\n");
+
+	size_t page_size = (size_t) sysconf(_SC_PAGESIZE);
+	/*driver will write at most sizeimage bytes*/
+	size_t length = vd->format.fmt.pix.sizeimage;
+	if(length == 0)
+		length = vd->format.fmt.pix.width * vd->format.fmt.pix.height * 3; //worst case (rgb)
+	length = (length + page_size - 1) & ~(page_size - 1);
+
+	int i = 0;
+	for (i = 0; i < vd->num_buffers; i++)
+	{
+		if(posix_memalign(&vd->mem[i], page_size, length) != 0)
+		{
+			fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (alloc_userptr_buff): %s\n", strerror(errno));
+			exit(-1);
+		}
+		vd->buff_length[i] = length;
+		vd->buff_offset[i] = 0;
+		vd->buff_dmabuf_fd[i] = -1;
+
+		if(verbosity > 1)
+			printf("V4L2_CORE: user buffer[%i] with length %i at pos %p\n",
+				i,
+				vd->buff_length[i],
+				vd->mem[i]);
 	}
 
+	vd->buf.length = length;
+
 	return (E_OK);
 }
 
 /*
  * Query and map buffers
  * args:
- *   none
+ *   vd - pointer to video device data
  *
  * asserts:
  *   vd is not null
  *
  * returns: error code  (0- E_OK)
  */
-static int query_buff()
+static int query_buff(v4l2_dev_t *vd)
 {
 	/*assertions*/
 	assert(vd != NULL);
@@ -295,8 +478,12 @@ static int query_buff()
 		case IO_READ:
 			break;
 
+		case IO_USERPTR:
+			ret = alloc_userptr_buff(vd);
+			break;
+
 		case IO_MMAP:
-			for (i = 0; i < NB_BUFFER; i++)
+			for (i = 0; i < vd->num_buffers; i++)
 			{
 				memset(&vd->buf, 0, sizeof(struct v4l2_buffer));
 				vd->buf.index = i;
@@ -325,7 +512,7 @@ static int query_buff()
 				vd->buff_offset[i] = vd->buf.m.offset;
 			}
 			// map the new buffers
-			if(map_buff() != 0)
+			if(map_buff(vd) != 0)
 				ret = E_MMAP_ERR;
 			break;
 	}
@@ -338,14 +525,14 @@ static int query_buff()
 /*
  * Queue Buffers
  * args:
- *   none
+ *   vd - pointer to video device data
  *
  * asserts:
  *   vd is not null
  *
  * returns: error code  (0- E_OK)
  */
-static int queue_buff()
+static int queue_buff(v4l2_dev_t *vd)
 {
 	/*assertions*/
 	assert(vd != NULL);
@@ -363,7 +550,7 @@ static int queue_buff()
 
 		case IO_MMAP:
 		default:
-			for (i = 0; i < NB_BUFFER; ++i)
+			for (i = 0; i < vd->num_buffers; ++i)
 			{
 				memset(&vd->buf, 0, sizeof(struct v4l2_buffer));
 				vd->buf.index = i;
@@ -372,7 +559,12 @@ static int queue_buff()
 				//vd->buf.timecode = vd->timecode;
 				//vd->buf.timestamp.tv_sec = 0;
 				//vd->buf.timestamp.tv_usec = 0;
-				vd->buf.memory = V4L2_MEMORY_MMAP;
+				vd->buf.memory = V4L2_MEMORY_TYPE(vd);
+				if(vd->cap_meth == IO_USERPTR)
+				{
+					vd->buf.m.userptr = (unsigned long) vd->mem[i];
+					vd->buf.length = vd->buff_length[i];
+				}
 				ret = xioctl(vd->fd, VIDIOC_QBUF, &vd->buf);
 				if (ret < 0)
 				{
@@ -385,17 +577,160 @@ static int queue_buff()
 	return ret;
 }
 
+/*
+ * unmap and delete the driver buffers
+ *   (streaming capture methods)
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+static void release_v4l2_buffers(v4l2_dev_t *vd)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	unmap_buff(vd);
+	memset(&vd->rb, 0, sizeof(struct v4l2_requestbuffers));
+	vd->rb.count = 0;
+	vd->rb.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	vd->rb.memory = V4L2_MEMORY_TYPE(vd);
+	if(xioctl(vd->fd, VIDIOC_REQBUFS, &vd->rb)<0)
+	{
+		fprintf(stderr, "V4L2_CORE: (VIDIOC_REQBUFS) Failed to delete buffers: %s (errno %d)\n", strerror(errno), errno);
+	}
+
+	free_buff_arrays(vd);
+}
+
+/*
+ * request, map and queue vd->requested_buffers driver buffers
+ *   (streaming capture methods)
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: error code  (0- E_OK)
+ */
+static int request_v4l2_buffers(v4l2_dev_t *vd)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	int ret = E_OK;
+
+	/* request buffers */
+	memset(&vd->rb, 0, sizeof(struct v4l2_requestbuffers));
+	vd->rb.count = vd->requested_buffers;
+	vd->rb.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	vd->rb.memory = V4L2_MEMORY_TYPE(vd);
+
+	ret = xioctl(vd->fd, VIDIOC_REQBUFS, &vd->rb);
+
+	if (ret < 0 && vd->cap_meth == IO_USERPTR)
+	{
+		/*driver (or libv4l2 format conversion) doesn't support user pointers*/
+		fprintf(stderr, "V4L2_CORE: (VIDIOC_REQBUFS) user pointer i/o not supported: %s\n", strerror(errno));
+		fprintf(stderr, "V4L2_CORE: falling back to mmap\n");
+		vd->cap_meth = IO_MMAP;
+		vd->rb.memory = V4L2_MEMORY_MMAP;
+		ret = xioctl(vd->fd, VIDIOC_REQBUFS, &vd->rb);
+	}
+
+	if (ret < 0 || vd->rb.count < 1)
+	{
+		fprintf(stderr, "V4L2_CORE: (VIDIOC_REQBUFS) Unable to allocate buffers: %s\n", strerror(errno));
+		return E_REQBUFS_ERR;
+	}
+
+	/*the driver may adjust the number of buffers*/
+	if(verbosity > 0 && (int) vd->rb.count != vd->requested_buffers)
+		printf("V4L2_CORE: requested %i buffers, driver allocated %i\n",
+			vd->requested_buffers, vd->rb.count);
+	alloc_buff_arrays(vd, vd->rb.count);
+
+	/* map the buffers */
+	if (query_buff(vd))
+	{
+		fprintf(stderr, "V4L2_CORE: (VIDIOC_QBUFS) Unable to query buffers: %s\n", strerror(errno));
+		/*delete requested buffers (unmaps any buffer mapped before the failure)*/
+		if(verbosity > 0)
+			printf("V4L2_CORE: cleaning requestbuffers\n");
+		release_v4l2_buffers(vd);
+		return E_QUERYBUF_ERR;
+	}
+
+	/* Queue the buffers */
+	if (queue_buff(vd))
+	{
+		fprintf(stderr, "V4L2_CORE: (VIDIOC_QBUFS) Unable to queue buffers: %s\n", strerror(errno));
+		/*delete requested buffers */
+		if(verbosity > 0)
+			printf("V4L2_CORE: cleaning requestbuffers\n");
+		release_v4l2_buffers(vd);
+		return E_QBUF_ERR;
+	}
+
+	return E_OK;
+}
+
+/*
+ * reallocs the driver buffers with the new requested count
+ *   (restarts the stream; no frame may be in use)
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: error code  (0- E_OK)
+ */
+static int resize_v4l2_buffers(v4l2_dev_t *vd)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	if(verbosity > 0)
+		printf("V4L2_CORE: changing number of buffers from %i to %i\n",
+			vd->num_buffers, vd->requested_buffers);
+
+	uint8_t stream_status = vd->streaming;
+	/*keep the stream statistics across the restart*/
+	v4l2_stream_stats_t stats = vd->stats;
+
+	if(stream_status == STRM_OK)
+		v4l2core_dev_stop_stream(vd);
+
+	release_v4l2_buffers(vd);
+
+	int ret = request_v4l2_buffers(vd);
+	if(ret != E_OK)
+		return ret;
+
+	if(stream_status == STRM_OK)
+		ret = v4l2core_dev_start_stream(vd);
+
+	vd->stats = stats;
+
+	return ret;
+}
+
 /*
  * do a VIDIOC_S_PARM ioctl for setting frame rate
  * args:
- *    none
+ *    vd - pointer to video device data
  *
  * asserts:
  *    vd is not null
  *
  * returns: error code
  */
-static int do_v4l2_framerate_update()
+static int do_v4l2_framerate_update(v4l2_dev_t *vd)
 {
 	/*asserts*/
 	assert(vd != NULL);
@@ -436,7 +771,7 @@ static int do_v4l2_framerate_update()
 /*
  * sets video device frame rate
  * args:
- *   none
+ *   vd - pointer to video device data
  *
  * asserts:
  *   vd is not null
@@ -444,11 +779,15 @@ static int do_v4l2_framerate_update()
  * returns: VIDIOC_S_PARM ioctl result value
  * (sets vd->fps_denom and vd->fps_num to device value)
  */
-static int set_v4l2_framerate ()
+static int set_v4l2_framerate(v4l2_dev_t *vd)
 {
 	/*assertions*/
 	assert(vd != NULL);
 
+	/*replay frame rate is set by the file*/
+	if(vd->cap_meth == IO_REPLAY)
+		return E_OK;
+
 	if(verbosity > 2)
 		printf("V4L2_CORE: trying to change fps to %i/%i\n", vd->fps_num, vd->fps_denom);
 
@@ -459,37 +798,44 @@ static int set_v4l2_framerate ()
 
 	/*store streaming flag*/
 	uint8_t stream_status = vd->streaming;
+	/*keep the stream statistics across the restart*/
+	v4l2_stream_stats_t stats = vd->stats;
 
 	/*try to stop the video stream*/
 	if(stream_status == STRM_OK)
-		v4l2core_stop_stream();
+		v4l2core_dev_stop_stream(vd);
 
 	switch(vd->cap_meth)
 	{
 		case IO_READ:
-			ret = do_v4l2_framerate_update();
+			ret = do_v4l2_framerate_update(vd);
 			break;
 
 		case IO_MMAP:
+		case IO_USERPTR:
 			if(stream_status == STRM_OK)
 			{
-				/*unmap the buffers*/
+				/*unmap the buffers (frees the user buffer pool)*/
 				unmap_buff(vd);
 			}
 
-			ret = do_v4l2_framerate_update();
+			ret = do_v4l2_framerate_update(vd);
 			break;
 	}
 	
 	if(stream_status == STRM_OK)
 	{
-		query_buff(); /*also mmaps the buffers*/
-		queue_buff();
+		query_buff(vd); /*also mmaps the buffers*/
+		queue_buff(vd);
 	}
 
 	/*try to start the video stream*/
 	if(stream_status == STRM_OK)
-		v4l2core_start_stream();
+		v4l2core_dev_start_stream(vd);
+
+	/*the smoothed interval restarts at the new rate*/
+	stats.frame_interval = 0;
+	vd->stats = stats;
 
 	/*unlock the mutex*/
 	__UNLOCK_MUTEX( __PMUTEX );
@@ -498,90 +844,301 @@ static int set_v4l2_framerate ()
 }
 
 /*
- * checks if frame data is available
+ * add a file descriptor to the device epoll set
  * args:
- *   none
+ *   vd - pointer to video device data
+ *   fd - file descriptor to watch for input
+ *   flags - extra epoll flags (e.g. EPOLLET)
  *
  * asserts:
  *   vd is not null
  *
- * returns: error code  (0- E_OK)
+ * returns: error code (0- E_OK)
  */
-static int check_frame_available()
+static int add_v4l2_event_fd(v4l2_dev_t *vd, int fd, uint32_t flags)
 {
-	/*asserts*/
+	/*assertions*/
 	assert(vd != NULL);
 
-	int ret = E_OK;
-	fd_set rdset;
-	struct timeval timeout;
-
-	/*lock the mutex*/
-	__LOCK_MUTEX( __PMUTEX );
-	int stream_state = vd->streaming;
-	/*unlock the mutex*/
-	__UNLOCK_MUTEX( __PMUTEX );
+	struct epoll_event ev;
+	memset(&ev, 0, sizeof(struct epoll_event));
+	ev.events = EPOLLIN | flags;
+	ev.data.fd = fd;
 
-	/*make sure streaming is on*/
-	if(stream_state != STRM_OK)
+	if(epoll_ctl(vd->epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0)
 	{
-		if(stream_state == STRM_REQ_STOP)
-			v4l2core_stop_stream();
-
-		fprintf(stderr, "V4L2_CORE: (get_v4l2_frame) video stream must be started first\n");
-		return E_NO_STREAM_ERR;
+		fprintf(stderr, "V4L2_CORE: (EPOLL_CTL_ADD) couldn't watch fd %i: %s\n", fd, strerror(errno));
+		return E_UNKNOWN_ERR;
 	}
 
-	/*a fps change was requested while streaming*/
-	if(flag_fps_change > 0)
-	{
-		if(verbosity > 2)
-			printf("V4L2_CORE: fps change request detected\n");
-		set_v4l2_framerate();
-		flag_fps_change = 0;
-	}
+	return E_OK;
+}
 
-	FD_ZERO(&rdset);
-	FD_SET(vd->fd, &rdset);
-	timeout.tv_sec = 1; /* 1 sec timeout*/
-	timeout.tv_usec = 0;
-	/* select - wait for data or timeout*/
-	ret = select(vd->fd + 1, &rdset, NULL, NULL, &timeout);
-	if (ret < 0)
+/*
+ * create the device event set (epoll) with the device
+ *   fd, the wakeup eventfd and the udev monitor fd
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: error code (0- E_OK)
+ */
+static int init_v4l2_events(v4l2_dev_t *vd)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	vd->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if(vd->epoll_fd < 0)
 	{
-		fprintf(stderr, "V4L2_CORE: Could not grab image (select error): %s\n", strerror(errno));
-		return E_SELECT_ERR;
+		fprintf(stderr, "V4L2_CORE: (epoll_create) couldn't create event set: %s\n", strerror(errno));
+		return E_UNKNOWN_ERR;
 	}
 
-	if (ret == 0)
+	vd->wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if(vd->wakeup_fd < 0)
 	{
-		fprintf(stderr, "V4L2_CORE: Could not grab image (select timeout): %s\n", strerror(errno));
-		return E_SELECT_TIMEOUT_ERR;
+		fprintf(stderr, "V4L2_CORE: (eventfd) couldn't create wakeup event: %s\n", strerror(errno));
+		return E_UNKNOWN_ERR;
 	}
 
-	if ((ret > 0) && (FD_ISSET(vd->fd, &rdset)))
-		return E_OK;
+	/*replay devices have no device fd*/
+	if((vd->fd > 0 && add_v4l2_event_fd(vd, vd->fd, 0) != E_OK) ||
+		add_v4l2_event_fd(vd, vd->wakeup_fd, 0) != E_OK)
+		return E_UNKNOWN_ERR;
+
+	/*
+	 * udev monitor is edge triggered: the client may
+	 * never check the device list, so it must not keep
+	 * the event set signaled
+	 */
+	v4l2_device_list *device_list = v4l2core_get_device_list();
+	if(device_list && device_list->udev_fd > 0)
+		add_v4l2_event_fd(vd, device_list->udev_fd, EPOLLET);
 
-	return E_UNKNOWN_ERR;
+	return E_OK;
 }
 
 /*
- * set verbosity
+ * process the events returned by epoll_wait
  * args:
- *   level - verbosity level
+ *   vd - pointer to video device data
+ *   events - array of ready events
+ *   nevents - number of ready events
  *
  * asserts:
- *   none
+ *   vd is not null
  *
- * returns void
+ * returns: 1 if frame data is available, 0 otherwise
  */
-void v4l2core_set_verbosity(int level)
+static int process_v4l2_events(v4l2_dev_t *vd, struct epoll_event *events, int nevents)
 {
-	verbosity = level;
+	/*assertions*/
+	assert(vd != NULL);
+
+	int frame_ready = 0;
+	uint64_t count = 0;
+
+	int i = 0;
+	for(i = 0; i < nevents; ++i)
+	{
+		int fd = events[i].data.fd;
+
+		if(fd == vd->fd)
+			frame_ready = 1;
+		else if(fd == vd->wakeup_fd)
+		{
+			/*clear the request counter*/
+			if(read(vd->wakeup_fd, &count, sizeof(uint64_t)) > 0 && verbosity > 2)
+				printf("V4L2_CORE: woken up by client request\n");
+		}
+		else if(fd == vd->timer_fd)
+		{
+			if(read(vd->timer_fd, &count, sizeof(uint64_t)) == sizeof(uint64_t))
+			{
+				__LOCK_MUTEX( __PMUTEX );
+				vd->timer_expirations += count;
+				__UNLOCK_MUTEX( __PMUTEX );
+			}
+		}
+		else
+			vd->device_list_event = 1; /*udev monitor*/
+	}
+
+	return frame_ready;
+}
+
+/*
+ * close the device event set and associated fds
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+static void close_v4l2_events(v4l2_dev_t *vd)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	if(vd->timer_fd >= 0)
+		close(vd->timer_fd);
+	vd->timer_fd = -1;
+
+	if(vd->wakeup_fd >= 0)
+		close(vd->wakeup_fd);
+	vd->wakeup_fd = -1;
+
+	if(vd->epoll_fd >= 0)
+		close(vd->epoll_fd);
+	vd->epoll_fd = -1;
+}
+
+/*
+ * get the number of ready (free) frames in the queue
+ *   (must be called with the device mutex locked)
+ * args:
+ *    vd - pointer to video device data
+ *
+ * returns: number of frames with FRAME_READY status
+ */
+static int get_number_ready_frames(v4l2_dev_t *vd)
+{
+	int n = 0;
+	int i = 0;
+	for(i=0; i<vd->frame_queue_size; ++i)
+	{
+		if(vd->frame_queue[i].status == FRAME_READY)
+			n++;
+	}
+
+	return n;
+}
+
+/*
+ * checks if frame data is available
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: error code  (0- E_OK)
+ */
+static int check_frame_available(v4l2_dev_t *vd)
+{
+	/*asserts*/
+	assert(vd != NULL);
+
+	int ret = E_OK;
+	struct epoll_event events[MAX_EPOLL_EVENTS];
+
+	/*lock the mutex*/
+	__LOCK_MUTEX( __PMUTEX );
+	int stream_state = vd->streaming;
+	/*unlock the mutex*/
+	__UNLOCK_MUTEX( __PMUTEX );
+
+	/*make sure streaming is on*/
+	if(stream_state != STRM_OK)
+	{
+		if(stream_state == STRM_REQ_STOP)
+			v4l2core_dev_stop_stream(vd);
+
+		fprintf(stderr, "V4L2_CORE: (get_v4l2_frame) video stream must be started first\n");
+		return E_NO_STREAM_ERR;
+	}
+
+	/*
+	 * a fps change was requested while streaming
+	 * (the driver buffers are remapped: only possible
+	 *  while no frame holds a driver buffer)
+	 */
+	if(vd->flag_fps_change > 0)
+	{
+		__LOCK_MUTEX( __PMUTEX );
+		int idle = (get_number_ready_frames(vd) == vd->frame_queue_size);
+		__UNLOCK_MUTEX( __PMUTEX );
+
+		if(idle)
+		{
+			if(verbosity > 2)
+				printf("V4L2_CORE: fps change request detected\n");
+			set_v4l2_framerate(vd);
+			vd->flag_fps_change = 0;
+		}
+	}
+
+	int timeout = FRAME_WAIT_TIMEOUT;
+	int replay_eof = 0;
+
+	/*replay: wait until the next frame is due (still serving the event set)*/
+	if(vd->cap_meth == IO_REPLAY)
+	{
+		int64_t delay = replay_next_frame_delay(vd);
+		if(delay == 0)
+			return E_OK;
+
+		if(delay < 0)
+			replay_eof = 1;
+		else
+			timeout = (int) ((delay + 999999) / 1000000);
+	}
+
+	/* epoll - wait for data, a wakeup request, a timer or a device list event*/
+	do
+		ret = epoll_wait(vd->epoll_fd, events, MAX_EPOLL_EVENTS, timeout);
+	while (ret < 0 && errno == EINTR);
+
+	if (ret < 0)
+	{
+		fprintf(stderr, "V4L2_CORE: Could not grab image (epoll error): %s\n", strerror(errno));
+		return E_SELECT_ERR;
+	}
+
+	if (ret == 0)
+	{
+		if(vd->cap_meth == IO_REPLAY)
+		{
+			if(replay_eof && verbosity > 0)
+				printf("V4L2_CORE: (replay) end of file\n");
+			return replay_eof ? E_NO_DATA : E_OK;
+		}
+
+		fprintf(stderr, "V4L2_CORE: Could not grab image (epoll timeout)\n");
+		return E_SELECT_TIMEOUT_ERR;
+	}
+
+	if(process_v4l2_events(vd, events, ret) > 0)
+		return E_OK;
+
+	/*woken up without a frame (request, timer or udev event)*/
+	return E_NO_DATA;
+}
+
+/*
+ * set verbosity
+ * args:
+ *   level - verbosity level
+ *
+ * asserts:
+ *   none
+ *
+ * returns void
+ */
+void v4l2core_set_verbosity(int level)
+{
+	verbosity = level;
 }
 
 /*
  * set frame queue size (set before v4l2core_init_dev)
+ *   each frame in the queue holds a driver buffer, so
+ *   it should be smaller than the number of driver buffers
  * args:
  *   size - size in frames of frame queue
  *
@@ -592,6 +1149,11 @@ void v4l2core_set_verbosity(int level)
  */
 void v4l2core_set_frame_queue_size(int size)
 {
+	if(size < 1)
+		size = 1;
+	if(size > NB_BUFFER_MAX)
+		size = NB_BUFFER_MAX;
+
 	frame_queue_size = size;
 }
 
@@ -628,24 +1190,35 @@ void v4l2core_enable_libv4l2()
 /*
  * Set v4l2 capture method
  * args:
- *   method - capture method (IO_READ or IO_MMAP)
+ *   vd - pointer to video device data
+ *   method - capture method (IO_READ, IO_MMAP or IO_USERPTR)
+ *      (IO_REPLAY is set when a replay file is opened)
  *
  * asserts:
  *   vd is not null
  *
  * returns: VIDIOC_STREAMON ioctl result (E_OK or E_STREAMON_ERR)
 */
-void v4l2core_set_capture_method(int method)
+void v4l2core_dev_set_capture_method(v4l2_dev_t *vd, int method)
 {
 	/*asserts*/
 	assert(vd != NULL);
 
+	/*replay is set by opening a replay file and can't be changed*/
+	if((vd->cap_meth == IO_REPLAY) != (method == IO_REPLAY))
+	{
+		if(verbosity > 0)
+			printf("V4L2_CORE: capture method %i not available for %s\n", method, vd->videodevice);
+		return;
+	}
+
 	vd->cap_meth = method;
 }
 
 /*
  * define fps values
  * args:
+ *   vd - pointer to video device data
  *   num - fps numerator
  *   denom - fps denominator
  *
@@ -654,7 +1227,7 @@ void v4l2core_set_capture_method(int method)
  *
  * returns - void
  */
-void v4l2core_define_fps(int num, int denom)
+void v4l2core_dev_define_fps(v4l2_dev_t *vd, int num, int denom)
 {
 	/*assertions*/
 	assert(vd != NULL);
@@ -671,14 +1244,14 @@ void v4l2core_define_fps(int num, int denom)
 /*
  * get requested fps numerator
  * args:
- *   none
+ *   vd - pointer to video device data
  *
  * asserts:
  *   vd is not null
  *
  * returns - requested fps numerator
  */
-int v4l2core_get_fps_num()
+int v4l2core_dev_get_fps_num(v4l2_dev_t *vd)
 {
 	/*assertions*/
 	assert(vd != NULL);
@@ -689,14 +1262,14 @@ int v4l2core_get_fps_num()
 /*
  * get requested fps denominator
  * args:
- *   none
+ *   vd - pointer to video device data
  *
  * asserts:
  *   vd is not null
  *
  * returns - requested fps denominator
  */
-int v4l2core_get_fps_denom()
+int v4l2core_dev_get_fps_denom(v4l2_dev_t *vd)
 {
 	/*assertions*/
 	assert(vd != NULL);
@@ -707,1244 +1280,3684 @@ int v4l2core_get_fps_denom()
 /*
  * get real fps
  * args:
- *   none
+ *   vd - pointer to video device data
  *
  * asserts:
  *   none
  *
  * returns: double with real fps value
  */
-double v4l2core_get_realfps()
+double v4l2core_dev_get_realfps(v4l2_dev_t *vd)
 {
-	return(real_fps);
+	return(vd->real_fps);
 }
 
 /*
- * get videodevice string
+ * get the video stream statistics
  * args:
- *    none
+ *   vd - pointer to video device data
+ *   stats - pointer to stats struct to fill
  *
  * asserts:
- *    none
+ *   vd is not null
+ *   stats is not null
  *
- * return: videodevice string
+ * returns: none
  */
-const char *v4l2core_get_videodevice()
+void v4l2core_dev_get_stream_stats(v4l2_dev_t *vd, v4l2_stream_stats_t *stats)
 {
 	/*assertions*/
 	assert(vd != NULL);
-	
-	return (const char *) vd->videodevice;	
+	assert(stats != NULL);
+
+	__LOCK_MUTEX( __PMUTEX );
+	*stats = vd->stats;
+	__UNLOCK_MUTEX( __PMUTEX );
 }
 
 /*
- * get device available number of formats
+ * enable/disable the per stage latency histograms
+ *   recording overhead is a flag check while disabled
  * args:
- *   none
+ *   vd - pointer to video device data
+ *   enable - 1 enable; 0 disable
+ *   dump_interval - interval in seconds for printing the
+ *      latency summary to stdout (0 - don't print)
  *
  * asserts:
  *   vd is not null
  *
- * returns - number of formats for device
+ * returns: none
  */
-int v4l2core_get_number_formats()
+void v4l2core_dev_set_latency_stats(v4l2_dev_t *vd, int enable, int dump_interval)
 {
 	/*assertions*/
 	assert(vd != NULL);
-	
-	return vd->numb_formats;	
+
+	/*
+	 * histograms are kept until the device is closed
+	 * (threads may be recording when disabled)
+	 */
+	if(enable && vd->latency == NULL)
+		vd->latency = latency_stats_new();
+
+	vd->latency_dump_interval = (dump_interval > 0) ? (uint64_t) dump_interval * NSEC_PER_SEC : 0;
+	vd->latency_dump_ts = ns_time_monotonic();
+	vd->latency_enabled = enable ? 1 : 0;
 }
 
 /*
- * get has_pantilt_id flag
+ * record a latency value for a stage measured by the client
+ *   (e.g. LATENCY_RENDER)
  * args:
- *   none
+ *   vd - pointer to video device data
+ *   stage - latency stage (LATENCY_DQBUF, ...)
+ *   latency - latency in ns
  *
  * asserts:
  *   vd is not null
  *
- * returns: has_pantilt_id flag
+ * returns: none
  */
-int v4l2core_has_pantilt_id()
+void v4l2core_dev_record_latency(v4l2_dev_t *vd, int stage, uint64_t latency)
 {
 	/*assertions*/
 	assert(vd != NULL);
-	
-	return vd->has_pantilt_control_id;
+
+	if(!vd->latency_enabled || vd->latency == NULL)
+		return;
+
+	latency_stats_record(vd->latency, stage, latency);
 }
 
 /*
- * get has_focus_control_id flag
+ * get the latency summary for a stage
  * args:
- *   none
+ *   vd - pointer to video device data
+ *   stage - latency stage (LATENCY_DQBUF, ...)
+ *   stats - pointer to stats struct to fill
  *
  * asserts:
  *   vd is not null
+ *   stats is not null
  *
- * returns: has_focus_control_id flag
+ * returns: error code (E_NO_DATA if latency stats were never enabled)
  */
-int v4l2core_has_focus_control_id()
+int v4l2core_dev_get_latency_stats(v4l2_dev_t *vd, int stage, v4l2_latency_stats_t *stats)
 {
 	/*assertions*/
 	assert(vd != NULL);
-	
-	return vd->has_focus_control_id;
+	assert(stats != NULL);
+
+	if(vd->latency == NULL)
+	{
+		memset(stats, 0, sizeof(v4l2_latency_stats_t));
+		return E_NO_DATA;
+	}
+
+	latency_stats_get(vd->latency, stage, stats);
+
+	return E_OK;
 }
 
 /*
- * sets bayer pixel order
+ * clear the latency histograms
  * args:
- *   order - pixel order
+ *   vd - pointer to video device data
  *
  * asserts:
  *   vd is not null
  *
- * returns - void
+ * returns: none
  */
-void v4l2core_set_bayer_pix_order(uint8_t order)
+void v4l2core_dev_reset_latency_stats(v4l2_dev_t *vd)
 {
 	/*assertions*/
 	assert(vd != NULL);
-	
-	vd->bayer_pix_order = order;
+
+	if(vd->latency != NULL)
+		latency_stats_reset(vd->latency);
 }
 
 /*
- * gets bayer pixel order
+ * print the latency summary of all stages to stdout
  * args:
- *   none
+ *   vd - pointer to video device data
  *
  * asserts:
  *   vd is not null
  *
- * returns - bayer pixel order
+ * returns: none
  */
-uint8_t v4l2core_get_bayer_pix_order()
+void v4l2core_dev_print_latency_stats(v4l2_dev_t *vd)
 {
 	/*assertions*/
 	assert(vd != NULL);
-	
-	return vd->bayer_pix_order;
+
+	if(vd->latency != NULL)
+		latency_stats_print(vd->latency);
 }
 
 /*
- * flags bayer mode
+ * set the replay flags (IO_REPLAY only)
  * args:
- *   flag - 1 if we are streaming bayer data (0 otherwise)
+ *   vd - pointer to video device data
+ *   flags - replay flags (REPLAY_TIMED | REPLAY_LOOP)
  *
  * asserts:
  *   vd is not null
  *
- * returns - void
+ * returns: none
  */
-void v4l2core_set_isbayer(uint8_t flag)
+void v4l2core_dev_set_replay_flags(v4l2_dev_t *vd, int flags)
 {
 	/*assertions*/
 	assert(vd != NULL);
-	
-	vd->isbayer = flag;
+
+	__LOCK_MUTEX( __PMUTEX );
+	replay_set_flags(vd, flags);
+	__UNLOCK_MUTEX( __PMUTEX );
 }
 
 /*
- * gets bayer pixel order
+ * check for the end of the replay (IO_REPLAY only)
  * args:
- *   none
+ *   vd - pointer to video device data
  *
  * asserts:
  *   vd is not null
  *
- * returns - isbayer flag
+ * returns: 1 at end of replay file, 0 otherwise
  */
-uint8_t v4l2core_get_isbayer()
+int v4l2core_dev_is_replay_eof(v4l2_dev_t *vd)
 {
 	/*assertions*/
 	assert(vd != NULL);
-	
-	return vd->isbayer;
+
+	if(vd->cap_meth != IO_REPLAY)
+		return 0;
+
+	__LOCK_MUTEX( __PMUTEX );
+	int eof = replay_is_eof(vd);
+	__UNLOCK_MUTEX( __PMUTEX );
+
+	return eof;
 }
 
 /*
- * gets current device index
+ * start recording the raw frames to a replay file
+ *   the file can later be opened as the video device
  * args:
- *   none
+ *   vd - pointer to video device data
+ *   filename - replay file name
  *
  * asserts:
  *   vd is not null
+ *   filename is not null
  *
- * returns - device index
+ * returns: error code (0- E_OK)
  */
-int v4l2core_get_this_device_index()
+int v4l2core_dev_start_replay_record(v4l2_dev_t *vd, const char *filename)
 {
-	/*assertions*/
-	assert(vd != NULL);
-	
-	return vd->this_device;
+	return replay_record_start(vd, filename);
 }
 
 /*
- * Start video stream
+ * stop recording raw frames
  * args:
- *   none
+ *   vd - pointer to video device data
  *
  * asserts:
  *   vd is not null
  *
- * returns: VIDIOC_STREAMON ioctl result (E_OK or E_STREAMON_ERR)
-*/
-int v4l2core_start_stream()
+ * returns: none
+ */
+void v4l2core_dev_stop_replay_record(v4l2_dev_t *vd)
 {
-	/*assertions*/
-	assert(vd != NULL);
-
-	if(vd->streaming == STRM_OK)
-	{
-		fprintf(stderr, "V4L2_CORE: (stream already started) stream_status = STRM_OK\n");
-		return E_OK;
-	}
-
-	int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-	int ret=E_OK;
-	switch(vd->cap_meth)
-	{
-		case IO_READ:
-			//do nothing
-			break;
-
-		case IO_MMAP:
-		default:
-			ret = xioctl(vd->fd, VIDIOC_STREAMON, &type);
-			if (ret < 0)
-			{
-				fprintf(stderr, "V4L2_CORE: (VIDIOC_STREAMON) Unable to start stream: %s \n", strerror(errno));
-				return E_STREAMON_ERR;
-			}
-			break;
-	}
-
-	vd->streaming = STRM_OK;
-	
-	if(verbosity > 2)
-		printf("V4L2_CORE: (VIDIOC_STREAMON) stream_status = STRM_OK\n");
-
-	return ret;
+	replay_record_stop(vd);
 }
 
 /*
- * request video stream to stop
+ * get videodevice string
  * args:
- *   none
+ *   vd - pointer to video device data
  *
  * asserts:
- *   vd is not null
+ *    none
  *
- * returns: error code (0 -OK)
-*/
-int v4l2core_request_stop_stream()
+ * return: videodevice string
+ */
+const char *v4l2core_dev_get_videodevice(v4l2_dev_t *vd)
 {
 	/*assertions*/
 	assert(vd != NULL);
+	
+	return (const char *) vd->videodevice;	
+}
 
-	if(vd->streaming != STRM_OK)
-		return -1;
+/*
+ * get device available number of formats
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns - number of formats for device
+ */
+int v4l2core_dev_get_number_formats(v4l2_dev_t *vd)
+{
+	/*assertions*/
+	assert(vd != NULL);
+	
+	return vd->numb_formats;	
+}
 
-	vd->streaming = STRM_REQ_STOP;
+/*
+ * get has_pantilt_id flag
+ * args:
+ *   none
+ *
+ * asserts:
+ *   my_vd is not null
+ *
+ * returns: has_pantilt_id flag
+ */
+int v4l2core_has_pantilt_id()
+{
+	/*assertions*/
+	assert(my_vd != NULL);
 	
-	if(verbosity > 2)
-		printf("V4L2_CORE: (request stream stop) stream_status = STRM_REQ_STOP\n");
+	return my_vd->has_pantilt_control_id;
+}
 
-	return 0;
+/*
+ * get has_focus_control_id flag
+ * args:
+ *   none
+ *
+ * asserts:
+ *   my_vd is not null
+ *
+ * returns: has_focus_control_id flag
+ */
+int v4l2core_has_focus_control_id()
+{
+	/*assertions*/
+	assert(my_vd != NULL);
+	
+	return my_vd->has_focus_control_id;
 }
 
 /*
- * Stops the video stream
+ * sets bayer pixel order
+ * args:
+ *   order - pixel order
+ *
+ * asserts:
+ *   my_vd is not null
+ *
+ * returns - void
+ */
+void v4l2core_set_bayer_pix_order(uint8_t order)
+{
+	/*assertions*/
+	assert(my_vd != NULL);
+	
+	my_vd->bayer_pix_order = order;
+}
+
+/*
+ * gets bayer pixel order
+ * args:
+ *   none
+ *
+ * asserts:
+ *   my_vd is not null
+ *
+ * returns - bayer pixel order
+ */
+uint8_t v4l2core_get_bayer_pix_order()
+{
+	/*assertions*/
+	assert(my_vd != NULL);
+	
+	return my_vd->bayer_pix_order;
+}
+
+/*
+ * flags bayer mode
+ * args:
+ *   flag - 1 if we are streaming bayer data (0 otherwise)
+ *
+ * asserts:
+ *   my_vd is not null
+ *
+ * returns - void
+ */
+void v4l2core_set_isbayer(uint8_t flag)
+{
+	/*assertions*/
+	assert(my_vd != NULL);
+	
+	my_vd->isbayer = flag;
+}
+
+/*
+ * gets bayer pixel order
+ * args:
+ *   none
+ *
+ * asserts:
+ *   my_vd is not null
+ *
+ * returns - isbayer flag
+ */
+uint8_t v4l2core_get_isbayer()
+{
+	/*assertions*/
+	assert(my_vd != NULL);
+	
+	return my_vd->isbayer;
+}
+
+/*
+ * gets current device index
  * args:
  *   none
  *
  * asserts:
+ *   my_vd is not null
+ *
+ * returns - device index
+ */
+int v4l2core_get_this_device_index()
+{
+	/*assertions*/
+	assert(my_vd != NULL);
+	
+	return my_vd->this_device;
+}
+
+/*
+ * Start video stream
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
  *   vd is not null
  *
- * returns: VIDIOC_STREAMON ioctl result (E_OK)
+ * returns: VIDIOC_STREAMON ioctl result (E_OK or E_STREAMON_ERR)
 */
-int v4l2core_stop_stream()
+int v4l2core_dev_start_stream(v4l2_dev_t *vd)
 {
 	/*assertions*/
 	assert(vd != NULL);
 
+	if(vd->streaming == STRM_OK)
+	{
+		fprintf(stderr, "V4L2_CORE: (stream already started) stream_status = STRM_OK\n");
+		return E_OK;
+	}
+
 	int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
 	int ret=E_OK;
 	switch(vd->cap_meth)
 	{
 		case IO_READ:
+			//do nothing
+			break;
+
+		case IO_REPLAY:
+			replay_resume(vd);
+			break;
+
 		case IO_MMAP:
 		default:
-			ret = xioctl(vd->fd, VIDIOC_STREAMOFF, &type);
+			ret = xioctl(vd->fd, VIDIOC_STREAMON, &type);
 			if (ret < 0)
 			{
-				if(errno == 9) /* stream allready stoped*/
-					vd->streaming = STRM_STOP;
-				fprintf(stderr, "V4L2_CORE: (VIDIOC_STREAMOFF) Unable to stop stream: %s\n", strerror(errno));
-				return E_STREAMOFF_ERR;
+				fprintf(stderr, "V4L2_CORE: (VIDIOC_STREAMON) Unable to start stream: %s \n", strerror(errno));
+				return E_STREAMON_ERR;
 			}
 			break;
 	}
 
-	vd->streaming = STRM_STOP;
+	/*sequence numbers and timestamps restart with the stream*/
+	vd->last_sequence = -1;
+	vd->last_timestamp = 0;
+	vd->last_interval = -1;
+	CLEAR(vd->stats);
+
+	vd->streaming = STRM_OK;
 	
 	if(verbosity > 2)
-		printf("V4L2_CORE: (VIDIOC_STREAMOFF) stream_status = STRM_STOP\n");
-		
+		printf("V4L2_CORE: (VIDIOC_STREAMON) stream_status = STRM_OK\n");
+
 	return ret;
 }
 
 /*
- * get next ready flaged frame from queue
+ * request video stream to stop
  * args:
- *    none
+ *   vd - pointer to video device data
  *
- * returns: index of frame queue or -1 if none
- */
-static int get_next_ready_frame()
+ * asserts:
+ *   vd is not null
+ *
+ * returns: error code (0 -OK)
+*/
+int v4l2core_dev_request_stop_stream(v4l2_dev_t *vd)
 {
-	int i = 0;
-	for(i=0; i<vd->frame_queue_size; ++i)
-	{
-		if(vd->frame_queue[i].status == FRAME_READY)
-			return (i);
-	}
+	/*assertions*/
+	assert(vd != NULL);
+
+	if(vd->streaming != STRM_OK)
+		return -1;
+
+	vd->streaming = STRM_REQ_STOP;
 	
-	return -1;
+	if(verbosity > 2)
+		printf("V4L2_CORE: (request stream stop) stream_status = STRM_REQ_STOP\n");
+
+	/*don't wait for the next frame to handle the request*/
+	v4l2core_dev_wakeup(vd);
+
+	return 0;
 }
 
 /*
- * process input buffer
+ * wakes up any thread waiting for a frame on the device
+ *   (e.g. after a stop or format change request)
  * args:
- *   none
+ *   vd - pointer to video device data
  *
- * returns: frame_queue index
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
  */
-static int process_input_buffer()
+void v4l2core_dev_wakeup(v4l2_dev_t *vd)
 {
-	/*get next available frame in queue*/
-	int qind = get_next_ready_frame(vd);
-	
-	if(verbosity > 2)
-		printf("V4L2_CORE: process frame queue index %i\n", qind);
-	
-	if(qind < 0 || qind >= vd->frame_queue_size)
-	{
-		if(verbosity > 2)
-		fprintf(stderr,"V4L2_CORE: frame queue index %i is invalid (no free frames in queue?)\n", qind);
-		return -1; 
-	}
-	
-	vd->frame_queue[qind].status = FRAME_DECODING;
-	
-	/*
-     * driver timestamp is unreliable
-	 * use monotonic system time
-	 */
-	vd->frame_queue[qind].timestamp = ns_time_monotonic();
-	
-	vd->frame_queue[qind].index = vd->buf.index;
-	 
-	vd->frame_index++;
-	
-	vd->frame_queue[qind].raw_frame_size = vd->buf.bytesused;
-	if(vd->frame_queue[qind].raw_frame_size == 0)
-	{
-		if(verbosity > 1)
-			fprintf(stderr, "V4L2_CORE: VIDIOC_QBUF returned buf.bytesused = 0 \n");
-	}
-	
-	/*point vd->raw_frame to current frame buffer*/
-	vd->frame_queue[qind].raw_frame = vd->mem[vd->buf.index];
-	
-	/*determine real fps every 3 sec aprox.*/
-	fps_frame_count++;
+	/*assertions*/
+	assert(vd != NULL);
+
+	uint64_t one = 1;
+	if(write(vd->wakeup_fd, &one, sizeof(uint64_t)) < 0 && verbosity > 0)
+		fprintf(stderr, "V4L2_CORE: (wakeup) couldn't signal event: %s\n", strerror(errno));
+
+	/*frames are waited on by the pipeline threads*/
+	__LOCK_MUTEX( __PMUTEX );
+	frame_pipeline_wakeup(vd);
+	__UNLOCK_MUTEX( __PMUTEX );
+}
 
-	if(vd->frame_queue[qind].timestamp - fps_ref_ts >= (3 * NSEC_PER_SEC))
-	{
-		if(verbosity > 2)
-			printf("V4L2CORE: (fps) ref:%"PRId64" ts:%"PRId64" frames:%i\n",
-				fps_ref_ts, vd->frame_queue[qind].timestamp, fps_frame_count);
-		real_fps = (double) (fps_frame_count * NSEC_PER_SEC) / (double) (vd->frame_queue[qind].timestamp - fps_ref_ts);
-		fps_frame_count = 0;
-		fps_ref_ts = vd->frame_queue[qind].timestamp;
-	}
-	
-	return qind;
-} 
- 
 /*
- * gets the next video frame (must be released after processing)
+ * sets a periodic timer on the device event set
+ *   expirations are collected while waiting for frames
  * args:
- *   none
+ *   vd - pointer to video device data
+ *   interval - timer interval in ns (0 disables the timer)
  *
  * asserts:
  *   vd is not null
  *
- * returns: pointer frame buffer (NULL on error)
+ * returns: error code (0- E_OK)
  */
-v4l2_frame_buff_t *v4l2core_get_frame()
+int v4l2core_dev_set_timer(v4l2_dev_t *vd, uint64_t interval)
 {
-	/*asserts*/
+	/*assertions*/
 	assert(vd != NULL);
 
-	int res = 0;
-	int ret = check_frame_available(vd);
+	if(vd->timer_fd < 0)
+	{
+		if(interval == 0)
+			return E_OK;
 
-	int qind = -1;
-	
-	if (ret < 0)
-		return NULL;
+		vd->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+		if(vd->timer_fd < 0)
+		{
+			fprintf(stderr, "V4L2_CORE: (timerfd_create) couldn't create timer: %s\n", strerror(errno));
+			return E_UNKNOWN_ERR;
+		}
 
-	int bytes_used = 0;
+		if(add_v4l2_event_fd(vd, vd->timer_fd, 0) != E_OK)
+		{
+			close(vd->timer_fd);
+			vd->timer_fd = -1;
+			return E_UNKNOWN_ERR;
+		}
+	}
 
-	switch(vd->cap_meth)
-	{
-		case IO_READ:
+	struct itimerspec its;
+	its.it_interval.tv_sec = interval / NSEC_PER_SEC;
+	its.it_interval.tv_nsec = interval % NSEC_PER_SEC;
+	its.it_value = its.it_interval; /*first expiration after one interval*/
 
-			/*lock the mutex*/
-			__LOCK_MUTEX( __PMUTEX );
-			if(vd->streaming == STRM_OK)
-			{
-				vd->buf.bytesused = v4l2_read (vd->fd, vd->mem[vd->buf.index], vd->buf.length);
-				bytes_used = vd->buf.bytesused;
-				
-				if(bytes_used > 0)
-					qind = process_input_buffer();
-			}
-			else res = -1;
-			/*unlock the mutex*/
-			__UNLOCK_MUTEX( __PMUTEX );
+	if(timerfd_settime(vd->timer_fd, 0, &its, NULL) < 0)
+	{
+		fprintf(stderr, "V4L2_CORE: (timerfd_settime) couldn't set timer: %s\n", strerror(errno));
+		return E_UNKNOWN_ERR;
+	}
 
-			if(res < 0)
-				return NULL;
+	__LOCK_MUTEX( __PMUTEX );
+	vd->timer_expirations = 0;
+	__UNLOCK_MUTEX( __PMUTEX );
 
-			if (-1 == bytes_used )
-			{
-				switch (errno)
-				{
-					case EAGAIN:
-						fprintf(stderr, "V4L2_CORE: No data available for read: %s\n", strerror(errno));
-						break;
-					case EINVAL:
-						fprintf(stderr, "V4L2_CORE: Read method error, try mmap instead: %s\n", strerror(errno));
-						break;
-					case EIO:
-						fprintf(stderr, "V4L2_CORE: read I/O Error: %s\n", strerror(errno));
-						break;
-					default:
-						fprintf(stderr, "V4L2_CORE: read: %s\n", strerror(errno));
-						break;
-				}
-				return NULL;
-			}
-			break;
+	return E_OK;
+}
 
-		case IO_MMAP:
-		default:
-			/* dequeue the buffers */
+/*
+ * gets (and clears) the number of timer expirations
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: number of timer expirations since last call
+ */
+uint64_t v4l2core_dev_get_timer_expirations(v4l2_dev_t *vd)
+{
+	/*assertions*/
+	assert(vd != NULL);
 
-			/*lock the mutex*/
-			__LOCK_MUTEX( __PMUTEX );
+	if(vd->timer_fd < 0)
+		return 0;
 
-			if(vd->streaming == STRM_OK)
-			{
-				memset(&vd->buf, 0, sizeof(struct v4l2_buffer));
+	uint64_t count = 0;
 
-				vd->buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-				vd->buf.memory = V4L2_MEMORY_MMAP;
+	__LOCK_MUTEX( __PMUTEX );
+	/*not streaming: nobody is waiting on the event set*/
+	if(vd->streaming != STRM_OK &&
+		read(vd->timer_fd, &count, sizeof(uint64_t)) == sizeof(uint64_t))
+		vd->timer_expirations += count;
 
-				ret = xioctl(vd->fd, VIDIOC_DQBUF, &vd->buf);
+	count = vd->timer_expirations;
+	vd->timer_expirations = 0;
+	__UNLOCK_MUTEX( __PMUTEX );
 
-				if(!ret)
-					qind = process_input_buffer();
-				else
-					fprintf(stderr, "V4L2_CORE: (VIDIOC_DQBUF) Unable to dequeue buffer: %s\n", strerror(errno));
-			}
-			else res = -1;
+	return count;
+}
 
-			/*unlock the mutex*/
-			__UNLOCK_MUTEX( __PMUTEX );
+/*
+ * sets the number of driver buffers
+ *   if the stream is running the change is applied
+ *   as soon as no frame holds a driver buffer
+ * args:
+ *   vd - pointer to video device data
+ *   count - number of buffers [NB_BUFFER_MIN - NB_BUFFER_MAX]
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_set_buffer_count(v4l2_dev_t *vd, int count)
+{
+	/*assertions*/
+	assert(vd != NULL);
 
-			if(res < 0 || ret < 0)
-				return NULL;
-	}
+	if(count < NB_BUFFER_MIN)
+		count = NB_BUFFER_MIN;
+	if(count > NB_BUFFER_MAX)
+		count = NB_BUFFER_MAX;
 
-	if(qind < 0 || qind >= vd->frame_queue_size)
-		return NULL;
-		
-	return &vd->frame_queue[qind];
+	__LOCK_MUTEX( __PMUTEX );
+	vd->requested_buffers = count;
+	if(vd->num_buffers > 0 && V4L2_STREAMING_IO(vd) && count != vd->num_buffers)
+		vd->flag_buffers_change = 1;
+	__UNLOCK_MUTEX( __PMUTEX );
 }
 
 /*
- * releases the video frame (so that it can be reused by the driver)
+ * gets the number of driver buffers in use
  * args:
- *   frame - pointer to decoded frame buffer
+ *   vd - pointer to video device data
  *
  * asserts:
  *   vd is not null
  *
- * returns: error code (E_OK)
+ * returns: number of driver buffers (requested count if none allocated)
  */
-int v4l2core_release_frame(v4l2_frame_buff_t *frame)
+int v4l2core_dev_get_buffer_count(v4l2_dev_t *vd)
 {
-	int ret = 0;
-	
-	//match the v4l2_buffer with the correspondig frame
-	vd->buf.index = frame->index;
-	
-	switch(vd->cap_meth)
-	{
-		case IO_READ:
-			break;
-		
-		case IO_MMAP:
-		default:
-			/* queue the buffer */
-			ret = xioctl(vd->fd, VIDIOC_QBUF, &vd->buf);
+	/*assertions*/
+	assert(vd != NULL);
 
-			if(ret)
-				fprintf(stderr, "V4L2_CORE: (VIDIOC_QBUF) Unable to queue buffer %i: %s\n", frame->index, strerror(errno));
-			break;	
-	}
-	
-	/*lock the mutex*/
-	__LOCK_MUTEX( __PMUTEX );
-	frame->raw_frame = NULL;
-	frame->raw_frame_size = 0;
-	frame->status = FRAME_READY;
-	/*unlock the mutex*/
-	__UNLOCK_MUTEX( __PMUTEX );
-	
-	if (ret < 0)
-		return E_QBUF_ERR;
-	
-	return E_OK;		
+	if(vd->num_buffers > 0)
+		return vd->num_buffers;
+
+	return vd->requested_buffers;
 }
 
 /*
- * gets the next video frame and decodes it
+ * sets the adaptive buffer count range:
+ *   the number of buffers grows when the driver drops frames
+ *   and shrinks back after a sustained period without drops
  * args:
- *    none
+ *   vd - pointer to video device data
+ *   min_count - minimum number of buffers
+ *   max_count - maximum number of buffers (0 - disable)
  *
- * returns: pointer to decoded frame buffer ( NULL on error)
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
  */
-v4l2_frame_buff_t *v4l2core_get_decoded_frame()
+void v4l2core_dev_set_adaptive_buffers(v4l2_dev_t *vd, int min_count, int max_count)
 {
-	v4l2_frame_buff_t *frame = v4l2core_get_frame();
-	if(frame != NULL)
+	/*assertions*/
+	assert(vd != NULL);
+
+	if(min_count < NB_BUFFER_MIN)
+		min_count = NB_BUFFER_MIN;
+	if(max_count > NB_BUFFER_MAX)
+		max_count = NB_BUFFER_MAX;
+
+	__LOCK_MUTEX( __PMUTEX );
+	if(max_count <= 0)
+		vd->adaptive_max_buffers = 0;
+	else
 	{
-		/*decode the raw frame*/
-		if(decode_v4l2_frame(vd, frame) != E_OK)
-		{
-			fprintf(stderr, "V4L2_CORE: Error - Couldn't decode frame\n");
-		}
+		if(max_count < min_count)
+			max_count = min_count;
+		vd->adaptive_min_buffers = min_count;
+		vd->adaptive_max_buffers = max_count;
 	}
-	
-	return frame;
+	vd->window_drops = 0;
+	vd->clean_windows = 0;
+	__UNLOCK_MUTEX( __PMUTEX );
 }
 
 /*
- * Try/Set device video stream format
+ * sets the low latency (latest frame wins) mode:
+ *   all the ready driver buffers are dequeued after each wait
+ *   and only the newest frame is returned, the stale ones are
+ *   requeued without decoding (counted in the stream stats)
  * args:
- *   width - requested video frame width
- *   height - requested video frame height
- *   pixelformat - requested v4l2 pixelformat
+ *   vd - pointer to video device data
+ *   enable - 1 to enable; 0 to disable
  *
  * asserts:
  *   vd is not null
  *
- * returns: error code ( E_OK)
+ * returns: none
  */
-static int try_video_stream_format(int width, int height, int pixelformat)
+void v4l2core_dev_set_low_latency(v4l2_dev_t *vd, int enable)
 {
-#ifdef _SUB_CHANNEL_BSP_            
-    struct v4l2_pix_format subch_fmt;
-#endif    
-    struct v4l2_streamparm parms;
-    struct v4l2_input inp;
-    config_t *my_config;    
+	/*assertions*/
+	assert(vd != NULL);
+
+	__LOCK_MUTEX( __PMUTEX );
+	vd->low_latency = enable ? 1 : 0;
+	__UNLOCK_MUTEX( __PMUTEX );
+}
 
+/*
+ * Stops the video stream
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: VIDIOC_STREAMON ioctl result (E_OK)
+*/
+int v4l2core_dev_stop_stream(v4l2_dev_t *vd)
+{
 	/*assertions*/
 	assert(vd != NULL);
 
-	int ret = E_OK;
-    my_config = config_get();
+	int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	int ret=E_OK;
+	switch(vd->cap_meth)
+	{
+		case IO_REPLAY:
+			//do nothing
+			break;
 
-	/*lock the mutex*/
-	__LOCK_MUTEX( __PMUTEX );
+		case IO_READ:
+		case IO_MMAP:
+		default:
+			ret = xioctl(vd->fd, VIDIOC_STREAMOFF, &type);
+			if (ret < 0)
+			{
+				if(errno == 9) /* stream allready stoped*/
+					vd->streaming = STRM_STOP;
+				fprintf(stderr, "V4L2_CORE: (VIDIOC_STREAMOFF) Unable to stop stream: %s\n", strerror(errno));
+				return E_STREAMOFF_ERR;
+			}
+			break;
+	}
 
-	vd->requested_fmt = pixelformat;
+	vd->streaming = STRM_STOP;
+	
+	if(verbosity > 2)
+		printf("V4L2_CORE: (VIDIOC_STREAMOFF) stream_status = STRM_STOP\n");
+		
+	return ret;
+}
 
-	uint8_t stream_status = vd->streaming;
+/*
+ * get next ready flaged frame from queue
+ * args:
+ *    vd - pointer to video device data
+ *
+ * returns: index of frame queue or -1 if none
+ */
+static int get_next_ready_frame(v4l2_dev_t *vd)
+{
+	int i = 0;
+	for(i=0; i<vd->frame_queue_size; ++i)
+	{
+		if(vd->frame_queue[i].status == FRAME_READY)
+			return (i);
+	}
+	
+	return -1;
+}
 
-	if(stream_status == STRM_OK)
-		v4l2core_stop_stream();
+/*
+ * update the adaptive buffer count at the end of a fps window:
+ *   doubles the count if the driver dropped frames and shrinks
+ *   it by one after ADAPTIVE_SHRINK_WINDOWS windows without drops
+ *   (must be called with the device mutex locked)
+ * args:
+ *   vd - pointer to video device data
+ *
+ * returns: none
+ */
+static void update_adaptive_buffers(v4l2_dev_t *vd)
+{
+	if(vd->adaptive_max_buffers <= 0 || vd->num_buffers <= 0)
+		return;
 
-    inp.index = vd->this_device;
-    if (-1 == xioctl(vd->fd, VIDIOC_S_INPUT, &inp))
-        printf("VIDIOC_S_INPUT error!\n");
+	int count = vd->num_buffers;
 
-    if (my_config->cmos_camera) {
-        CLEAR(parms);
-        parms.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-        parms.parm.capture.timeperframe.numerator = 1;
-        parms.parm.capture.timeperframe.denominator = 25;
-        parms.parm.capture.capturemode = 2;
-        if (-1 == xioctl(vd->fd, VIDIOC_S_PARM, &parms))
-            printf("VIDIOC_S_PARM error\n");
-    }
+	if(vd->window_drops > 0)
+	{
+		vd->clean_windows = 0;
+		count *= 2;
+		if(count > vd->adaptive_max_buffers)
+			count = vd->adaptive_max_buffers;
+	}
+	else if(++vd->clean_windows >= ADAPTIVE_SHRINK_WINDOWS)
+	{
+		vd->clean_windows = 0;
+		count--;
+		if(count < vd->adaptive_min_buffers)
+			count = vd->adaptive_min_buffers;
+	}
 
-	vd->format.fmt.pix.pixelformat = pixelformat;
-	vd->format.fmt.pix.width = width;
-	vd->format.fmt.pix.height = height;
+	if(verbosity > 2)
+		printf("V4L2_CORE: (adaptive buffers) %u drops in window, %i buffers\n",
+			vd->window_drops, count);
 
-#ifdef _SUB_CHANNEL_BSP_        
-    if (my_config->cmos_camera) {
-        CLEAR(subch_fmt);
-        vd->format.fmt.pix.subchannel = &subch_fmt;
-        subch_fmt.width = width / 2;
-        subch_fmt.height = height / 2;
-        subch_fmt.pixelformat = pixelformat;       
-        subch_fmt.field = V4L2_FIELD_NONE;        
-        subch_fmt.rot_angle = 0;
-    }
-#endif    
+	vd->window_drops = 0;
 
-	/* make sure we set a valid format*/
-	if(verbosity > 0)
-		printf("V4L2_CORE: CMOS CAMERA: %d - checking format: %c%c%c%c\n",
-            my_config->cmos_camera,
-			(vd->format.fmt.pix.pixelformat) & 0xFF, ((vd->format.fmt.pix.pixelformat) >> 8) & 0xFF,
-			((vd->format.fmt.pix.pixelformat) >> 16) & 0xFF, ((vd->format.fmt.pix.pixelformat) >> 24) & 0xFF);
+	if(count != vd->num_buffers)
+	{
+		vd->requested_buffers = count;
+		vd->flag_buffers_change = 1;
+	}
+}
 
-	/*override field and type entries*/
-	vd->format.fmt.pix.field = V4L2_FIELD_NONE; // V4L2_FIELD_ANY;
-	vd->format.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+/*
+ * set the frame timestamp and sequence and update the stream statistics
+ *   uses the driver timestamp if it's monotonic, else the dequeue time
+ *   (must be called with the device mutex locked)
+ * args:
+ *   vd - pointer to video device data
+ *   qind - frame queue index
+ *
+ * returns: none
+ */
+static void update_stream_stats(v4l2_dev_t *vd, int qind)
+{
+	uint64_t now = ns_time_monotonic();
+	uint64_t ts = now;
 
-	ret = xioctl(vd->fd, VIDIOC_S_FMT, &vd->format);
+	vd->stats.frames++;
+	vd->stats.driver_timestamps = 0;
 
-	/*unlock the mutex*/
-	__UNLOCK_MUTEX( __PMUTEX );
+	if(vd->cap_meth != IO_READ)
+	{
+		/*gaps in the driver sequence are frames dropped by the driver*/
+		if(vd->last_sequence >= 0 && vd->buf.sequence > vd->last_sequence + 1)
+		{
+			uint32_t drops = vd->buf.sequence - (vd->last_sequence + 1);
+			vd->window_drops += drops;
+			vd->stats.dropped += drops;
 
-	if (ret != 0)
+			if(verbosity > 1)
+				printf("V4L2_CORE: driver dropped %u frames (sequence %u)\n",
+					drops, vd->buf.sequence);
+		}
+		vd->last_sequence = vd->buf.sequence;
+
+		if((vd->buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC &&
+			(vd->buf.timestamp.tv_sec > 0 || vd->buf.timestamp.tv_usec > 0))
+		{
+			uint64_t drv_ts = (uint64_t) vd->buf.timestamp.tv_sec * NSEC_PER_SEC +
+				(uint64_t) vd->buf.timestamp.tv_usec * 1000;
+
+			/*driver timestamp can't be in the future*/
+			if(drv_ts <= now)
+			{
+				ts = drv_ts;
+				vd->stats.driver_timestamps = 1;
+
+				uint64_t delay = now - drv_ts;
+				/*smoothed as in RFC 3550 (1/16 gain)*/
+				vd->stats.dequeue_delay += ((int64_t) delay - (int64_t) vd->stats.dequeue_delay) / 16;
+				if(delay > vd->stats.max_dequeue_delay)
+					vd->stats.max_dequeue_delay = delay;
+			}
+		}
+	}
+
+	vd->frame_queue[qind].timestamp = ts;
+	vd->frame_queue[qind].sequence = (vd->cap_meth != IO_READ) ?
+		vd->buf.sequence : (uint32_t) (vd->stats.frames - 1);
+
+	if(vd->last_timestamp > 0 && ts > vd->last_timestamp)
 	{
-		fprintf(stderr, "V4L2_CORE: (VIDIOC_S_FORMAT) Unable to set format: %s\n", strerror(errno));
-		return E_FORMAT_ERR;
+		int64_t interval = ts - vd->last_timestamp;
+
+		if(vd->stats.frame_interval == 0)
+			vd->stats.frame_interval = interval;
+		else
+			vd->stats.frame_interval += (interval - (int64_t) vd->stats.frame_interval) / 16;
+
+		if(vd->last_interval >= 0)
+		{
+			int64_t diff = interval - vd->last_interval;
+			uint64_t jitter = (uint64_t) (diff < 0 ? -diff : diff);
+
+			vd->stats.jitter += ((int64_t) jitter - (int64_t) vd->stats.jitter) / 16;
+			if(jitter > vd->stats.max_jitter)
+				vd->stats.max_jitter = jitter;
+		}
+		vd->last_interval = interval;
 	}
+	vd->last_timestamp = ts;
+}
 
-	if ((vd->format.fmt.pix.width != width) ||
-		(vd->format.fmt.pix.height != height))
+/*
+ * latest frame wins: dequeue all the ready driver buffers and
+ *   requeue the stale ones without decoding, leaving the newest
+ *   buffer in vd->buf (must be called with the device mutex locked
+ *   and a buffer already dequeued into vd->buf)
+ * args:
+ *   vd - pointer to video device data
+ *
+ * returns: number of skipped frames
+ */
+static int skip_stale_buffers(v4l2_dev_t *vd)
+{
+	int skipped = 0;
+	int ret = 0;
+	struct v4l2_buffer buf;
+
+	while(1)
 	{
-		fprintf(stderr, "V4L2_CORE: Requested resolution unavailable: got width %d height %d\n",
-		vd->format.fmt.pix.width, vd->format.fmt.pix.height);
+		memset(&buf, 0, sizeof(struct v4l2_buffer));
+		buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+		buf.memory = V4L2_MEMORY_TYPE(vd);
+
+		/*
+		 * don't use xioctl: it retries on EAGAIN and the
+		 * fd is non blocking, EAGAIN means no more ready buffers
+		 */
+		do
+		{
+			if(!disable_libv4l2)
+				ret = v4l2_ioctl(vd->fd, VIDIOC_DQBUF, &buf);
+			else
+				ret = ioctl(vd->fd, VIDIOC_DQBUF, &buf);
+		}
+		while (ret < 0 && errno == EINTR);
+
+		if(ret < 0)
+			break;
+
+		/*vd->buf is now stale: give it back to the driver*/
+		struct v4l2_buffer stale = vd->buf;
+		vd->buf = buf;
+
+		/*sequence gaps before the stale frame are still driver drops*/
+		if(vd->last_sequence >= 0 && stale.sequence > vd->last_sequence + 1)
+		{
+			uint32_t drops = stale.sequence - (vd->last_sequence + 1);
+			vd->window_drops += drops;
+			vd->stats.dropped += drops;
+		}
+		vd->last_sequence = stale.sequence;
+
+		vd->stats.frames++;
+		vd->stats.skipped++;
+		vd->fps_frame_count++;
+		skipped++;
+
+		if(xioctl(vd->fd, VIDIOC_QBUF, &stale) < 0)
+			fprintf(stderr, "V4L2_CORE: (VIDIOC_QBUF) Unable to queue buffer %i: %s\n", stale.index, strerror(errno));
+	}
+
+	if(skipped > 0 && verbosity > 2)
+		printf("V4L2_CORE: (low latency) skipped %i stale frames (sequence %u)\n",
+			skipped, vd->buf.sequence);
+
+	return skipped;
+}
+
+/*
+ * process input buffer
+ * args:
+ *   vd - pointer to video device data
+ *
+ * returns: frame_queue index
+ */
+static int process_input_buffer(v4l2_dev_t *vd)
+{
+	/*get next available frame in queue*/
+	int qind = get_next_ready_frame(vd);
+	
+	if(verbosity > 2)
+		printf("V4L2_CORE: process frame queue index %i\n", qind);
+	
+	if(qind < 0 || qind >= vd->frame_queue_size)
+	{
+		if(verbosity > 2)
+		fprintf(stderr,"V4L2_CORE: frame queue index %i is invalid (no free frames in queue?)\n", qind);
+		return -1; 
+	}
+	
+	vd->frame_queue[qind].status = FRAME_DECODING;
+
+	update_stream_stats(vd, qind);
+	
+	vd->frame_queue[qind].index = vd->buf.index;
+
+	vd->frame_queue[qind].frame_index = vd->frame_index;
+	vd->frame_index++;
+	
+	vd->frame_queue[qind].raw_frame_size = vd->buf.bytesused;
+	if(vd->frame_queue[qind].raw_frame_size == 0)
+	{
+		if(verbosity > 1)
+			fprintf(stderr, "V4L2_CORE: VIDIOC_QBUF returned buf.bytesused = 0 \n");
+	}
+	
+	/*point vd->raw_frame to current frame buffer*/
+	vd->frame_queue[qind].raw_frame = vd->mem[vd->buf.index];
+	vd->frame_queue[qind].dmabuf_fd = (vd->cap_meth == IO_MMAP) ? vd->buff_dmabuf_fd[vd->buf.index] : -1;
+
+	/*dump the raw frame for later replay*/
+	if(vd->replay_record != NULL)
+		replay_record_frame(vd, &vd->frame_queue[qind]);
+	
+	/*determine real fps every 3 sec aprox.*/
+	vd->fps_frame_count++;
+
+	if(vd->frame_queue[qind].timestamp - vd->fps_ref_ts >= (3 * NSEC_PER_SEC))
+	{
+		if(verbosity > 2)
+			printf("V4L2CORE: (fps) ref:%"PRId64" ts:%"PRId64" frames:%i\n",
+				vd->fps_ref_ts, vd->frame_queue[qind].timestamp, vd->fps_frame_count);
+		vd->real_fps = (double) (vd->fps_frame_count * NSEC_PER_SEC) / (double) (vd->frame_queue[qind].timestamp - vd->fps_ref_ts);
+		vd->fps_frame_count = 0;
+		vd->fps_ref_ts = vd->frame_queue[qind].timestamp;
+
+		update_adaptive_buffers(vd);
+	}
+	
+	return qind;
+} 
+ 
+/*
+ * print the latency summary if the dump interval elapsed
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+static void check_latency_dump(v4l2_dev_t *vd)
+{
+	if(!vd->latency_enabled || vd->latency_dump_interval == 0)
+		return;
+
+	uint64_t now = ns_time_monotonic();
+
+	if(now - vd->latency_dump_ts >= vd->latency_dump_interval)
+	{
+		vd->latency_dump_ts = now;
+		latency_stats_print(vd->latency);
 	}
+}
+
+/*
+ * gets the next video frame (must be released after processing)
+ *   damaged compressed frames are dropped (counted in stream stats)
+ *   in low latency mode only the newest ready frame is returned
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: pointer frame buffer (NULL on error)
+ */
+v4l2_frame_buff_t *v4l2core_dev_get_frame(v4l2_dev_t *vd)
+{
+	/*asserts*/
+	assert(vd != NULL);
+
+	int res = 0;
 
 	/*
-	 * try to alloc frame buffers based on requested format
+	 * a buffer count change was requested while streaming
+	 * (only possible while no frame holds a driver buffer)
 	 */
-	ret = alloc_v4l2_frames(vd);
-	if( ret != E_OK)
+	if(vd->flag_buffers_change > 0 && V4L2_STREAMING_IO(vd))
 	{
-		fprintf(stderr, "V4L2_CORE: Frame allocation returned error (%i)\n", ret);
-		return E_ALLOC_ERR;
+		__LOCK_MUTEX( __PMUTEX );
+		if(get_number_ready_frames(vd) == vd->frame_queue_size)
+		{
+			vd->flag_buffers_change = 0;
+			if(resize_v4l2_buffers(vd) != E_OK)
+				fprintf(stderr, "V4L2_CORE: couldn't change the number of buffers\n");
+		}
+		__UNLOCK_MUTEX( __PMUTEX );
 	}
 
-	switch (vd->cap_meth)
+	uint64_t lat_ts = latency_stats_start(vd);
+
+	int ret = check_frame_available(vd);
+
+	int qind = -1;
+	
+	if (ret < 0)
+		return NULL;
+
+	int bytes_used = 0;
+
+	switch(vd->cap_meth)
 	{
-		case IO_READ: /*allocate buffer for read*/
+		case IO_READ:
+
 			/*lock the mutex*/
 			__LOCK_MUTEX( __PMUTEX );
+			if(vd->streaming == STRM_OK)
+			{
+				vd->buf.bytesused = v4l2_read (vd->fd, vd->mem[vd->buf.index], vd->buf.length);
+				bytes_used = vd->buf.bytesused;
+				
+				if(bytes_used > 0)
+					qind = process_input_buffer(vd);
+			}
+			else res = -1;
+			/*unlock the mutex*/
+			__UNLOCK_MUTEX( __PMUTEX );
 
-			memset(&vd->buf, 0, sizeof(struct v4l2_buffer));
-			vd->buf.length = (vd->format.fmt.pix.width) * (vd->format.fmt.pix.height) * 3; //worst case (rgb)
-			vd->mem[vd->buf.index] = calloc(vd->buf.length, sizeof(uint8_t));
-			if(vd->mem[vd->buf.index] == NULL)
+			if(res < 0)
+				return NULL;
+
+			if (-1 == bytes_used )
 			{
-				fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (try_video_stream_format): %s\n", strerror(errno));
-				exit(-1);
+				switch (errno)
+				{
+					case EAGAIN:
+						fprintf(stderr, "V4L2_CORE: No data available for read: %s\n", strerror(errno));
+						break;
+					case EINVAL:
+						fprintf(stderr, "V4L2_CORE: Read method error, try mmap instead: %s\n", strerror(errno));
+						break;
+					case EIO:
+						fprintf(stderr, "V4L2_CORE: read I/O Error: %s\n", strerror(errno));
+						break;
+					default:
+						fprintf(stderr, "V4L2_CORE: read: %s\n", strerror(errno));
+						break;
+				}
+				return NULL;
 			}
+			break;
 
+		case IO_REPLAY:
+			/*lock the mutex*/
+			__LOCK_MUTEX( __PMUTEX );
+			if(vd->streaming == STRM_OK)
+			{
+				/*each frame in the queue has its own buffer*/
+				int ind = get_next_ready_frame(vd);
+				if(ind >= 0)
+				{
+					memset(&vd->buf, 0, sizeof(struct v4l2_buffer));
+					vd->buf.index = ind;
+					if(replay_read_frame(vd, vd->mem[ind], vd->buff_length[ind], &vd->buf) == E_OK)
+						qind = process_input_buffer(vd);
+				}
+				else if(verbosity > 2)
+					fprintf(stderr, "V4L2_CORE: (replay) no free frames in queue\n");
+			}
+			else res = -1;
 			/*unlock the mutex*/
 			__UNLOCK_MUTEX( __PMUTEX );
+
+			if(res < 0)
+				return NULL;
 			break;
 
 		case IO_MMAP:
 		default:
-			/* request buffers */
-			memset(&vd->rb, 0, sizeof(struct v4l2_requestbuffers));
-			vd->rb.count = NB_BUFFER;
-			vd->rb.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-			vd->rb.memory = V4L2_MEMORY_MMAP;
+			/* dequeue the buffers */
 
-			ret = xioctl(vd->fd, VIDIOC_REQBUFS, &vd->rb);
+			/*lock the mutex*/
+			__LOCK_MUTEX( __PMUTEX );
 
-			if (ret < 0)
-			{
-				fprintf(stderr, "V4L2_CORE: (VIDIOC_REQBUFS) Unable to allocate buffers: %s\n", strerror(errno));
-				return E_REQBUFS_ERR;
-			}
-			/* map the buffers */
-			if (query_buff(vd))
+			if(vd->streaming == STRM_OK)
 			{
-				fprintf(stderr, "V4L2_CORE: (VIDIOC_QBUFS) Unable to query buffers: %s\n", strerror(errno));
-				/*
-				 * delete requested buffers
-				 * no need to unmap as mmap failed for sure
-				 */
-				if(verbosity > 0)
-					printf("V4L2_CORE: cleaning requestbuffers\n");
-				memset(&vd->rb, 0, sizeof(struct v4l2_requestbuffers));
-				vd->rb.count = 0;
-				vd->rb.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-				vd->rb.memory = V4L2_MEMORY_MMAP;
-				if(xioctl(vd->fd, VIDIOC_REQBUFS, &vd->rb)<0)
-					fprintf(stderr, "V4L2_CORE: (VIDIOC_REQBUFS) Unable to delete buffers: %s\n", strerror(errno));
-
-				return E_QUERYBUF_ERR;
-			}
+				memset(&vd->buf, 0, sizeof(struct v4l2_buffer));
 
-			/* Queue the buffers */
-			if (queue_buff(vd))
-			{
-				fprintf(stderr, "V4L2_CORE: (VIDIOC_QBUFS) Unable to queue buffers: %s\n", strerror(errno));
-				/*delete requested buffers */
-				if(verbosity > 0)
-					printf("V4L2_CORE: cleaning requestbuffers\n");
-				unmap_buff(vd);
-				memset(&vd->rb, 0, sizeof(struct v4l2_requestbuffers));
-				vd->rb.count = 0;
-				vd->rb.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-				vd->rb.memory = V4L2_MEMORY_MMAP;
-				if(xioctl(vd->fd, VIDIOC_REQBUFS, &vd->rb)<0)
-					fprintf(stderr, "V4L2_CORE: (VIDIOC_REQBUFS) Unable to delete buffers: %s\n", strerror(errno));
-				return E_QBUF_ERR;
+				vd->buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+				vd->buf.memory = V4L2_MEMORY_TYPE(vd);
+
+				ret = xioctl(vd->fd, VIDIOC_DQBUF, &vd->buf);
+
+				if(!ret && vd->low_latency)
+					skip_stale_buffers(vd);
+
+				if(!ret)
+					qind = process_input_buffer(vd);
+				else
+					fprintf(stderr, "V4L2_CORE: (VIDIOC_DQBUF) Unable to dequeue buffer: %s\n", strerror(errno));
 			}
+			else res = -1;
+
+			/*unlock the mutex*/
+			__UNLOCK_MUTEX( __PMUTEX );
+
+			if(res < 0 || ret < 0)
+				return NULL;
 	}
 
-	/*this locks the mutex (can't be called while the mutex is being locked)*/
-	v4l2core_request_framerate_update();
+	if(qind < 0 || qind >= vd->frame_queue_size)
+		return NULL;
+
+	latency_stats_stop(vd, LATENCY_DQBUF, lat_ts);
+	check_latency_dump(vd);
+
+	/*
+	 * drop damaged frames (e.g. truncated usb payloads) before they
+	 * reach the decoder or the recorder: the render keeps the last good frame
+	 */
+	ret = check_v4l2_frame(vd, &vd->frame_queue[qind]);
+	if(ret != E_OK)
+	{
+		__LOCK_MUTEX( __PMUTEX );
+		vd->stats.corrupt++;
+		__UNLOCK_MUTEX( __PMUTEX );
+
+		if(verbosity > 1)
+			fprintf(stderr, "V4L2_CORE: dropping damaged frame %" PRIu64 " (%i bytes): error %i\n",
+				vd->frame_queue[qind].frame_index, (int) vd->frame_queue[qind].raw_frame_size, ret);
+
+		v4l2core_dev_release_frame(vd, &vd->frame_queue[qind]);
+		return NULL;
+	}
+		
+	return &vd->frame_queue[qind];
+}
+
+/*
+ * releases the video frame (so that it can be reused by the driver)
+ * args:
+ *   vd - pointer to video device data
+ *   frame - pointer to decoded frame buffer
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: error code (E_OK)
+ */
+int v4l2core_dev_release_frame(v4l2_dev_t *vd, v4l2_frame_buff_t *frame)
+{
+	int ret = 0;
+
+	uint64_t lat_ts = latency_stats_start(vd);
+
+	/*
+	 * don't use vd->buf: with the decoding pipeline
+	 * the dequeue thread may be using it
+	 */
+	struct v4l2_buffer buf;
+
+	switch(vd->cap_meth)
+	{
+		case IO_READ:
+		case IO_REPLAY:
+			break;
+		
+		case IO_MMAP:
+		default:
+			//match the v4l2_buffer with the correspondig frame
+			memset(&buf, 0, sizeof(struct v4l2_buffer));
+			buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+			buf.memory = V4L2_MEMORY_TYPE(vd);
+			buf.index = frame->index;
+			if(vd->cap_meth == IO_USERPTR)
+			{
+				buf.m.userptr = (unsigned long) vd->mem[frame->index];
+				buf.length = vd->buff_length[frame->index];
+			}
+
+			/* queue the buffer */
+			ret = xioctl(vd->fd, VIDIOC_QBUF, &buf);
+
+			if(ret)
+				fprintf(stderr, "V4L2_CORE: (VIDIOC_QBUF) Unable to queue buffer %i: %s\n", frame->index, strerror(errno));
+			break;	
+	}
+	
+	/*lock the mutex*/
+	__LOCK_MUTEX( __PMUTEX );
+	frame->raw_frame = NULL;
+	frame->raw_frame_size = 0;
+	frame->dmabuf_fd = -1;
+	frame->status = FRAME_READY;
+	/*wake the pipeline dequeue thread (if waiting for a free frame)*/
+	frame_pipeline_frame_released(vd);
+	/*unlock the mutex*/
+	__UNLOCK_MUTEX( __PMUTEX );
+
+	latency_stats_stop(vd, LATENCY_QBUF, lat_ts);
+	
+	if (ret < 0)
+		return E_QBUF_ERR;
+	
+	return E_OK;		
+}
+
+/*
+ * get the dma-buf fd exported for the frame raw buffer
+ *   (owned by the device: closed in unmap_buff)
+ * args:
+ *   vd - pointer to video device data
+ *   frame - pointer to frame buffer
+ *
+ * asserts:
+ *   vd is not null
+ *   frame is not null
+ *
+ * returns: dma-buf fd or -1 if not available
+ */
+int v4l2core_dev_get_frame_dmabuf_fd(v4l2_dev_t *vd, v4l2_frame_buff_t *frame)
+{
+	/*assertions*/
+	assert(vd != NULL);
+	assert(frame != NULL);
+
+	/*only mmap buffers are exported*/
+	if(vd->cap_meth != IO_MMAP || frame->raw_frame == NULL)
+		return -1;
+
+	return frame->dmabuf_fd;
+}
+
+/*
+ * gets the next video frame and decodes it
+ *   if the decoding pipeline is running the next decoded
+ *   frame (in capture order) is taken from the pipeline
+ * args:
+ *   vd - pointer to video device data
+ *
+ * returns: pointer to decoded frame buffer ( NULL on error)
+ */
+v4l2_frame_buff_t *v4l2core_dev_get_decoded_frame(v4l2_dev_t *vd)
+{
+	/*frames are decoded by the pipeline threads*/
+	if(vd->pipeline != NULL)
+		return frame_pipeline_get_frame(vd);
+
+	v4l2_frame_buff_t *frame = v4l2core_dev_get_frame(vd);
+	if(frame != NULL)
+	{
+		uint64_t lat_ts = latency_stats_start(vd);
+
+		/*decode the raw frame*/
+		if(decode_v4l2_frame(vd, frame) != E_OK)
+		{
+			fprintf(stderr, "V4L2_CORE: Error - Couldn't decode frame\n");
+		}
+
+		latency_stats_stop(vd, LATENCY_DECODE, lat_ts);
+	}
+	
+	return frame;
+}
+
+/*
+ * decodes a frame (from v4l2core_dev_get_frame)
+ *   if planes is set the frame is decoded straight into them
+ *   (e.g. a locked render buffer) honouring the plane pitches,
+ *   saving a full frame copy; frame->yuv_frame may then not
+ *   hold the decoded frame
+ * args:
+ *   vd - pointer to video device data
+ *   frame - pointer to frame buffer
+ *   planes - output planes (yu12: y, u, v; yuyv: a single plane)
+ *      or null to decode to frame->yuv_frame
+ *   pitches - output plane pitches
+ *
+ * asserts:
+ *   vd is not null
+ *   frame is not null
+ *
+ * returns: error code (0- E_OK)
+ */
+int v4l2core_dev_decode_frame(v4l2_dev_t *vd, v4l2_frame_buff_t *frame, uint8_t **planes, int *pitches)
+{
+	/*assertions*/
+	assert(vd != NULL);
+	assert(frame != NULL);
+
+	uint64_t lat_ts = latency_stats_start(vd);
+
+	int ret = (planes != NULL) ?
+		decode_v4l2_frame_to(vd, frame, planes, pitches) :
+		decode_v4l2_frame(vd, frame);
+
+	if(ret != E_OK)
+		fprintf(stderr, "V4L2_CORE: Error - Couldn't decode frame\n");
+
+	latency_stats_stop(vd, LATENCY_DECODE, lat_ts);
+
+	return ret;
+}
+
+/*
+ * decodes a frame (from v4l2core_dev_get_frame) to frame->yuv_frame
+ *   at the preview size: frame->yuv_scale is set to the scale used
+ * args:
+ *   vd - pointer to video device data
+ *   frame - pointer to frame buffer
+ *
+ * asserts:
+ *   vd is not null
+ *   frame is not null
+ *
+ * returns: error code (0- E_OK)
+ */
+int v4l2core_dev_decode_preview_frame(v4l2_dev_t *vd, v4l2_frame_buff_t *frame)
+{
+	/*assertions*/
+	assert(vd != NULL);
+	assert(frame != NULL);
+
+	uint64_t lat_ts = latency_stats_start(vd);
+
+	int ret = decode_v4l2_frame_preview(vd, frame);
+
+	if(ret != E_OK)
+		fprintf(stderr, "V4L2_CORE: Error - Couldn't decode frame\n");
+
+	latency_stats_stop(vd, LATENCY_DECODE, lat_ts);
+
+	return ret;
+}
+
+/*
+ * copies a decoded frame (frame->yuv_frame) to the given planes
+ *   honouring the plane pitches and decimated to the preview size
+ * args:
+ *   vd - pointer to video device data
+ *   frame - pointer to decoded frame buffer
+ *   planes - output planes (yu12: y, u, v; yuyv: a single plane)
+ *   pitches - output plane pitches
+ *
+ * asserts:
+ *   vd is not null
+ *   frame is not null
+ *   planes is not null
+ *   pitches is not null
+ *
+ * returns: error code (0- E_OK)
+ */
+int v4l2core_dev_copy_frame(v4l2_dev_t *vd, v4l2_frame_buff_t *frame, uint8_t **planes, int *pitches)
+{
+	/*assertions*/
+	assert(vd != NULL);
+	assert(frame != NULL);
+	assert(planes != NULL);
+	assert(pitches != NULL);
+
+	int ret = copy_v4l2_frame_to(vd, frame, planes, pitches);
+
+	if(ret != E_OK)
+		fprintf(stderr, "V4L2_CORE: Error - Couldn't copy frame\n");
+
+	return ret;
+}
+
+/*
+ * starts the decoding pipeline for the video stream:
+ *   a dequeue thread and ndecoders decoder threads
+ * args:
+ *   vd - pointer to video device data
+ *   ndecoders - number of decoder threads
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: error code (0- E_OK)
+ */
+int v4l2core_dev_start_pipeline(v4l2_dev_t *vd, int ndecoders)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	if(vd->cap_meth == IO_READ)
+	{
+		/*read method uses a single buffer for all frames*/
+		fprintf(stderr, "V4L2_CORE: (pipeline) not supported for read capture method\n");
+		return E_UNKNOWN_ERR;
+	}
+
+	if(vd->streaming != STRM_OK)
+	{
+		fprintf(stderr, "V4L2_CORE: (pipeline) video stream must be started first\n");
+		return E_NO_STREAM_ERR;
+	}
+
+	if(vd->frame_queue_size < 2 && verbosity > 0)
+		printf("V4L2_CORE: (pipeline) frame queue size is %i, frames won't be decoded in parallel\n",
+			vd->frame_queue_size);
+
+	return frame_pipeline_start(vd, ndecoders);
+}
+
+/*
+ * stops the decoding pipeline
+ *   frames not yet delivered are returned to the driver
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_stop_pipeline(v4l2_dev_t *vd)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	frame_pipeline_stop(vd);
+}
+
+/*
+ * set the number of (m)jpeg band decoding threads
+ * args:
+ *   vd - pointer to video device data
+ *   nthreads - number of band threads (0 - disabled)
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_set_jpeg_band_threads(v4l2_dev_t *vd, int nthreads)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	vd->jpeg_band_threads = (nthreads > 0) ? nthreads : 0;
+
+	set_band_threads(vd);
+}
+
+/*
+ * set the number of raw bayer stripe decoding threads
+ * args:
+ *   vd - pointer to video device data
+ *   nthreads - number of stripe threads (0 - disabled)
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_set_bayer_threads(v4l2_dev_t *vd, int nthreads)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	vd->bayer_threads = (nthreads > 0) ? nthreads : 0;
+
+	set_band_threads(vd);
+}
+
+/*
+ * set the number of raw frame conversion band threads
+ * args:
+ *   vd - pointer to video device data
+ *   nthreads - number of band threads (0 - disabled)
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_set_convert_threads(v4l2_dev_t *vd, int nthreads)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	vd->convert_threads = (nthreads > 0) ? nthreads : 0;
+
+	set_band_threads(vd);
+}
+
+/*
+ * set the yuv colorimetry used for rgb image snapshots
+ * args:
+ *   vd - pointer to video device data
+ *   matrix - YUV_MATRIX_xxx (YUV_MATRIX_AUTO - from the format)
+ *   range - YUV_RANGE_xxx (YUV_RANGE_AUTO - from the format)
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_set_yuv_colorimetry(v4l2_dev_t *vd, int matrix, int range)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	vd->yuv_matrix = (matrix >= YUV_MATRIX_BT601 && matrix <= YUV_MATRIX_BT2020) ? matrix : YUV_MATRIX_AUTO;
+	vd->yuv_range = (range == YUV_RANGE_FULL || range == YUV_RANGE_LIMITED) ? range : YUV_RANGE_AUTO;
+}
+
+/*
+ * set the 16 bit luma mode (Y10B and Y16 formats)
+ * args:
+ *   vd - pointer to video device data
+ *   enable - 1: keep 16 bit luma; 0: 8 bit only (default)
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_set_luma16_mode(v4l2_dev_t *vd, int enable)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	vd->luma16_mode = enable ? 1 : 0;
+}
+
+/*
+ * set the preview scale denominator
+ *   (m)jpeg frames decoded with v4l2core_dev_decode_frame into
+ *   client planes are scaled down in the idct (1/2, 1/4 or 1/8)
+ *   the frame buffer (yuv_frame) is always at full resolution
+ * args:
+ *   vd - pointer to video device data
+ *   scale - preview scale denominator (1, 2, 4 or 8)
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_set_preview_scale(v4l2_dev_t *vd, int scale)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	/*dct scaling factors: round down to a power of 2*/
+	vd->preview_scale = 1;
+	while(vd->preview_scale < 8 && vd->preview_scale * 2 <= scale)
+		vd->preview_scale *= 2;
+}
+
+/*
+ * set the pipeline preview mode
+ *   the pipeline decodes (m)jpeg frames at the preview scale
+ * args:
+ *   vd - pointer to video device data
+ *   enable - 1 enable, 0 disable (default)
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_set_pipeline_preview(v4l2_dev_t *vd, int enable)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	vd->pipeline_preview = enable ? 1 : 0;
+}
+
+/*
+ * get the preview width
+ *   (the frame width scaled down by the preview scale)
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: preview width
+ */
+int v4l2core_dev_get_preview_width(v4l2_dev_t *vd)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	return vd->format.fmt.pix.width / get_preview_scale(vd);
+}
+
+/*
+ * get the preview height
+ *   (the frame height scaled down by the preview scale)
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: preview height
+ */
+int v4l2core_dev_get_preview_height(v4l2_dev_t *vd)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	return vd->format.fmt.pix.height / get_preview_scale(vd);
+}
+
+/*
+ * set the video stream format for a replay file
+ *   (format and resolution are fixed by the file)
+ * args:
+ *   vd - pointer to video device data
+ *   width - requested width
+ *   height - requested height
+ *   pixelformat - requested pixel format
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: error code ( 0 - E_OK)
+ */
+static int try_replay_format(v4l2_dev_t *vd, int width, int height, int pixelformat)
+{
+	/*assertions*/
+	assert(vd != NULL);
+	assert(vd->list_stream_formats != NULL);
+
+	v4l2_stream_cap_t *cap = &vd->list_stream_formats[0].list_stream_cap[0];
+
+	if(pixelformat != vd->list_stream_formats[0].format || width != cap->width || height != cap->height)
+		fprintf(stderr, "V4L2_CORE: (replay) using the recorded format %s %ix%i\n",
+			vd->list_stream_formats[0].fourcc, cap->width, cap->height);
+
+	/*lock the mutex*/
+	__LOCK_MUTEX( __PMUTEX );
+
+	uint8_t stream_status = vd->streaming;
+
+	if(stream_status == STRM_OK)
+		v4l2core_dev_stop_stream(vd);
+
+	vd->requested_fmt = vd->list_stream_formats[0].format;
+	vd->format.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	vd->format.fmt.pix.pixelformat = vd->requested_fmt;
+	vd->format.fmt.pix.width = cap->width;
+	vd->format.fmt.pix.height = cap->height;
+	vd->format.fmt.pix.field = V4L2_FIELD_NONE;
+
+	/*unlock the mutex*/
+	__UNLOCK_MUTEX( __PMUTEX );
+
+	int ret = alloc_v4l2_frames(vd);
+	if( ret != E_OK)
+	{
+		fprintf(stderr, "V4L2_CORE: Frame allocation returned error (%i)\n", ret);
+		return E_ALLOC_ERR;
+	}
+
+	/*lock the mutex*/
+	__LOCK_MUTEX( __PMUTEX );
+
+	/*one buffer for each frame in the queue*/
+	free_replay_buffers(vd);
+	alloc_buff_arrays(vd, vd->frame_queue_size);
+
+	int i = 0;
+	for(i = 0; i < vd->num_buffers; ++i)
+	{
+		vd->buff_length[i] = cap->width * cap->height * 3; //worst case (rgb)
+		vd->mem[i] = calloc(vd->buff_length[i], sizeof(uint8_t));
+		if(vd->mem[i] == NULL)
+		{
+			fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (try_replay_format): %s\n", strerror(errno));
+			exit(-1);
+		}
+	}
+
+	/*unlock the mutex*/
+	__UNLOCK_MUTEX( __PMUTEX );
+
+	if(stream_status == STRM_OK)
+		v4l2core_dev_start_stream(vd);
+
+	return E_OK;
+}
+
+/*
+ * Try/Set device video stream format
+ * args:
+ *   vd - pointer to video device data
+ *   width - requested video frame width
+ *   height - requested video frame height
+ *   pixelformat - requested v4l2 pixelformat
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: error code ( E_OK)
+ */
+static int try_video_stream_format(v4l2_dev_t *vd, int width, int height, int pixelformat)
+{
+#ifdef _SUB_CHANNEL_BSP_            
+    struct v4l2_pix_format subch_fmt;
+#endif    
+    struct v4l2_streamparm parms;
+    struct v4l2_input inp;
+    config_t *my_config;    
+
+	/*assertions*/
+	assert(vd != NULL);
+
+	int ret = E_OK;
+
+	if(vd->cap_meth == IO_REPLAY)
+		return try_replay_format(vd, width, height, pixelformat);
+
+    my_config = config_get();
+
+	/*lock the mutex*/
+	__LOCK_MUTEX( __PMUTEX );
+
+	vd->requested_fmt = pixelformat;
+
+	uint8_t stream_status = vd->streaming;
+
+	if(stream_status == STRM_OK)
+		v4l2core_dev_stop_stream(vd);
+
+    inp.index = vd->this_device;
+    if (-1 == xioctl(vd->fd, VIDIOC_S_INPUT, &inp))
+        printf("VIDIOC_S_INPUT error!\n");
+
+    if (my_config->cmos_camera) {
+        CLEAR(parms);
+        parms.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        parms.parm.capture.timeperframe.numerator = 1;
+        parms.parm.capture.timeperframe.denominator = 25;
+        parms.parm.capture.capturemode = 2;
+        if (-1 == xioctl(vd->fd, VIDIOC_S_PARM, &parms))
+            printf("VIDIOC_S_PARM error\n");
+    }
+
+	vd->format.fmt.pix.pixelformat = pixelformat;
+	vd->format.fmt.pix.width = width;
+	vd->format.fmt.pix.height = height;
+
+#ifdef _SUB_CHANNEL_BSP_        
+    if (my_config->cmos_camera) {
+        CLEAR(subch_fmt);
+        vd->format.fmt.pix.subchannel = &subch_fmt;
+        subch_fmt.width = width / 2;
+        subch_fmt.height = height / 2;
+        subch_fmt.pixelformat = pixelformat;       
+        subch_fmt.field = V4L2_FIELD_NONE;        
+        subch_fmt.rot_angle = 0;
+    }
+#endif    
+
+	/* make sure we set a valid format*/
+	if(verbosity > 0)
+		printf("V4L2_CORE: CMOS CAMERA: %d - checking format: %c%c%c%c\n",
+            my_config->cmos_camera,
+			(vd->format.fmt.pix.pixelformat) & 0xFF, ((vd->format.fmt.pix.pixelformat) >> 8) & 0xFF,
+			((vd->format.fmt.pix.pixelformat) >> 16) & 0xFF, ((vd->format.fmt.pix.pixelformat) >> 24) & 0xFF);
+
+	/*override field and type entries*/
+	vd->format.fmt.pix.field = V4L2_FIELD_NONE; // V4L2_FIELD_ANY;
+	vd->format.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+
+	ret = xioctl(vd->fd, VIDIOC_S_FMT, &vd->format);
+
+	/*unlock the mutex*/
+	__UNLOCK_MUTEX( __PMUTEX );
+
+	if (ret != 0)
+	{
+		fprintf(stderr, "V4L2_CORE: (VIDIOC_S_FORMAT) Unable to set format: %s\n", strerror(errno));
+		return E_FORMAT_ERR;
+	}
+
+	if ((vd->format.fmt.pix.width != width) ||
+		(vd->format.fmt.pix.height != height))
+	{
+		fprintf(stderr, "V4L2_CORE: Requested resolution unavailable: got width %d height %d\n",
+		vd->format.fmt.pix.width, vd->format.fmt.pix.height);
+	}
+
+	/*
+	 * try to alloc frame buffers based on requested format
+	 */
+	ret = alloc_v4l2_frames(vd);
+	if( ret != E_OK)
+	{
+		fprintf(stderr, "V4L2_CORE: Frame allocation returned error (%i)\n", ret);
+		return E_ALLOC_ERR;
+	}
+
+	switch (vd->cap_meth)
+	{
+		case IO_READ: /*allocate buffer for read*/
+			/*lock the mutex*/
+			__LOCK_MUTEX( __PMUTEX );
+
+			memset(&vd->buf, 0, sizeof(struct v4l2_buffer));
+			/*a single buffer for read*/
+			alloc_buff_arrays(vd, 1);
+			vd->buf.length = (vd->format.fmt.pix.width) * (vd->format.fmt.pix.height) * 3; //worst case (rgb)
+			vd->mem[vd->buf.index] = calloc(vd->buf.length, sizeof(uint8_t));
+			if(vd->mem[vd->buf.index] == NULL)
+			{
+				fprintf(stderr, "V4L2_CORE: FATAL memory allocation failure (try_video_stream_format): %s\n", strerror(errno));
+				exit(-1);
+			}
+
+			/*unlock the mutex*/
+			__UNLOCK_MUTEX( __PMUTEX );
+			break;
+
+		case IO_MMAP:
+		default:
+			ret = request_v4l2_buffers(vd);
+			if(ret != E_OK)
+				return ret;
+			break;
+	}
+
+	/*this locks the mutex (can't be called while the mutex is being locked)*/
+	v4l2core_dev_request_framerate_update(vd);
+
+	if(stream_status == STRM_OK)
+		v4l2core_dev_start_stream(vd);
+
+	/*update the current framerate for the device*/
+	v4l2core_dev_get_framerate(vd);
+
+	return E_OK;
+}
+
+/*
+ * get frame width
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: frame width
+ */
+int v4l2core_dev_get_frame_width(v4l2_dev_t *vd)
+{
+	/*assertions*/
+	assert(vd != NULL);
+	
+	return vd->format.fmt.pix.width;
+}
+
+/*
+ * get frame height
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: frame height
+ */
+int v4l2core_dev_get_frame_height(v4l2_dev_t *vd)
+{
+	/*assertions*/
+	assert(vd != NULL);
+	
+	return vd->format.fmt.pix.height;
+}
+
+/*
+ * get requested frame format
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: requested frame format
+ */
+int v4l2core_dev_get_requested_frame_format(v4l2_dev_t *vd)
+{
+	/*asserts*/
+	assert(vd != NULL);
+	
+	return vd->requested_fmt;
+}
+
+/*
+ * prepare new format
+ * args:
+ *   vd - pointer to video device data
+ *   new_format - new format
+ *
+ * asserts:
+ *    vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_prepare_new_format(v4l2_dev_t *vd, int new_format)
+{
+	/*asserts*/
+	assert(vd != NULL);
+
+	int format_index = v4l2core_dev_get_frame_format_index(vd, new_format);
+
+	if(format_index < 0)
+		format_index = 0;
+
+	vd->prep_pixelformat = vd->list_stream_formats[format_index].format;
+}
+
+/*
+ * prepare a valid format (first in the format list)
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *    vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_prepare_valid_format(v4l2_dev_t *vd)
+{
+	/*asserts*/
+	assert(vd != NULL);
+
+	int format_index = 0;
+
+	vd->prep_pixelformat = vd->list_stream_formats[format_index].format;
+}
+
+/*
+ * prepare new resolution
+ * args:
+ *   vd - pointer to video device data
+ *   new_width - new width
+ *   new_height - new height
+ *
+ * asserts:
+ *    vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_prepare_new_resolution(v4l2_dev_t *vd, int new_width, int new_height)
+{
+	/*asserts*/
+	assert(vd != NULL);
+
+	int format_index = v4l2core_dev_get_frame_format_index(vd, vd->prep_pixelformat);
+
+	if(format_index < 0)
+		format_index = 0;
+
+	int resolution_index = v4l2core_dev_get_format_resolution_index(vd, format_index, new_width, new_height);
+
+	if(resolution_index < 0)
+		resolution_index = 0;
+
+	vd->prep_width  = vd->list_stream_formats[format_index].list_stream_cap[resolution_index].width;
+	vd->prep_height = vd->list_stream_formats[format_index].list_stream_cap[resolution_index].height;
+}
+
+/*
+ * prepare valid resolution (first in the resolution list for the format)
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *    vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_prepare_valid_resolution(v4l2_dev_t *vd)
+{
+	/*asserts*/
+	assert(vd != NULL);
+
+	int format_index = v4l2core_dev_get_frame_format_index(vd, vd->prep_pixelformat);
+
+	if(format_index < 0)
+		format_index = 0;
+
+	int resolution_index = 0;
+
+	vd->prep_width  = vd->list_stream_formats[format_index].list_stream_cap[resolution_index].width;
+	vd->prep_height = vd->list_stream_formats[format_index].list_stream_cap[resolution_index].height;
+}
+
+/*
+ * update the current format (pixelformat, width and height)
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *    vd is not null
+ *
+ * returns:
+ *    error code
+ */
+int v4l2core_dev_update_current_format(v4l2_dev_t *vd)
+{
+	/*asserts*/
+	assert(vd != NULL);
+
+	return(try_video_stream_format(vd, vd->prep_width, vd->prep_height, vd->prep_pixelformat));
+}
+
+/*
+ * clean video device data allocation
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: void
+ */
+static void clean_v4l2_dev(v4l2_dev_t *vd)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	if(vd->videodevice)
+		free(vd->videodevice);
+	vd->videodevice = NULL;
+
+	if(vd->list_device_controls)
+		free_v4l2_control_list(vd);
+
+	if(vd->list_stream_formats)
+		free_frame_formats(vd);
+
+	if(vd->list_device_controls)
+		free_v4l2_control_list(vd);
+	
+	if(vd->frame_queue)
+		free(vd->frame_queue);
+
+	free_buff_arrays(vd);
+
+	latency_stats_delete(vd->latency);
+	vd->latency = NULL;
+
+	jpeg_close_decoder(vd->jpeg_ctx);
+	vd->jpeg_ctx = NULL;
+
+	bayer_close_decoder(vd->bayer_ctx);
+	vd->bayer_ctx = NULL;
+
+	band_executor_destroy(vd->band_exec);
+	vd->band_exec = NULL;
+
+	replay_record_stop(vd);
+	replay_close(vd);
+	
+	close_v4l2_events(vd);
+
+	/*close descriptor*/
+	if(vd->fd > 0)
+		v4l2_close(vd->fd);
+
+	vd->fd = 0;
+
+	__CLOSE_MUTEX(__PMUTEX);
+
+	free(vd);
+}
+
+/*
+ * Open a video device and initiate its data with default values
+ * args:
+ *   device - device name (e.g: "/dev/video0")
+ *
+ * asserts:
+ *   device is not null
+ *
+ * returns: handle to the new device data (NULL on error)
+ */
+v4l2_dev_t *v4l2core_dev_open(const char *device)
+{
+	assert(device != NULL);
+#if 0
+	/*localization*/
+	char* lc_all = setlocale (LC_ALL, "");
+	char* lc_dir = bindtextdomain (GETTEXT_PACKAGE_V4L2CORE, PACKAGE_LOCALE_DIR);
+	bind_textdomain_codeset (GETTEXT_PACKAGE_V4L2CORE, "UTF-8");
+	if (verbosity > 1) printf("V4L2_CORE: language catalog=> dir:%s type:%s cat:%s.mo\n",
+		lc_dir, lc_all, GETTEXT_PACKAGE_V4L2CORE);
+#endif
+	/*alloc the device data*/
+	v4l2_dev_t *vd = calloc(1, sizeof(v4l2_dev_t));
+
+	assert(vd != NULL);
+
+	__INIT_MUTEX(__PMUTEX);
+
+	/*no event fds yet*/
+	vd->epoll_fd = -1;
+	vd->wakeup_fd = -1;
+	vd->timer_fd = -1;
+
+	/*MMAP by default*/
+	vd->cap_meth = IO_MMAP;
+
+	vd->videodevice = strdup(device);
+
+	if(verbosity > 0)
+	{
+		printf("V4L2_CORE: capture method mmap (%i)\n",vd->cap_meth);
+		printf("V4L2_CORE: video device: %s \n", vd->videodevice);
+	}
+
+	vd->frame_queue_size = frame_queue_size;
+	/*alloc frame buffer queue*/
+	vd->frame_queue = calloc(vd->frame_queue_size, sizeof(v4l2_frame_buff_t));
+	
+	/*set some defaults*/
+	vd->fps_num = 1;
+	vd->fps_denom = 25;
+
+	vd->pan_step = 128;
+	vd->tilt_step = 128;
+
+	/*full resolution preview*/
+	vd->preview_scale = 1;
+
+	/*driver buffers are allocated with the stream format*/
+	vd->requested_buffers = NB_BUFFER;
+	vd->last_sequence = -1;
+
+	/*a recorded stream is replayed through the same frame path*/
+	if(replay_check_file(vd->videodevice))
+	{
+		vd->fd = -1;
+		vd->cap_meth = IO_REPLAY;
+
+		if(replay_open(vd, vd->videodevice) != E_OK ||
+			init_v4l2_events(vd) != E_OK)
+		{
+			clean_v4l2_dev(vd);
+			return NULL;
+		}
+
+		return vd;
+	}
+
+	/*open device*/
+	if ((vd->fd = v4l2_open(vd->videodevice, O_RDWR | O_NONBLOCK, 0)) < 0)
+	{
+		fprintf(stderr, "V4L2_CORE: ERROR opening V4L interface: %s\n", strerror(errno));
+		clean_v4l2_dev(vd);
+		return NULL;
+	}
+
+	if(init_v4l2_events(vd) != E_OK)
+	{
+		clean_v4l2_dev(vd);
+		return NULL;
+	}
+
+	vd->this_device = v4l2core_get_device_index(vd->videodevice);
+	if(vd->this_device < 0)
+		vd->this_device = 0;
+
+	v4l2_device_list *device_list = v4l2core_get_device_list();
+	if(device_list && device_list->list_devices)
+		device_list->list_devices[vd->this_device].current = 1;
+
+	/*try to map known xu controls (we could/should leave this for libwebcam)*/
+	init_xu_ctrls(vd);
+
+	/*zero structs*/
+	memset(&vd->cap, 0, sizeof(struct v4l2_capability));
+	memset(&vd->format, 0, sizeof(struct v4l2_format));
+	memset(&vd->buf, 0, sizeof(struct v4l2_buffer));
+	memset(&vd->rb, 0, sizeof(struct v4l2_requestbuffers));
+	memset(&vd->streamparm, 0, sizeof(struct v4l2_streamparm));
+
+	if(check_v4l2_dev(vd) != E_OK)
+	{
+		clean_v4l2_dev(vd);
+		return NULL;
+	}
+
+	return vd;
+}
+
+/*
+ * Initiate video device data with default values
+ *   (opens the default device for the single device api)
+ * args:
+ *   device - device name (e.g: "/dev/video0")
+ *
+ * asserts:
+ *   device is not null
+ *
+ * returns: error code  (< 0) on error
+ */
+int v4l2core_init_dev(const char *device)
+{
+	my_vd = v4l2core_dev_open(device);
+	if(my_vd == NULL)
+		return (-1);
+
+	/*if we have a focus control initiate the software autofocus*/
+	if(my_vd->has_focus_control_id)
+	{
+		if(soft_autofocus_init(my_vd) != E_OK)
+			my_vd->has_focus_control_id = 0;
+	}
+
+	return (0);
+}
+
+/*
+ * get the default device handle (the one used by the single device api)
+ * args:
+ *   none
+ *
+ * asserts:
+ *   none
+ *
+ * returns: default device handle (NULL if v4l2core_init_dev was not called)
+ */
+v4l2_dev_t *v4l2core_get_default_dev()
+{
+	return my_vd;
+}
+
+/*
+ * get stream frame format list for device
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *    vd is not null
+ *
+ * return: pointer to first format in the list
+ */
+v4l2_stream_formats_t *v4l2core_dev_get_formats_list(v4l2_dev_t *vd)
+{
+	/*assertions*/
+	assert(vd != NULL);
+	
+	return vd->list_stream_formats;
+}
+
+/*
+ * get device control list
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *    vd is not null
+ *
+ * return: pointer to first control in the list
+ */
+v4l2_ctrl_t *v4l2core_dev_get_control_list(v4l2_dev_t *vd)
+{
+	/*assertions*/
+	assert(vd != NULL);
+	
+	return vd->list_device_controls;
+}
+
+/*
+ * get device pan step value
+ * args:
+ *    none
+ *
+ * asserts:
+ *    my_vd is not null
+ *
+ * return: pan step value
+ */
+int v4l2core_get_pan_step()
+{
+	/*assertions*/
+	assert(my_vd != NULL);
+	
+	return my_vd->pan_step;
+}
+
+/*
+ * get device tilt step value
+ * args:
+ *    none
+ *
+ * asserts:
+ *    my_vd is not null
+ *
+ * return: tilt step value
+ */
+int v4l2core_get_tilt_step()
+{
+	/*assertions*/
+	assert(my_vd != NULL);
+	
+	return my_vd->tilt_step;
+}
+
+/*
+ * set device pan step value
+ * args:
+ *    step - pan step value
+ *
+ * asserts:
+ *    my_vd is not null
+ *
+ * return: none
+ */
+void v4l2core_set_pan_step(int step)
+{
+	/*assertions*/
+	assert(my_vd != NULL);
+	
+	my_vd->pan_step = step;
+}
+
+/*
+ * set device tilt step value
+ * args:
+ *    step -tilt step value
+ *
+ * asserts:
+ *    my_vd is not null
+ *
+ * return: none
+ */
+void v4l2core_set_tilt_step(int step)
+{
+	/*assertions*/
+	assert(my_vd != NULL);
+	
+	my_vd->tilt_step = step;
+}
+
+/*
+ * initiate software autofocus
+ * args:
+ *    none
+ *
+ * asserts:
+ *    none
+ *
+ * returns: error code (0 - E_OK)
+ */
+int v4l2core_soft_autofocus_init ()
+{
+	return soft_autofocus_init(my_vd);
+}
+
+/*
+ * run the software autofocus
+ * args:
+ *    frame - pointer to frame buffer
+ *
+ * asserts:
+ *    my_vd is not null
+ *
+ * returns: 1 - running  0- focused
+ * 	(only matters for non-continue focus)
+ */
+int v4l2core_soft_autofocus_run(v4l2_frame_buff_t *frame)
+{
+	uint64_t lat_ts = latency_stats_start(my_vd);
+
+	int ret = soft_autofocus_run(my_vd, frame);
+
+	latency_stats_stop(my_vd, LATENCY_AUTOFOCUS, lat_ts);
+
+	return ret;
+}
+
+/*
+ * clean v4l2 buffers
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *    vd is not null
+ *
+ * return: none
+ */
+void v4l2core_dev_clean_buffers(v4l2_dev_t *vd)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	if(verbosity > 1)
+		printf("V4L2_CORE: cleaning v4l2 buffers\n");
+
+	/*frame buffers will be freed, make sure nobody is using them*/
+	frame_pipeline_stop(vd);
+
+	if(vd->streaming == STRM_OK)
+		v4l2core_dev_stop_stream(vd);
+
+	clean_v4l2_frames(vd);
+
+	// unmap queue buffers
+	switch(vd->cap_meth)
+	{
+		case IO_READ:
+			if(vd->mem && vd->mem[vd->buf.index]!= NULL)
+	    	{
+				free(vd->mem[vd->buf.index]);
+				vd->mem[vd->buf.index] = NULL;
+			}
+			free_buff_arrays(vd);
+			break;
+
+		case IO_REPLAY:
+			free_replay_buffers(vd);
+			break;
+
+		case IO_MMAP:
+		default:
+			//delete requested buffers
+			release_v4l2_buffers(vd);
+			break;
+	}
+}
+/*
+ * cleans video device data and allocations
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: void
+ */
+void v4l2core_dev_close(v4l2_dev_t *vd)
+{
+	/*asserts*/
+	assert(vd != NULL);
+
+	v4l2core_dev_clean_buffers(vd);
+	clean_v4l2_dev(vd);
+}
+
+/*
+ * cleans default video device data and allocations
+ * args:
+ *   none
+ *
+ * asserts:
+ *   my_vd is not null
+ *
+ * returns: void
+ */
+void v4l2core_close_dev()
+{
+	/*asserts*/
+	assert(my_vd != NULL);
+
+	if(my_vd->has_focus_control_id)
+		v4l2core_soft_autofocus_close();
+
+	v4l2core_dev_close(my_vd);
+	my_vd = NULL;
+}
+
+/*
+ * request a fps update - this locks the mutex
+ *   (can't be called while the mutex is being locked)
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *    vd is not null
+ *
+ * returns: none
+ */
+void v4l2core_dev_request_framerate_update(v4l2_dev_t *vd)
+{
+	/*
+	 * if we are streaming flag a fps change when retrieving frame
+	 * else change fps immediatly
+	 */
+	if(vd->streaming == STRM_OK)
+		vd->flag_fps_change = 1;
+	else
+		set_v4l2_framerate(vd);
+}
+
+/*
+ * gets video device defined frame rate (not real - consider it a maximum value)
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   vd is not null
+ *
+ * returns: VIDIOC_G_PARM ioctl result value
+ * (sets vd->fps_denom and vd->fps_num to device value)
+ */
+int v4l2core_dev_get_framerate(v4l2_dev_t *vd)
+{
+	/*assertions*/
+	assert(vd != NULL);
+
+	int ret=0;
+
+	/*replay frame rate is set by the file*/
+	if(vd->cap_meth == IO_REPLAY)
+		return E_OK;
+
+	vd->streamparm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	ret = xioctl(vd->fd, VIDIOC_G_PARM, &vd->streamparm);
+	if (ret < 0)
+	{
+		fprintf(stderr, "V4L2_CORE: (VIDIOC_G_PARM) error: %s\n", strerror(errno));
+		return ret;
+	}
+	else
+	{
+		if (vd->streamparm.parm.capture.capability & V4L2_CAP_TIMEPERFRAME)
+		{
+			vd->fps_denom = vd->streamparm.parm.capture.timeperframe.denominator;
+			vd->fps_num = vd->streamparm.parm.capture.timeperframe.numerator;
+		}
+	}
+
+	if(vd->fps_denom == 0 )
+		vd->fps_denom = 1;
+	if(vd->fps_num == 0)
+		vd->fps_num = 1;
+
+	return ret;
+}
+
+/*
+ * return the control associated to id from device list
+ * args:
+ *   vd - pointer to video device data
+ *   id - control id
+ *
+ * asserts:
+ *   vd is not null
+ *   vd->list_device_controls is not null
+ *
+ * returns: pointer to v4l2_control if succeded or null otherwise
+ */
+v4l2_ctrl_t *v4l2core_dev_get_control_by_id(v4l2_dev_t *vd, int id)
+{
+	return get_control_by_id(vd, id);
+}
+
+/*
+ * updates the value for control id from the device
+ * also updates control flags
+ * args:
+ *   vd - pointer to video device data
+ *   id -control id
+ *
+ * asserts:
+ *   none
+ *
+ * returns: ioctl result
+ */
+int v4l2core_dev_get_control_value_by_id(v4l2_dev_t *vd, int id)
+{
+	return get_control_value_by_id (vd, id);
+}
+
+/*
+ * goes trough the control list and sets values in device to default
+ * args:
+ *   vd - pointer to video device data
+ *
+ * asserts:
+ *   none
+ *
+ * returns: void
+ */
+void v4l2core_dev_set_control_defaults(v4l2_dev_t *vd)
+{
+	set_control_defaults(vd);
+}
+
+/*
+ * sets the value of control id in device
+ * args:
+ *   vd - pointer to video device data
+ *   id - control id
+ *
+ * asserts:
+ *   none
+ *
+ * returns: ioctl result
+ */
+int v4l2core_dev_set_control_value_by_id(v4l2_dev_t *vd, int id)
+{
+	return set_control_value_by_id(vd, id);
+}
+
+/*
+ * check for new devices
+ * args:
+ *   none
+ *
+ * asserts:
+ *   my_device_list.udev is not null
+ *   my_device_list.udev_fd is valid (> 0)
+ *   my_device_list.udev_mon is not null
+ *
+ * returns: true(1) if device list was updated, false(0) otherwise
+ */
+int v4l2core_check_device_list_events()
+{
+	return check_device_list_events(my_vd);
+}
+
+/* get frame format index from format list
+ * args:
+ *   vd - pointer to video device data
+ *   format - v4l2 pixel format
+ *
+ * asserts:
+ *   vd is not null
+ *   vd->list_stream_formats is not null
+ *
+ * returns: format list index or -1 if not available
+ */
+int v4l2core_dev_get_frame_format_index(v4l2_dev_t *vd, int format)
+{
+	return get_frame_format_index(vd, format);
+}
+
+/* get resolution index for format index from format list
+ * args:
+ *   vd - pointer to video device data
+ *   format - format index from format list
+ *   width - requested width
+ *   height - requested height
+ *
+ * asserts:
+ *   vd is not null
+ *   vd->list_stream_formats is not null
+ *
+ * returns: resolution list index for format index or -1 if not available
+ */
+int v4l2core_dev_get_format_resolution_index(v4l2_dev_t *vd, int format, int width, int height)
+{
+	return get_format_resolution_index(vd, format, width, height);
+}
+
+/*
+ * get lenght of xu control defined by unit id and selector
+ * args:
+ *   unit - unit id of xu control
+ *   selector - selector for control
+ *
+ * asserts:
+ *   none
+ *
+ * returns: length of xu control
+ */
+uint16_t v4l2core_get_length_xu_control(uint8_t unit, uint8_t selector)
+{
+	return get_length_xu_control(my_vd, unit, selector);
+}
+
+/*
+ * get uvc info for xu control defined by unit id and selector
+ * args:
+ *   unit - unit id of xu control
+ *   selector - selector for control
+ *
+ * asserts:
+ *   none
+ *
+ * returns: info of xu control
+ */
+uint8_t v4l2core_get_info_xu_control(uint8_t unit, uint8_t selector)
+{
+	return get_info_xu_control(my_vd, unit, selector);
+}
+
+/*
+ * runs a query on xu control defined by unit id and selector
+ * args:
+ *   unit - unit id of xu control
+ *   selector - selector for control
+ *   query - query type
+ *   data - pointer to query data
+ *
+ * asserts:
+ *   none
+ *
+ * returns: 0 if query succeded or errno otherwise
+ */
+int v4l2core_query_xu_control(uint8_t unit, uint8_t selector, uint8_t query, void *data)
+{
+	return query_xu_control(my_vd, unit, selector, query, data);
+}
+
+/*
+ *  ######### SINGLE DEVICE API (default device) ##########
+ */
+
+/*
+ * Set v4l2 capture method
+ * args:
+ *   method - capture method (IO_READ, IO_MMAP or IO_USERPTR)
+ *      (IO_REPLAY is set when a replay file is opened)
+ *
+ * asserts:
+ *   my_vd is not null
+ *
+ * returns: VIDIOC_STREAMON ioctl result (E_OK or E_STREAMON_ERR)
+*/
+void v4l2core_set_capture_method(int method)
+{
+	v4l2core_dev_set_capture_method(my_vd, method);
+}
+
+/*
+ * define fps values
+ * args:
+ *   num - fps numerator
+ *   denom - fps denominator
+ *
+ * asserts:
+ *   my_vd is not null
+ *
+ * returns - void
+ */
+void v4l2core_define_fps(int num, int denom)
+{
+	v4l2core_dev_define_fps(my_vd, num, denom);
+}
+
+/*
+ * get requested fps numerator
+ * args:
+ *   none
+ *
+ * asserts:
+ *   my_vd is not null
+ *
+ * returns - requested fps numerator
+ */
+int v4l2core_get_fps_num()
+{
+	return v4l2core_dev_get_fps_num(my_vd);
+}
+
+/*
+ * get requested fps denominator
+ * args:
+ *   none
+ *
+ * asserts:
+ *   my_vd is not null
+ *
+ * returns - requested fps denominator
+ */
+int v4l2core_get_fps_denom()
+{
+	return v4l2core_dev_get_fps_denom(my_vd);
+}
+
+/*
+ * get real fps
+ * args:
+ *   none
+ *
+ * asserts:
+ *   none
+ *
+ * returns: double with real fps value
+ */
+double v4l2core_get_realfps()
+{
+	return v4l2core_dev_get_realfps(my_vd);
+}
+
+/*
+ * get the video stream statistics
+ * args:
+ *   stats - pointer to stats struct to fill
+ *
+ * asserts:
+ *   stats is not null
+ *
+ * returns: none
+ */
+void v4l2core_get_stream_stats(v4l2_stream_stats_t *stats)
+{
+	v4l2core_dev_get_stream_stats(my_vd, stats);
+}
+
+/*
+ * save the current frame to file (asynchronous)
+ * args:
+ *    frame - pointer to frame buffer
+ *    filename - output file name
+ *    format - image type
+ *           (IMG_FMT_RAW, IMG_FMT_JPG, IMG_FMT_PNG, IMG_FMT_BMP)
+ *
+ * asserts:
+ *    none
+ *
+ * returns: error code (E_OK if the image was queued)
+ */
+int v4l2core_save_image(v4l2_frame_buff_t *frame, const char *filename, int format)
+{
+	return v4l2core_dev_save_image(my_vd, frame, filename, format);
+}
+
+/*
+ * enable/disable the per stage latency histograms
+ * args:
+ *   enable - 1 enable; 0 disable
+ *   dump_interval - interval in seconds for printing the
+ *      latency summary to stdout (0 - don't print)
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+void v4l2core_set_latency_stats(int enable, int dump_interval)
+{
+	v4l2core_dev_set_latency_stats(my_vd, enable, dump_interval);
+}
+
+/*
+ * record a latency value for a stage measured by the client
+ * args:
+ *   stage - latency stage (LATENCY_DQBUF, ...)
+ *   latency - latency in ns
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+void v4l2core_record_latency(int stage, uint64_t latency)
+{
+	v4l2core_dev_record_latency(my_vd, stage, latency);
+}
+
+/*
+ * get the latency summary for a stage
+ * args:
+ *   stage - latency stage (LATENCY_DQBUF, ...)
+ *   stats - pointer to stats struct to fill
+ *
+ * asserts:
+ *   none
+ *
+ * returns: error code (E_NO_DATA if latency stats were never enabled)
+ */
+int v4l2core_get_latency_stats(int stage, v4l2_latency_stats_t *stats)
+{
+	return v4l2core_dev_get_latency_stats(my_vd, stage, stats);
+}
+
+/*
+ * clear the latency histograms
+ * args:
+ *   none
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+void v4l2core_reset_latency_stats()
+{
+	v4l2core_dev_reset_latency_stats(my_vd);
+}
+
+/*
+ * print the latency summary of all stages to stdout
+ * args:
+ *   none
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+void v4l2core_print_latency_stats()
+{
+	v4l2core_dev_print_latency_stats(my_vd);
+}
+
+/*
+ * set the replay flags (IO_REPLAY only)
+ * args:
+ *   flags - replay flags (REPLAY_TIMED | REPLAY_LOOP)
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+void v4l2core_set_replay_flags(int flags)
+{
+	v4l2core_dev_set_replay_flags(my_vd, flags);
+}
+
+/*
+ * check for the end of the replay (IO_REPLAY only)
+ * args:
+ *   none
+ *
+ * asserts:
+ *   my_vd is not null
+ *
+ * returns: 1 at end of replay file, 0 otherwise
+ */
+int v4l2core_is_replay_eof()
+{
+	return v4l2core_dev_is_replay_eof(my_vd);
+}
+
+/*
+ * start recording the raw frames to a replay file
+ * args:
+ *   filename - replay file name
+ *
+ * asserts:
+ *   filename is not null
+ *
+ * returns: error code (0- E_OK)
+ */
+int v4l2core_start_replay_record(const char *filename)
+{
+	return v4l2core_dev_start_replay_record(my_vd, filename);
+}
+
+/*
+ * stop recording raw frames
+ * args:
+ *   none
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+void v4l2core_stop_replay_record()
+{
+	v4l2core_dev_stop_replay_record(my_vd);
+}
+
+/*
+ * get videodevice string
+ * args:
+ *    none
+ *
+ * asserts:
+ *    none
+ *
+ * return: videodevice string
+ */
+const char *v4l2core_get_videodevice()
+{
+	return v4l2core_dev_get_videodevice(my_vd);
+}
+
+/*
+ * get device available number of formats
+ * args:
+ *   none
+ *
+ * asserts:
+ *   my_vd is not null
+ *
+ * returns - number of formats for device
+ */
+int v4l2core_get_number_formats()
+{
+	return v4l2core_dev_get_number_formats(my_vd);
+}
+
+/*
+ * Start video stream
+ * args:
+ *   none
+ *
+ * asserts:
+ *   my_vd is not null
+ *
+ * returns: VIDIOC_STREAMON ioctl result (E_OK or E_STREAMON_ERR)
+*/
+int v4l2core_start_stream()
+{
+	return v4l2core_dev_start_stream(my_vd);
+}
+
+/*
+ * request video stream to stop
+ * args:
+ *   none
+ *
+ * asserts:
+ *   my_vd is not null
+ *
+ * returns: error code (0 -OK)
+*/
+int v4l2core_request_stop_stream()
+{
+	return v4l2core_dev_request_stop_stream(my_vd);
+}
+
+/*
+ * Stops the video stream
+ * args:
+ *   none
+ *
+ * asserts:
+ *   my_vd is not null
+ *
+ * returns: VIDIOC_STREAMON ioctl result (E_OK)
+*/
+int v4l2core_stop_stream()
+{
+	return v4l2core_dev_stop_stream(my_vd);
+}
+
+/*
+ * wakes up any thread waiting for a frame on the default device
+ * args:
+ *   none
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+void v4l2core_wakeup()
+{
+	v4l2core_dev_wakeup(my_vd);
+}
+
+/*
+ * sets a periodic timer on the default device event loop
+ * args:
+ *   interval - timer interval in ns (0 disables the timer)
+ *
+ * asserts:
+ *   none
+ *
+ * returns: error code (0- E_OK)
+ */
+int v4l2core_set_timer(uint64_t interval)
+{
+	return v4l2core_dev_set_timer(my_vd, interval);
+}
+
+/*
+ * gets (and clears) the number of timer expirations of the default device
+ * args:
+ *   none
+ *
+ * asserts:
+ *   none
+ *
+ * returns: number of timer expirations since last call
+ */
+uint64_t v4l2core_get_timer_expirations()
+{
+	return v4l2core_dev_get_timer_expirations(my_vd);
+}
+
+/*
+ * sets the number of driver buffers of the default device
+ * args:
+ *   count - number of buffers [NB_BUFFER_MIN - NB_BUFFER_MAX]
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+void v4l2core_set_buffer_count(int count)
+{
+	v4l2core_dev_set_buffer_count(my_vd, count);
+}
+
+/*
+ * gets the number of driver buffers of the default device
+ * args:
+ *   none
+ *
+ * asserts:
+ *   none
+ *
+ * returns: number of driver buffers
+ */
+int v4l2core_get_buffer_count()
+{
+	return v4l2core_dev_get_buffer_count(my_vd);
+}
+
+/*
+ * sets the adaptive buffer count range of the default device
+ * args:
+ *   min_count - minimum number of buffers
+ *   max_count - maximum number of buffers (0 - disable)
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+void v4l2core_set_adaptive_buffers(int min_count, int max_count)
+{
+	v4l2core_dev_set_adaptive_buffers(my_vd, min_count, max_count);
+}
+
+/*
+ * sets the low latency (latest frame wins) mode of the default device
+ * args:
+ *   enable - 1 to enable; 0 to disable
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+void v4l2core_set_low_latency(int enable)
+{
+	v4l2core_dev_set_low_latency(my_vd, enable);
+}
+
+/*
+ * gets the next video frame (must be released after processing)
+ * args:
+ *   none
+ *
+ * asserts:
+ *   my_vd is not null
+ *
+ * returns: pointer frame buffer (NULL on error)
+ */
+v4l2_frame_buff_t *v4l2core_get_frame()
+{
+	return v4l2core_dev_get_frame(my_vd);
+}
+
+/*
+ * releases the video frame (so that it can be reused by the driver)
+ * args:
+ *   frame - pointer to decoded frame buffer
+ *
+ * asserts:
+ *   my_vd is not null
+ *
+ * returns: error code (E_OK)
+ */
+int v4l2core_release_frame(v4l2_frame_buff_t *frame)
+{
+	return v4l2core_dev_release_frame(my_vd, frame);
+}
+
+/*
+ * get the dma-buf fd exported for the frame raw buffer
+ * args:
+ *   frame - pointer to frame buffer
+ *
+ * asserts:
+ *   my_vd is not null
+ *
+ * returns: dma-buf fd or -1 if not available
+ */
+int v4l2core_get_frame_dmabuf_fd(v4l2_frame_buff_t *frame)
+{
+	return v4l2core_dev_get_frame_dmabuf_fd(my_vd, frame);
+}
 
-	if(stream_status == STRM_OK)
-		v4l2core_start_stream();
+/*
+ * gets the next video frame and decodes it
+ * args:
+ *    none
+ *
+ * returns: pointer to decoded frame buffer ( NULL on error)
+ */
+v4l2_frame_buff_t *v4l2core_get_decoded_frame()
+{
+	return v4l2core_dev_get_decoded_frame(my_vd);
+}
 
-	/*update the current framerate for the device*/
-	v4l2core_get_framerate();
+/*
+ * decodes a frame (from v4l2core_get_frame)
+ *   if planes is set the frame is decoded straight into them
+ * args:
+ *   frame - pointer to frame buffer
+ *   planes - output planes or null to decode to frame->yuv_frame
+ *   pitches - output plane pitches
+ *
+ * asserts:
+ *   frame is not null
+ *
+ * returns: error code (0- E_OK)
+ */
+int v4l2core_decode_frame(v4l2_frame_buff_t *frame, uint8_t **planes, int *pitches)
+{
+	return v4l2core_dev_decode_frame(my_vd, frame, planes, pitches);
+}
 
-	return E_OK;
+/*
+ * decodes a frame (from v4l2core_get_frame) to frame->yuv_frame
+ *   at the preview size
+ * args:
+ *   frame - pointer to frame buffer
+ *
+ * asserts:
+ *   frame is not null
+ *
+ * returns: error code (0- E_OK)
+ */
+int v4l2core_decode_preview_frame(v4l2_frame_buff_t *frame)
+{
+	return v4l2core_dev_decode_preview_frame(my_vd, frame);
 }
 
 /*
- * get frame width
+ * copies a decoded frame to the given planes
+ *   decimated to the preview size
  * args:
- *   none
+ *   frame - pointer to decoded frame buffer
+ *   planes - output planes
+ *   pitches - output plane pitches
  *
  * asserts:
- *   vd is not null
+ *   frame is not null
+ *   planes is not null
+ *   pitches is not null
  *
- * returns: frame width
+ * returns: error code (0- E_OK)
  */
-int v4l2core_get_frame_width()
+int v4l2core_copy_frame(v4l2_frame_buff_t *frame, uint8_t **planes, int *pitches)
 {
-	/*assertions*/
-	assert(vd != NULL);
-	
-	return vd->format.fmt.pix.width;
+	return v4l2core_dev_copy_frame(my_vd, frame, planes, pitches);
 }
 
 /*
- * get frame height
+ * starts the decoding pipeline for the default device
  * args:
- *   none
+ *   ndecoders - number of decoder threads
  *
  * asserts:
- *   vd is not null
+ *   none
  *
- * returns: frame height
+ * returns: error code (0- E_OK)
  */
-int v4l2core_get_frame_height()
+int v4l2core_start_pipeline(int ndecoders)
 {
-	/*assertions*/
-	assert(vd != NULL);
-	
-	return vd->format.fmt.pix.height;
+	return v4l2core_dev_start_pipeline(my_vd, ndecoders);
 }
 
 /*
- * get requested frame format
+ * stops the decoding pipeline for the default device
  * args:
  *   none
  *
  * asserts:
- *   vd is not null
+ *   none
  *
- * returns: requested frame format
+ * returns: none
  */
-int v4l2core_get_requested_frame_format()
+void v4l2core_stop_pipeline()
 {
-	/*asserts*/
-	assert(vd != NULL);
-	
-	return vd->requested_fmt;
+	v4l2core_dev_stop_pipeline(my_vd);
 }
 
 /*
- * prepare new format
+ * set the number of (m)jpeg band decoding threads
  * args:
- *   new_format - new format
+ *   nthreads - number of band threads (0 - disabled)
  *
  * asserts:
- *    vd is not null
+ *   none
  *
  * returns: none
  */
-void v4l2core_prepare_new_format(int new_format)
+void v4l2core_set_jpeg_band_threads(int nthreads)
 {
-	/*asserts*/
-	assert(vd != NULL);
-
-	int format_index = v4l2core_get_frame_format_index(new_format);
-
-	if(format_index < 0)
-		format_index = 0;
-
-	my_pixelformat = vd->list_stream_formats[format_index].format;
+	v4l2core_dev_set_jpeg_band_threads(my_vd, nthreads);
 }
 
 /*
- * prepare a valid format (first in the format list)
+ * set the number of raw bayer stripe decoding threads
  * args:
- *   none
+ *   nthreads - number of stripe threads (0 - disabled)
  *
  * asserts:
- *    vd is not null
+ *   none
  *
  * returns: none
  */
-void v4l2core_prepare_valid_format()
+void v4l2core_set_bayer_threads(int nthreads)
 {
-	/*asserts*/
-	assert(vd != NULL);
-
-	int format_index = 0;
-
-	my_pixelformat = vd->list_stream_formats[format_index].format;
+	v4l2core_dev_set_bayer_threads(my_vd, nthreads);
 }
 
 /*
- * prepare new resolution
+ * set the number of raw frame conversion band threads
  * args:
- *   new_width - new width
- *   new_height - new height
+ *   nthreads - number of band threads (0 - disabled)
  *
  * asserts:
- *    vd is not null
+ *   none
  *
  * returns: none
  */
-void v4l2core_prepare_new_resolution(int new_width, int new_height)
+void v4l2core_set_convert_threads(int nthreads)
 {
-	/*asserts*/
-	assert(vd != NULL);
-
-	int format_index = v4l2core_get_frame_format_index(my_pixelformat);
-
-	if(format_index < 0)
-		format_index = 0;
-
-	int resolution_index = v4l2core_get_format_resolution_index(format_index, new_width, new_height);
-
-	if(resolution_index < 0)
-		resolution_index = 0;
-
-	my_width  = vd->list_stream_formats[format_index].list_stream_cap[resolution_index].width;
-	my_height = vd->list_stream_formats[format_index].list_stream_cap[resolution_index].height;
+	v4l2core_dev_set_convert_threads(my_vd, nthreads);
 }
 
 /*
- * prepare valid resolution (first in the resolution list for the format)
+ * set the yuv colorimetry used for rgb image snapshots
  * args:
- *   none
+ *   matrix - YUV_MATRIX_xxx (YUV_MATRIX_AUTO - from the format)
+ *   range - YUV_RANGE_xxx (YUV_RANGE_AUTO - from the format)
  *
  * asserts:
- *    vd is not null
+ *   none
  *
  * returns: none
  */
-void v4l2core_prepare_valid_resolution()
+void v4l2core_set_yuv_colorimetry(int matrix, int range)
 {
-	/*asserts*/
-	assert(vd != NULL);
-
-	int format_index = v4l2core_get_frame_format_index(my_pixelformat);
-
-	if(format_index < 0)
-		format_index = 0;
-
-	int resolution_index = 0;
+	v4l2core_dev_set_yuv_colorimetry(my_vd, matrix, range);
+}
 
-	my_width  = vd->list_stream_formats[format_index].list_stream_cap[resolution_index].width;
-	my_height = vd->list_stream_formats[format_index].list_stream_cap[resolution_index].height;
+/*
+ * set the 16 bit luma mode (Y10B and Y16 formats)
+ * args:
+ *   enable - 1: keep 16 bit luma in frame->luma16_frame; 0: 8 bit only
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+void v4l2core_set_luma16_mode(int enable)
+{
+	v4l2core_dev_set_luma16_mode(my_vd, enable);
 }
 
 /*
- * update the current format (pixelformat, width and height)
+ * set the preview scale denominator
  * args:
- *    none
+ *   scale - preview scale denominator (1, 2, 4 or 8)
  *
  * asserts:
- *    vd is not null
+ *   none
  *
- * returns:
- *    error code
+ * returns: none
  */
-int v4l2core_update_current_format()
+void v4l2core_set_preview_scale(int scale)
 {
-	/*asserts*/
-	assert(vd != NULL);
+	v4l2core_dev_set_preview_scale(my_vd, scale);
+}
 
-	return(try_video_stream_format(my_width, my_height, my_pixelformat));
+/*
+ * set the pipeline preview mode
+ * args:
+ *   enable - 1 enable, 0 disable (default)
+ *
+ * asserts:
+ *   none
+ *
+ * returns: none
+ */
+void v4l2core_set_pipeline_preview(int enable)
+{
+	v4l2core_dev_set_pipeline_preview(my_vd, enable);
 }
 
 /*
- * clean video device data allocation
+ * get the preview width
  * args:
  *   none
  *
  * asserts:
- *   vd is not null
+ *   none
  *
- * returns: void
+ * returns: preview width
  */
-static void clean_v4l2_dev()
+int v4l2core_get_preview_width()
 {
-	/*assertions*/
-	assert(vd != NULL);
-
-	if(vd->videodevice)
-		free(vd->videodevice);
-	vd->videodevice = NULL;
-
-	if(vd->has_focus_control_id)
-		v4l2core_soft_autofocus_close(vd);
-
-	if(vd->list_device_controls)
-		free_v4l2_control_list(vd);
-
-	if(vd->list_stream_formats)
-		free_frame_formats(vd);
-
-	if(vd->list_device_controls)
-		free_v4l2_control_list(vd);
-	
-	if(vd->frame_queue)
-		free(vd->frame_queue);
-	
-	/*close descriptor*/
-	if(vd->fd > 0)
-		v4l2_close(vd->fd);
-
-	vd->fd = 0;
-
-	free(vd);
+	return v4l2core_dev_get_preview_width(my_vd);
 }
 
 /*
- * Initiate video device data with default values
+ * get the preview height
  * args:
- *   device - device name (e.g: "/dev/video0")
+ *   none
  *
  * asserts:
- *   device is not null
+ *   none
  *
- * returns: error code  (< 0) on error
+ * returns: preview height
  */
-int v4l2core_init_dev(const char *device)
+int v4l2core_get_preview_height()
 {
-	assert(device != NULL);
-#if 0
-	/*localization*/
-	char* lc_all = setlocale (LC_ALL, "");
-	char* lc_dir = bindtextdomain (GETTEXT_PACKAGE_V4L2CORE, PACKAGE_LOCALE_DIR);
-	bind_textdomain_codeset (GETTEXT_PACKAGE_V4L2CORE, "UTF-8");
-	if (verbosity > 1) printf("V4L2_CORE: language catalog=> dir:%s type:%s cat:%s.mo\n",
-		lc_dir, lc_all, GETTEXT_PACKAGE_V4L2CORE);
-#endif
-	/*alloc the device data*/
-	vd = calloc(1, sizeof(v4l2_dev_t));
-
-	assert(vd != NULL);
-
-	/*MMAP by default*/
-	vd->cap_meth = IO_MMAP;
-
-	vd->videodevice = strdup(device);
-
-	if(verbosity > 0)
-	{
-		printf("V4L2_CORE: capture method mmap (%i)\n",vd->cap_meth);
-		printf("V4L2_CORE: video device: %s \n", vd->videodevice);
-	}
-
-	vd->frame_queue_size = frame_queue_size;
-	/*alloc frame buffer queue*/
-	vd->frame_queue = calloc(vd->frame_queue_size, sizeof(v4l2_frame_buff_t));
-	
-	/*set some defaults*/
-	vd->fps_num = 1;
-	vd->fps_denom = 25;
-
-	vd->pan_step = 128;
-	vd->tilt_step = 128;
-
-	/*open device*/
-	if ((vd->fd = v4l2_open(vd->videodevice, O_RDWR | O_NONBLOCK, 0)) < 0)
-	{
-		fprintf(stderr, "V4L2_CORE: ERROR opening V4L interface: %s\n", strerror(errno));
-		clean_v4l2_dev(vd);
-		return (-1);
-	}
-
-	vd->this_device = v4l2core_get_device_index(vd->videodevice);
-	if(vd->this_device < 0)
-		vd->this_device = 0;
-
-	v4l2_device_list *device_list = v4l2core_get_device_list();
-	if(device_list && device_list->list_devices)
-		device_list->list_devices[vd->this_device].current = 1;
-
-	/*try to map known xu controls (we could/should leave this for libwebcam)*/
-	init_xu_ctrls(vd);
-
-	/*zero structs*/
-	memset(&vd->cap, 0, sizeof(struct v4l2_capability));
-	memset(&vd->format, 0, sizeof(struct v4l2_format));
-	memset(&vd->buf, 0, sizeof(struct v4l2_buffer));
-	memset(&vd->rb, 0, sizeof(struct v4l2_requestbuffers));
-	memset(&vd->streamparm, 0, sizeof(struct v4l2_streamparm));
-
-	if(check_v4l2_dev(vd) != E_OK)
-	{
-		clean_v4l2_dev(vd);
-		return (-2);
-	}
-
-	int i = 0;
-	for (i = 0; i < NB_BUFFER; i++)
-	{
-		vd->mem[i] = MAP_FAILED; /*not mmaped yet*/
-	}
+	return v4l2core_dev_get_preview_height(my_vd);
+}
 
-	return (0);
+/*
+ * get frame width
+ * args:
+ *   none
+ *
+ * asserts:
+ *   my_vd is not null
+ *
+ * returns: frame width
+ */
+int v4l2core_get_frame_width()
+{
+	return v4l2core_dev_get_frame_width(my_vd);
 }
 
 /*
- * get stream frame format list for device
+ * get frame height
  * args:
- *    none
+ *   none
  *
  * asserts:
- *    vd is not null
+ *   my_vd is not null
  *
- * return: pointer to first format in the list
+ * returns: frame height
  */
-v4l2_stream_formats_t *v4l2core_get_formats_list()
+int v4l2core_get_frame_height()
 {
-	/*assertions*/
-	assert(vd != NULL);
-	
-	return vd->list_stream_formats;
+	return v4l2core_dev_get_frame_height(my_vd);
 }
 
 /*
- * get device control list
+ * get requested frame format
  * args:
- *    none
+ *   none
  *
  * asserts:
- *    vd is not null
+ *   my_vd is not null
  *
- * return: pointer to first control in the list
+ * returns: requested frame format
  */
-v4l2_ctrl_t *v4l2core_get_control_list()
+int v4l2core_get_requested_frame_format()
 {
-	/*assertions*/
-	assert(vd != NULL);
-	
-	return vd->list_device_controls;
+	return v4l2core_dev_get_requested_frame_format(my_vd);
 }
 
 /*
- * get device pan step value
+ * prepare new format
  * args:
- *    none
+ *   new_format - new format
  *
  * asserts:
- *    vd is not null
+ *    my_vd is not null
  *
- * return: pan step value
+ * returns: none
  */
-int v4l2core_get_pan_step()
+void v4l2core_prepare_new_format(int new_format)
 {
-	/*assertions*/
-	assert(vd != NULL);
-	
-	return vd->pan_step;
+	v4l2core_dev_prepare_new_format(my_vd, new_format);
 }
 
 /*
- * get device tilt step value
+ * prepare a valid format (first in the format list)
  * args:
- *    none
+ *   none
  *
  * asserts:
- *    vd is not null
+ *    my_vd is not null
  *
- * return: tilt step value
+ * returns: none
  */
-int v4l2core_get_tilt_step()
+void v4l2core_prepare_valid_format()
 {
-	/*assertions*/
-	assert(vd != NULL);
-	
-	return vd->tilt_step;
+	v4l2core_dev_prepare_valid_format(my_vd);
 }
 
 /*
- * set device pan step value
+ * prepare new resolution
  * args:
- *    step - pan step value
+ *   new_width - new width
+ *   new_height - new height
  *
  * asserts:
- *    vd is not null
+ *    my_vd is not null
  *
- * return: none
+ * returns: none
  */
-void v4l2core_set_pan_step(int step)
+void v4l2core_prepare_new_resolution(int new_width, int new_height)
 {
-	/*assertions*/
-	assert(vd != NULL);
-	
-	vd->pan_step = step;
+	v4l2core_dev_prepare_new_resolution(my_vd, new_width, new_height);
 }
 
 /*
- * set device tilt step value
+ * prepare valid resolution (first in the resolution list for the format)
  * args:
- *    step -tilt step value
+ *   none
  *
  * asserts:
- *    vd is not null
+ *    my_vd is not null
  *
- * return: none
+ * returns: none
  */
-void v4l2core_set_tilt_step(int step)
+void v4l2core_prepare_valid_resolution()
 {
-	/*assertions*/
-	assert(vd != NULL);
-	
-	vd->tilt_step = step;
+	v4l2core_dev_prepare_valid_resolution(my_vd);
 }
 
 /*
- * initiate software autofocus
+ * update the current format (pixelformat, width and height)
  * args:
  *    none
  *
  * asserts:
- *    none
+ *    my_vd is not null
  *
- * returns: error code (0 - E_OK)
+ * returns:
+ *    error code
  */
-int v4l2core_soft_autofocus_init ()
+int v4l2core_update_current_format()
 {
-	return soft_autofocus_init(vd);
+	return v4l2core_dev_update_current_format(my_vd);
 }
 
 /*
- * run the software autofocus
+ * get stream frame format list for device
  * args:
- *    frame - pointer to frame buffer
+ *    none
  *
  * asserts:
- *    vd is not null
+ *    my_vd is not null
  *
- * returns: 1 - running  0- focused
- * 	(only matters for non-continue focus)
+ * return: pointer to first format in the list
  */
-int v4l2core_soft_autofocus_run(v4l2_frame_buff_t *frame)
+v4l2_stream_formats_t *v4l2core_get_formats_list()
 {
-	return soft_autofocus_run(vd, frame);
+	return v4l2core_dev_get_formats_list(my_vd);
 }
 
 /*
- * clean v4l2 buffers
+ * get device control list
  * args:
  *    none
  *
  * asserts:
- *    vd is not null
+ *    my_vd is not null
  *
- * return: none
+ * return: pointer to first control in the list
  */
-void v4l2core_clean_buffers()
+v4l2_ctrl_t *v4l2core_get_control_list()
 {
-	/*assertions*/
-	assert(vd != NULL);
-
-	if(verbosity > 1)
-		printf("V4L2_CORE: cleaning v4l2 buffers\n");
-
-	if(vd->streaming == STRM_OK)
-		v4l2core_stop_stream(vd);
-
-	clean_v4l2_frames(vd);
-
-	// unmap queue buffers
-	switch(vd->cap_meth)
-	{
-		case IO_READ:
-			if(vd->mem[vd->buf.index]!= NULL)
-	    	{
-				free(vd->mem[vd->buf.index]);
-				vd->mem[vd->buf.index] = NULL;
-			}
-			break;
-
-		case IO_MMAP:
-		default:
-			//delete requested buffers
-			unmap_buff(vd);
-			memset(&vd->rb, 0, sizeof(struct v4l2_requestbuffers));
-			vd->rb.count = 0;
-			vd->rb.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-			vd->rb.memory = V4L2_MEMORY_MMAP;
-			if(xioctl(vd->fd, VIDIOC_REQBUFS, &vd->rb)<0)
-			{
-				fprintf(stderr, "V4L2_CORE: (VIDIOC_REQBUFS) Failed to delete buffers: %s (errno %d)\n", strerror(errno), errno);
-			}
-			break;
-	}
+	return v4l2core_dev_get_control_list(my_vd);
 }
+
 /*
- * cleans video device data and allocations
+ * clean v4l2 buffers
  * args:
- *   none
+ *    none
  *
  * asserts:
- *   vd is not null
+ *    my_vd is not null
  *
- * returns: void
+ * return: none
  */
-void v4l2core_close_dev()
+void v4l2core_clean_buffers()
 {
-	/*asserts*/
-	assert(vd != NULL);
-
-	v4l2core_clean_buffers();
-	clean_v4l2_dev();
+	v4l2core_dev_clean_buffers(my_vd);
 }
 
 /*
@@ -1954,20 +4967,13 @@ void v4l2core_close_dev()
  *    none
  *
  * asserts:
- *    vd is not null
+ *    my_vd is not null
  *
  * returns: none
  */
 void v4l2core_request_framerate_update()
 {
-	/*
-	 * if we are streaming flag a fps change when retrieving frame
-	 * else change fps immediatly
-	 */
-	if(vd->streaming == STRM_OK)
-		flag_fps_change = 1;
-	else
-		set_v4l2_framerate();
+	v4l2core_dev_request_framerate_update(my_vd);
 }
 
 /*
@@ -1976,40 +4982,14 @@ void v4l2core_request_framerate_update()
  *   none
  *
  * asserts:
- *   vd is not null
+ *   my_vd is not null
  *
  * returns: VIDIOC_G_PARM ioctl result value
  * (sets vd->fps_denom and vd->fps_num to device value)
  */
-int v4l2core_get_framerate ()
+int v4l2core_get_framerate()
 {
-	/*assertions*/
-	assert(vd != NULL);
-
-	int ret=0;
-
-	vd->streamparm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-	ret = xioctl(vd->fd, VIDIOC_G_PARM, &vd->streamparm);
-	if (ret < 0)
-	{
-		fprintf(stderr, "V4L2_CORE: (VIDIOC_G_PARM) error: %s\n", strerror(errno));
-		return ret;
-	}
-	else
-	{
-		if (vd->streamparm.parm.capture.capability & V4L2_CAP_TIMEPERFRAME)
-		{
-			vd->fps_denom = vd->streamparm.parm.capture.timeperframe.denominator;
-			vd->fps_num = vd->streamparm.parm.capture.timeperframe.numerator;
-		}
-	}
-
-	if(vd->fps_denom == 0 )
-		vd->fps_denom = 1;
-	if(vd->fps_num == 0)
-		vd->fps_num = 1;
-
-	return ret;
+	return v4l2core_dev_get_framerate(my_vd);
 }
 
 /*
@@ -2018,14 +4998,14 @@ int v4l2core_get_framerate ()
  *   id - control id
  *
  * asserts:
- *   vd is not null
+ *   my_vd is not null
  *   vd->list_device_controls is not null
  *
  * returns: pointer to v4l2_control if succeded or null otherwise
  */
 v4l2_ctrl_t *v4l2core_get_control_by_id(int id)
 {
-	return get_control_by_id(vd, id);
+	return v4l2core_dev_get_control_by_id(my_vd, id);
 }
 
 /*
@@ -2039,9 +5019,9 @@ v4l2_ctrl_t *v4l2core_get_control_by_id(int id)
  *
  * returns: ioctl result
  */
-int v4l2core_get_control_value_by_id (int id)
+int v4l2core_get_control_value_by_id(int id)
 {
-	return get_control_value_by_id (vd, id);
+	return v4l2core_dev_get_control_value_by_id(my_vd, id);
 }
 
 /*
@@ -2056,7 +5036,7 @@ int v4l2core_get_control_value_by_id (int id)
  */
 void v4l2core_set_control_defaults()
 {
-	set_control_defaults(vd);
+	v4l2core_dev_set_control_defaults(my_vd);
 }
 
 /*
@@ -2071,24 +5051,7 @@ void v4l2core_set_control_defaults()
  */
 int v4l2core_set_control_value_by_id(int id)
 {
-	return set_control_value_by_id(vd, id);
-}
-
-/*
- * check for new devices
- * args:
- *   none
- *
- * asserts:
- *   my_device_list.udev is not null
- *   my_device_list.udev_fd is valid (> 0)
- *   my_device_list.udev_mon is not null
- *
- * returns: true(1) if device list was updated, false(0) otherwise
- */
-int v4l2core_check_device_list_events()
-{
-	return check_device_list_events(vd);
+	return v4l2core_dev_set_control_value_by_id(my_vd, id);
 }
 
 /* get frame format index from format list
@@ -2096,14 +5059,14 @@ int v4l2core_check_device_list_events()
  *   format - v4l2 pixel format
  *
  * asserts:
- *   vd is not null
- *   vd->list_stream_formats is not null
+ *   my_vd is not null
+ *   my_vd->list_stream_formats is not null
  *
  * returns: format list index or -1 if not available
  */
 int v4l2core_get_frame_format_index(int format)
 {
-	return get_frame_format_index(vd, format);
+	return v4l2core_dev_get_frame_format_index(my_vd, format);
 }
 
 /* get resolution index for format index from format list
@@ -2113,62 +5076,12 @@ int v4l2core_get_frame_format_index(int format)
  *   height - requested height
  *
  * asserts:
- *   vd is not null
- *   vd->list_stream_formats is not null
+ *   my_vd is not null
+ *   my_vd->list_stream_formats is not null
  *
  * returns: resolution list index for format index or -1 if not available
  */
 int v4l2core_get_format_resolution_index(int format, int width, int height)
 {
-	return get_format_resolution_index(vd, format, width, height);
-}
-
-/*
- * get lenght of xu control defined by unit id and selector
- * args:
- *   unit - unit id of xu control
- *   selector - selector for control
- *
- * asserts:
- *   none
- *
- * returns: length of xu control
- */
-uint16_t v4l2core_get_length_xu_control(uint8_t unit, uint8_t selector)
-{
-	return get_length_xu_control(vd, unit, selector);
-}
-
-/*
- * get uvc info for xu control defined by unit id and selector
- * args:
- *   unit - unit id of xu control
- *   selector - selector for control
- *
- * asserts:
- *   none
- *
- * returns: info of xu control
- */
-uint8_t v4l2core_get_info_xu_control(uint8_t unit, uint8_t selector)
-{
-	return get_info_xu_control(vd, unit, selector);
-}
-
-/*
- * runs a query on xu control defined by unit id and selector
- * args:
- *   unit - unit id of xu control
- *   selector - selector for control
- *   query - query type
- *   data - pointer to query data
- *
- * asserts:
- *   none
- *
- * returns: 0 if query succeded or errno otherwise
- */
-int v4l2core_query_xu_control(uint8_t unit, uint8_t selector, uint8_t query, void *data)
-{
-	return query_xu_control(vd, unit, selector, query, data);
+	return v4l2core_dev_get_format_resolution_index(my_vd, format, width, height);
 }
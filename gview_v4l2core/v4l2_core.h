@@ -23,6 +23,7 @@
 #define V4L2CORE_H
 
 #include "gviewv4l2core.h"
+#include "gview.h"
 
 /*
  * video device data
@@ -32,7 +33,7 @@ typedef struct _v4l2_dev_t
 	int fd;                             // device file descriptor
 	char *videodevice;                  // video device string (default "/dev/video0)"
 
-	int cap_meth;                       // capture method: IO_READ or IO_MMAP
+	int cap_meth;                       // capture method: IO_READ, IO_MMAP, IO_USERPTR or IO_REPLAY
 	v4l2_stream_formats_t* list_stream_formats; //list of available stream formats
 	int numb_formats;                   //list size
 	//int current_format_index;           //index of current stream format
@@ -45,19 +46,71 @@ typedef struct _v4l2_dev_t
 	struct v4l2_streamparm streamparm;  // v4l2 stream parameters struct
 
 	int requested_fmt;                  //requested format (may differ from format.fmt.pix.pixelformat)
+	int prep_pixelformat;               //prepared format (set by v4l2core_dev_prepare_*)
+	int prep_width;                     //prepared width
+	int prep_height;                    //prepared height
 
 	int fps_num;                        //fps numerator
 	int fps_denom;                      //fps denominator
 
 	uint8_t streaming;                  // flag device stream : STRM_STOP ; STRM_REQ_STOP; STRM_OK
 	uint64_t frame_index;               // captured frame index from 0 to max(uint64_t)
-	void *mem[NB_BUFFER];               // memory buffers for mmap driver frames
-	uint32_t buff_length[NB_BUFFER];    // memory buffers length as set by VIDIOC_QUERYBUF
-	uint32_t buff_offset[NB_BUFFER];    // memory buffers offset as set by VIDIOC_QUERYBUF
+	int num_buffers;                    // number of driver buffers (as set by VIDIOC_REQBUFS)
+	int requested_buffers;              // number of driver buffers to request
+	void **mem;                         // memory buffers for driver frames (num_buffers)
+	uint32_t *buff_length;              // memory buffers length as set by VIDIOC_QUERYBUF
+	uint32_t *buff_offset;              // memory buffers offset as set by VIDIOC_QUERYBUF
+	int *buff_dmabuf_fd;                // dma-buf fds exported with VIDIOC_EXPBUF (-1 if not exported)
+
+	int adaptive_min_buffers;           // adaptive buffer count lower bound
+	int adaptive_max_buffers;           // adaptive buffer count upper bound (0 - adaptive mode off)
+	uint8_t flag_buffers_change;        // set to 1 to request a buffer count change while streaming
+	int64_t last_sequence;              // last driver frame sequence number (-1 if none)
+	uint32_t window_drops;              // frames dropped by the driver in the current fps window
+	int clean_windows;                  // consecutive fps windows without dropped frames
+	uint8_t low_latency;                // 1 - return only the newest ready frame (requeue stale ones)
+
+	v4l2_stream_stats_t stats;          // stream statistics
+	uint64_t last_timestamp;            // timestamp of the previous frame (0 if none)
+	int64_t last_interval;              // interval between the two previous frames (-1 if none)
+
+	struct _latency_stats_t *latency;   // per stage latency histograms (NULL if never enabled)
+	int latency_enabled;                // set to 1 to record stage latencies
+	uint64_t latency_dump_interval;     // latency summary print interval in ns (0 - don't print)
+	uint64_t latency_dump_ts;           // timestamp of the last latency summary print
+
+	struct _replay_t *replay;           // replay file (IO_REPLAY only)
+	struct _replay_t *replay_record;    // raw frame recorder (NULL if not recording)
 
 	v4l2_frame_buff_t *frame_queue;     //frame queue
 	int frame_queue_size;               //size of frame queue (in frames)
 
+	struct _band_executor_t *band_exec; //band threads (shared by the jpeg, bayer and raw frame decoders)
+	struct _jpeg_decoder_context_t *jpeg_ctx; //(m)jpeg decoder context
+	int jpeg_band_threads;              //(m)jpeg band decoding threads (0 - disabled)
+	struct _bayer_decoder_context_t *bayer_ctx; //raw bayer decoder context
+	int bayer_threads;                  //raw bayer stripe decoding threads (0 - disabled)
+	int convert_threads;                //raw frame conversion band threads (0 - disabled)
+	int yuv_matrix;                     //yuv to rgb matrix (YUV_MATRIX_AUTO - from the format)
+	int yuv_range;                      //yuv to rgb range (YUV_RANGE_AUTO - from the format)
+	int luma16_mode;                    //1 - keep 16 bit luma for Y10B/Y16 (frame->luma16_frame)
+	int preview_scale;                  //(m)jpeg preview scale denominator (1, 2, 4 or 8)
+	int pipeline_preview;               //1 - the pipeline decodes (m)jpeg at the preview scale
+	struct _frame_pipeline_t *pipeline; //decoding pipeline (NULL if not running)
+
+	double real_fps;                    //measured frame rate
+	uint64_t fps_ref_ts;                //reference timestamp for real_fps
+	uint32_t fps_frame_count;           //frames captured since fps_ref_ts
+	uint8_t flag_fps_change;            //set to 1 to request a fps change
+
+	__MUTEX_TYPE mutex;                 //device data mutex
+
+	int epoll_fd;                       //epoll set: device, wakeup, timer and udev monitor fds
+	int wakeup_fd;                      //eventfd used to wake up a frame wait (stop/format change requests)
+	int timer_fd;                       //timerfd for the user timer (-1 if not set)
+	uint64_t timer_expirations;         //timer expirations not yet consumed by the client
+	uint8_t device_list_event;          //set by the event loop when the udev monitor has data
+
     int this_device;                    // index of this device in device list
 
     v4l2_ctrl_t* list_device_controls;    //null terminated linked list of available device controls
@@ -285,6 +285,8 @@ int v4l2core_get_device_index(const char *videodevice)
 
 /*
  * check for new devices
+ *   if vd is streaming its event loop already watches the udev
+ *   monitor, so the monitor is only read when it flagged an event
  * args:
  *   vd - pointer to device data (can be null)
  *
@@ -302,61 +304,56 @@ int check_device_list_events(v4l2_dev_t *vd)
 	assert(my_device_list.udev_fd > 0);
 	assert(my_device_list.udev_mon != NULL);
 
-    fd_set fds;
-    struct timeval tv;
-    int ret = 0;
+	if(vd)
+	{
+		if(vd->streaming == STRM_OK && !vd->device_list_event)
+			return(0);
 
-    FD_ZERO(&fds);
-    FD_SET(my_device_list.udev_fd, &fds);
-    tv.tv_sec = 0;
-    tv.tv_usec = 0;
+		vd->device_list_event = 0;
+	}
 
-    ret = select(my_device_list.udev_fd+1, &fds, NULL, NULL, &tv);
+	int num_events = 0;
+	struct udev_device *dev = NULL;
 
-    /* Check if our file descriptor has received data. */
-    if (ret > 0 && FD_ISSET(my_device_list.udev_fd, &fds))
-    {
-        /*
-         * Make the call to receive the device.
-         *   select() ensured that this will not block.
-         */
-        struct udev_device *dev = udev_monitor_receive_device(my_device_list.udev_mon);
-        if (dev)
-        {
-            if (verbosity > 0)
-            {
-                printf("V4L2_CORE: Got Device event\n");
-                printf("          Node: %s\n", udev_device_get_devnode(dev));
-                printf("     Subsystem: %s\n", udev_device_get_subsystem(dev));
-                printf("       Devtype: %s\n", udev_device_get_devtype(dev));
-                printf("        Action: %s\n", udev_device_get_action(dev));
-            }
-
-            /*update device list*/
-            if(my_device_list.list_devices != NULL)
-				free_device_list();
-            enum_v4l2_devices();
-            
-            /*update the current device index*/
-            if(vd)
-            {
-				vd->this_device = v4l2core_get_device_index(vd->videodevice);
-				if(vd->this_device < 0)
-					vd->this_device = 0;
-	
-				if(my_device_list.list_devices)
-					my_device_list.list_devices[vd->this_device].current = 1;
-			}
-			
-            udev_device_unref(dev);
+	/*
+	 * the monitor fd is non blocking and edge triggered
+	 * in the event loop: drain all pending events
+	 */
+	while((dev = udev_monitor_receive_device(my_device_list.udev_mon)) != NULL)
+	{
+		if (verbosity > 0)
+		{
+			printf("V4L2_CORE: Got Device event\n");
+			printf("          Node: %s\n", udev_device_get_devnode(dev));
+			printf("     Subsystem: %s\n", udev_device_get_subsystem(dev));
+			printf("       Devtype: %s\n", udev_device_get_devtype(dev));
+			printf("        Action: %s\n", udev_device_get_action(dev));
+		}
 
-            return(1);
-        }
-        else
-            fprintf(stderr, "V4L2_CORE: No Device from receive_device(). An error occured.\n");
-    }
+		udev_device_unref(dev);
+		num_events++;
+	}
+
+	if(num_events == 0)
+		return(0);
+
+	/*update device list*/
+	if(my_device_list.list_devices != NULL)
+		free_device_list();
+	enum_v4l2_devices();
+
+	/*update the current device index*/
+	if(vd)
+	{
+		vd->this_device = v4l2core_get_device_index(vd->videodevice);
+		if(vd->this_device < 0)
+			vd->this_device = 0;
+
+		if(my_device_list.list_devices)
+			my_device_list.list_devices[vd->this_device].current = 1;
+	}
 
-    return(0);
+	return(1);
 }
 
 /*
@@ -42,6 +42,8 @@ int enum_v4l2_devices();
 
 /*
  * check for new devices
+ *   if vd is streaming its event loop already watches the udev
+ *   monitor, so the monitor is only read when it flagged an event
  * args:
  *   vd - pointer to device data (can be null)
  *
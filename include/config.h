@@ -33,7 +33,7 @@ typedef struct _config_t
 	char format[5];  /*pixelformat fourcc*/
 	char render[5];  /*render api*/
 	char gui[5];     /*gui api*/
-	char capture[5]; /*capture method: read or mmap*/
+	char capture[5]; /*capture method: read, mmap or user*/
 	char video_codec[5]; /*video codec*/
 	int fps_num;
 	int fps_denom;
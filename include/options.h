@@ -25,7 +25,7 @@
 typedef struct _options_t
 {
 	int  verbosity;  /*verbosity level*/
-	char device[30]; /*device name*/
+	char device[256]; /*device name (or replay file)*/
     int  cmos_camera; /* CMOS camera */
 	int  width;      /*width*/
 	int  height;     /*height*/
@@ -36,7 +36,7 @@ typedef struct _options_t
 	char gui[5];     /*gui api*/
 	char audio[6];   /*audio api - none; port; pulse*/
 	int audio_device; /*audio device index 0..N (-1 = default)*/
-	char capture[5]; /*capture method: read or mmap*/
+	char capture[5]; /*capture method: read, mmap or user*/
 	char audio_codec[5]; /*audio codec*/
 	char video_codec[5]; /*video codec*/
 	char *prof_filename; /*profile_filename (if set load it on start)*/
@@ -50,6 +50,15 @@ typedef struct _options_t
 	double photo_timer; /*photo capture timer interval in seconds (double)*/
 	int photo_npics; /*number of photo captures*/
 	char render_flag[5]; /*render window flag => default (none) | FULLSCREEN (full) | MAXIMIZED (max)*/
+	int decoder_threads; /*number of decoder threads (0 - decode in the capture thread)*/
+	int band_threads; /*number of mjpeg band decoding threads (0 - disabled)*/
+	int preview_scale; /*mjpeg preview scale denominator: 1 (def), 2, 4 or 8*/
+	int low_latency; /*show only the newest frame (1 - skip stale frames)*/
+	int luma16; /*keep 16 bit luma for Y10B/Y16 frames (0 - 8 bit only)*/
+	int buffers; /*number of driver buffers (0 - default; -1 - adaptive)*/
+	int latency; /*latency histograms print interval in seconds (0 - disabled)*/
+	char replay[16]; /*replay mode: timed or fast (with optional ",loop")*/
+	char *replay_record; /*record raw frames to this replay file (NULL - disabled)*/
 } options_t;
 
 /*